@@ -1,11 +1,13 @@
 // Compilation cache management
 pub mod manager;
 pub mod metadata;
+pub mod objects;
 pub mod path;
 
 // Re-exports for convenience
 pub use manager::{CacheEntry, CacheManager};
-pub use metadata::CacheMetadata;
+pub use metadata::{CacheMetadata, InputDigest};
+pub use objects::ObjectStore;
 pub use path::{cache_key_for_file, cache_root, ensure_cache_dir};
 
 /// Build options for caching
@@ -17,6 +19,12 @@ pub struct CacheBuildOptions {
     pub release: bool,
     pub lto: bool,
     pub emit_ir: bool,
+    /// Target triple, or `None` for the host
+    pub target: Option<String>,
+    /// Enabled language feature names
+    pub features: Vec<String>,
+    /// LLVM version the code generator links against
+    pub llvm_version: String,
 }
 
 /// Compilation inputs for caching
@@ -35,4 +43,26 @@ impl CompilationInputs {
             imports: Vec::new(),
         }
     }
+
+    /// Content digests of the source file and every imported module, in the
+    /// order they are fingerprinted. A file that cannot be read gets an
+    /// empty digest, which never matches a readable file.
+    pub fn digests(&self) -> Vec<InputDigest> {
+        let mut imports: Vec<std::path::PathBuf> = self
+            .imports
+            .iter()
+            .map(|import| canonical(std::path::Path::new(import)))
+            .collect();
+        imports.sort();
+        imports.dedup();
+
+        std::iter::once(canonical(&self.source_path))
+            .chain(imports)
+            .map(|path| InputDigest::of_file(&path))
+            .collect()
+    }
+}
+
+fn canonical(path: &std::path::Path) -> std::path::PathBuf {
+    path.canonicalize().unwrap_or_else(|_| path.to_path_buf())
 }
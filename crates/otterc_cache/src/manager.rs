@@ -1,9 +1,32 @@
 use std::collections::HashMap;
-use std::path::PathBuf;
+use std::fs;
+use std::io;
+use std::path::{Path, PathBuf};
+use std::time::SystemTime;
 
-/// Compilation cache manager
+use sha1::{Digest, Sha1};
+
+use super::metadata::CacheMetadata;
+use super::objects::touch;
+
+/// Bumped whenever the on-disk layout or the fingerprint recipe changes.
+const CACHE_FORMAT: &str = "otter-cache-v1";
+const METADATA_FILE: &str = "metadata.json";
+
+/// Compilation cache manager.
+///
+/// Entries live on disk under the cache directory:
+///
+/// - `entries/<key>/` holds a built program and its `metadata.json`;
+/// - `keys/<key>` names the entry for a fingerprint taken before imports
+///   were resolved, so unchanged programs hit without parsing;
+/// - `objects/` holds per-unit object code (see [`ObjectStore`](crate::ObjectStore)).
+///
+/// Keys are content fingerprints, and every lookup re-checks the recorded
+/// input digests, so an entry is never served for stale sources.
 pub struct CacheManager {
-    _cache_dir: PathBuf,
+    cache_dir: PathBuf,
+    max_cache_size: u64,
     entries: HashMap<String, CacheEntry>,
 }
 
@@ -19,7 +42,8 @@ pub struct CacheEntry {
 impl Default for CacheManager {
     fn default() -> Self {
         Self {
-            _cache_dir: PathBuf::from("./cache"),
+            cache_dir: PathBuf::from("./cache"),
+            max_cache_size: 1024 * 1024 * 1024,
             entries: HashMap::new(),
         }
     }
@@ -30,6 +54,14 @@ impl CacheManager {
         Self::default()
     }
 
+    pub fn with_options(options: &super::CacheBuildOptions) -> Self {
+        Self {
+            cache_dir: options.cache_dir.clone(),
+            max_cache_size: options.max_cache_size as u64,
+            entries: HashMap::new(),
+        }
+    }
+
     pub fn get(&self, key: &str) -> Option<&CacheEntry> {
         self.entries.get(key)
     }
@@ -42,36 +74,115 @@ impl CacheManager {
         self.entries.clear();
     }
 
+    /// Content fingerprint of a build: the source and imported modules by
+    /// content, the declared dependencies, every option that changes the
+    /// output, and the compiler and LLVM versions.
     pub fn fingerprint(
         &self,
-        _inputs: &super::CompilationInputs,
-        _options: &super::CacheBuildOptions,
-        _version: &str,
+        inputs: &super::CompilationInputs,
+        options: &super::CacheBuildOptions,
+        version: &str,
     ) -> String {
-        // Simple fingerprinting - in a real implementation this would hash the inputs
-        format!(
-            "cache_key_{}",
-            std::time::SystemTime::now()
-                .duration_since(std::time::UNIX_EPOCH)
-                .unwrap()
-                .as_secs()
-        )
+        let mut hasher = Sha1::new();
+        let mut field = |name: &str, value: &[u8]| {
+            hasher.update(name.as_bytes());
+            hasher.update((value.len() as u64).to_le_bytes());
+            hasher.update(value);
+        };
+
+        field("format", CACHE_FORMAT.as_bytes());
+        field("compiler", version.as_bytes());
+        field("llvm", options.llvm_version.as_bytes());
+        field(
+            "profile",
+            &[
+                options.release as u8,
+                options.lto as u8,
+                options.emit_ir as u8,
+            ],
+        );
+        field(
+            "target",
+            options.target.as_deref().unwrap_or("host").as_bytes(),
+        );
+        let mut features = options.features.clone();
+        features.sort();
+        for feature in &features {
+            field("feature", feature.as_bytes());
+        }
+        let mut dependencies = inputs.dependencies.clone();
+        dependencies.sort();
+        for dependency in &dependencies {
+            field("dependency", dependency.as_bytes());
+        }
+        for input in inputs.digests() {
+            field("input", input.path.to_string_lossy().as_bytes());
+            field("content", input.hash.as_bytes());
+        }
+
+        format!("{:x}", hasher.finalize())
     }
 
+    /// Returns a valid entry for `key`, following aliases recorded by
+    /// [`alias`](Self::alias). Entries whose binary or inputs changed are
+    /// removed.
     pub fn lookup(&self, key: &str) -> Option<CacheEntry> {
-        self.entries.get(key).cloned()
+        if let Some(entry) = self.entries.get(key) {
+            return Some(entry.clone());
+        }
+
+        let key = self.resolve(key)?;
+        let dir = self.entry_path(&key);
+        let metadata_path = dir.join(METADATA_FILE);
+        let metadata: CacheMetadata = fs::read(&metadata_path)
+            .ok()
+            .and_then(|bytes| serde_json::from_slice(&bytes).ok())?;
+
+        if metadata.key != key || !metadata.is_valid() {
+            let _ = fs::remove_dir_all(&dir);
+            return None;
+        }
+
+        touch(&metadata_path);
+        Some(CacheEntry {
+            path: dir,
+            last_modified: metadata.created_at,
+            size: metadata.binary_size,
+            binary_path: metadata.binary_path.clone(),
+            metadata,
+        })
     }
 
+    /// Where the program for `key` is built, inside its entry directory.
     pub fn binary_path(&self, key: &str) -> Option<PathBuf> {
-        self.entries.get(key).map(|entry| entry.binary_path.clone())
+        if let Some(entry) = self.entries.get(key) {
+            return Some(entry.binary_path.clone());
+        }
+        Some(
+            self.entry_path(key)
+                .join(format!("program{}", std::env::consts::EXE_SUFFIX)),
+        )
+    }
+
+    pub fn entry_path(&self, key: &str) -> PathBuf {
+        self.cache_dir.join("entries").join(key)
+    }
+
+    /// Directory for per-unit object code.
+    pub fn objects_dir(&self) -> PathBuf {
+        self.cache_dir.join("objects")
     }
 
     pub fn store(
         &mut self,
         metadata: &super::metadata::CacheMetadata,
     ) -> Result<(), Box<dyn std::error::Error>> {
+        let dir = self.entry_path(&metadata.key);
+        fs::create_dir_all(&dir)?;
+        write_atomic(&dir.join(METADATA_FILE), &serde_json::to_vec(metadata)?)?;
+
         let entry = CacheEntry {
-            path: metadata.cache_path.clone(),
+            path: dir,
             last_modified: metadata.created_at,
             size: metadata.binary_size,
             metadata: metadata.clone(),
@@ -80,4 +191,230 @@ impl CacheManager {
         self.entries.insert(metadata.key.clone(), entry);
         Ok(())
     }
+
+    /// Makes lookups of `alias` find the entry stored under `key`.
+    pub fn alias(&self, alias: &str, key: &str) -> io::Result<()> {
+        if alias == key {
+            return Ok(());
+        }
+        let dir = self.cache_dir.join("keys");
+        fs::create_dir_all(&dir)?;
+        write_atomic(&dir.join(alias), key.as_bytes())
+    }
+
+    /// Removes least recently used entries and objects until the cache fits
+    /// in its size limit, never touching the entry for `keep`. Returns the
+    /// number of bytes freed.
+    pub fn evict(&self, keep: &str) -> io::Result<u64> {
+        let mut candidates = Vec::new();
+        let mut total = 0u64;
+
+        for dir in read_dir_paths(&self.cache_dir.join("entries"))? {
+            let size = dir_size(&dir);
+            total += size;
+            if dir.file_name().is_some_and(|name| name == keep) {
+                continue;
+            }
+            let used = last_used(&dir.join(METADATA_FILE)).or_else(|| last_used(&dir));
+            candidates.push((used.unwrap_or(SystemTime::UNIX_EPOCH), size, dir));
+        }
+        for object in read_dir_paths(&self.objects_dir())? {
+            let size = fs::metadata(&object).map_or(0, |meta| meta.len());
+            total += size;
+            let used = last_used(&object).unwrap_or(SystemTime::UNIX_EPOCH);
+            candidates.push((used, size, object));
+        }
+
+        candidates.sort_by_key(|(used, _, _)| *used);
+        let mut freed = 0u64;
+        for (_, size, path) in candidates {
+            if total <= self.max_cache_size {
+                break;
+            }
+            let removed = if path.is_dir() {
+                fs::remove_dir_all(&path)
+            } else {
+                fs::remove_file(&path)
+            };
+            if removed.is_ok() {
+                total -= size;
+                freed += size;
+            }
+        }
+
+        // Drop aliases whose entry is gone.
+        for alias in read_dir_paths(&self.cache_dir.join("keys"))? {
+            let target = fs::read_to_string(&alias).unwrap_or_default();
+            if target.is_empty() || !self.entry_path(target.trim()).is_dir() {
+                let _ = fs::remove_file(&alias);
+            }
+        }
+
+        Ok(freed)
+    }
+
+    fn resolve(&self, key: &str) -> Option<String> {
+        if self.entry_path(key).is_dir() {
+            return Some(key.to_string());
+        }
+        let target = fs::read_to_string(self.cache_dir.join("keys").join(key)).ok()?;
+        Some(target.trim().to_string())
+    }
+}
+
+/// Writes through a temporary file and a rename, so readers see either the
+/// old content or the new one.
+fn write_atomic(path: &Path, contents: &[u8]) -> io::Result<()> {
+    let mut partial = path.as_os_str().to_owned();
+    partial.push(format!(".{}.partial", std::process::id()));
+    let partial = PathBuf::from(partial);
+    fs::write(&partial, contents)?;
+    fs::rename(&partial, path).inspect_err(|_| {
+        let _ = fs::remove_file(&partial);
+    })
+}
+
+fn read_dir_paths(dir: &Path) -> io::Result<Vec<PathBuf>> {
+    match fs::read_dir(dir) {
+        Ok(entries) => Ok(entries
+            .filter_map(|entry| entry.ok().map(|entry| entry.path()))
+            .collect()),
+        Err(err) if err.kind() == io::ErrorKind::NotFound => Ok(Vec::new()),
+        Err(err) => Err(err),
+    }
+}
+
+fn dir_size(dir: &Path) -> u64 {
+    read_dir_paths(dir)
+        .unwrap_or_default()
+        .iter()
+        .map(|path| match fs::symlink_metadata(path) {
+            Ok(meta) if meta.is_dir() => dir_size(path),
+            Ok(meta) => meta.len(),
+            Err(_) => 0,
+        })
+        .sum()
+}
+
+fn last_used(path: &Path) -> Option<SystemTime> {
+    fs::metadata(path).and_then(|meta| meta.modified()).ok()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{CacheBuildOptions, CompilationInputs};
+    use tempfile::TempDir;
+
+    fn options(dir: &Path) -> CacheBuildOptions {
+        CacheBuildOptions {
+            enable_cache: true,
+            cache_dir: dir.join("cache"),
+            max_cache_size: 1024 * 1024,
+            release: false,
+            lto: false,
+            emit_ir: false,
+            target: None,
+            features: Vec::new(),
+            llvm_version: "18.1".to_string(),
+        }
+    }
+
+    fn store_entry(manager: &mut CacheManager, inputs: &CompilationInputs, key: &str) -> PathBuf {
+        let binary = manager.binary_path(key).unwrap();
+        fs::create_dir_all(binary.parent().unwrap()).unwrap();
+        fs::write(&binary, vec![0u8; 10_000]).unwrap();
+        let metadata = CacheMetadata::new(
+            key.to_string(),
+            inputs.source_path.clone(),
+            Vec::new(),
+            binary.clone(),
+            10_000,
+            1,
+            manager.entry_path(key),
+        )
+        .with_inputs(inputs.digests());
+        manager.store(&metadata).unwrap();
+        binary
+    }
+
+    #[test]
+    fn fingerprint_tracks_content_and_options() {
+        let temp = TempDir::new().unwrap();
+        let source = temp.path().join("main.ot");
+        let module = temp.path().join("util.ot");
+        fs::write(&source, "fn main():\n    pass\n").unwrap();
+        fs::write(&module, "fn helper():\n    pass\n").unwrap();
+
+        let manager = CacheManager::new();
+        let mut options = options(temp.path());
+        let mut inputs = CompilationInputs::new(source.clone(), Vec::new());
+        let base = manager.fingerprint(&inputs, &options, "0.1.0");
+        assert_eq!(base, manager.fingerprint(&inputs, &options, "0.1.0"));
+        assert_ne!(base, manager.fingerprint(&inputs, &options, "0.2.0"));
+
+        inputs.imports = vec![module.display().to_string()];
+        let with_module = manager.fingerprint(&inputs, &options, "0.1.0");
+        assert_ne!(base, with_module);
+
+        fs::write(&module, "fn helper():\n    return\n").unwrap();
+        assert_ne!(with_module, manager.fingerprint(&inputs, &options, "0.1.0"));
+
+        options.release = true;
+        let release = manager.fingerprint(&inputs, &options, "0.1.0");
+        options.llvm_version = "19.1".to_string();
+        assert_ne!(release, manager.fingerprint(&inputs, &options, "0.1.0"));
+    }
+
+    #[test]
+    fn lookup_revalidates_inputs_through_aliases() {
+        let temp = TempDir::new().unwrap();
+        let source = temp.path().join("main.ot");
+        let module = temp.path().join("util.ot");
+        fs::write(&source, "use util\n").unwrap();
+        fs::write(&module, "fn helper():\n    pass\n").unwrap();
+
+        let options = options(temp.path());
+        let mut manager = CacheManager::with_options(&options);
+        let mut inputs = CompilationInputs::new(source.clone(), Vec::new());
+        let initial = manager.fingerprint(&inputs, &options, "0.1.0");
+        inputs.imports = vec![module.display().to_string()];
+        let full = manager.fingerprint(&inputs, &options, "0.1.0");
+        store_entry(&mut manager, &inputs, &full);
+        manager.alias(&initial, &full).unwrap();
+
+        // A fresh manager only has the disk to go on.
+        let manager = CacheManager::with_options(&options);
+        assert!(manager.lookup(&initial).is_some());
+        assert!(manager.lookup(&full).is_some());
+
+        fs::write(&module, "fn helper():\n    return\n").unwrap();
+        assert!(manager.lookup(&initial).is_none());
+        assert!(!manager.entry_path(&full).exists());
+    }
+
+    #[test]
+    fn evict_removes_least_recently_used_first() {
+        let temp = TempDir::new().unwrap();
+        let source = temp.path().join("main.ot");
+        fs::write(&source, "fn main():\n    pass\n").unwrap();
+
+        let mut options = options(temp.path());
+        options.max_cache_size = 25_000;
+        let mut manager = CacheManager::with_options(&options);
+        let inputs = CompilationInputs::new(source.clone(), Vec::new());
+        for key in ["a", "b", "c"] {
+            store_entry(&mut manager, &inputs, key);
+            std::thread::sleep(std::time::Duration::from_millis(20));
+        }
+
+        let manager = CacheManager::with_options(&options);
+        // Using "a" makes "b" the oldest.
+        assert!(manager.lookup("a").is_some());
+        manager.evict("c").unwrap();
+
+        assert!(manager.entry_path("a").exists());
+        assert!(!manager.entry_path("b").exists());
+        assert!(manager.entry_path("c").exists());
+    }
 }
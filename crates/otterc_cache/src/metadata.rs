@@ -1,5 +1,6 @@
 use serde::{Deserialize, Serialize};
-use std::{fs, path::PathBuf};
+use sha1::{Digest, Sha1};
+use std::{fs, path::Path, path::PathBuf};
 
 /// Cache metadata
 #[derive(Debug, Clone, Serialize, Deserialize)]
@@ -13,6 +14,36 @@ pub struct CacheMetadata {
     pub binary_size: u64,
     pub build_time_ms: u64,
     pub llvm_version: Option<String>,
+    /// Content digests of every file the binary was built from
+    #[serde(default)]
+    pub inputs: Vec<InputDigest>,
+}
+
+/// The content hash of one compilation input
+#[derive(Debug, Clone, PartialEq, Eq, Serialize, Deserialize)]
+pub struct InputDigest {
+    pub path: PathBuf,
+    pub hash: String,
+}
+
+impl InputDigest {
+    pub fn of_file(path: &Path) -> Self {
+        Self {
+            path: path.to_path_buf(),
+            hash: file_digest(path).unwrap_or_default(),
+        }
+    }
+
+    /// Whether the file still has the recorded content.
+    pub fn is_current(&self) -> bool {
+        !self.hash.is_empty() && file_digest(&self.path).as_deref() == Some(self.hash.as_str())
+    }
+}
+
+/// Hex SHA-1 of a file's content, or `None` when it cannot be read.
+pub(crate) fn file_digest(path: &Path) -> Option<String> {
+    let content = fs::read(path).ok()?;
+    Some(format!("{:x}", Sha1::digest(&content)))
 }
 
 impl CacheMetadata {
@@ -38,6 +69,7 @@ impl CacheMetadata {
             binary_size,
             build_time_ms,
             llvm_version: None,
+            inputs: Vec::new(),
         }
     }
 
@@ -46,24 +78,22 @@ impl CacheMetadata {
         self.clone()
     }
 
+    pub fn with_inputs(mut self, inputs: Vec<InputDigest>) -> Self {
+        self.inputs = inputs;
+        self
+    }
+
     pub fn binary_size(&self) -> u64 {
         self.binary_size
     }
 
+    /// Checks that the cached binary is intact and that every input still
+    /// has the content it was built from. Modification times are not
+    /// trusted: checkouts and copies change them without changing content.
     pub fn is_valid(&self) -> bool {
-        // Check if source file still exists and hasn't been modified
-
-        if let Ok(metadata) = fs::metadata(&self.source_path)
-            && let Ok(modified) = metadata.modified()
-        {
-            let modified_secs = modified
-                .duration_since(std::time::UNIX_EPOCH)
-                .unwrap()
-                .as_secs();
-
-            return modified_secs <= self.created_at;
-        }
+        let binary_intact = fs::metadata(&self.binary_path)
+            .is_ok_and(|binary| binary.is_file() && binary.len() == self.binary_size);
 
-        false
+        binary_intact && !self.inputs.is_empty() && self.inputs.iter().all(InputDigest::is_current)
     }
 }
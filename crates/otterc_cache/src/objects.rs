@@ -0,0 +1,93 @@
+use std::fs;
+use std::io;
+use std::path::{Path, PathBuf};
+use std::time::SystemTime;
+
+/// Content-addressed store for compiled object files.
+///
+/// Objects are keyed by a hash of whatever produced them, so a key never
+/// needs invalidating: changed code simply hashes to a new key, and the old
+/// object ages out through [`CacheManager::evict`](crate::CacheManager::evict).
+#[derive(Debug, Clone)]
+pub struct ObjectStore {
+    dir: PathBuf,
+}
+
+impl ObjectStore {
+    pub fn open(dir: impl Into<PathBuf>) -> io::Result<Self> {
+        let dir = dir.into();
+        fs::create_dir_all(&dir)?;
+        Ok(Self { dir })
+    }
+
+    pub fn path(&self, key: &str) -> PathBuf {
+        self.dir.join(format!("{key}.o"))
+    }
+
+    /// Copies the object stored under `key` to `dest`, returning `false`
+    /// when there is none. A hit counts as a use for eviction.
+    ///
+    /// Objects are always copied, never hard-linked, in both directions:
+    /// `dest` and the stored object's source are build-directory paths that
+    /// later builds overwrite in place, which would rewrite a linked cache
+    /// entry too.
+    pub fn fetch(&self, key: &str, dest: &Path) -> bool {
+        let cached = self.path(key);
+        if !cached.is_file() {
+            return false;
+        }
+        let _ = fs::remove_file(dest);
+        if fs::copy(&cached, dest).is_err() {
+            return false;
+        }
+        touch(&cached);
+        true
+    }
+
+    /// Stores a copy of `object` under `key`.
+    pub fn store(&self, key: &str, object: &Path) -> io::Result<()> {
+        let cached = self.path(key);
+        // Publish through a unique name and a rename, so concurrent builds
+        // never see a partially written object.
+        let partial = self
+            .dir
+            .join(format!("{key}.{}.partial", std::process::id()));
+        let _ = fs::remove_file(&partial);
+        fs::copy(object, &partial)?;
+        fs::rename(&partial, &cached).inspect_err(|_| {
+            let _ = fs::remove_file(&partial);
+        })
+    }
+}
+
+/// Marks a cache file as just used; eviction removes the oldest first.
+pub(crate) fn touch(path: &Path) {
+    if let Ok(file) = fs::File::options().write(true).open(path) {
+        let _ = file.set_modified(SystemTime::now());
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use tempfile::TempDir;
+
+    #[test]
+    fn rewriting_build_objects_leaves_the_store_intact() {
+        let temp = TempDir::new().unwrap();
+        let store = ObjectStore::open(temp.path().join("objects")).unwrap();
+        let object = temp.path().join("main.cgu0.o");
+        fs::write(&object, b"first").unwrap();
+        store.store("key", &object).unwrap();
+
+        // Builds write objects in place, truncating whatever is there.
+        fs::write(&object, b"second").unwrap();
+        assert_eq!(fs::read(store.path("key")).unwrap(), b"first");
+
+        let fetched = temp.path().join("main.cgu1.o");
+        assert!(store.fetch("key", &fetched));
+        fs::write(&fetched, b"third").unwrap();
+        assert_eq!(fs::read(store.path("key")).unwrap(), b"first");
+        assert!(!store.fetch("missing", &fetched));
+    }
+}
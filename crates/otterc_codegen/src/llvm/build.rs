@@ -3,27 +3,177 @@ use std::env;
 use std::fs;
 use std::path::{Path, PathBuf};
 use std::process::Command;
+use std::thread;
 
 use anyhow::{Context, Result, anyhow, bail};
 use glob::glob;
 use inkwell::OptimizationLevel;
+use inkwell::attributes::AttributeLoc;
 use inkwell::context::Context as LlvmContext;
-use inkwell::targets::{CodeModel, FileType, InitializationConfig, RelocMode, Target};
+use inkwell::module::{Linkage, Module};
+use inkwell::targets::{
+    CodeModel, FileType, InitializationConfig, RelocMode, Target, TargetMachine,
+};
 use otterc_ast::nodes::Program;
+use otterc_cache::ObjectStore;
+use otterc_metrics::profiler::CompilationProfiler;
 use otterc_span::Span;
 
 use otterc_config::{CodegenOptLevel, CodegenOptions, TargetTriple};
 use otterc_typecheck::{EnumLayout, TypeInfo};
 
 use super::bridges::prepare_rust_bridges;
+use super::codegen_units::{MachineSpec, emit_objects};
 use super::compiler::Compiler;
-use super::config::{BuildArtifact, llvm_triple_to_string, preferred_target_flag};
-
-const RUNTIME_CODE_STANDARD: &str = include_str!("runtimes/standard.c");
-const RUNTIME_CODE_EMBEDDED: &str = include_str!("runtimes/embedded.c");
-const RUNTIME_CODE_WASM: &str = include_str!("runtimes/wasm.c");
+use super::config::{
+    BuildArtifact, bitcode_compiler, llvm_triple_to_string, preferred_fast_linker,
+    preferred_target_flag,
+};
+use super::runtime_cache::{RuntimeArtifact, compile_runtime_object};
+
+// Each C runtime is emitted as a single translation unit with the shared
+// UTF-8 and number formatting kernels prepended, so the runtimes never carry
+// their own copies. The hosted runtimes also get the runtime counters and
+// the shared layer for header-tagged runtime strings.
+const RUNTIME_CODE_STANDARD: &str = concat!(
+    include_str!("runtimes/utf8.c"),
+    include_str!("runtimes/numfmt.c"),
+    include_str!("runtimes/stats.c"),
+    include_str!("runtimes/strings.c"),
+    include_str!("runtimes/standard.c")
+);
+const RUNTIME_CODE_EMBEDDED: &str = concat!(
+    "#define OTTER_UTF8_SCALAR_ONLY 1\n",
+    include_str!("runtimes/utf8.c"),
+    include_str!("runtimes/numfmt.c"),
+    include_str!("runtimes/embedded.c")
+);
+const RUNTIME_CODE_WASM: &str = concat!(
+    include_str!("runtimes/utf8.c"),
+    include_str!("runtimes/numfmt.c"),
+    include_str!("runtimes/stats.c"),
+    include_str!("runtimes/strings.c"),
+    include_str!("runtimes/wasm.c")
+);
 const RUNTIME_CODE_SHIM: &str = include_str!("runtimes/shim.c");
 
+/// Flags used to compile the C runtime, apart from `-c`, input and output.
+/// The runtime is optimized like the program itself, and emitted as LTO
+/// bitcode when the final link runs with `-flto`.
+fn runtime_c_flags(
+    runtime_triple: &TargetTriple,
+    c_compiler: &str,
+    cross_triple: Option<&str>,
+    options: &CodegenOptions,
+) -> Vec<String> {
+    let mut flags = Vec::new();
+    if runtime_triple.needs_pic() && !runtime_triple.is_windows() {
+        flags.push("-fPIC".to_string());
+    }
+
+    // Add macOS version minimum
+    if runtime_triple.os == "darwin" {
+        flags.push("-mmacosx-version-min=11.0".to_string());
+    }
+
+    // Add target triple for cross-compilation
+    if let Some(triple) = cross_triple {
+        flags.push(preferred_target_flag(c_compiler).to_string());
+        flags.push(triple.to_string());
+    }
+
+    flags.push(
+        match options.opt_level {
+            CodegenOptLevel::None => "-O0",
+            CodegenOptLevel::Default => "-O2",
+            CodegenOptLevel::Aggressive => "-O3",
+        }
+        .to_string(),
+    );
+    if options.enable_lto {
+        flags.push("-flto".to_string());
+    }
+    flags
+}
+
+/// Compiles the C runtime to bitcode for the module's target and links it
+/// into `module`. Every runtime definition except `main` and the wasm
+/// runtime's host exports is then made internal, so the pass pipeline can
+/// inline runtime calls into the program and drop whatever the program does
+/// not use.
+///
+/// Returns `Ok(false)`, leaving `module` untouched, when no clang driver is
+/// available or this LLVM cannot read the bitcode it produced; the caller
+/// then links the runtime as a native object instead.
+#[expect(clippy::too_many_arguments, reason = "Mirrors the build inputs")]
+fn link_runtime_bitcode<'ctx>(
+    context: &'ctx LlvmContext,
+    module: &Module<'ctx>,
+    source: &str,
+    runtime_triple: &TargetTriple,
+    triple_str: &str,
+    target_machine: &TargetMachine,
+    options: &CodegenOptions,
+    fallback_dir: &Path,
+) -> Result<bool> {
+    let clang = bitcode_compiler(&runtime_triple.c_compiler());
+    let mut flags = runtime_c_flags(runtime_triple, &clang, Some(triple_str), options);
+    // The bitcode is optimized again with the program; LTO has nothing to add.
+    flags.retain(|flag| flag != "-flto");
+
+    let Ok(bitcode) = compile_runtime_object(
+        source,
+        &clang,
+        triple_str,
+        &flags,
+        RuntimeArtifact::Bitcode,
+        fallback_dir,
+    ) else {
+        return Ok(false);
+    };
+    let Ok(runtime_module) = Module::parse_bitcode_from_path(&bitcode.path, context) else {
+        return Ok(false);
+    };
+
+    runtime_module.set_triple(&module.get_triple());
+    runtime_module.set_data_layout(&target_machine.get_target_data().get_data_layout());
+
+    // Functions the wasm runtime exports to its host by name stay external.
+    let defined_functions: Vec<String> = runtime_module
+        .get_functions()
+        .filter(|function| function.count_basic_blocks() > 0)
+        .filter(|function| {
+            function
+                .get_string_attribute(AttributeLoc::Function, "wasm-export-name")
+                .is_none()
+        })
+        .map(|function| function.get_name().to_string_lossy().into_owned())
+        .filter(|name| name != "main")
+        .collect();
+    let defined_globals: Vec<String> = runtime_module
+        .get_globals()
+        .filter(|global| global.get_initializer().is_some())
+        .map(|global| global.get_name().to_string_lossy().into_owned())
+        .collect();
+
+    module
+        .link_in_module(runtime_module)
+        .map_err(|e| anyhow!("failed to link runtime bitcode: {e}"))?;
+
+    for name in &defined_functions {
+        if let Some(function) = module.get_function(name) {
+            function.set_linkage(Linkage::Internal);
+        }
+    }
+    for name in &defined_globals {
+        if let Some(global) = module.get_global(name) {
+            global.set_linkage(Linkage::Internal);
+        }
+    }
+
+    Ok(true)
+}
+
 /// Check if a library is available on the system
 fn check_library_available(lib_name: &str) -> bool {
     // Try pkg-config first
@@ -72,7 +222,8 @@ fn check_library_available(lib_name: &str) -> bool {
 }
 
 pub fn current_llvm_version() -> String {
-    "15.0".to_string()
+    let (major, minor, patch) = inkwell::support::get_llvm_version();
+    format!("{major}.{minor}.{patch}")
 }
 
 /// Find the Rust runtime static library
@@ -128,11 +279,13 @@ pub fn build_executable(
     output: &Path,
     options: &CodegenOptions,
 ) -> Result<BuildArtifact> {
+    let profiler = CompilationProfiler::new();
     let context = LlvmContext::create();
     let module = context.create_module("otter");
     let builder = context.create_builder();
     let registry = otterc_ffi::bootstrap_stdlib();
-    let bridge_libraries = prepare_rust_bridges(program, registry)?;
+    let bridge_libraries =
+        profiler.time_phase("rust bridges", || prepare_rust_bridges(program, registry))?;
 
     // Determine target triple early so compiler can use it for ABI decisions
     Target::initialize_all(&InitializationConfig::default());
@@ -154,10 +307,10 @@ pub fn build_executable(
         Some(runtime_triple.clone()),
     );
 
-    compiler.lower_program(program, true)?; // Require main for executables
-    compiler
-        .module
-        .verify()
+    // Require main for executables
+    profiler.time_phase("lower", || compiler.lower_program(program, true))?;
+    profiler
+        .time_phase("verify", || compiler.module.verify())
         .map_err(|e| anyhow!("LLVM module verification failed: {e}"))?;
 
     if options.emit_ir {
@@ -177,9 +330,6 @@ pub fn build_executable(
         llvm_triple_to_string(&llvm_triple) == llvm_triple_to_string(&native_triple);
     compiler.module.set_triple(&llvm_triple);
 
-    let target = Target::from_triple(&llvm_triple)
-        .map_err(|e| anyhow!("failed to create target from triple {}: {e}", triple_str))?;
-
     let optimization: OptimizationLevel = options.opt_level.into();
     let reloc_mode = if runtime_triple.needs_pic() {
         RelocMode::PIC
@@ -194,101 +344,114 @@ pub fn build_executable(
         ("generic", "")
     };
 
-    let target_machine = target
-        .create_target_machine(
-            &llvm_triple,
-            cpu,
-            features,
-            optimization,
-            reloc_mode,
-            CodeModel::Default,
-        )
-        .ok_or_else(|| anyhow!("failed to create target machine"))?;
+    // Kept around so codegen worker threads can build their own machines.
+    let machine_spec = MachineSpec {
+        triple: triple_str.clone(),
+        cpu,
+        features,
+        optimization,
+        reloc_mode,
+    };
+    let target_machine = machine_spec.create()?;
 
     compiler
         .module
         .set_data_layout(&target_machine.get_target_data().get_data_layout());
 
-    compiler.run_default_passes(
-        options.opt_level,
-        options.enable_pgo,
-        options.pgo_profile_file.as_deref(),
-        options.inline_threshold,
-        &target_machine,
-    );
-
     if let Some(parent) = output.parent() {
         fs::create_dir_all(parent)
             .with_context(|| format!("failed to create output directory {}", parent.display()))?;
     }
 
-    let object_path = output.with_extension("o");
-    target_machine
-        .write_to_file(&compiler.module, FileType::Object, &object_path)
-        .map_err(|e| {
-            anyhow!(
-                "failed to emit object file at {}: {e}",
-                object_path.display()
-            )
-        })?;
-
     // Build and link the runtime static library (check once)
     let runtime_lib = find_runtime_library(&runtime_triple)?;
     let use_rust_runtime = runtime_lib.exists();
 
-    // Create a C runtime shim for the FFI functions (target-specific)
-    let runtime_c = if runtime_triple.is_wasm() {
-        None
+    // Select the C runtime (target-specific). It is linked into the module as
+    // bitcode when possible, so the passes below can inline and strip it.
+    let runtime_c_content = if runtime_triple.is_wasm() {
+        RUNTIME_CODE_WASM
+    } else if use_rust_runtime {
+        RUNTIME_CODE_SHIM
+    } else if runtime_triple.is_embedded() {
+        RUNTIME_CODE_EMBEDDED
     } else {
-        let runtime_c = output.with_extension("runtime.c");
-        let runtime_c_content = if use_rust_runtime {
-            RUNTIME_CODE_SHIM.to_string()
-        } else if runtime_triple.is_wasm() {
-            RUNTIME_CODE_WASM.to_string()
-        } else if runtime_triple.is_embedded() {
-            RUNTIME_CODE_EMBEDDED.to_string()
-        } else {
-            RUNTIME_CODE_STANDARD.to_string()
-        };
-        fs::write(&runtime_c, runtime_c_content).context("failed to write runtime C file")?;
-        Some(runtime_c)
+        RUNTIME_CODE_STANDARD
     };
+    let runtime_fallback_dir = output.parent().unwrap_or(Path::new("."));
+    let runtime_in_module = profiler.time_phase("runtime bitcode", || {
+        link_runtime_bitcode(
+            &context,
+            &compiler.module,
+            runtime_c_content,
+            &runtime_triple,
+            &triple_str,
+            &target_machine,
+            options,
+            runtime_fallback_dir,
+        )
+    })?;
+
+    profiler.time_phase("optimize", || {
+        compiler.run_default_passes(
+            options.opt_level,
+            options.enable_pgo,
+            options.pgo_profile_file.as_deref(),
+            options.inline_threshold,
+            &target_machine,
+        )
+    });
 
-    // Compile runtime C file (target-specific)
-    let runtime_o = if let Some(ref rt_c) = runtime_c {
-        let runtime_o = output.with_extension("runtime.o");
-        let c_compiler = runtime_triple.c_compiler();
-        let mut cc = Command::new(&c_compiler);
-
-        // Add target-specific compiler flags
-        cc.arg("-c");
-        if runtime_triple.needs_pic() && !runtime_triple.is_windows() {
-            cc.arg("-fPIC");
-        }
-
-        // Add macOS version minimum
-        if runtime_triple.os == "darwin" {
-            cc.arg("-mmacosx-version-min=11.0");
-        }
-
-        // Add target triple for cross-compilation (skip for native target)
-        if !is_native_target {
-            let compiler_target_flag = preferred_target_flag(&c_compiler);
-            cc.arg(compiler_target_flag).arg(&triple_str);
-        }
-
-        cc.arg(rt_c).arg("-o").arg(&runtime_o);
-
-        let cc_status = cc.status().context("failed to compile runtime C file")?;
-
-        if !cc_status.success() {
-            bail!("failed to compile runtime C file");
-        }
+    // Unit objects are reused across builds when the caller supplies a
+    // cache; without a usable directory every unit is simply emitted.
+    let object_cache = options
+        .object_cache_dir
+        .as_ref()
+        .and_then(|dir| ObjectStore::open(dir).ok());
 
-        Some(runtime_o)
-    } else {
-        None
-    };
+    // Otherwise compile (or reuse) it as an object for the system linker,
+    // on its own thread while LLVM emits the program's objects.
+    let object_path = output.with_extension("o");
+    let (object_paths, runtime_o) = thread::scope(|scope| {
+        let runtime_job = (!runtime_in_module && !runtime_triple.is_wasm()).then(|| {
+            scope.spawn(|| {
+                profiler.time_phase("runtime object", || {
+                    let c_compiler = runtime_triple.c_compiler();
+                    let flags = runtime_c_flags(
+                        &runtime_triple,
+                        &c_compiler,
+                        (!is_native_target).then_some(triple_str.as_str()),
+                        options,
+                    );
+                    compile_runtime_object(
+                        runtime_c_content,
+                        &c_compiler,
+                        &triple_str,
+                        &flags,
+                        RuntimeArtifact::Object,
+                        runtime_fallback_dir,
+                    )
+                })
+            })
+        });
+
+        let objects = profiler.time_phase("emit objects", || {
+            emit_objects(
+                &compiler.module,
+                &target_machine,
+                &machine_spec,
+                &object_path,
+                object_cache.as_ref(),
+            )
+        });
+        let runtime_o = runtime_job
+            .map(|job| {
+                job.join()
+                    .map_err(|_| anyhow!("runtime compilation thread panicked"))?
+            })
+            .transpose();
+        anyhow::Ok((objects?, runtime_o?))
+    })?;
 
     // Link the object files together (target-specific)
     let linker = runtime_triple.linker();
@@ -302,7 +465,7 @@ pub fn build_executable(
             .arg(&triple_str)
             .arg("--no-entry")
             .arg("--export-dynamic")
-            .arg(&object_path)
+            .args(&object_paths)
             .arg("-o")
             .arg(output);
     } else {
@@ -333,11 +496,18 @@ pub fn build_executable(
             cc.arg(format!("-Wl,/LIBPATH:{}", path.display()));
         }
 
-        // Always link the generated object first
-        cc.arg(&object_path);
+        // Prefer mold or lld over the platform default where both work
+        if matches!(runtime_triple.os.as_str(), "linux" | "freebsd")
+            && let Some(fast_linker) = preferred_fast_linker(&linker, options.enable_lto)
+        {
+            cc.arg(format!("-fuse-ld={fast_linker}"));
+        }
+
+        // Always link the generated objects first
+        cc.args(&object_paths);
 
         if let Some(ref rt_o) = runtime_o {
-            cc.arg(rt_o);
+            cc.arg(&rt_o.path);
         }
 
         // Delay specifying the output until after we've queued all inputs and flags
@@ -462,25 +632,23 @@ pub fn build_executable(
         cc.arg("-v");
     }
 
-    let status = cc.status().context("failed to invoke system linker (cc)")?;
+    let status = profiler
+        .time_phase("link", || cc.status())
+        .context("failed to invoke system linker (cc)")?;
 
     if !status.success() {
         bail!("linker invocation failed with status {status}");
     }
 
-    // Clean up temporary files
-    if let Some(ref rt_c) = runtime_c {
-        fs::remove_file(rt_c)?;
-    }
-    if let Some(ref rt_o) = runtime_o {
-        fs::remove_file(rt_o)?;
+    // Clean up temporary files (a cached runtime object stays in the cache)
+    for object in &object_paths {
+        fs::remove_file(object)?;
     }
 
-    fs::remove_file(&object_path)?;
-
     Ok(BuildArtifact {
         binary: output.to_path_buf(),
         ir: compiler.cached_ir.take(),
+        phases: profiler.get_phases(),
     })
 }
 
@@ -569,6 +737,32 @@ pub fn build_shared_library(
         .module
         .set_data_layout(&target_machine.get_target_data().get_data_layout());
 
+    if let Some(parent) = output.parent() {
+        fs::create_dir_all(parent)
+            .with_context(|| format!("failed to create output directory {}", parent.display()))?;
+    }
+
+    // Select the C runtime (target-specific). It is linked into the module as
+    // bitcode when possible, so the passes below can inline and strip it.
+    let runtime_c_content = if runtime_triple.is_wasm() {
+        RUNTIME_CODE_WASM
+    } else if runtime_triple.is_embedded() {
+        RUNTIME_CODE_EMBEDDED
+    } else {
+        RUNTIME_CODE_STANDARD
+    };
+    let runtime_fallback_dir = output.parent().unwrap_or(Path::new("."));
+    let runtime_in_module = link_runtime_bitcode(
+        &context,
+        &compiler.module,
+        runtime_c_content,
+        &runtime_triple,
+        &triple_str,
+        &target_machine,
+        options,
+        runtime_fallback_dir,
+    )?;
+
     compiler.run_default_passes(
         options.opt_level,
         options.enable_pgo,
@@ -577,11 +771,6 @@ pub fn build_shared_library(
         &target_machine,
     );
 
-    if let Some(parent) = output.parent() {
-        fs::create_dir_all(parent)
-            .with_context(|| format!("failed to create output directory {}", parent.display()))?;
-    }
-
     // Compile to object file with position-independent code
     let object_path = output.with_extension("o");
     target_machine
@@ -593,53 +782,25 @@ pub fn build_shared_library(
             )
         })?;
 
-    // Create runtime C file (target-specific)
-    let runtime_c = if runtime_triple.is_wasm() {
+    // Otherwise compile (or reuse) it as an object for the system linker
+    let runtime_o = if runtime_in_module || runtime_triple.is_wasm() {
         None
     } else {
-        let runtime_c = output.with_extension("runtime.c");
-        let runtime_c_content = if runtime_triple.is_wasm() {
-            RUNTIME_CODE_WASM.to_string()
-        } else if runtime_triple.is_embedded() {
-            RUNTIME_CODE_EMBEDDED.to_string()
-        } else {
-            RUNTIME_CODE_STANDARD.to_string()
-        };
-        fs::write(&runtime_c, runtime_c_content).context("failed to write runtime C file")?;
-        Some(runtime_c)
-    };
-
-    // Compile runtime C file (target-specific)
-    let runtime_o = if let Some(ref rt_c) = runtime_c {
-        let runtime_o = output.with_extension("runtime.o");
         let c_compiler = runtime_triple.c_compiler();
-        let mut cc = Command::new(&c_compiler);
-
-        // Add target-specific compiler flags
-        cc.arg("-c");
-        if runtime_triple.needs_pic() && !runtime_triple.is_windows() {
-            cc.arg("-fPIC");
-        }
-
-        // Add macOS version minimum
-        if runtime_triple.os == "darwin" {
-            cc.arg("-mmacosx-version-min=11.0");
-        }
-
-        let compiler_target_flag = preferred_target_flag(&c_compiler);
-        cc.arg(compiler_target_flag).arg(&triple_str);
-
-        cc.arg(rt_c).arg("-o").arg(&runtime_o);
-
-        let cc_status = cc.status().context("failed to compile runtime C file")?;
-
-        if !cc_status.success() {
-            bail!("failed to compile runtime C file");
-        }
-
-        Some(runtime_o)
-    } else {
-        None
+        let flags = runtime_c_flags(
+            &runtime_triple,
+            &c_compiler,
+            Some(triple_str.as_str()),
+            options,
+        );
+        Some(compile_runtime_object(
+            runtime_c_content,
+            &c_compiler,
+            &triple_str,
+            &flags,
+            RuntimeArtifact::Object,
+            runtime_fallback_dir,
+        )?)
     };
 
     // Determine shared library extension (target-specific)
@@ -691,7 +852,7 @@ pub fn build_shared_library(
         }
 
         if let Some(ref rt_o) = runtime_o {
-            cc.arg(rt_o);
+            cc.arg(&rt_o.path);
         }
 
         cc.arg("-o").arg(&lib_path).arg(&object_path);
@@ -793,17 +954,66 @@ pub fn build_shared_library(
         bail!("linker invocation failed with status {status}");
     }
 
-    // Clean up temporary files
-    if let Some(ref rt_c) = runtime_c {
-        fs::remove_file(rt_c)?;
-    }
-    if let Some(ref rt_o) = runtime_o {
-        fs::remove_file(rt_o)?;
-    }
+    // Clean up temporary files (a cached runtime object stays in the cache)
     fs::remove_file(&object_path)?;
 
     Ok(BuildArtifact {
         binary: lib_path,
         ir: compiler.cached_ir.take(),
+        phases: Vec::new(),
     })
 }
+
+#[cfg(all(test, target_os = "linux"))]
+mod tests {
+    use std::path::Path;
+    use std::process::Command;
+
+    /// Builds each C driver in runtimes/tests against the standard runtime
+    /// and the wasm runtime compiled for the host, and runs it.
+    #[test]
+    fn runtime_c_tests_pass() {
+        let tests_dir = Path::new(env!("CARGO_MANIFEST_DIR")).join("src/llvm/runtimes/tests");
+        let out_dir =
+            std::env::temp_dir().join(format!("otter-runtime-tests-{}", std::process::id()));
+        std::fs::create_dir_all(&out_dir).unwrap();
+
+        let mut drivers: Vec<_> = std::fs::read_dir(&tests_dir)
+            .unwrap()
+            .map(|entry| entry.unwrap().path())
+            .filter(|path| path.extension().is_some_and(|ext| ext == "c"))
+            .collect();
+        drivers.sort();
+        assert!(
+            !drivers.is_empty(),
+            "no C drivers in {}",
+            tests_dir.display()
+        );
+
+        for driver in &drivers {
+            for (variant, defines) in [
+                ("standard", &[][..]),
+                ("wasm", &["-DOTTER_TEST_WASM_RUNTIME"][..]),
+            ] {
+                let stem = driver.file_stem().unwrap().to_string_lossy();
+                let binary = out_dir.join(format!("{stem}-{variant}"));
+                let status = Command::new("cc")
+                    .args(["-O2", "-Wall", "-Wextra", "-Werror"])
+                    .args(defines)
+                    .arg("-o")
+                    .arg(&binary)
+                    .arg(driver)
+                    .status()
+                    .expect("failed to invoke cc");
+                assert!(status.success(), "{stem} ({variant}) failed to compile");
+                let output = Command::new(&binary).output().unwrap();
+                assert!(
+                    output.status.success(),
+                    "{stem} ({variant}) failed:\n{}",
+                    String::from_utf8_lossy(&output.stderr)
+                );
+            }
+        }
+        let _ = std::fs::remove_dir_all(&out_dir);
+    }
+}
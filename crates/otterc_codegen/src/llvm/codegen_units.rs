@@ -0,0 +1,401 @@
+use std::collections::HashSet;
+use std::env;
+use std::fs;
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::thread;
+
+use anyhow::{Result, anyhow};
+use inkwell::GlobalVisibility;
+use inkwell::OptimizationLevel;
+use inkwell::context::Context as LlvmContext;
+use inkwell::memory_buffer::MemoryBuffer;
+use inkwell::module::{Linkage, Module};
+use inkwell::passes::PassBuilderOptions;
+use inkwell::targets::{CodeModel, FileType, RelocMode, Target, TargetMachine, TargetTriple};
+use inkwell::values::{FunctionValue, GlobalValue};
+use otterc_cache::ObjectStore;
+use sha1::{Digest, Sha1};
+
+/// Below this many instructions per unit, splitting costs more (bitcode
+/// round trip, one backend setup per unit) than the parallelism saves.
+const MIN_UNIT_INSTRUCTIONS: usize = 20_000;
+const MAX_CODEGEN_UNITS: usize = 16;
+/// Cached builds split finer, so an edit invalidates less object code.
+const CACHED_UNIT_INSTRUCTIONS: usize = 4_000;
+const MAX_CACHED_UNITS: usize = 32;
+
+/// Everything needed to create an identical [`TargetMachine`] on another
+/// thread; LLVM target machines cannot be shared between threads.
+pub(crate) struct MachineSpec {
+    pub(crate) triple: String,
+    pub(crate) cpu: &'static str,
+    pub(crate) features: &'static str,
+    pub(crate) optimization: OptimizationLevel,
+    pub(crate) reloc_mode: RelocMode,
+}
+
+impl MachineSpec {
+    pub(crate) fn create(&self) -> Result<TargetMachine> {
+        let triple = TargetTriple::create(&self.triple);
+        let target = Target::from_triple(&triple)
+            .map_err(|e| anyhow!("failed to create target from triple {}: {e}", self.triple))?;
+        target
+            .create_target_machine(
+                &triple,
+                self.cpu,
+                self.features,
+                self.optimization,
+                self.reloc_mode,
+                CodeModel::Default,
+            )
+            .ok_or_else(|| anyhow!("failed to create target machine"))
+    }
+}
+
+/// Emits the optimized `module` as one or more object files next to
+/// `object_path` and returns their paths.
+///
+/// Small modules go straight through `machine`. Large ones are split into
+/// codegen units by function size; each unit is a copy of the module in its
+/// own LLVM context, where the functions it does not own are marked
+/// `available_externally` so the backend skips them, and is emitted from a
+/// worker thread. Local symbols are promoted to hidden globals first so
+/// units can reference each other's definitions. `OTTER_CODEGEN_UNITS`
+/// overrides the unit count.
+///
+/// With an object `cache`, units are planned by [`plan_cached_units`] and
+/// each is looked up by a hash of its own bitcode before it is emitted.
+/// Only this backend step is cached: parsing, type checking, lowering and
+/// the module-wide optimization pipeline still run on the whole program
+/// every build, and units are keyed after optimization, so an edited
+/// function that was inlined elsewhere re-emits the units it was inlined
+/// into as well.
+pub(crate) fn emit_objects(
+    module: &Module<'_>,
+    machine: &TargetMachine,
+    spec: &MachineSpec,
+    object_path: &Path,
+    cache: Option<&ObjectStore>,
+) -> Result<Vec<PathBuf>> {
+    if let Some(cache) = cache {
+        return emit_cached_units(module, spec, object_path, cache);
+    }
+
+    let units = plan_units(module);
+    if units.len() <= 1 {
+        write_object(machine, module, object_path)?;
+        return Ok(vec![object_path.to_path_buf()]);
+    }
+
+    promote_local_symbols(module);
+    let bitcode = module.write_bitcode_to_memory();
+    let bitcode = bitcode.as_slice();
+
+    thread::scope(|scope| {
+        let workers: Vec<_> = units
+            .iter()
+            .enumerate()
+            .map(|(index, owned)| {
+                let path = object_path.with_extension(format!("cgu{index}.o"));
+                scope.spawn(move || emit_unit(bitcode, spec, index, owned, &path).map(|()| path))
+            })
+            .collect();
+
+        // Join every worker before reporting, so no unit is still writing
+        // when the caller cleans up.
+        let results: Vec<Result<PathBuf>> = workers
+            .into_iter()
+            .map(|worker| {
+                worker
+                    .join()
+                    .map_err(|_| anyhow!("codegen worker thread panicked"))?
+            })
+            .collect();
+        results.into_iter().collect()
+    })
+}
+
+fn write_object(machine: &TargetMachine, module: &Module<'_>, path: &Path) -> Result<()> {
+    machine
+        .write_to_file(module, FileType::Object, path)
+        .map_err(|e| anyhow!("failed to emit object file at {}: {e}", path.display()))
+}
+
+fn emit_unit(
+    bitcode: &[u8],
+    spec: &MachineSpec,
+    index: usize,
+    owned: &HashSet<String>,
+    path: &Path,
+) -> Result<()> {
+    let context = LlvmContext::create();
+    let module = load_unit(&context, bitcode, index, owned)?;
+    write_object(&spec.create()?, &module, path)
+}
+
+/// Emits every unit of a cached build, reusing the stored object of each
+/// unit whose code is unchanged. Units are spread over at most one worker
+/// thread per core.
+fn emit_cached_units(
+    module: &Module<'_>,
+    spec: &MachineSpec,
+    object_path: &Path,
+    cache: &ObjectStore,
+) -> Result<Vec<PathBuf>> {
+    let units = plan_cached_units(module);
+    promote_local_symbols(module);
+    let bitcode = module.write_bitcode_to_memory();
+    let bitcode = bitcode.as_slice();
+
+    let units = &units;
+    let next = &AtomicUsize::new(0);
+    let cores = thread::available_parallelism().map_or(1, |cores| cores.get());
+    let mut results: Vec<(usize, Result<PathBuf>)> = thread::scope(|scope| {
+        let workers: Vec<_> = (0..cores.min(units.len()))
+            .map(|_| {
+                scope.spawn(move || {
+                    let mut done = Vec::new();
+                    loop {
+                        let index = next.fetch_add(1, Ordering::Relaxed);
+                        let Some(owned) = units.get(index) else {
+                            return done;
+                        };
+                        let path = object_path.with_extension(format!("cgu{index}.o"));
+                        let result = emit_cached_unit(bitcode, spec, index, owned, &path, cache)
+                            .map(|()| path);
+                        done.push((index, result));
+                    }
+                })
+            })
+            .collect();
+
+        let mut results = Vec::new();
+        for worker in workers {
+            match worker.join() {
+                Ok(done) => results.extend(done),
+                Err(_) => {
+                    results.push((usize::MAX, Err(anyhow!("codegen worker thread panicked"))))
+                }
+            }
+        }
+        results
+    });
+
+    results.sort_by_key(|(index, _)| *index);
+    results.into_iter().map(|(_, result)| result).collect()
+}
+
+/// Emits one unit through the object cache. The key hashes the unit's
+/// bitcode once the bodies it does not own are stripped, so it changes only
+/// when code the unit emits (or a declaration it uses) changes.
+fn emit_cached_unit(
+    bitcode: &[u8],
+    spec: &MachineSpec,
+    index: usize,
+    owned: &HashSet<String>,
+    path: &Path,
+    cache: &ObjectStore,
+) -> Result<()> {
+    let context = LlvmContext::create();
+    let module = load_unit(&context, bitcode, index, owned)?;
+    let machine = spec.create()?;
+    // `available_externally` bodies are never emitted; dropping them keeps
+    // edits elsewhere out of this unit's key.
+    module
+        .run_passes("elim-avail-extern", &machine, PassBuilderOptions::create())
+        .map_err(|e| anyhow!("failed to prepare codegen unit {index}: {e}"))?;
+
+    let key = unit_cache_key(module.write_bitcode_to_memory().as_slice(), spec);
+    if cache.fetch(&key, path) {
+        return Ok(());
+    }
+
+    // The path may still be a hard link into the cache from an earlier,
+    // failed build; writing through it would corrupt the cached object.
+    let _ = fs::remove_file(path);
+    write_object(&machine, &module, path)?;
+    let _ = cache.store(&key, path);
+    Ok(())
+}
+
+fn unit_cache_key(bitcode: &[u8], spec: &MachineSpec) -> String {
+    let (major, minor, patch) = inkwell::support::get_llvm_version();
+    let mut hasher = Sha1::new();
+    hasher.update(
+        format!(
+            "otter-cgu-v1\0llvm:{major}.{minor}.{patch}\0triple:{}\0cpu:{}\0features:{}\0opt:{:?}\0reloc:{:?}\0",
+            spec.triple, spec.cpu, spec.features, spec.optimization, spec.reloc_mode
+        )
+        .as_bytes(),
+    );
+    hasher.update(bitcode);
+    format!("{:x}", hasher.finalize())
+}
+
+/// Loads a copy of the program in `context`, with the functions `owned`
+/// does not contain marked `available_externally`.
+fn load_unit<'ctx>(
+    context: &'ctx LlvmContext,
+    bitcode: &[u8],
+    index: usize,
+    owned: &HashSet<String>,
+) -> Result<Module<'ctx>> {
+    let buffer = MemoryBuffer::create_from_memory_range_copy(bitcode, "otter.cgu");
+    let module = Module::parse_bitcode_from_buffer(&buffer, context)
+        .map_err(|e| anyhow!("failed to load codegen unit {index}: {e}"))?;
+
+    for function in module.get_functions() {
+        if is_definition(function) && !owned.contains(&symbol_name(function.as_global_value())) {
+            function.set_linkage(Linkage::AvailableExternally);
+        }
+    }
+
+    // Unit 0 owns every global variable, including the `llvm.*` tables
+    // (constructors, `llvm.used`) that must be emitted exactly once.
+    if index > 0 {
+        let globals: Vec<GlobalValue<'_>> = module.get_globals().collect();
+        for global in globals {
+            if global.get_initializer().is_none() {
+                continue;
+            }
+            if global.get_linkage() == Linkage::Appending {
+                // SAFETY: the appending `llvm.*` tables have no users.
+                unsafe { global.delete() };
+            } else {
+                global.set_linkage(Linkage::AvailableExternally);
+            }
+        }
+    }
+
+    Ok(module)
+}
+
+/// Splits the module's function definitions into balanced units, largest
+/// function first onto the lightest unit. Returns a single unit when the
+/// module is too small to be worth splitting.
+fn plan_units(module: &Module<'_>) -> Vec<HashSet<String>> {
+    let mut functions: Vec<(String, usize)> = module
+        .get_functions()
+        .filter(|function| is_definition(*function))
+        .map(|function| {
+            (
+                symbol_name(function.as_global_value()),
+                instruction_count(function),
+            )
+        })
+        .collect();
+    let total: usize = functions.iter().map(|(_, size)| size).sum();
+
+    let count = match env::var("OTTER_CODEGEN_UNITS")
+        .ok()
+        .and_then(|value| value.parse::<usize>().ok())
+    {
+        Some(requested) => requested.clamp(1, MAX_CODEGEN_UNITS),
+        None => {
+            let cores = thread::available_parallelism().map_or(1, |cores| cores.get());
+            (total / MIN_UNIT_INSTRUCTIONS).clamp(1, cores.min(MAX_CODEGEN_UNITS))
+        }
+    }
+    .min(functions.len().max(1));
+    if count <= 1 {
+        return vec![functions.into_iter().map(|(name, _)| name).collect()];
+    }
+
+    functions.sort_by(|a, b| b.1.cmp(&a.1));
+    let mut units = vec![HashSet::new(); count];
+    let mut loads = vec![0usize; count];
+    for (name, size) in functions {
+        let lightest = (0..count).min_by_key(|&unit| loads[unit]).unwrap_or(0);
+        loads[lightest] += size;
+        units[lightest].insert(name);
+    }
+    units
+}
+
+/// Splits the module for a cached build. Unit 0 holds only the global
+/// variables; functions go to the other units by a hash of their name, so a
+/// function stays in the same unit across edits and only the unit it lives
+/// in (plus any unit it was inlined into) has to be emitted again.
+fn plan_cached_units(module: &Module<'_>) -> Vec<HashSet<String>> {
+    let functions: Vec<(String, usize)> = module
+        .get_functions()
+        .filter(|function| is_definition(*function))
+        .map(|function| {
+            (
+                symbol_name(function.as_global_value()),
+                instruction_count(function),
+            )
+        })
+        .collect();
+    let total: usize = functions.iter().map(|(_, size)| size).sum();
+
+    // A power of two, so growing the program reshuffles functions rarely.
+    let count = (total / CACHED_UNIT_INSTRUCTIONS)
+        .max(1)
+        .next_power_of_two()
+        .min(MAX_CACHED_UNITS);
+    let mut units = vec![HashSet::new(); count + 1];
+    for (name, _) in functions {
+        let unit = 1 + (stable_hash(&name) % count as u64) as usize;
+        units[unit].insert(name);
+    }
+    units
+}
+
+/// FNV-1a, which unlike the std hasher is fixed across Rust releases.
+fn stable_hash(name: &str) -> u64 {
+    name.bytes().fold(0xcbf2_9ce4_8422_2325, |hash, byte| {
+        (hash ^ u64::from(byte)).wrapping_mul(0x0100_0000_01b3)
+    })
+}
+
+/// Gives every local definition a name and hidden external linkage, so a
+/// unit can still reach it when another unit owns it.
+fn promote_local_symbols(module: &Module<'_>) {
+    let mut anonymous = 0usize;
+    let mut promote = |global: GlobalValue<'_>| {
+        if !matches!(global.get_linkage(), Linkage::Internal | Linkage::Private) {
+            return;
+        }
+        if global.get_name().to_bytes().is_empty() {
+            global
+                .as_pointer_value()
+                .set_name(&format!("__otter_cgu_anon.{anonymous}"));
+            anonymous += 1;
+        }
+        global.set_linkage(Linkage::External);
+        global.set_visibility(GlobalVisibility::Hidden);
+    };
+
+    for function in module.get_functions() {
+        if is_definition(function) {
+            promote(function.as_global_value());
+        }
+    }
+    for global in module.get_globals() {
+        if global.get_initializer().is_some() {
+            promote(global);
+        }
+    }
+}
+
+fn is_definition(function: FunctionValue<'_>) -> bool {
+    function.count_basic_blocks() > 0
+}
+
+fn symbol_name(global: GlobalValue<'_>) -> String {
+    global.get_name().to_string_lossy().into_owned()
+}
+
+fn instruction_count(function: FunctionValue<'_>) -> usize {
+    let mut count = 0;
+    for block in function.get_basic_blocks() {
+        let mut instruction = block.get_first_instruction();
+        while let Some(current) = instruction {
+            count += 1;
+            instruction = current.get_next_instruction();
+        }
+    }
+    count
+}
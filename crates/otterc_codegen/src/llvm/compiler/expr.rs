@@ -8,6 +8,7 @@ use std::collections::BTreeSet;
 use crate::llvm::compiler::Compiler;
 use crate::llvm::compiler::types::{EvaluatedValue, FunctionContext, OtterType, Variable};
 use otterc_ast::nodes::{BinaryOp, Block, Expr, FStringPart, Literal, Node, Statement, UnaryOp};
+use otterc_symbol::key_hash::hash_map_key;
 use otterc_typecheck::TypeInfo;
 
 struct CapturedVariable<'ctx> {
@@ -1094,20 +1095,23 @@ impl<'ctx> Compiler<'ctx> {
             bail!("Expected FString expression")
         };
 
-        let mut result = self.eval_literal(&Literal::String(String::new()), None)?;
+        if parts.is_empty() {
+            return self.eval_literal(&Literal::String(String::new()), None);
+        }
 
+        let mut values = Vec::with_capacity(parts.len());
         for part in parts {
             let part_val = match part.as_ref() {
-                otterc_ast::nodes::FStringPart::Text(s) => {
-                    self.eval_literal(&Literal::String(s.clone()), None)?
-                }
-                otterc_ast::nodes::FStringPart::Expr(e) => self.eval_expr(e.as_ref(), ctx)?,
+                otterc_ast::nodes::FStringPart::Text(s) => (
+                    self.eval_literal(&Literal::String(s.clone()), None)?,
+                    Some(s.len()),
+                ),
+                otterc_ast::nodes::FStringPart::Expr(e) => (self.eval_expr(e.as_ref(), ctx)?, None),
             };
-
-            result = self.build_string_concat(result, part_val)?;
+            values.push(part_val);
         }
 
-        Ok(result)
+        self.build_string_concat_n(values)
     }
 
     fn eval_literal(
@@ -1194,6 +1198,28 @@ impl<'ctx> Compiler<'ctx> {
         right: &Expr,
         ctx: &mut FunctionContext<'ctx>,
     ) -> Result<EvaluatedValue<'ctx>> {
+        // `a + b + c + ...` on strings is flattened into one n-ary concat so
+        // no intermediate strings are built.
+        if matches!(op, BinaryOp::Add)
+            && (self.is_string_concat(left) || self.is_string_concat(right))
+        {
+            let mut operands = Vec::new();
+            self.collect_concat_operands(left, &mut operands);
+            self.collect_concat_operands(right, &mut operands);
+            let mut values = Vec::with_capacity(operands.len());
+            for operand in operands {
+                let known_len = match operand {
+                    Expr::Literal(lit) => match lit.as_ref() {
+                        Literal::String(text) => Some(text.len()),
+                        _ => None,
+                    },
+                    _ => None,
+                };
+                values.push((self.eval_expr(operand, ctx)?, known_len));
+            }
+            return self.build_string_concat_n(values);
+        }
+
         let lhs = self.eval_expr(left, ctx)?;
         let rhs = self.eval_expr(right, ctx)?;
         let lhs_ty = lhs.ty.clone();
@@ -1906,6 +1932,35 @@ impl<'ctx> Compiler<'ctx> {
                     bail!("Function {} not found", func_name);
                 };
 
+            // A string-literal map key is measured and hashed here; the
+            // `<prehashed>` builtin then neither scans nor hashes it.
+            let prehashed_key = if implicit_self.is_none() {
+                prehashed_map_key(&resolved_func_name, args)
+            } else {
+                None
+            };
+            let (function, resolved_func_name) = match prehashed_key {
+                Some(_) => {
+                    let name = format!("{resolved_func_name}<prehashed>");
+                    (self.get_or_declare_ffi_function(&name)?, name)
+                }
+                None => (function, resolved_func_name),
+            };
+
+            // A literal error message lives as long as the program, so the
+            // runtime can borrow it rather than copy it.
+            let (function, resolved_func_name) = if implicit_self.is_none()
+                && is_static_raise(&resolved_func_name, args)
+                && self.symbol_registry.contains(STATIC_RAISE)
+            {
+                (
+                    self.get_or_declare_ffi_function(STATIC_RAISE)?,
+                    STATIC_RAISE.to_string(),
+                )
+            } else {
+                (function, resolved_func_name)
+            };
+
             // Get parameter types upfront to avoid borrow issues
             let param_types: Vec<BasicTypeEnum> = function
                 .get_param_iter()
@@ -1949,6 +2004,12 @@ impl<'ctx> Compiler<'ctx> {
                 } else {
                     bail!("Cannot pass unit value as argument");
                 }
+                if let (1, Some((len, hash))) = (i, prehashed_key) {
+                    let i64_type = self.context.i64_type();
+                    arg_values.push(i64_type.const_int(len, false).into());
+                    arg_values.push(i64_type.const_int(hash, false).into());
+                    param_offset += 2;
+                }
             }
 
             // Fill in default values for missing arguments
@@ -2108,27 +2169,188 @@ impl<'ctx> Compiler<'ctx> {
         lhs: EvaluatedValue<'ctx>,
         rhs: EvaluatedValue<'ctx>,
     ) -> Result<EvaluatedValue<'ctx>> {
-        let left_ptr = self.ensure_string_value(lhs)?;
-        let right_ptr = self.ensure_string_value(rhs)?;
+        let mut temporaries = Vec::new();
+        let left_ptr = self.ensure_string_operand(lhs, &mut temporaries)?;
+        let right_ptr = self.ensure_string_operand(rhs, &mut temporaries)?;
         let result = self.call_ffi_returning_value(
             "std.strings.concat",
             vec![left_ptr, right_ptr],
             "str_concat",
         )?;
+        self.release_string_temporaries(temporaries)?;
+        Ok(EvaluatedValue::with_value(result, OtterType::Str))
+    }
+
+    /// Like `ensure_string_value`, but records the strings it had to create
+    /// so the caller can release them once they have been copied.
+    fn ensure_string_operand(
+        &mut self,
+        value: EvaluatedValue<'ctx>,
+        temporaries: &mut Vec<BasicValueEnum<'ctx>>,
+    ) -> Result<BasicValueEnum<'ctx>> {
+        let converted = value.ty != OtterType::Str;
+        let ptr = self.ensure_string_value(value)?;
+        if converted {
+            temporaries.push(ptr);
+        }
+        Ok(ptr)
+    }
+
+    fn release_string_temporaries(&mut self, temporaries: Vec<BasicValueEnum<'ctx>>) -> Result<()> {
+        if temporaries.is_empty() {
+            return Ok(());
+        }
+        let free_fn = self.get_or_declare_ffi_function("std.strings.free")?;
+        for ptr in temporaries {
+            self.builder.build_call(free_fn, &[ptr.into()], "")?;
+        }
+        Ok(())
+    }
+
+    fn is_string_concat(&self, expr: &Expr) -> bool {
+        matches!(
+            expr,
+            Expr::Binary {
+                op: BinaryOp::Add,
+                ..
+            }
+        ) && matches!(self.expr_type(expr), Some(TypeInfo::Str))
+    }
+
+    fn collect_concat_operands<'e>(&self, expr: &'e Expr, operands: &mut Vec<&'e Expr>) {
+        if self.is_string_concat(expr)
+            && let Expr::Binary { left, right, .. } = expr
+        {
+            self.collect_concat_operands(left.as_ref().as_ref(), operands);
+            self.collect_concat_operands(right.as_ref().as_ref(), operands);
+            return;
+        }
+        operands.push(expr);
+    }
+
+    /// Concatenate all `parts` with a single `otter_str_concat_n` call. Parts
+    /// whose byte length is known at compile time (literals) pass it along so
+    /// the runtime does not have to measure them.
+    fn build_string_concat_n(
+        &mut self,
+        parts: Vec<(EvaluatedValue<'ctx>, Option<usize>)>,
+    ) -> Result<EvaluatedValue<'ctx>> {
+        let function = self
+            .builder
+            .get_insert_block()
+            .and_then(|block| block.get_parent())
+            .ok_or_else(|| anyhow!("string concatenation outside of a function"))?;
+        let i64_type = self.context.i64_type();
+        let count = parts.len() as u32;
+        let parts_ty = self.string_ptr_type.array_type(count);
+        let lens_ty = i64_type.array_type(count);
+        let parts_slot =
+            self.create_entry_block_alloca_of(function, "concat_parts", parts_ty.into())?;
+        let lens_slot =
+            self.create_entry_block_alloca_of(function, "concat_lens", lens_ty.into())?;
+        let zero = i64_type.const_zero();
+        let mut temporaries = Vec::new();
+
+        for (idx, (part, known_len)) in parts.into_iter().enumerate() {
+            let part_ptr = self.ensure_string_operand(part, &mut temporaries)?;
+            let index = i64_type.const_int(idx as u64, false);
+            let part_slot = unsafe {
+                self.builder.build_in_bounds_gep(
+                    parts_ty,
+                    parts_slot,
+                    &[zero, index],
+                    "part_slot",
+                )?
+            };
+            self.builder.build_store(part_slot, part_ptr)?;
+
+            // -1 tells the runtime to measure the part itself.
+            let len = match known_len {
+                Some(len) => i64_type.const_int(len as u64, false),
+                None => i64_type.const_all_ones(),
+            };
+            let len_slot = unsafe {
+                self.builder
+                    .build_in_bounds_gep(lens_ty, lens_slot, &[zero, index], "len_slot")?
+            };
+            self.builder.build_store(len_slot, len)?;
+        }
+
+        let concat_fn = self.get_str_concat_n_fn();
+        let call = self.builder.build_call(
+            concat_fn,
+            &[
+                parts_slot.into(),
+                lens_slot.into(),
+                i64_type.const_int(u64::from(count), false).into(),
+            ],
+            "str_concat_n",
+        )?;
+        let result = call
+            .try_as_basic_value()
+            .left()
+            .ok_or_else(|| anyhow!("otter_str_concat_n returned void"))?;
+        // Formatted numbers and stringified collections were copied into the
+        // result and are not referenced anywhere else.
+        self.release_string_temporaries(temporaries)?;
         Ok(EvaluatedValue::with_value(result, OtterType::Str))
     }
 
+    fn get_str_concat_n_fn(&mut self) -> FunctionValue<'ctx> {
+        if let Some(func) = self.declared_functions.get("__str_concat_n") {
+            return *func;
+        }
+        let fn_type = self.string_ptr_type.fn_type(
+            &[
+                self.raw_ptr_type().into(),
+                self.raw_ptr_type().into(),
+                self.context.i64_type().into(),
+            ],
+            false,
+        );
+        let function = self
+            .module
+            .add_function("otter_str_concat_n", fn_type, None);
+        self.declared_functions
+            .insert("__str_concat_n".to_string(), function);
+        function
+    }
+
     fn eval_array_expr(
         &mut self,
         elements: &[Node<Expr>],
         expr_type: Option<&TypeInfo>,
         ctx: &mut FunctionContext<'ctx>,
     ) -> Result<EvaluatedValue<'ctx>> {
-        // Create a new empty list
-        let create_fn = self.get_or_declare_ffi_function("list.new")?;
-        let handle = self
-            .builder
-            .build_call(create_fn, &[], "list_handle")?
+        let list_ty = expr_type
+            .and_then(|ty| self.typeinfo_to_otter_type(ty))
+            .unwrap_or_else(OtterType::opaque_list);
+
+        // Create a new empty list. When the element type is known, the list
+        // gets a typed backing that stores elements unboxed.
+        let typed_constructor = match list_ty.list_element() {
+            Some(OtterType::I32 | OtterType::I64) => Some("list.new<int>"),
+            Some(OtterType::F64) => Some("list.new<float>"),
+            Some(OtterType::Bool) => Some("list.new<bool>"),
+            Some(OtterType::Str) => Some("list.new<string>"),
+            _ => None,
+        };
+        let call = match typed_constructor {
+            Some(name) => {
+                let create_fn = self.get_or_declare_ffi_function(name)?;
+                let capacity = self
+                    .context
+                    .i64_type()
+                    .const_int(elements.len() as u64, false);
+                self.builder
+                    .build_call(create_fn, &[capacity.into()], "list_handle")?
+            }
+            None => {
+                let create_fn = self.get_or_declare_ffi_function("list.new")?;
+                self.builder.build_call(create_fn, &[], "list_handle")?
+            }
+        };
+        let handle = call
             .try_as_basic_value()
             .left()
             .ok_or_else(|| anyhow!("list creation returned void"))?
@@ -2143,9 +2365,6 @@ impl<'ctx> Compiler<'ctx> {
             self.append_value_to_list(handle, elem_value, elem_val.ty, &format!("append_{}", idx))?;
         }
 
-        let list_ty = expr_type
-            .and_then(|ty| self.typeinfo_to_otter_type(ty))
-            .unwrap_or_else(OtterType::opaque_list);
         Ok(EvaluatedValue::with_value(handle.into(), list_ty))
     }
 
@@ -2911,7 +3130,11 @@ impl<'ctx> Compiler<'ctx> {
         })
     }
 
-    fn resolve_member_function_name(&self, object: &Expr, field: &str) -> Option<String> {
+    pub(crate) fn resolve_member_function_name(
+        &self,
+        object: &Expr,
+        field: &str,
+    ) -> Option<String> {
         if let Some(module) = self.module_path_from_expr(object) {
             let candidate = format!("{}.{}", module, field);
             if self.symbol_registry.contains(&candidate)
@@ -3134,3 +3357,44 @@ fn enum_field_kind(field_type: &TypeInfo) -> EnumFieldKind {
         _ => EnumFieldKind::Ptr,
     }
 }
+
+/// `runtime.raise` for a message that is never freed
+const STATIC_RAISE: &str = "runtime.raise<static>";
+
+/// Whether a call raises a string-literal message
+fn is_static_raise(func_name: &str, args: &[Node<Expr>]) -> bool {
+    func_name == "runtime.raise"
+        && args.first().is_some_and(|message| {
+            matches!(message.as_ref(), Expr::Literal(lit) if matches!(lit.as_ref(), Literal::String(_)))
+        })
+}
+
+/// Map builtins that have a `<prehashed>` variant taking the key's length and
+/// hash after the key
+const PREHASHED_MAP_BUILTINS: &[&str] = &[
+    "map.get",
+    "map.get_int",
+    "map.get_float",
+    "map.get_bool",
+    "map.get_list",
+    "map.get_map",
+    "map.set",
+];
+
+/// Length and hash of the key of a `PREHASHED_MAP_BUILTINS` call whose key is
+/// a string literal. Keys with a NUL byte are left to the C-string builtins,
+/// which end the key there.
+fn prehashed_map_key(func_name: &str, args: &[Node<Expr>]) -> Option<(u64, u64)> {
+    if !PREHASHED_MAP_BUILTINS.contains(&func_name) {
+        return None;
+    }
+    match args.get(1)?.as_ref() {
+        Expr::Literal(lit) => match lit.as_ref() {
+            Literal::String(key) if !key.contains('\0') => {
+                Some((key.len() as u64, hash_map_key(key.as_bytes())))
+            }
+            _ => None,
+        },
+        _ => None,
+    }
+}
@@ -9,7 +9,7 @@ use inkwell::module::Module;
 use inkwell::passes::{PassBuilderOptions, PassManager};
 use inkwell::targets::TargetMachine;
 use inkwell::types::{BasicType, BasicTypeEnum, PointerType, StructType};
-use inkwell::values::{FunctionValue, PointerValue};
+use inkwell::values::{FunctionValue, InstructionOpcode, PointerValue};
 
 use crate::llvm::bridges::prepare_rust_bridges;
 use otterc_ast::nodes::{Block, Expr, FStringPart, Function, Node, Program, Statement};
@@ -271,6 +271,10 @@ impl<'ctx> Compiler<'ctx> {
             .unwrap_or(false)
     }
 
+    fn is_wasm_target(&self) -> bool {
+        self.target_triple.as_ref().is_some_and(|t| t.is_wasm())
+    }
+
     pub fn lower_program(&mut self, program: &Program, _require_main: bool) -> Result<()> {
         self.compile_module(program)
     }
@@ -824,6 +828,35 @@ impl<'ctx> Compiler<'ctx> {
             }
         }
 
+        // A wasm module has no exit hook to flush buffered output (or report
+        // runtime counters) from, so the entry point does it on every return.
+        if func.name == "main" && self.is_wasm_target() {
+            self.exit_runtime_before_returns("otter_entry")?;
+        }
+
+        Ok(())
+    }
+
+    fn exit_runtime_before_returns(&mut self, function_name: &str) -> Result<()> {
+        let Some(function) = self.module.get_function(function_name) else {
+            return Ok(());
+        };
+        let exit = self
+            .module
+            .get_function("otter_runtime_exit")
+            .unwrap_or_else(|| {
+                let fn_type = self.context.void_type().fn_type(&[], false);
+                self.module
+                    .add_function("otter_runtime_exit", fn_type, None)
+            });
+        for block in function.get_basic_blocks() {
+            if let Some(terminator) = block.get_terminator()
+                && terminator.get_opcode() == InstructionOpcode::Return
+            {
+                self.builder.position_before(&terminator);
+                self.builder.build_call(exit, &[], "")?;
+            }
+        }
         Ok(())
     }
 
@@ -833,6 +866,21 @@ impl<'ctx> Compiler<'ctx> {
         function: FunctionValue<'ctx>,
         name: &str,
         otter_type: OtterType,
+    ) -> Result<PointerValue<'ctx>> {
+        let llvm_type: BasicTypeEnum = self
+            .basic_type(otter_type)?
+            .unwrap_or_else(|| self.context.i8_type().into());
+
+        self.create_entry_block_alloca_of(function, name, llvm_type)
+    }
+
+    /// Creates a stack allocation of a raw LLVM type (e.g. a fixed-size array)
+    /// in the entry block of the function.
+    pub(super) fn create_entry_block_alloca_of(
+        &self,
+        function: FunctionValue<'ctx>,
+        name: &str,
+        llvm_type: BasicTypeEnum<'ctx>,
     ) -> Result<PointerValue<'ctx>> {
         let builder = self.context.create_builder();
         let entry_block = function.get_first_basic_block().unwrap();
@@ -844,10 +892,6 @@ impl<'ctx> Compiler<'ctx> {
             None => builder.position_at_end(entry_block),
         }
 
-        let llvm_type: BasicTypeEnum = self
-            .basic_type(otter_type)?
-            .unwrap_or_else(|| self.context.i8_type().into());
-
         Ok(builder.build_alloca(llvm_type, name)?)
     }
 
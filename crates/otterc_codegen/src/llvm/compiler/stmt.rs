@@ -346,6 +346,31 @@ impl<'ctx> Compiler<'ctx> {
             )?;
 
             Ok(())
+        } else if let Some((path, source, element_type)) = self.streamed_iterable(iterable) {
+            // `for line in io.lines(path)` reads the file one line at a time
+            // instead of building the whole list first.
+            let path_val = self.eval_expr(path, ctx)?;
+            let (iter_create_fn, iter_has_next_fn, iter_next_fn, iter_free_fn) = (
+                self.get_or_declare_ffi_function(&format!("__otter_iter_{source}"))?,
+                self.get_or_declare_ffi_function(&format!("__otter_iter_has_next_{source}"))?,
+                self.get_or_declare_ffi_function(&format!("__otter_iter_next_{source}"))?,
+                self.get_or_declare_ffi_function(&format!("__otter_iter_free_{source}"))?,
+            );
+
+            self.lower_collection_for_loop(
+                var,
+                path_val,
+                body,
+                function,
+                ctx,
+                IteratorRuntime {
+                    create_fn: iter_create_fn,
+                    has_next_fn: iter_has_next_fn,
+                    next_fn: iter_next_fn,
+                    free_fn: iter_free_fn,
+                    element_type,
+                },
+            )
         } else {
             // Handle other iterable types (arrays, strings, etc.)
             let iterable_val = self.eval_expr(iterable, ctx)?;
@@ -503,7 +528,13 @@ impl<'ctx> Compiler<'ctx> {
 
         // Decode the runtime type tag and convert to the correct type
         // The runtime now returns tagged values: upper 8 bits = type tag, lower 56 bits = data
-        let decoded_value = self.decode_and_convert_tagged_value(element_val, &element_ty)?;
+        // A next function that already returns a string (the `io.lines`
+        // stream) hands over the element itself.
+        let decoded_value = if element_val.is_pointer_value() {
+            Some(element_val)
+        } else {
+            self.decode_and_convert_tagged_value(element_val, &element_ty)?
+        };
         if let Some(value) = decoded_value {
             self.builder.build_store(var_alloca, value)?;
         }
@@ -536,6 +567,33 @@ impl<'ctx> Compiler<'ctx> {
     }
 
     // Exception handling (try/except/finally/raise) removed - use Result<T, E> pattern matching instead
+
+    /// For a loop iterable that streams a file (`io.lines(path)`), its path
+    /// argument, the suffix of its `__otter_iter_*` runtime functions and its
+    /// element type
+    fn streamed_iterable<'e>(
+        &self,
+        iterable: &'e Expr,
+    ) -> Option<(&'e Expr, &'static str, OtterType)> {
+        let Expr::Call { func, args } = iterable else {
+            return None;
+        };
+        let Expr::Member { object, field } = func.as_ref().as_ref() else {
+            return None;
+        };
+        let [path] = args.as_slice() else {
+            return None;
+        };
+        let name = self.resolve_member_function_name(object.as_ref().as_ref(), field)?;
+        let (source, element_type) = match name.as_str() {
+            "io.lines" => ("lines", OtterType::Str),
+            _ => return None,
+        };
+        self.symbol_registry
+            .contains(&format!("__otter_iter_{source}"))
+            .then(|| (path.as_ref(), source, element_type))
+    }
+
     pub(crate) fn list_element_type(&self, iterable: &Expr) -> Option<OtterType> {
         if let Some(ty) = self.expr_type(iterable) {
             self.resolve_list_element_type_from_typeinfo(ty)
@@ -1,7 +1,11 @@
+use std::collections::HashMap;
+use std::env;
 use std::path::{Path, PathBuf};
-use std::process::Command;
+use std::process::{Command, Stdio};
+use std::sync::{Mutex, OnceLock};
 
 use inkwell::targets::TargetTriple as LlvmTargetTriple;
+use otterc_metrics::profiler::CompilationPhase;
 
 pub(crate) fn llvm_triple_to_string(triple: &LlvmTargetTriple) -> String {
     triple
@@ -19,6 +23,65 @@ pub(crate) fn preferred_target_flag(driver: &str) -> &'static str {
     }
 }
 
+/// Driver used to emit runtime bitcode: the target's C compiler when it is
+/// clang, otherwise `clang` from `PATH`.
+pub(crate) fn bitcode_compiler(c_compiler: &str) -> String {
+    if driver_prefers_clang_style(c_compiler) {
+        c_compiler.to_string()
+    } else {
+        "clang".to_string()
+    }
+}
+
+/// `-fuse-ld=` value for the fastest linker on `PATH`: mold, then lld.
+/// `OTTER_FUSE_LD` overrides the choice; set it to `default` to keep the
+/// driver's own linker. lld cannot read GCC's LTO objects, so it is only
+/// picked for LTO builds when `driver` is clang. A linker is only picked
+/// once `driver` has shown it accepts it (GCC before 12.1 rejects
+/// `-fuse-ld=mold`).
+pub(crate) fn preferred_fast_linker(driver: &str, lto: bool) -> Option<String> {
+    if let Ok(choice) = env::var("OTTER_FUSE_LD") {
+        return (!choice.is_empty() && choice != "default").then_some(choice);
+    }
+
+    let on_path = |program: &str| {
+        env::var_os("PATH")
+            .is_some_and(|paths| env::split_paths(&paths).any(|dir| dir.join(program).is_file()))
+    };
+    if on_path("ld.mold") && driver_accepts_linker(driver, "mold") {
+        Some("mold".to_string())
+    } else if on_path("ld.lld")
+        && (!lto || driver_prefers_clang_style(driver))
+        && driver_accepts_linker(driver, "lld")
+    {
+        Some("lld".to_string())
+    } else {
+        None
+    }
+}
+
+/// Whether `driver -fuse-ld=<linker>` works, probed by asking the linker for
+/// its version through the driver. Each driver and linker pair is probed
+/// once per process.
+fn driver_accepts_linker(driver: &str, linker: &str) -> bool {
+    static PROBES: OnceLock<Mutex<HashMap<(String, String), bool>>> = OnceLock::new();
+    let key = (driver.to_string(), linker.to_string());
+    let probes = PROBES.get_or_init(Default::default);
+    if let Some(&accepted) = probes.lock().unwrap().get(&key) {
+        return accepted;
+    }
+
+    let accepted = Command::new(driver)
+        .arg(format!("-fuse-ld={linker}"))
+        .arg("-Wl,--version")
+        .stdout(Stdio::null())
+        .stderr(Stdio::null())
+        .status()
+        .is_ok_and(|status| status.success());
+    probes.lock().unwrap().insert(key, accepted);
+    accepted
+}
+
 fn driver_prefers_clang_style(driver: &str) -> bool {
     let lower = driver.to_ascii_lowercase();
     if lower.contains("clang") || lower.contains("wasm-ld") {
@@ -52,4 +115,19 @@ fn compiler_reports_clang(driver: &str) -> bool {
 pub struct BuildArtifact {
     pub binary: PathBuf,
     pub ir: Option<String>,
+    /// Wall time of each build phase, from the compilation profiler
+    pub phases: Vec<CompilationPhase>,
+}
+
+#[cfg(all(test, target_os = "linux"))]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn linker_probe_rejects_unknown_linkers() {
+        assert!(driver_accepts_linker("cc", "bfd"));
+        assert!(!driver_accepts_linker("cc", "otter-no-such-linker"));
+        // Answered from the cache the second time.
+        assert!(!driver_accepts_linker("cc", "otter-no-such-linker"));
+    }
 }
@@ -1,7 +1,9 @@
 pub mod bridges;
 pub mod build;
+mod codegen_units;
 pub mod compiler;
 pub mod config;
+mod runtime_cache;
 
 pub use build::{build_executable, build_shared_library, current_llvm_version};
 pub use config::BuildArtifact;
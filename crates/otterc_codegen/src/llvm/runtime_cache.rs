@@ -0,0 +1,305 @@
+use std::env;
+use std::fs;
+use std::path::{Path, PathBuf};
+use std::process::Command;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::time::UNIX_EPOCH;
+
+use anyhow::{Context, Result, bail};
+use otterc_cache::path::cache_root;
+use sha1::{Digest, Sha1};
+
+/// What [`compile_runtime_object`] produces from the runtime source.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub(crate) enum RuntimeArtifact {
+    /// A native object for the system linker.
+    Object,
+    /// LLVM bitcode (`-emit-llvm`) to link into the program module.
+    Bitcode,
+}
+
+impl RuntimeArtifact {
+    fn extension(self) -> &'static str {
+        match self {
+            RuntimeArtifact::Object => "o",
+            RuntimeArtifact::Bitcode => "bc",
+        }
+    }
+}
+
+/// Compiles a C runtime translation unit, reusing a previously built object
+/// when one exists.
+///
+/// Objects live under `<cache root>/runtime/<triple>/<key>.<o|bc>`, where the key
+/// hashes the runtime source, the triple, the compiler (see
+/// [`compiler_fingerprint`]) and every flag passed to it. A change to any of
+/// them produces a new object; stale ones are simply never looked up again.
+///
+/// When the cache directory cannot be created, the object is built next to
+/// `fallback_dir` instead and the returned [`RuntimeObject`] removes it once
+/// dropped.
+pub(crate) fn compile_runtime_object(
+    source: &str,
+    c_compiler: &str,
+    triple: &str,
+    flags: &[String],
+    artifact: RuntimeArtifact,
+    fallback_dir: &Path,
+) -> Result<RuntimeObject> {
+    let key = runtime_cache_key(source, c_compiler, triple, flags, artifact);
+    let extension = artifact.extension();
+
+    let (dir, cached) = match runtime_cache_dir(triple) {
+        Some(dir) => (dir, true),
+        None => (fallback_dir.to_path_buf(), false),
+    };
+    let object = dir.join(format!("{key}.{extension}"));
+    if cached && object.exists() {
+        return Ok(RuntimeObject {
+            path: object,
+            temporary: false,
+        });
+    }
+
+    // Build under unique names and rename into place, so concurrent builds
+    // sharing the cache never observe a partially written object.
+    let unique = unique_name(&key);
+    let source_path = dir.join(format!("{unique}.runtime.c"));
+    let partial_object = dir.join(format!("{unique}.{extension}.partial"));
+    fs::write(&source_path, source).context("failed to write runtime C file")?;
+
+    let mut cc = Command::new(c_compiler);
+    cc.arg("-c").args(flags);
+    if artifact == RuntimeArtifact::Bitcode {
+        cc.arg("-emit-llvm");
+    }
+    let status = cc
+        .arg(&source_path)
+        .arg("-o")
+        .arg(&partial_object)
+        .status()
+        .context("failed to compile runtime C file");
+    let _ = fs::remove_file(&source_path);
+    if !status?.success() {
+        let _ = fs::remove_file(&partial_object);
+        bail!("failed to compile runtime C file");
+    }
+
+    if let Err(err) = fs::rename(&partial_object, &object) {
+        // Another build may have won the race; its object is just as good.
+        let _ = fs::remove_file(&partial_object);
+        if !object.exists() {
+            return Err(err)
+                .with_context(|| format!("failed to store runtime object {}", object.display()));
+        }
+    }
+
+    Ok(RuntimeObject {
+        path: object,
+        temporary: !cached,
+    })
+}
+
+/// A compiled runtime object, ready for the linker or for bitcode linking.
+pub(crate) struct RuntimeObject {
+    pub(crate) path: PathBuf,
+    temporary: bool,
+}
+
+impl Drop for RuntimeObject {
+    fn drop(&mut self) {
+        if self.temporary {
+            let _ = fs::remove_file(&self.path);
+        }
+    }
+}
+
+fn runtime_cache_dir(triple: &str) -> Option<PathBuf> {
+    let dir = cache_root().ok()?.join("runtime").join(triple);
+    fs::create_dir_all(&dir).ok()?;
+    Some(dir)
+}
+
+/// `<key>.<pid>.<n>`: unique across processes and across threads of this one.
+fn unique_name(key: &str) -> String {
+    static NEXT: AtomicUsize = AtomicUsize::new(0);
+    let n = NEXT.fetch_add(1, Ordering::Relaxed);
+    format!("{key}.{}.{n}", std::process::id())
+}
+
+fn runtime_cache_key(
+    source: &str,
+    c_compiler: &str,
+    triple: &str,
+    flags: &[String],
+    artifact: RuntimeArtifact,
+) -> String {
+    let mut hasher = Sha1::new();
+    hasher.update(b"artifact:");
+    hasher.update(artifact.extension().as_bytes());
+    hasher.update(b"\0source:");
+    hasher.update(source.as_bytes());
+    hasher.update(b"\0triple:");
+    hasher.update(triple.as_bytes());
+    hasher.update(b"\0compiler:");
+    hasher.update(c_compiler.as_bytes());
+    hasher.update(b"\0");
+    let records = cache_root()
+        .ok()
+        .map(|root| root.join("runtime").join("compilers"));
+    hasher.update(compiler_fingerprint(c_compiler, records.as_deref()).as_bytes());
+    for flag in flags {
+        hasher.update(b"\0flag:");
+        hasher.update(flag.as_bytes());
+    }
+    format!("{:x}", hasher.finalize())
+}
+
+/// Identifies the C compiler binary without running it on every build: its
+/// resolved path, size and modification time, plus its `--version` output.
+/// LTO objects are only readable by the compiler version that wrote them, so
+/// the version is part of the identity, but it is recorded under `records`
+/// the first time a binary is seen and only re-run when the binary changes.
+/// A compiler that cannot be found on disk is asked for its version directly.
+fn compiler_fingerprint(c_compiler: &str, records: Option<&Path>) -> String {
+    let Some((path, metadata)) = resolve_compiler(c_compiler) else {
+        return compiler_version(c_compiler);
+    };
+    let modified = metadata
+        .modified()
+        .ok()
+        .and_then(|time| time.duration_since(UNIX_EPOCH).ok())
+        .map_or(0, |since| since.as_nanos());
+    let identity = format!("{}\0{}\0{modified}", path.display(), metadata.len());
+
+    let record =
+        records.map(|dir| dir.join(format!("{:x}.version", Sha1::digest(identity.as_bytes()))));
+    if let Some(version) = record
+        .as_ref()
+        .and_then(|record| fs::read_to_string(record).ok())
+    {
+        return format!("{identity}\0{version}");
+    }
+
+    let version = compiler_version(c_compiler);
+    if let Some(record) = record
+        && fs::create_dir_all(record.parent().unwrap_or(Path::new("."))).is_ok()
+    {
+        let partial = record.with_extension(unique_name("partial"));
+        if fs::write(&partial, &version).is_ok() && fs::rename(&partial, &record).is_err() {
+            let _ = fs::remove_file(&partial);
+        }
+    }
+    format!("{identity}\0{version}")
+}
+
+fn compiler_version(c_compiler: &str) -> String {
+    Command::new(c_compiler)
+        .arg("--version")
+        .output()
+        .map(|output| String::from_utf8_lossy(&output.stdout).into_owned())
+        .unwrap_or_default()
+}
+
+/// The canonical path and metadata of `c_compiler`, searched for on `PATH`
+/// when it is a bare name.
+fn resolve_compiler(c_compiler: &str) -> Option<(PathBuf, fs::Metadata)> {
+    let name = Path::new(c_compiler);
+    let found = if name.components().count() > 1 {
+        name.to_path_buf()
+    } else {
+        let with_suffix = format!("{c_compiler}{}", env::consts::EXE_SUFFIX);
+        env::split_paths(&env::var_os("PATH")?)
+            .flat_map(|dir| [dir.join(c_compiler), dir.join(&with_suffix)])
+            .find(|path| path.is_file())?
+    };
+    let path = found.canonicalize().ok()?;
+    let metadata = fs::metadata(&path).ok()?;
+    Some((path, metadata))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn cache_key_depends_on_source_triple_and_flags() {
+        let key = |source: &str, triple: &str, flags: &[&str], artifact| {
+            let flags: Vec<String> = flags.iter().map(|flag| flag.to_string()).collect();
+            runtime_cache_key(source, "cc", triple, &flags, artifact)
+        };
+        let linux = "x86_64-unknown-linux-gnu";
+        let base = key("int x;", linux, &["-O2"], RuntimeArtifact::Object);
+
+        assert_eq!(
+            base,
+            key("int x;", linux, &["-O2"], RuntimeArtifact::Object)
+        );
+        assert_ne!(
+            base,
+            key("int y;", linux, &["-O2"], RuntimeArtifact::Object)
+        );
+        assert_ne!(
+            base,
+            key(
+                "int x;",
+                "aarch64-unknown-linux-gnu",
+                &["-O2"],
+                RuntimeArtifact::Object
+            )
+        );
+        assert_ne!(
+            base,
+            key("int x;", linux, &["-O2", "-flto"], RuntimeArtifact::Object)
+        );
+        assert_ne!(
+            base,
+            key("int x;", linux, &["-O2"], RuntimeArtifact::Bitcode)
+        );
+    }
+
+    #[test]
+    fn unique_names_differ_within_a_process() {
+        let names: Vec<String> = (0..4).map(|_| unique_name("key")).collect();
+        for (i, name) in names.iter().enumerate() {
+            assert!(name.starts_with(&format!("key.{}.", std::process::id())));
+            assert!(!names[i + 1..].contains(name));
+        }
+    }
+
+    #[cfg(unix)]
+    #[test]
+    fn compiler_version_is_only_queried_for_new_binaries() {
+        use std::os::unix::fs::PermissionsExt;
+
+        let dir = env::temp_dir().join(format!("otter-cc-fingerprint-{}", std::process::id()));
+        let records = dir.join("records");
+        fs::create_dir_all(&dir).unwrap();
+        let calls = dir.join("calls");
+        let compiler = dir.join("fake-cc");
+        let write_compiler = |version: &str| {
+            let script = format!(
+                "#!/bin/sh\necho x >> '{}'\necho '{version}'\n",
+                calls.display()
+            );
+            fs::write(&compiler, script).unwrap();
+            fs::set_permissions(&compiler, fs::Permissions::from_mode(0o755)).unwrap();
+        };
+        let queries = || fs::read_to_string(&calls).map_or(0, |log| log.lines().count());
+        let compiler_name = compiler.to_str().unwrap();
+
+        write_compiler("fake cc 1.0");
+        let first = compiler_fingerprint(compiler_name, Some(&records));
+        assert!(first.ends_with("fake cc 1.0\n"));
+        assert_eq!(compiler_fingerprint(compiler_name, Some(&records)), first);
+        assert_eq!(queries(), 1);
+
+        write_compiler("fake cc 2.0.1");
+        let second = compiler_fingerprint(compiler_name, Some(&records));
+        assert_ne!(second, first);
+        assert!(second.ends_with("fake cc 2.0.1\n"));
+        assert_eq!(queries(), 2);
+
+        let _ = fs::remove_dir_all(&dir);
+    }
+}
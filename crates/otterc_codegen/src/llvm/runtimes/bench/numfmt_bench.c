@@ -0,0 +1,78 @@
+// Benchmark for the shared number formatting kernel in ../numfmt.c against
+// the snprintf calls the runtimes used before it.
+//
+//   cc -O2 -o numfmt_bench numfmt_bench.c && ./numfmt_bench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../numfmt.c"
+
+#define BENCH_VALUES 4096
+#define BENCH_ROUNDS 500
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Metric-like values: counters, latencies and ratios.
+static void fill_values(int64_t* ints, double* floats, size_t count) {
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < count; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        ints[i] = (int64_t)(state >> (i % 48));
+        if (i % 3 == 0) ints[i] = -ints[i];
+        floats[i] = (double)(state >> 11) / (double)(1ULL << (i % 53));
+    }
+}
+
+int main(void) {
+    int64_t* ints = (int64_t*)malloc(sizeof(int64_t) * BENCH_VALUES);
+    double* floats = (double*)malloc(sizeof(double) * BENCH_VALUES);
+    if (!ints || !floats) return 1;
+    fill_values(ints, floats, BENCH_VALUES);
+
+    char buf[64];
+    size_t sink = 0;
+    const double total = (double)BENCH_VALUES * BENCH_ROUNDS;
+
+    double start = now_seconds();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (size_t i = 0; i < BENCH_VALUES; i++) sink += (size_t)snprintf(buf, sizeof(buf), "%lld", (long long)ints[i]);
+    }
+    double int_legacy = total / (now_seconds() - start) / 1e6;
+
+    start = now_seconds();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (size_t i = 0; i < BENCH_VALUES; i++) sink += otter_format_int_into(ints[i], buf, sizeof(buf));
+    }
+    double int_kernel = total / (now_seconds() - start) / 1e6;
+
+    // "%.17g" is what snprintf needs to round-trip, which is the contract
+    // the kernel provides.
+    start = now_seconds();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (size_t i = 0; i < BENCH_VALUES; i++) sink += (size_t)snprintf(buf, sizeof(buf), "%.17g", floats[i]);
+    }
+    double float_legacy = total / (now_seconds() - start) / 1e6;
+
+    start = now_seconds();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (size_t i = 0; i < BENCH_VALUES; i++) sink += otter_format_float_into(floats[i], buf, sizeof(buf));
+    }
+    double float_kernel = total / (now_seconds() - start) / 1e6;
+
+    printf("%-8s %14s %14s %8s\n", "value", "snprintf M/s", "kernel M/s", "speedup");
+    printf("%-8s %14.1f %14.1f %7.1fx\n", "int", int_legacy, int_kernel, int_kernel / int_legacy);
+    printf("%-8s %14.1f %14.1f %7.1fx\n", "float", float_legacy, float_kernel, float_kernel / float_legacy);
+    printf("(checksum %zu)\n", sink);
+
+    free(ints);
+    free(floats);
+    return 0;
+}
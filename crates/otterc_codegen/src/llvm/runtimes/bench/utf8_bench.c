@@ -0,0 +1,119 @@
+// Benchmark for the shared UTF-8 kernel in ../utf8.c against the
+// byte-at-a-time loop the runtimes used before it.
+//
+//   cc -O2 -o utf8_bench utf8_bench.c && ./utf8_bench
+//
+// Add -DOTTER_UTF8_SCALAR_ONLY to measure the embedded fallback instead of
+// the SIMD path picked for the host CPU.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../utf8.c"
+
+#define BENCH_INPUT_SIZE (1u << 20)
+#define BENCH_ROUNDS 200
+
+// The validation loop that standard.c, wasm.c and embedded.c each carried.
+static int legacy_is_valid_utf8(const unsigned char* str, size_t len) {
+    size_t i = 0;
+    while (i < len) {
+        if (str[i] == 0) break;
+        int bytes_needed;
+        if ((str[i] & 0x80) == 0) {
+            bytes_needed = 1;
+        } else if ((str[i] & 0xE0) == 0xC0) {
+            bytes_needed = 2;
+        } else if ((str[i] & 0xF0) == 0xE0) {
+            bytes_needed = 3;
+        } else if ((str[i] & 0xF8) == 0xF0) {
+            bytes_needed = 4;
+        } else {
+            return 0;
+        }
+        if (i + bytes_needed > len) return 0;
+        for (int j = 1; j < bytes_needed; j++) {
+            if ((str[i + j] & 0xC0) != 0x80) return 0;
+        }
+        i += bytes_needed;
+    }
+    return 1;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Mostly log-line ASCII with an occasional multi-byte character.
+static void fill_ascii_heavy(unsigned char* buf, size_t len) {
+    static const char line[] = "2024-05-01T12:00:00Z level=info msg=\"request served\" status=200 path=/api/v1/items\n";
+    for (size_t i = 0; i < len; i++) buf[i] = (unsigned char)line[i % (sizeof(line) - 1)];
+    for (size_t i = 4096; i + 2 < len; i += 4096) {
+        buf[i] = 0xC3;
+        buf[i + 1] = 0xA9;
+    }
+}
+
+// Roughly one third ASCII, two- and three-byte sequences each.
+static void fill_mixed(unsigned char* buf, size_t len) {
+    static const unsigned char pattern[] = {
+        'o', 't', 't', 'e', 'r', ' ', 0xC3, 0xA9, 0xC3, 0xB1, 0xE2, 0x82, 0xAC, 0xE6, 0x97, 0xA5,
+    };
+    for (size_t i = 0; i < len; i++) buf[i] = pattern[i % sizeof(pattern)];
+    // Keep the tail on a sequence boundary.
+    for (size_t i = len - len % sizeof(pattern); i < len; i++) buf[i] = ' ';
+}
+
+// ASCII with a stray continuation byte near the end.
+static void fill_invalid(unsigned char* buf, size_t len) {
+    fill_ascii_heavy(buf, len);
+    for (size_t i = 4096; i + 2 < len; i += 4096) buf[i] = buf[i + 1] = 'x';
+    buf[len - 100] = 0x80;
+}
+
+typedef int (*ValidateFn)(const unsigned char*, size_t);
+
+static double bench(ValidateFn fn, const unsigned char* buf, size_t len, int* result) {
+    double start = now_seconds();
+    int acc = 0;
+    for (int round = 0; round < BENCH_ROUNDS; round++) acc += fn(buf, len);
+    double elapsed = now_seconds() - start;
+    *result = acc / BENCH_ROUNDS;
+    return (double)len * BENCH_ROUNDS / elapsed / 1e9;
+}
+
+int main(void) {
+    (void)otter_utf8_repair;
+    unsigned char* buf = (unsigned char*)malloc(BENCH_INPUT_SIZE);
+    if (!buf) return 1;
+
+    struct {
+        const char* name;
+        void (*fill)(unsigned char*, size_t);
+    } inputs[] = {
+        {"ascii-heavy", fill_ascii_heavy},
+        {"mixed", fill_mixed},
+        {"invalid", fill_invalid},
+    };
+
+    printf("%-12s %14s %14s %8s\n", "input", "legacy GB/s", "kernel GB/s", "speedup");
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+        inputs[i].fill(buf, BENCH_INPUT_SIZE);
+        int legacy_result = 0, kernel_result = 0;
+        double legacy = bench(legacy_is_valid_utf8, buf, BENCH_INPUT_SIZE, &legacy_result);
+        double kernel = bench(otter_utf8_validate, buf, BENCH_INPUT_SIZE, &kernel_result);
+        if (legacy_result != kernel_result) {
+            fprintf(stderr, "%s: kernel and legacy disagree (%d vs %d)\n",
+                    inputs[i].name, kernel_result, legacy_result);
+            free(buf);
+            return 1;
+        }
+        printf("%-12s %14.2f %14.2f %7.1fx\n", inputs[i].name, legacy, kernel, kernel / legacy);
+    }
+
+    free(buf);
+    return 0;
+}
@@ -1,47 +1,112 @@
 #include <stdint.h>
 #include <stdbool.h>
-#include <stdlib.h>
 #include <string.h>
 
 // Minimal runtime for embedded targets
 // No stdio, no system calls - just basic memory operations
 
-int otter_is_valid_utf8(const unsigned char* str, size_t len) {
-    size_t i = 0;
-    while (i < len) {
-        if (str[i] == 0) break;
-        int bytes_needed;
-        if ((str[i] & 0x80) == 0) {
-            bytes_needed = 1;
-        } else if ((str[i] & 0xE0) == 0xC0) {
-            bytes_needed = 2;
-        } else if ((str[i] & 0xF0) == 0xE0) {
-            bytes_needed = 3;
-        } else if ((str[i] & 0xF8) == 0xF0) {
-            bytes_needed = 4;
-        } else {
-            return 0;
-        }
-        if (i + bytes_needed > len) return 0;
-        for (int j = 1; j < bytes_needed; j++) {
-            if ((str[i + j] & 0xC0) != 0x80) return 0;
-        }
-        i += bytes_needed;
+// Every string the runtime returns comes from a static pool sized at compile
+// time (-DOTTER_POOL_SIZE=<bytes>), so the RAM ceiling is known at link time
+// and no libc allocator is needed. Blocks are 16 to 1024 bytes, header
+// included, in power-of-two classes; each class keeps a free list and
+// untouched pool memory is handed out by a bump pointer, so alloc and free
+// are O(1) with no search. A request that does not fit any class, or finds
+// its free list empty and the pool exhausted, returns NULL.
+#ifndef OTTER_POOL_SIZE
+#define OTTER_POOL_SIZE (16 * 1024)
+#endif
+
+#define OTTER_POOL_CLASSES 7
+#define OTTER_POOL_MIN_SHIFT 4
+#define OTTER_POOL_MAX_BLOCK (1u << (OTTER_POOL_MIN_SHIFT + OTTER_POOL_CLASSES - 1))
+#define OTTER_POOL_LIVE 0x4F500000u
+
+// Sits in front of every block: OTTER_POOL_LIVE | class while allocated,
+// 0 once freed. A free block keeps the arena offset of the next free block
+// of its class (plus one, so 0 ends the list) right after the header.
+typedef uint32_t OtterPoolHeader;
+
+static uint32_t otter_pool_arena[OTTER_POOL_SIZE / sizeof(uint32_t)];
+static uint32_t otter_pool_free_lists[OTTER_POOL_CLASSES];
+static size_t otter_pool_bump = 0;
+static size_t otter_pool_in_use = 0;
+static size_t otter_pool_peak = 0;
+
+static unsigned otter_pool_class(size_t block_size) {
+    if (block_size <= (1u << OTTER_POOL_MIN_SHIFT)) return 0;
+    return (32 - (unsigned)__builtin_clz((uint32_t)(block_size - 1))) - OTTER_POOL_MIN_SHIFT;
+}
+
+static void* otter_pool_alloc(size_t size) {
+    if (size > OTTER_POOL_MAX_BLOCK - sizeof(OtterPoolHeader)) return NULL;
+    unsigned index = otter_pool_class(size + sizeof(OtterPoolHeader));
+    size_t block_size = (size_t)1 << (index + OTTER_POOL_MIN_SHIFT);
+
+    OtterPoolHeader* header;
+    if (otter_pool_free_lists[index]) {
+        header = (OtterPoolHeader*)((char*)otter_pool_arena + otter_pool_free_lists[index] - 1);
+        otter_pool_free_lists[index] = header[1];
+    } else {
+        if (block_size > sizeof(otter_pool_arena) - otter_pool_bump) return NULL;
+        header = (OtterPoolHeader*)((char*)otter_pool_arena + otter_pool_bump);
+        otter_pool_bump += block_size;
     }
-    return 1;
+    *header = OTTER_POOL_LIVE | index;
+    otter_pool_in_use += block_size;
+    if (otter_pool_in_use > otter_pool_peak) otter_pool_peak = otter_pool_in_use;
+    return header + 1;
+}
+
+// Pointers outside the pool (string literals, caller-owned buffers) and
+// blocks that are already free are ignored.
+static void otter_pool_free(void* ptr) {
+    char* bytes = (char*)ptr;
+    char* arena = (char*)otter_pool_arena;
+    if (!bytes || bytes < arena + sizeof(OtterPoolHeader) || bytes >= arena + otter_pool_bump) return;
+    OtterPoolHeader* header = (OtterPoolHeader*)ptr - 1;
+    if ((*header & ~0xFFu) != OTTER_POOL_LIVE) return;
+    unsigned index = *header & 0xFFu;
+    *header = 0;
+    otter_pool_in_use -= (size_t)1 << (index + OTTER_POOL_MIN_SHIFT);
+    header[1] = otter_pool_free_lists[index];
+    otter_pool_free_lists[index] = (uint32_t)((char*)header - arena) + 1;
+}
+
+size_t otter_pool_capacity(void) {
+    return sizeof(otter_pool_arena);
+}
+
+size_t otter_pool_in_use_bytes(void) {
+    return otter_pool_in_use;
+}
+
+// Most pool bytes ever held by live blocks at once.
+size_t otter_pool_high_water(void) {
+    return otter_pool_peak;
+}
+
+static char* otter_pool_dup(const char* src, size_t len) {
+    char* result = (char*)otter_pool_alloc(len + 1);
+    if (!result) return NULL;
+    memcpy(result, src, len);
+    result[len] = '\0';
+    return result;
+}
+
+int otter_is_valid_utf8(const unsigned char* str, size_t len) {
+    return otter_utf8_validate(str, len);
 }
 
 char* otter_normalize_text(const char* input) {
     if (!input) return NULL;
     size_t len = strlen(input);
     if (otter_is_valid_utf8((const unsigned char*)input, len)) {
-        char* result = (char*)malloc(len + 1);
-        if (result) memcpy(result, input, len + 1);
-        return result;
+        return otter_pool_dup(input, len);
     }
-    // Simplified: just copy the input
-    char* result = (char*)malloc(len + 1);
-    if (result) memcpy(result, input, len + 1);
+    char* result = (char*)otter_pool_alloc(len * 3 + 1);
+    if (!result) return NULL;
+    size_t out_pos = otter_utf8_repair((const unsigned char*)input, len, result);
+    result[out_pos] = '\0';
     return result;
 }
 
@@ -61,7 +126,7 @@ char* otter_std_io_read_line() {
 }
 
 void otter_std_io_free_string(char* ptr) {
-    if (ptr) free(ptr);
+    otter_pool_free(ptr);
 }
 
 int64_t otter_std_time_now_ms() {
@@ -70,31 +135,23 @@ int64_t otter_std_time_now_ms() {
 }
 
 char* otter_format_float(double value) {
-    (void)value;
-    // Minimal implementation - would need custom float formatting
-    char* buffer = (char*)malloc(32);
-    if (buffer) buffer[0] = '\0';
-    return buffer;
+    char digits[OTTER_FMT_FLOAT_BUFFER];
+    return otter_pool_dup(digits, otter_fmt_f64(value, digits));
 }
 
 char* otter_format_int(int64_t value) {
-    // Minimal implementation
-    char* buffer = (char*)malloc(32);
-    if (buffer) buffer[0] = '\0';
-    return buffer;
+    char digits[OTTER_FMT_INT_BUFFER];
+    return otter_pool_dup(digits, otter_fmt_i64(value, digits));
 }
 
 char* otter_format_bool(bool value) {
-    const char* str = value ? "true" : "false";
-    char* buffer = (char*)malloc(strlen(str) + 1);
-    if (buffer) memcpy(buffer, str, strlen(str) + 1);
-    return buffer;
+    return value ? otter_pool_dup("true", 4) : otter_pool_dup("false", 5);
 }
 
 char* otter_str_concat(const char* s1, const char* s2) {
     if (!s1 || !s2) return NULL;
     size_t len1 = strlen(s1), len2 = strlen(s2);
-    char* result = (char*)malloc(len1 + len2 + 1);
+    char* result = (char*)otter_pool_alloc(len1 + len2 + 1);
     if (result) {
         memcpy(result, s1, len1);
         memcpy(result + len1, s2, len2 + 1);
@@ -103,25 +160,10 @@ char* otter_str_concat(const char* s1, const char* s2) {
 }
 
 void otter_free_string(char* ptr) {
-    if (ptr) free(ptr);
+    otter_pool_free(ptr);
 }
 
 int otter_validate_utf8(const char* ptr) {
     if (!ptr) return 0;
-    while (*ptr) {
-        unsigned char c = (unsigned char)*ptr;
-        if (c <= 0x7F) ptr++;
-        else if (c <= 0xDF) {
-            if (!ptr[1] || (ptr[1] & 0xC0) != 0x80) return 0;
-            ptr += 2;
-        } else if (c <= 0xEF) {
-            if (!ptr[1] || !ptr[2] || (ptr[1] & 0xC0) != 0x80 || (ptr[2] & 0xC0) != 0x80) return 0;
-            ptr += 3;
-        } else if (c <= 0xF7) {
-            if (!ptr[1] || !ptr[2] || !ptr[3] ||
-                (ptr[1] & 0xC0) != 0x80 || (ptr[2] & 0xC0) != 0x80 || (ptr[3] & 0xC0) != 0x80) return 0;
-            ptr += 4;
-        } else return 0;
-    }
-    return 1;
-}
\ No newline at end of file
+    return otter_utf8_validate((const unsigned char*)ptr, strlen(ptr));
+}
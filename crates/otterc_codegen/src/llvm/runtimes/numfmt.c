@@ -0,0 +1,351 @@
+// Shared number formatting kernel.
+//
+// build.rs prepends this file (after utf8.c) to every C runtime. Integers
+// are written two digits per step from a pair table; floats use Grisu2,
+// which always produces a string that parses back to the same double and
+// is the shortest such string for nearly every input. Both write into a
+// caller-provided buffer so hot paths can format without allocating.
+//
+// Floats print in plain notation when the decimal exponent lies in
+// [-6, 21) and in scientific notation ("1.5e-7", "1e+21") otherwise.
+// Integral values print without a fractional part ("3", not "3.0").
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Large enough for any value produced below, including the terminator.
+#define OTTER_FMT_INT_BUFFER 24
+#define OTTER_FMT_FLOAT_BUFFER 32
+
+static const char otter_fmt_digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Writes the decimal digits of `value` ending just before `end` and returns
+// a pointer to the first digit.
+static char* otter_fmt_u64_backwards(uint64_t value, char* end) {
+    char* p = end;
+    while (value >= 100) {
+        unsigned pair = (unsigned)(value % 100) * 2;
+        value /= 100;
+        p -= 2;
+        p[0] = otter_fmt_digit_pairs[pair];
+        p[1] = otter_fmt_digit_pairs[pair + 1];
+    }
+    if (value >= 10) {
+        unsigned pair = (unsigned)value * 2;
+        p -= 2;
+        p[0] = otter_fmt_digit_pairs[pair];
+        p[1] = otter_fmt_digit_pairs[pair + 1];
+    } else {
+        *--p = (char)('0' + value);
+    }
+    return p;
+}
+
+// Formats `value` into `out` (no terminator) and returns the length.
+// `out` needs OTTER_FMT_INT_BUFFER - 1 bytes.
+static size_t otter_fmt_i64(int64_t value, char* out) {
+    char tmp[OTTER_FMT_INT_BUFFER];
+    char* end = tmp + sizeof(tmp);
+    uint64_t magnitude = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    char* start = otter_fmt_u64_backwards(magnitude, end);
+    if (value < 0) *--start = '-';
+    size_t len = (size_t)(end - start);
+    memcpy(out, start, len);
+    return len;
+}
+
+// --- Grisu2 -----------------------------------------------------------------
+
+typedef struct OtterDiyFp {
+    uint64_t f;
+    int e;
+} OtterDiyFp;
+
+#define OTTER_DP_SIGNIFICAND_MASK 0x000FFFFFFFFFFFFFULL
+#define OTTER_DP_EXPONENT_MASK 0x7FF0000000000000ULL
+#define OTTER_DP_HIDDEN_BIT 0x0010000000000000ULL
+#define OTTER_DP_EXPONENT_BIAS 1075
+
+// Normalized 10^k for k = -348, -340, ..., 340.
+static const uint64_t otter_fmt_cached_powers_f[] = {
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+    0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+    0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+    0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+    0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+    0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+    0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+    0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+    0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+    0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+    0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+    0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+    0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+    0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+    0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+    0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+    0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+    0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+    0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+    0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+    0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+    0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+};
+
+static const int16_t otter_fmt_cached_powers_e[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066,
+};
+
+static const uint64_t otter_fmt_pow10[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL,
+};
+
+static OtterDiyFp otter_diyfp_make(uint64_t f, int e) {
+    OtterDiyFp fp = { f, e };
+    return fp;
+}
+
+static OtterDiyFp otter_diyfp_from_double(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int biased_e = (int)((bits & OTTER_DP_EXPONENT_MASK) >> 52);
+    uint64_t significand = bits & OTTER_DP_SIGNIFICAND_MASK;
+    if (biased_e != 0) {
+        return otter_diyfp_make(significand + OTTER_DP_HIDDEN_BIT, biased_e - OTTER_DP_EXPONENT_BIAS);
+    }
+    return otter_diyfp_make(significand, 1 - OTTER_DP_EXPONENT_BIAS);
+}
+
+static OtterDiyFp otter_diyfp_normalize(OtterDiyFp fp) {
+    while (!(fp.f & 0x8000000000000000ULL)) {
+        fp.f <<= 1;
+        fp.e--;
+    }
+    return fp;
+}
+
+static OtterDiyFp otter_diyfp_mul(OtterDiyFp x, OtterDiyFp y) {
+    const uint64_t mask32 = 0xFFFFFFFFULL;
+    uint64_t a = x.f >> 32, b = x.f & mask32;
+    uint64_t c = y.f >> 32, d = y.f & mask32;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t tmp = (bd >> 32) + (ad & mask32) + (bc & mask32);
+    tmp += 1ULL << 31; // round
+    return otter_diyfp_make(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), x.e + y.e + 64);
+}
+
+// The neighbouring boundaries m- and m+ of `v`, sharing m+'s exponent.
+static void otter_diyfp_boundaries(OtterDiyFp v, OtterDiyFp* minus, OtterDiyFp* plus) {
+    OtterDiyFp pl = otter_diyfp_make((v.f << 1) + 1, v.e - 1);
+    while (!(pl.f & (OTTER_DP_HIDDEN_BIT << 1))) {
+        pl.f <<= 1;
+        pl.e--;
+    }
+    pl.f <<= 10;
+    pl.e -= 10;
+    OtterDiyFp mi = v.f == OTTER_DP_HIDDEN_BIT
+        ? otter_diyfp_make((v.f << 2) - 1, v.e - 2)
+        : otter_diyfp_make((v.f << 1) - 1, v.e - 1);
+    mi.f <<= mi.e - pl.e;
+    mi.e = pl.e;
+    *minus = mi;
+    *plus = pl;
+}
+
+static OtterDiyFp otter_fmt_cached_power(int e, int* k) {
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int ki = (int)dk;
+    if (dk - ki > 0.0) ki++;
+    unsigned index = (unsigned)((ki >> 3) + 1);
+    *k = -(-348 + (int)(index * 8));
+    return otter_diyfp_make(otter_fmt_cached_powers_f[index], otter_fmt_cached_powers_e[index]);
+}
+
+static void otter_grisu_round(char* buffer, int len, uint64_t delta, uint64_t rest,
+                              uint64_t ten_kappa, uint64_t wp_w) {
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+        buffer[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static int otter_fmt_count_digits32(uint32_t n) {
+    int digits = 1;
+    while (digits < 10 && n >= otter_fmt_pow10[digits]) digits++;
+    return digits;
+}
+
+static void otter_grisu_digit_gen(OtterDiyFp w, OtterDiyFp mp, uint64_t delta,
+                                  char* buffer, int* len, int* k) {
+    OtterDiyFp one = otter_diyfp_make(1ULL << -mp.e, mp.e);
+    uint64_t wp_w = mp.f - w.f;
+    uint32_t p1 = (uint32_t)(mp.f >> -one.e);
+    uint64_t p2 = mp.f & (one.f - 1);
+    int kappa = otter_fmt_count_digits32(p1);
+    *len = 0;
+
+    while (kappa > 0) {
+        uint32_t divisor = (uint32_t)otter_fmt_pow10[kappa - 1];
+        uint32_t d = p1 / divisor;
+        p1 %= divisor;
+        if (d || *len) buffer[(*len)++] = (char)('0' + d);
+        kappa--;
+        uint64_t tmp = ((uint64_t)p1 << -one.e) + p2;
+        if (tmp <= delta) {
+            *k += kappa;
+            otter_grisu_round(buffer, *len, delta, tmp, otter_fmt_pow10[kappa] << -one.e, wp_w);
+            return;
+        }
+    }
+
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        char d = (char)(p2 >> -one.e);
+        if (d || *len) buffer[(*len)++] = (char)('0' + d);
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta) {
+            *k += kappa;
+            int index = -kappa;
+            otter_grisu_round(buffer, *len, delta, p2, one.f, wp_w * (index < 20 ? otter_fmt_pow10[index] : 0));
+            return;
+        }
+    }
+}
+
+// Shortest digits of a finite, positive `value`: value = digits * 10^k.
+static int otter_grisu2(double value, char* digits, int* k) {
+    OtterDiyFp v = otter_diyfp_from_double(value);
+    OtterDiyFp w_minus, w_plus;
+    otter_diyfp_boundaries(v, &w_minus, &w_plus);
+    OtterDiyFp c_mk = otter_fmt_cached_power(w_plus.e, k);
+    OtterDiyFp w = otter_diyfp_mul(otter_diyfp_normalize(v), c_mk);
+    OtterDiyFp wp = otter_diyfp_mul(w_plus, c_mk);
+    OtterDiyFp wm = otter_diyfp_mul(w_minus, c_mk);
+    wm.f++;
+    wp.f--;
+    int len = 0;
+    otter_grisu_digit_gen(w, wp, wp.f - wm.f, digits, &len, k);
+    return len;
+}
+
+// Formats `value` into `out` (no terminator) and returns the length.
+// `out` needs OTTER_FMT_FLOAT_BUFFER - 1 bytes.
+static size_t otter_fmt_f64(double value, char* out) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int negative = (bits >> 63) != 0;
+    size_t pos = 0;
+
+    if ((bits & OTTER_DP_EXPONENT_MASK) == OTTER_DP_EXPONENT_MASK) {
+        if (bits & OTTER_DP_SIGNIFICAND_MASK) {
+            memcpy(out, "nan", 3);
+            return 3;
+        }
+        if (negative) out[pos++] = '-';
+        memcpy(out + pos, "inf", 3);
+        return pos + 3;
+    }
+    if (negative) out[pos++] = '-';
+    if ((bits & ~(1ULL << 63)) == 0) {
+        out[pos++] = '0';
+        return pos;
+    }
+
+    char digits[20];
+    int k = 0;
+    int len = otter_grisu2(negative ? -value : value, digits, &k);
+    int point = len + k; // position of the decimal point relative to the digits
+
+    if (point > 0 && point <= 21) {
+        if (k >= 0) {
+            memcpy(out + pos, digits, (size_t)len);
+            pos += (size_t)len;
+            memset(out + pos, '0', (size_t)k);
+            pos += (size_t)k;
+        } else {
+            memcpy(out + pos, digits, (size_t)point);
+            pos += (size_t)point;
+            out[pos++] = '.';
+            memcpy(out + pos, digits + point, (size_t)(len - point));
+            pos += (size_t)(len - point);
+        }
+    } else if (point <= 0 && point > -6) {
+        out[pos++] = '0';
+        out[pos++] = '.';
+        memset(out + pos, '0', (size_t)-point);
+        pos += (size_t)-point;
+        memcpy(out + pos, digits, (size_t)len);
+        pos += (size_t)len;
+    } else {
+        out[pos++] = digits[0];
+        if (len > 1) {
+            out[pos++] = '.';
+            memcpy(out + pos, digits + 1, (size_t)(len - 1));
+            pos += (size_t)(len - 1);
+        }
+        int exponent = point - 1;
+        out[pos++] = 'e';
+        out[pos++] = exponent < 0 ? '-' : '+';
+        char tmp[4];
+        char* end = tmp + sizeof(tmp);
+        char* start = otter_fmt_u64_backwards((uint64_t)(exponent < 0 ? -exponent : exponent), end);
+        memcpy(out + pos, start, (size_t)(end - start));
+        pos += (size_t)(end - start);
+    }
+    return pos;
+}
+
+// snprintf-style entry points: always return the full length, and write a
+// NUL-terminated result only when it fits in `cap` bytes.
+size_t otter_format_int_into(int64_t value, char* buf, size_t cap) {
+    char tmp[OTTER_FMT_INT_BUFFER];
+    size_t len = otter_fmt_i64(value, tmp);
+    if (buf && len < cap) {
+        memcpy(buf, tmp, len);
+        buf[len] = '\0';
+    }
+    return len;
+}
+
+size_t otter_format_float_into(double value, char* buf, size_t cap) {
+    char tmp[OTTER_FMT_FLOAT_BUFFER];
+    size_t len = otter_fmt_f64(value, tmp);
+    if (buf && len < cap) {
+        memcpy(buf, tmp, len);
+        buf[len] = '\0';
+    }
+    return len;
+}
+
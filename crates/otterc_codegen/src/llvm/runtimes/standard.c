@@ -7,6 +7,9 @@
 #ifndef _WIN32
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+#include <pthread.h>
+#include <unistd.h>
 #else
 #define WIN32_LEAN_AND_MEAN
 #ifndef NOMINMAX
@@ -14,6 +17,7 @@
 #endif
 #include <windows.h>
 #include <BaseTsd.h>
+#include <io.h>
 typedef SSIZE_T ssize_t;
 
 struct timeval {
@@ -79,96 +83,335 @@ static ssize_t otter_getline(char** lineptr, size_t* n, FILE* stream) {
 #define getline otter_getline
 #endif
 
-int otter_is_valid_utf8(const unsigned char* str, size_t len) {
-    size_t i = 0;
-    while (i < len) {
-        if (str[i] == 0) break;
-        int bytes_needed;
-        if ((str[i] & 0x80) == 0) {
-            bytes_needed = 1;
-        } else if ((str[i] & 0xE0) == 0xC0) {
-            bytes_needed = 2;
-        } else if ((str[i] & 0xF0) == 0xE0) {
-            bytes_needed = 3;
-        } else if ((str[i] & 0xF8) == 0xF0) {
-            bytes_needed = 4;
+#if OTTER_RUNTIME_STATS
+// Every thread that touches a counter gets its own zeroed block, linked into
+// a global list so snapshots can sum them. Blocks are never freed: a thread
+// that exits still contributes what it counted.
+typedef struct OtterStatsNode {
+    OtterRuntimeStats stats;
+    struct OtterStatsNode* next;
+} OtterStatsNode;
+
+static OtterStatsNode* otter_stats_threads = NULL;
+static __thread OtterRuntimeStats* otter_stats_current = NULL;
+static __thread bool otter_stats_failed = false;
+static const char* otter_stats_report_path = NULL;
+static struct timeval otter_stats_started;
+
+static void otter_stats_report(void);
+
+// Runs before main (or when a shared library is loaded), so the report is
+// written even by programs that never touch a counter.
+__attribute__((constructor)) static void otter_stats_init(void) {
+    const char* path = getenv("OTTER_RUNTIME_STATS_FILE");
+    if (path && path[0]) {
+        otter_stats_report_path = path;
+        gettimeofday(&otter_stats_started, NULL);
+        atexit(otter_stats_report);
+    }
+}
+
+static OtterRuntimeStats* otter_stats_register(void) {
+    OtterStatsNode* node = (OtterStatsNode*)calloc(1, sizeof(OtterStatsNode));
+    if (!node) {
+        // Stop counting on this thread rather than retrying every update.
+        otter_stats_failed = true;
+        return NULL;
+    }
+    node->next = __atomic_load_n(&otter_stats_threads, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&otter_stats_threads, &node->next, node, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+    otter_stats_current = &node->stats;
+    return otter_stats_current;
+}
+
+static inline OtterRuntimeStats* otter_stats_local(void) {
+    if (__builtin_expect(otter_stats_current != NULL, 1)) return otter_stats_current;
+    return otter_stats_failed ? NULL : otter_stats_register();
+}
+
+// Fold one thread's counters into `total`.
+static void otter_stats_accumulate(OtterRuntimeStats* total, const OtterRuntimeStats* stats) {
+    total->allocations += __atomic_load_n(&stats->allocations, __ATOMIC_RELAXED);
+    total->allocated_bytes += __atomic_load_n(&stats->allocated_bytes, __ATOMIC_RELAXED);
+    total->frees += __atomic_load_n(&stats->frees, __ATOMIC_RELAXED);
+    total->freed_bytes += __atomic_load_n(&stats->freed_bytes, __ATOMIC_RELAXED);
+    for (int kind = 0; kind < OTTER_ALLOC_KINDS; kind++) {
+        total->kind_allocations[kind] += __atomic_load_n(&stats->kind_allocations[kind], __ATOMIC_RELAXED);
+        total->kind_bytes[kind] += __atomic_load_n(&stats->kind_bytes[kind], __ATOMIC_RELAXED);
+    }
+    total->normalize_calls += __atomic_load_n(&stats->normalize_calls, __ATOMIC_RELAXED);
+    total->normalize_repairs += __atomic_load_n(&stats->normalize_repairs, __ATOMIC_RELAXED);
+    total->exceptions_raised += __atomic_load_n(&stats->exceptions_raised, __ATOMIC_RELAXED);
+    uint64_t depth = __atomic_load_n(&stats->max_context_depth, __ATOMIC_RELAXED);
+    if (depth > total->max_context_depth) total->max_context_depth = depth;
+}
+#endif
+
+// Sums the counters of every thread into `out`. Threads still running may be
+// mid-update, so the totals are approximate until they stop.
+void otter_runtime_stats_snapshot(OtterRuntimeStats* out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+#if OTTER_RUNTIME_STATS
+    for (OtterStatsNode* node = __atomic_load_n(&otter_stats_threads, __ATOMIC_ACQUIRE); node;
+         node = node->next) {
+        otter_stats_accumulate(out, &node->stats);
+    }
+#endif
+}
+
+#if OTTER_RUNTIME_STATS
+// At exit, writes the snapshot as JSON to $OTTER_RUNTIME_STATS_FILE ("-" for
+// stderr) for `otter profile stats --file`. A report that outgrows the stack
+// buffer is formatted again on the heap; if that fails too, what fits is
+// written with a warning on stderr.
+static void otter_stats_report(void) {
+    OtterRuntimeStats stats;
+    otter_runtime_stats_snapshot(&stats);
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    double duration = (double)(now.tv_sec - otter_stats_started.tv_sec) +
+                      (double)(now.tv_usec - otter_stats_started.tv_usec) / 1e6;
+
+    char buffer[1024];
+    char* json = buffer;
+    size_t len = otter_runtime_stats_format_json(&stats, duration, buffer, sizeof(buffer));
+    if (len >= sizeof(buffer)) {
+        char* grown = (char*)malloc(len + 1);
+        if (grown) {
+            json = grown;
+            len = otter_runtime_stats_format_json(&stats, duration, grown, len + 1);
         } else {
-            return 0;
+            fprintf(stderr, "otter: runtime stats report truncated to %zu of %zu bytes\n",
+                    sizeof(buffer), len);
+            len = sizeof(buffer);
         }
-        if (i + bytes_needed > len) return 0;
-        for (int j = 1; j < bytes_needed; j++) {
-            if ((str[i + j] & 0xC0) != 0x80) return 0;
+    }
+    if (strcmp(otter_stats_report_path, "-") == 0) {
+        fwrite(json, 1, len, stderr);
+    } else {
+        FILE* file = fopen(otter_stats_report_path, "w");
+        if (file) {
+            fwrite(json, 1, len, file);
+            fclose(file);
         }
-        i += bytes_needed;
     }
-    return 1;
+    if (json != buffer) free(json);
+}
+#endif
+
+// String blocks come straight from the C heap. Strings the runtime did not
+// allocate (Rust runtime and FFI results) were malloc'd too and are freed as
+// they are.
+static void* otter_str_block_alloc(size_t size) {
+    return malloc(size);
+}
+
+static void otter_str_block_free(void* block) {
+    free(block);
+}
+
+static void otter_str_foreign_free(char* s) {
+    free(s);
 }
 
 char* otter_normalize_text(const char* input) {
     if (!input) return NULL;
-    size_t len = strlen(input);
-    if (otter_is_valid_utf8((const unsigned char*)input, len)) {
-        char* result = (char*)malloc(len + 1);
-        if (result) {
-            memcpy(result, input, len + 1);
-        }
-        return result;
+    OTTER_STAT_ADD(normalize_calls, 1);
+    size_t len = otter_str_len(input);
+    if (otter_str_utf8_valid(input, len)) {
+        OTTER_STAT_ALLOC_KIND(OTTER_ALLOC_NORMALIZE, len);
+        return otter_str_from_slice(input, len, OTTER_STR_FLAG_UTF8_CHECKED | OTTER_STR_FLAG_UTF8_VALID);
     }
-    char* result = (char*)malloc(len * 3 + 1);
+    char* result = otter_str_alloc(len * 3);
     if (!result) return NULL;
-    size_t i = 0, out_pos = 0;
-    while (i < len) {
-        unsigned char c = (unsigned char)input[i];
-        if (c == 0) break;
-        int bytes_needed = 0, valid_sequence = 1;
-        if ((c & 0x80) == 0) bytes_needed = 1;
-        else if ((c & 0xE0) == 0xC0) bytes_needed = 2;
-        else if ((c & 0xF0) == 0xE0) bytes_needed = 3;
-        else if ((c & 0xF8) == 0xF0) bytes_needed = 4;
-        else { valid_sequence = 0; bytes_needed = 1; }
-        if (i + bytes_needed > len) valid_sequence = 0;
-        else if (bytes_needed > 1) {
-            for (int j = 1; j < bytes_needed && valid_sequence; j++) {
-                if ((input[i + j] & 0xC0) != 0x80) valid_sequence = 0;
-            }
+    OTTER_STAT_ADD(normalize_repairs, 1);
+    OTTER_STAT_ALLOC_KIND(OTTER_ALLOC_NORMALIZE, len * 3);
+    size_t out_pos = otter_utf8_repair((const unsigned char*)input, len, result);
+    otter_str_set_len(result, out_pos, OTTER_STR_FLAG_UTF8_CHECKED | OTTER_STR_FLAG_UTF8_VALID);
+    return result;
+}
+
+// Runtime-owned output buffers. Prints append straight into them (repairing
+// invalid UTF-8 in place, so no normalized copy is made) and reach the fd in
+// large writes: when the buffer fills, on otter_std_io_flush, at exit, and
+// after every print when the fd is a terminal. stderr is flushed after every
+// message, and stdout is flushed before it so the two streams stay ordered.
+#define OTTER_OUT_BUFFER_SIZE (64 * 1024)
+
+typedef struct OtterOutBuffer {
+    int fd;
+    int is_tty; // -1 until probed
+    size_t len;
+    char data[OTTER_OUT_BUFFER_SIZE];
+} OtterOutBuffer;
+
+static OtterOutBuffer otter_stdout_buffer = { 1, -1, 0, {0} };
+static OtterOutBuffer otter_stderr_buffer = { 2, -1, 0, {0} };
+static bool otter_out_exit_hook = false;
+
+void otter_std_io_flush(void);
+
+// Held across the write syscalls, so it is a blocking lock: a thread waiting
+// on a slow pipe or terminal must not keep other printers spinning.
+#ifdef _WIN32
+static SRWLOCK otter_out_lock = SRWLOCK_INIT;
+
+static void otter_out_acquire(void) {
+    AcquireSRWLockExclusive(&otter_out_lock);
+}
+
+static void otter_out_release(void) {
+    ReleaseSRWLockExclusive(&otter_out_lock);
+}
+#else
+static pthread_mutex_t otter_out_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void otter_out_acquire(void) {
+    pthread_mutex_lock(&otter_out_lock);
+}
+
+static void otter_out_release(void) {
+    pthread_mutex_unlock(&otter_out_lock);
+}
+#endif
+
+static void otter_fd_write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+#ifdef _WIN32
+        int n = _write(fd, data, (unsigned int)(len > 0x40000000 ? 0x40000000 : len));
+#else
+        ssize_t n = write(fd, data, len);
+#endif
+        if (n <= 0) return;
+        data += n;
+        len -= (size_t)n;
+    }
+}
+
+// Write the buffered bytes followed by `extra` in as few syscalls as possible.
+static void otter_out_drain(OtterOutBuffer* out, const char* extra, size_t extra_len) {
+#ifndef _WIN32
+    if (out->len > 0 && extra_len > 0) {
+        struct iovec iov[2] = {
+            { out->data, out->len },
+            { (void*)extra, extra_len },
+        };
+        size_t total = out->len + extra_len;
+        ssize_t n = writev(out->fd, iov, 2);
+        if (n > 0 && (size_t)n == total) {
+            out->len = 0;
+            return;
         }
-        if (valid_sequence) {
-            for (int j = 0; j < bytes_needed; j++) result[out_pos++] = input[i + j];
-            i += bytes_needed;
+        // Partial write: fall through and finish with plain writes.
+        size_t written = n > 0 ? (size_t)n : 0;
+        if (written < out->len) {
+            otter_fd_write_all(out->fd, out->data + written, out->len - written);
+            otter_fd_write_all(out->fd, extra, extra_len);
         } else {
-            result[out_pos++] = (char)0xEF;
-            result[out_pos++] = (char)0xBF;
-            result[out_pos++] = (char)0xBD;
-            i++;
+            written -= out->len;
+            otter_fd_write_all(out->fd, extra + written, extra_len - written);
         }
+        out->len = 0;
+        return;
     }
-    result[out_pos] = '\0';
-    return result;
+#endif
+    otter_fd_write_all(out->fd, out->data, out->len);
+    out->len = 0;
+    otter_fd_write_all(out->fd, extra, extra_len);
 }
 
-void otter_std_io_print(const char* message) {
-    if (!message) return;
-    char* normalized = otter_normalize_text(message);
-    if (normalized) {
-        printf("%s", normalized);
-        fflush(stdout);
-        free(normalized);
+static void otter_out_append(OtterOutBuffer* out, const char* data, size_t len) {
+    if (len <= OTTER_OUT_BUFFER_SIZE - out->len) {
+        memcpy(out->data + out->len, data, len);
+        out->len += len;
+        return;
+    }
+    if (len >= OTTER_OUT_BUFFER_SIZE) {
+        otter_out_drain(out, data, len);
+        return;
     }
+    otter_out_drain(out, NULL, 0);
+    memcpy(out->data, data, len);
+    out->len = len;
+}
+
+static void otter_out_append_text(OtterOutBuffer* out, const char* message, bool newline) {
+    size_t len = otter_str_len(message);
+    if (otter_str_utf8_valid(message, len)) {
+        otter_out_append(out, message, len);
+    } else {
+        const unsigned char* bytes = (const unsigned char*)message;
+        size_t i = 0;
+        while (i < len) {
+            size_t valid = otter_utf8_valid_prefix(bytes + i, len - i);
+            otter_out_append(out, message + i, valid);
+            i += valid;
+            if (i < len) {
+                otter_out_append(out, "\xEF\xBF\xBD", 3);
+                i++;
+            }
+        }
+    }
+    if (newline) otter_out_append(out, "\n", 1);
 }
 
-void otter_std_io_println(const char* message) {
-    if (!message) {
-        printf("\n");
-        return;
+static bool otter_out_is_tty(OtterOutBuffer* out) {
+    if (out->is_tty < 0) {
+#ifdef _WIN32
+        out->is_tty = _isatty(out->fd) ? 1 : 0;
+#else
+        out->is_tty = isatty(out->fd) ? 1 : 0;
+#endif
+    }
+    return out->is_tty != 0;
+}
+
+static void otter_out_emit(OtterOutBuffer* out, const char* message, bool newline) {
+    otter_out_acquire();
+    if (!otter_out_exit_hook) {
+        otter_out_exit_hook = true;
+        atexit(otter_std_io_flush);
+    }
+    if (out == &otter_stderr_buffer) {
+        otter_out_drain(&otter_stdout_buffer, NULL, 0);
+    }
+    if (message) {
+        otter_out_append_text(out, message, newline);
+    } else if (newline) {
+        otter_out_append(out, "\n", 1);
     }
-    char* normalized = otter_normalize_text(message);
-    if (normalized) {
-        printf("%s\n", normalized);
-        free(normalized);
+    if (out == &otter_stderr_buffer || otter_out_is_tty(out)) {
+        otter_out_drain(out, NULL, 0);
     }
+    otter_out_release();
+}
+
+void otter_std_io_flush(void) {
+    otter_out_acquire();
+    otter_out_drain(&otter_stdout_buffer, NULL, 0);
+    otter_out_drain(&otter_stderr_buffer, NULL, 0);
+    otter_out_release();
+}
+
+void otter_std_io_print(const char* message) {
+    if (!message) return;
+    otter_out_emit(&otter_stdout_buffer, message, false);
+}
+
+void otter_std_io_println(const char* message) {
+    otter_out_emit(&otter_stdout_buffer, message, true);
+}
+
+void otter_std_io_eprintln(const char* message) {
+    otter_out_emit(&otter_stderr_buffer, message, true);
 }
 
 char* otter_std_io_read_line() {
+    // Make sure a pending prompt is visible before blocking on input.
+    otter_std_io_flush();
     char* line = NULL;
     size_t len = 0;
     ssize_t read = getline(&line, &len, stdin);
@@ -177,13 +420,15 @@ char* otter_std_io_read_line() {
         return NULL;
     }
     if (read > 0 && line[read-1] == '\n') {
-        line[read-1] = '\0';
+        read--;
     }
-    return line;
+    char* result = otter_str_from_slice(line, (size_t)read, 0);
+    free(line);
+    return result;
 }
 
 void otter_std_io_free_string(char* ptr) {
-    if (ptr) free(ptr);
+    if (ptr) otter_str_release(ptr);
 }
 
 int64_t otter_std_time_now_ms() {
@@ -193,160 +438,256 @@ int64_t otter_std_time_now_ms() {
 }
 
 char* otter_format_float(double value) {
-    char* buffer = (char*)malloc(64);
-    if (buffer) {
-        int len = snprintf(buffer, 64, "%.9f", value);
-        if (len > 0) {
-            char* p = buffer + len - 1;
-            while (p > buffer && *p == '0') {
-                *p = '\0';
-                p--;
-            }
-            if (p > buffer && *p == '.') *p = '\0';
-        }
-    }
-    return buffer;
+    char buffer[OTTER_FMT_FLOAT_BUFFER];
+    size_t len = otter_fmt_f64(value, buffer);
+    OTTER_STAT_ALLOC_KIND(OTTER_ALLOC_FORMAT, len);
+    return otter_str_from_slice(buffer, len, OTTER_STR_FLAG_UTF8_CHECKED | OTTER_STR_FLAG_UTF8_VALID);
 }
 
 char* otter_format_int(int64_t value) {
-    char* buffer = (char*)malloc(32);
-    if (buffer) snprintf(buffer, 32, "%lld", (long long)value);
-    return buffer;
+    char buffer[OTTER_FMT_INT_BUFFER];
+    size_t len = otter_fmt_i64(value, buffer);
+    OTTER_STAT_ALLOC_KIND(OTTER_ALLOC_FORMAT, len);
+    return otter_str_from_slice(buffer, len, OTTER_STR_FLAG_UTF8_CHECKED | OTTER_STR_FLAG_UTF8_VALID);
 }
 
 char* otter_format_bool(bool value) {
-    const char* str = value ? "true" : "false";
-    size_t len = strlen(str);
-    char* buffer = (char*)malloc(len + 1);
-    if (buffer) {
-        memcpy(buffer, str, len + 1);
-    }
-    return buffer;
+    OTTER_STAT_ALLOC_KIND(OTTER_ALLOC_FORMAT, value ? 4 : 5);
+    return value
+        ? otter_str_from_slice("true", 4, OTTER_STR_FLAG_UTF8_CHECKED | OTTER_STR_FLAG_UTF8_VALID)
+        : otter_str_from_slice("false", 5, OTTER_STR_FLAG_UTF8_CHECKED | OTTER_STR_FLAG_UTF8_VALID);
 }
 
 char* otter_str_concat(const char* s1, const char* s2) {
     if (!s1 || !s2) return NULL;
-    size_t len1 = strlen(s1), len2 = strlen(s2);
-    char* result = (char*)malloc(len1 + len2 + 1);
+    OtterStrHeader* h1 = otter_str_header(s1);
+    OtterStrHeader* h2 = otter_str_header(s2);
+    size_t len1 = h1 ? h1->len : strlen(s1);
+    size_t len2 = h2 ? h2->len : strlen(s2);
+    char* result = otter_str_alloc(len1 + len2);
     if (result) {
+        OTTER_STAT_ALLOC_KIND(OTTER_ALLOC_CONCAT, len1 + len2);
         memcpy(result, s1, len1);
-        memcpy(result + len1, s2, len2 + 1);
+        memcpy(result + len1, s2, len2);
+        // Two valid UTF-8 strings concatenate to a valid one, so the cached
+        // bit carries over when both sides already know they are valid.
+        uint32_t flags = 0;
+        if (h1 && h2 && (h1->flags & h2->flags & OTTER_STR_FLAG_UTF8_VALID)) {
+            flags = OTTER_STR_FLAG_UTF8_CHECKED | OTTER_STR_FLAG_UTF8_VALID;
+        }
+        otter_str_set_len(result, len1 + len2, flags);
     }
     return result;
 }
 
+// Concatenate `count` strings into one allocation. `lens[i]` may carry the
+// byte length of `parts[i]` when the caller already knows it (e.g. literals);
+// a negative entry, or a NULL `lens`, means the runtime measures the part.
+char* otter_str_concat_n(const char* const* parts, const int64_t* lens, int64_t count) {
+    if (count < 0 || (!parts && count > 0)) return NULL;
+    size_t total = 0;
+    bool all_valid = true;
+    for (int64_t i = 0; i < count; i++) {
+        if (!parts[i]) return NULL;
+        OtterStrHeader* header = otter_str_header(parts[i]);
+        if (!header || !(header->flags & OTTER_STR_FLAG_UTF8_VALID)) all_valid = false;
+        if (!lens || lens[i] < 0) {
+            total += header ? header->len : strlen(parts[i]);
+        } else {
+            total += (size_t)lens[i];
+        }
+    }
+    char* result = otter_str_alloc(total);
+    if (!result) return NULL;
+    OTTER_STAT_ALLOC_KIND(OTTER_ALLOC_CONCAT, total);
+    size_t pos = 0;
+    for (int64_t i = 0; i < count; i++) {
+        size_t len = (lens && lens[i] >= 0) ? (size_t)lens[i] : otter_str_len(parts[i]);
+        memcpy(result + pos, parts[i], len);
+        pos += len;
+    }
+    otter_str_set_len(result, pos, all_valid ? OTTER_STR_FLAG_UTF8_CHECKED | OTTER_STR_FLAG_UTF8_VALID : 0);
+    return result;
+}
+
 void otter_free_string(char* ptr) {
-    if (ptr) free(ptr);
+    if (ptr) otter_str_release(ptr);
 }
 
 
-// Exception handling with flag-based approach
+// Exception handling with flag-based approach.
+//
+// Each thread keeps its handler contexts in one array indexed by depth. The
+// first OTTER_ERROR_INLINE_DEPTH levels live in TLS; deeper nesting moves the
+// array to the heap, doubling as needed and never shrinking. Pushing and
+// popping a context that never fails is an index bump.
+//
+// A raised message is either borrowed (otter_error_raise_static, which
+// codegen uses for string-literal messages) or copied into a buffer owned by
+// the slot. Slot buffers are kept across pops, so later handlers at the same
+// depth reuse them.
 typedef struct ExceptionContext {
-    char* error_message;
+    const char* error_message;      // borrowed, owned_message, or NULL
     size_t error_message_len;
+    char* owned_message;
+    size_t owned_capacity;
     bool has_error;
-    struct ExceptionContext* prev;
 } ExceptionContext;
 
-static __thread ExceptionContext* context_stack = NULL;
+#define OTTER_ERROR_INLINE_DEPTH 16
+// Slot buffers that grew past this are released on pop rather than kept.
+#define OTTER_ERROR_RETAINED_MESSAGE 4096
+
+static __thread ExceptionContext otter_error_inline_contexts[OTTER_ERROR_INLINE_DEPTH];
+static __thread ExceptionContext* otter_error_heap_contexts = NULL;
+static __thread size_t context_capacity = OTTER_ERROR_INLINE_DEPTH;
+static __thread size_t context_depth = 0;
+
+static ExceptionContext* otter_error_contexts(void) {
+    return otter_error_heap_contexts ? otter_error_heap_contexts : otter_error_inline_contexts;
+}
+
+static ExceptionContext* otter_error_current(void) {
+    return context_depth ? &otter_error_contexts()[context_depth - 1] : NULL;
+}
+
+static bool otter_error_grow_contexts(void) {
+    size_t capacity = context_capacity * 2;
+    ExceptionContext* contexts = (ExceptionContext*)calloc(capacity, sizeof(ExceptionContext));
+    if (!contexts) return false;
+    memcpy(contexts, otter_error_contexts(), context_capacity * sizeof(ExceptionContext));
+    free(otter_error_heap_contexts);
+    otter_error_heap_contexts = contexts;
+    context_capacity = capacity;
+    return true;
+}
+
+// Copies `len` bytes into the slot's own buffer, growing it if needed.
+static void otter_error_store_copy(ExceptionContext* ctx, const char* message_ptr, size_t message_len) {
+    if (message_len + 1 > ctx->owned_capacity) {
+        size_t capacity = ctx->owned_capacity ? ctx->owned_capacity : 64;
+        while (capacity < message_len + 1) capacity *= 2;
+        char* buffer = (char*)realloc(ctx->owned_message, capacity);
+        if (!buffer) {
+            ctx->error_message = NULL;
+            ctx->error_message_len = 0;
+            return;
+        }
+        ctx->owned_message = buffer;
+        ctx->owned_capacity = capacity;
+    }
+    memcpy(ctx->owned_message, message_ptr, message_len);
+    ctx->owned_message[message_len] = '\0';
+    ctx->error_message = ctx->owned_message;
+    ctx->error_message_len = message_len;
+}
 
 void otter_error_push_context() {
-    ExceptionContext* ctx = (ExceptionContext*)malloc(sizeof(ExceptionContext));
-    if (!ctx) return;
-    
+    if (context_depth == context_capacity && !otter_error_grow_contexts()) return;
+
+    ExceptionContext* ctx = &otter_error_contexts()[context_depth++];
+    OTTER_STAT_MAX(max_context_depth, context_depth);
     ctx->error_message = NULL;
     ctx->error_message_len = 0;
     ctx->has_error = false;
-    ctx->prev = context_stack;
-    context_stack = ctx;
 }
 
 bool otter_error_pop_context() {
-    if (!context_stack) return false;
-    
-    ExceptionContext* ctx = context_stack;
-    context_stack = ctx->prev;
-    
-    if (ctx->error_message) {
-        free(ctx->error_message);
-    }
-    free(ctx);
-    
+    ExceptionContext* ctx = otter_error_current();
+    if (!ctx) return false;
+
+    if (ctx->owned_capacity > OTTER_ERROR_RETAINED_MESSAGE) {
+        free(ctx->owned_message);
+        ctx->owned_message = NULL;
+        ctx->owned_capacity = 0;
+    }
+    ctx->error_message = NULL;
+    ctx->has_error = false;
+    context_depth--;
     return true;
 }
 
-void otter_error_raise(const char* message_ptr, size_t message_len) {
-    if (!context_stack) {
-        // No exception handler - print and abort
-        if (message_ptr && message_len > 0) {
-            fprintf(stderr, "Uncaught exception: %.*s\n", (int)message_len, message_ptr);
-        } else {
-            fprintf(stderr, "Uncaught exception\n");
-        }
-        abort();
+static void otter_error_uncaught(const char* message_ptr, size_t message_len) {
+    otter_std_io_flush();
+    if (message_ptr && message_len > 0) {
+        fprintf(stderr, "Uncaught exception: %.*s\n", (int)message_len, message_ptr);
+    } else {
+        fprintf(stderr, "Uncaught exception\n");
     }
-    
-    // Store error message in current context
-    context_stack->has_error = true;
-    context_stack->error_message_len = message_len;
-    
+    abort();
+}
+
+void otter_error_raise(const char* message_ptr, size_t message_len) {
+    OTTER_STAT_ADD(exceptions_raised, 1);
+    ExceptionContext* ctx = otter_error_current();
+    if (!ctx) otter_error_uncaught(message_ptr, message_len);
+
+    ctx->has_error = true;
     if (message_ptr && message_len > 0) {
-        context_stack->error_message = (char*)malloc(message_len + 1);
-        if (context_stack->error_message) {
-            memcpy(context_stack->error_message, message_ptr, message_len);
-            context_stack->error_message[message_len] = '\0';
-        }
+        otter_error_store_copy(ctx, message_ptr, message_len);
+    } else {
+        ctx->error_message = NULL;
+        ctx->error_message_len = 0;
     }
 }
 
+// Like otter_error_raise, but borrows the message instead of copying it. The
+// message must outlive the handler, e.g. a string literal.
+void otter_error_raise_static(const char* message_ptr, size_t message_len) {
+    OTTER_STAT_ADD(exceptions_raised, 1);
+    ExceptionContext* ctx = otter_error_current();
+    if (!ctx) otter_error_uncaught(message_ptr, message_len);
+
+    ctx->has_error = true;
+    ctx->error_message = message_len > 0 ? message_ptr : NULL;
+    ctx->error_message_len = ctx->error_message ? message_len : 0;
+}
+
 bool otter_error_clear() {
-    if (!context_stack) return false;
-    
-    context_stack->has_error = false;
-    if (context_stack->error_message) {
-        free(context_stack->error_message);
-        context_stack->error_message = NULL;
-    }
-    context_stack->error_message_len = 0;
-    
+    ExceptionContext* ctx = otter_error_current();
+    if (!ctx) return false;
+
+    ctx->has_error = false;
+    ctx->error_message = NULL;
+    ctx->error_message_len = 0;
     return true;
 }
 
 char* otter_error_get_message() {
-    if (!context_stack || !context_stack->error_message) {
-        char* result = (char*)malloc(1);
-        if (result) result[0] = '\0';
-        return result;
+    ExceptionContext* ctx = otter_error_current();
+    if (!ctx || !ctx->error_message) {
+        return otter_str_alloc(0);
     }
-    
+
     // Return a copy of the error message
-    char* result = (char*)malloc(context_stack->error_message_len + 1);
-    if (result) {
-        memcpy(result, context_stack->error_message, context_stack->error_message_len);
-        result[context_stack->error_message_len] = '\0';
-    }
-    return result;
+    return otter_str_from_slice(ctx->error_message, ctx->error_message_len, 0);
 }
 
 bool otter_error_has_error() {
-    return context_stack && context_stack->has_error;
+    ExceptionContext* ctx = otter_error_current();
+    return ctx && ctx->has_error;
 }
 
 void otter_error_rethrow() {
-    if (!context_stack || !context_stack->has_error) return;
-    
-    // If there's a previous context, copy error to it
-    if (context_stack->prev) {
-        ExceptionContext* prev = context_stack->prev;
+    ExceptionContext* ctx = otter_error_current();
+    if (!ctx || !ctx->has_error) return;
+
+    // If there's a previous context, hand the error to it
+    if (context_depth > 1) {
+        ExceptionContext* prev = ctx - 1;
         prev->has_error = true;
-        prev->error_message_len = context_stack->error_message_len;
-        
-        if (context_stack->error_message) {
-            prev->error_message = (char*)malloc(context_stack->error_message_len + 1);
-            if (prev->error_message) {
-                memcpy(prev->error_message, context_stack->error_message, context_stack->error_message_len);
-                prev->error_message[context_stack->error_message_len] = '\0';
-            }
+        prev->error_message_len = ctx->error_message_len;
+        if (ctx->error_message && ctx->error_message == ctx->owned_message) {
+            // Swap buffers instead of copying; this slot is about to be popped.
+            char* buffer = prev->owned_message;
+            size_t capacity = prev->owned_capacity;
+            prev->owned_message = ctx->owned_message;
+            prev->owned_capacity = ctx->owned_capacity;
+            prev->error_message = prev->owned_message;
+            ctx->owned_message = buffer;
+            ctx->owned_capacity = capacity;
+        } else {
+            prev->error_message = ctx->error_message;
         }
     }
     // Just return - the unreachable after rethrow will prevent further execution
@@ -356,132 +697,65 @@ void otter_error_rethrow() {
 // This is called by LLVM during exception unwinding
 int otter_personality(int version, int actions, uint64_t exception_class,
                       void* exception_object, void* context) {
+    (void)version;
+    (void)actions;
+    (void)exception_class;
+    (void)exception_object;
+    (void)context;
     // For our simple exception model, we always claim we can handle the exception
     // Return 0 (_URC_NO_REASON) to indicate successful handling
     return 0;
 }
 
 char* otter_builtin_stringify_int(int64_t value) {
-    char* buffer = (char*)malloc(32);
-    if (buffer) {
-        snprintf(buffer, 32, "%lld", (long long)value);
-    }
-    return buffer;
+    return otter_format_int(value);
 }
 
 char* otter_builtin_stringify_float(double value) {
-    char* buffer = (char*)malloc(64);
-    if (buffer) {
-        int len = snprintf(buffer, 64, "%.9f", value);
-        if (len > 0) {
-            char* p = buffer + len - 1;
-            while (p > buffer && *p == '0') {
-                *p = '0';
-                p--;
-            }
-            if (p > buffer && *p == '.') *p = '0';
-        }
-    }
-    return buffer;
+    return otter_format_float(value);
 }
 
 char* otter_builtin_stringify_bool(int value) {
-    char* buffer = (char*)malloc(6);
-    if (buffer) {
-        const char* str = value ? "true" : "false";
-        size_t len = value ? 4 : 5;
-        memcpy(buffer, str, len + 1);
-    }
-    return buffer;
+    return otter_format_bool(value != 0);
 }
 
 
 void otter_std_fmt_println(const char* msg) {
-    if (!msg) {
-        printf("n");
-        return;
-    }
-    char* normalized = otter_normalize_text(msg);
-    if (normalized) {
-        printf("%sn", normalized);
-        free(normalized);
-    }
+    otter_std_io_println(msg);
 }
 
 void otter_std_fmt_print(const char* msg) {
-    if (!msg) return;
-    char* normalized = otter_normalize_text(msg);
-    if (normalized) {
-        printf("%s", normalized);
-        fflush(stdout);
-        free(normalized);
-    }
+    otter_std_io_print(msg);
 }
 
 void otter_std_fmt_eprintln(const char* msg) {
-    if (!msg) {
-        fprintf(stderr, "n");
-        return;
-    }
-    char* normalized = otter_normalize_text(msg);
-    if (normalized) {
-        fprintf(stderr, "%sn", normalized);
-        free(normalized);
-    }
+    otter_std_io_eprintln(msg);
 }
 
 char* otter_std_fmt_stringify_float(double value) {
-    char* buffer = (char*)malloc(64);
-    if (buffer) {
-        int len = snprintf(buffer, 64, "%.9f", value);
-        if (len > 0) {
-            char* p = buffer + len - 1;
-            while (p > buffer && *p == '0') {
-                *p = '0';
-                p--;
-            }
-            if (p > buffer && *p == '.') *p = '0';
-        }
-    }
-    return buffer;
+    return otter_format_float(value);
 }
 
 char* otter_std_fmt_stringify_int(int64_t value) {
-    char* buffer = (char*)malloc(32);
-    if (buffer) {
-        snprintf(buffer, 32, "%lld", (long long)value);
-    }
-    return buffer;
+    return otter_format_int(value);
 }
 
 
 int otter_validate_utf8(const char* ptr) {
     if (!ptr) return 0;
-    while (*ptr) {
-        unsigned char c = (unsigned char)*ptr;
-        if (c <= 0x7F) ptr++;
-        else if (c <= 0xDF) {
-            if (!ptr[1] || (ptr[1] & 0xC0) != 0x80) return 0;
-            ptr += 2;
-        } else if (c <= 0xEF) {
-            if (!ptr[1] || !ptr[2] || (ptr[1] & 0xC0) != 0x80 || (ptr[2] & 0xC0) != 0x80) return 0;
-            ptr += 3;
-        } else if (c <= 0xF7) {
-            if (!ptr[1] || !ptr[2] || !ptr[3] ||
-                (ptr[1] & 0xC0) != 0x80 || (ptr[2] & 0xC0) != 0x80 || (ptr[3] & 0xC0) != 0x80) return 0;
-            ptr += 4;
-        } else return 0;
-    }
-    return 1;
+    return otter_str_utf8_valid(ptr, otter_str_len(ptr));
 }
 
 int64_t otter_builtin_len_string(const char* s) {
     if (!s) return 0;
-    return (int64_t)strlen(s);
+    return (int64_t)otter_str_len(s);
 }
 
 extern void otter_entry();
 int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
     otter_entry();
+    otter_std_io_flush();
     return 0;
 }
\ No newline at end of file
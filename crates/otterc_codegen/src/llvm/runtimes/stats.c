@@ -0,0 +1,188 @@
+// Shared runtime counters.
+//
+// build.rs prepends this file (after numfmt.c) to the standard and wasm
+// runtimes. The runtime that includes it defines otter_stats_local(),
+// returning the calling thread's counters (or NULL when none can be set up),
+// and defines otter_runtime_stats_snapshot(). Counters are only ever
+// written by their own thread, so bumping one is a plain load and store.
+//
+// Building a runtime with -DOTTER_RUNTIME_STATS=0 compiles every counter
+// away; the snapshot then reports zeros.
+//
+// otter_runtime_stats_format_json renders a snapshot in the ProfilingStats
+// layout that `otter profile stats --file` reads, with the counters that
+// have no ProfilingStats field under "runtime_counters".
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef OTTER_RUNTIME_STATS
+#define OTTER_RUNTIME_STATS 1
+#endif
+
+typedef enum OtterAllocKind {
+    OTTER_ALLOC_CONCAT,
+    OTTER_ALLOC_FORMAT,
+    OTTER_ALLOC_NORMALIZE,
+    OTTER_ALLOC_KINDS
+} OtterAllocKind;
+
+typedef struct OtterRuntimeStats {
+    uint64_t allocations;
+    uint64_t allocated_bytes;
+    uint64_t frees;
+    uint64_t freed_bytes;
+    // Allocations attributed to a caller; the rest count as "other".
+    uint64_t kind_allocations[OTTER_ALLOC_KINDS];
+    uint64_t kind_bytes[OTTER_ALLOC_KINDS];
+    uint64_t normalize_calls;
+    uint64_t normalize_repairs;
+    uint64_t exceptions_raised;
+    uint64_t max_context_depth;
+} OtterRuntimeStats;
+
+#if OTTER_RUNTIME_STATS
+static OtterRuntimeStats* otter_stats_local(void);
+
+#define OTTER_STAT_ADD(field, amount)                                                          \
+    do {                                                                                       \
+        OtterRuntimeStats* otter_stats_ = otter_stats_local();                                 \
+        if (otter_stats_) {                                                                    \
+            __atomic_store_n(&otter_stats_->field,                                             \
+                             __atomic_load_n(&otter_stats_->field, __ATOMIC_RELAXED) + (amount), \
+                             __ATOMIC_RELAXED);                                                \
+        }                                                                                      \
+    } while (0)
+
+#define OTTER_STAT_MAX(field, value)                                                    \
+    do {                                                                                \
+        OtterRuntimeStats* otter_stats_ = otter_stats_local();                          \
+        uint64_t otter_stat_value_ = (uint64_t)(value);                                 \
+        if (otter_stats_ && __atomic_load_n(&otter_stats_->field, __ATOMIC_RELAXED) < otter_stat_value_) { \
+            __atomic_store_n(&otter_stats_->field, otter_stat_value_, __ATOMIC_RELAXED); \
+        }                                                                               \
+    } while (0)
+
+#define OTTER_STAT_ALLOC_KIND(kind, bytes)            \
+    do {                                              \
+        OTTER_STAT_ADD(kind_allocations[kind], 1);    \
+        OTTER_STAT_ADD(kind_bytes[kind], (bytes));    \
+    } while (0)
+#else
+#define OTTER_STAT_ADD(field, amount) ((void)0)
+#define OTTER_STAT_MAX(field, value) ((void)0)
+#define OTTER_STAT_ALLOC_KIND(kind, bytes) ((void)0)
+#endif
+
+typedef struct OtterJsonOut {
+    char* buf;
+    size_t cap;
+    size_t len;
+} OtterJsonOut;
+
+static void otter_json_raw(OtterJsonOut* out, const char* text, size_t len) {
+    if (out->len < out->cap) {
+        size_t room = out->cap - out->len;
+        memcpy(out->buf + out->len, text, len < room ? len : room);
+    }
+    out->len += len;
+}
+
+static void otter_json_key(OtterJsonOut* out, const char* key) {
+    otter_json_raw(out, "\"", 1);
+    otter_json_raw(out, key, strlen(key));
+    otter_json_raw(out, "\":", 2);
+}
+
+static void otter_json_u64(OtterJsonOut* out, uint64_t value) {
+    char digits[OTTER_FMT_INT_BUFFER];
+    char* end = digits + sizeof(digits);
+    char* start = otter_fmt_u64_backwards(value, end);
+    otter_json_raw(out, start, (size_t)(end - start));
+}
+
+static void otter_json_allocator(OtterJsonOut* out, const char* name, uint64_t bytes, uint64_t count) {
+    otter_json_raw(out, "[\"", 2);
+    otter_json_raw(out, name, strlen(name));
+    otter_json_raw(out, "\",[", 3);
+    otter_json_u64(out, bytes);
+    otter_json_raw(out, ",", 1);
+    otter_json_u64(out, count);
+    otter_json_raw(out, "]]", 2);
+}
+
+// Render `stats` as JSON into `buf`. Like snprintf, returns the full length
+// and NUL-terminates only when the result fits in `cap` bytes.
+size_t otter_runtime_stats_format_json(const OtterRuntimeStats* stats, double duration_seconds,
+                                       char* buf, size_t cap) {
+    static const char* const kind_names[OTTER_ALLOC_KINDS] = {
+        "otter_str_concat", "otter_format", "otter_normalize_text",
+    };
+    OtterJsonOut out = { buf, cap, 0 };
+    uint64_t live = stats->allocated_bytes > stats->freed_bytes ? stats->allocated_bytes - stats->freed_bytes : 0;
+    uint64_t active = stats->allocations > stats->frees ? stats->allocations - stats->frees : 0;
+
+    otter_json_raw(&out, "{", 1);
+    otter_json_key(&out, "enabled");
+    otter_json_raw(&out, OTTER_RUNTIME_STATS ? "true," : "false,", OTTER_RUNTIME_STATS ? 5 : 6);
+    otter_json_key(&out, "total_allocated");
+    otter_json_u64(&out, stats->allocated_bytes);
+    otter_json_raw(&out, ",", 1);
+    otter_json_key(&out, "total_freed");
+    otter_json_u64(&out, stats->freed_bytes);
+    otter_json_raw(&out, ",", 1);
+    otter_json_key(&out, "current_memory");
+    otter_json_u64(&out, live);
+    otter_json_raw(&out, ",", 1);
+    // Per-thread counters cannot yield a process-wide peak without a shared
+    // counter on every allocation, so none is reported.
+    otter_json_key(&out, "peak_memory");
+    otter_json_raw(&out, "0,", 2);
+    otter_json_key(&out, "active_allocations");
+    otter_json_u64(&out, active);
+    otter_json_raw(&out, ",", 1);
+    otter_json_key(&out, "duration_seconds");
+    char number[OTTER_FMT_FLOAT_BUFFER];
+    otter_json_raw(&out, number, otter_fmt_f64(duration_seconds, number));
+    otter_json_raw(&out, ",", 1);
+    otter_json_key(&out, "size_histogram");
+    otter_json_raw(&out, "{},", 3);
+
+    otter_json_key(&out, "top_allocators");
+    otter_json_raw(&out, "[", 1);
+    uint64_t other_allocations = stats->allocations;
+    uint64_t other_bytes = stats->allocated_bytes;
+    for (int kind = 0; kind < OTTER_ALLOC_KINDS; kind++) {
+        otter_json_allocator(&out, kind_names[kind], stats->kind_bytes[kind], stats->kind_allocations[kind]);
+        otter_json_raw(&out, ",", 1);
+        other_allocations -= stats->kind_allocations[kind] < other_allocations ? stats->kind_allocations[kind] : other_allocations;
+        other_bytes -= stats->kind_bytes[kind] < other_bytes ? stats->kind_bytes[kind] : other_bytes;
+    }
+    otter_json_allocator(&out, "other", other_bytes, other_allocations);
+    otter_json_raw(&out, "],", 2);
+
+    otter_json_key(&out, "runtime_counters");
+    otter_json_raw(&out, "{", 1);
+    otter_json_key(&out, "allocations");
+    otter_json_u64(&out, stats->allocations);
+    otter_json_raw(&out, ",", 1);
+    otter_json_key(&out, "frees");
+    otter_json_u64(&out, stats->frees);
+    otter_json_raw(&out, ",", 1);
+    otter_json_key(&out, "normalize_calls");
+    otter_json_u64(&out, stats->normalize_calls);
+    otter_json_raw(&out, ",", 1);
+    otter_json_key(&out, "normalize_repairs");
+    otter_json_u64(&out, stats->normalize_repairs);
+    otter_json_raw(&out, ",", 1);
+    otter_json_key(&out, "exceptions_raised");
+    otter_json_u64(&out, stats->exceptions_raised);
+    otter_json_raw(&out, ",", 1);
+    otter_json_key(&out, "max_context_depth");
+    otter_json_u64(&out, stats->max_context_depth);
+    otter_json_raw(&out, "}}\n", 3);
+
+    if (out.len < cap) buf[out.len] = '\0';
+    return out.len;
+}
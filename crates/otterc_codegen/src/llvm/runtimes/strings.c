@@ -0,0 +1,146 @@
+// Runtime-owned strings.
+//
+// build.rs prepends this file (after stats.c) to the standard and wasm
+// runtimes. Strings the runtime allocates carry a header directly in front of
+// the character data, so callers still see a plain NUL-terminated `char*`
+// while the runtime knows the length and caches UTF-8 validity.
+//
+// The header ends in a tag word, OTTER_STR_TAG ^ the header's address, which
+// is cleared when the string is released. A pointer is only taken for a
+// runtime string when it is aligned like a header and the tag in front of it
+// matches; literals, host strings and FFI results fail that check and are
+// measured with strlen and validated without caching. The header is only
+// read when it lies on the same page as the string itself
+// (OTTER_STR_GUARD_PAGE, the smallest page size the runtimes run on), so a
+// borrowed string at the start of a page never touches the page before it;
+// otter_str_alloc shifts the rare string that would land there.
+//
+// The runtime that includes this file defines otter_str_block_alloc() and
+// otter_str_block_free(), which back the strings, and otter_str_foreign_free(),
+// which releases pointers the runtime did not allocate as a string.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define OTTER_STR_FLAG_UTF8_CHECKED 0x1u
+#define OTTER_STR_FLAG_UTF8_VALID 0x2u
+
+#define OTTER_STR_TAG ((uintptr_t)0x9E3779B97F4A7C15ULL)
+#define OTTER_STR_GUARD_PAGE 4096u
+
+typedef struct OtterStrHeader {
+    size_t len;
+    size_t cap;
+    uint32_t flags;
+    uint32_t pad;    // bytes between the block start and this header
+    uintptr_t tag;   // OTTER_STR_TAG ^ header address while the string lives
+} OtterStrHeader;
+
+static void* otter_str_block_alloc(size_t size);
+static void otter_str_block_free(void* block);
+static void otter_str_foreign_free(char* s);
+
+// True when a header in front of `data` would sit on the same guard page.
+static bool otter_str_header_in_page(uintptr_t data) {
+    return (data & (OTTER_STR_GUARD_PAGE - 1)) >= sizeof(OtterStrHeader);
+}
+
+// Reading the tag in front of a borrowed string stays on its page but outside
+// the object; AddressSanitizer builds of the runtime tests must allow that.
+#if defined(__SANITIZE_ADDRESS__) || defined(__clang__)
+#define OTTER_STR_NO_ASAN __attribute__((no_sanitize_address))
+#else
+#define OTTER_STR_NO_ASAN
+#endif
+
+// The header of `s`, or NULL when the runtime does not own it.
+OTTER_STR_NO_ASAN
+static OtterStrHeader* otter_str_header(const char* s) {
+    uintptr_t data = (uintptr_t)s;
+    if (data % _Alignof(OtterStrHeader) != 0 || !otter_str_header_in_page(data)) return NULL;
+    OtterStrHeader* header = (OtterStrHeader*)(void*)(data - sizeof(OtterStrHeader));
+    return header->tag == (OTTER_STR_TAG ^ (uintptr_t)header) ? header : NULL;
+}
+
+static char* otter_str_alloc(size_t cap) {
+    if (cap > SIZE_MAX - 2 * sizeof(OtterStrHeader) - 1) return NULL;
+    size_t size = sizeof(OtterStrHeader) + cap + 1;
+    char* block = (char*)otter_str_block_alloc(size);
+    if (!block) return NULL;
+    size_t pad = 0;
+    if (!otter_str_header_in_page((uintptr_t)block + sizeof(OtterStrHeader))) {
+        // Retry with room to move the header one header size further in,
+        // which takes the data clear of the page start.
+        otter_str_block_free(block);
+        block = (char*)otter_str_block_alloc(size + sizeof(OtterStrHeader));
+        if (!block) return NULL;
+        if (!otter_str_header_in_page((uintptr_t)block + sizeof(OtterStrHeader))) {
+            pad = sizeof(OtterStrHeader);
+        }
+    }
+    OtterStrHeader* header = (OtterStrHeader*)(void*)(block + pad);
+    char* data = (char*)(header + 1);
+    data[0] = '\0';
+    header->len = 0;
+    header->cap = cap;
+    header->flags = 0;
+    header->pad = (uint32_t)pad;
+    header->tag = OTTER_STR_TAG ^ (uintptr_t)header;
+    OTTER_STAT_ADD(allocations, 1);
+    OTTER_STAT_ADD(allocated_bytes, cap);
+    return data;
+}
+
+// Only for strings fresh from otter_str_alloc.
+static void otter_str_set_len(char* s, size_t len, uint32_t flags) {
+    OtterStrHeader* header = (OtterStrHeader*)(void*)(s - sizeof(OtterStrHeader));
+    header->len = len;
+    header->flags = flags;
+    s[len] = '\0';
+}
+
+static char* otter_str_from_slice(const char* src, size_t len, uint32_t flags) {
+    if (!src) return NULL;
+    char* data = otter_str_alloc(len);
+    if (!data) return NULL;
+    memcpy(data, src, len);
+    otter_str_set_len(data, len, flags);
+    return data;
+}
+
+static size_t otter_str_len(const char* s) {
+    OtterStrHeader* header = otter_str_header(s);
+    return header ? header->len : strlen(s);
+}
+
+// Anything the runtime did not allocate as a string (a Rust or FFI result, a
+// plain heap buffer) goes to otter_str_foreign_free.
+static void otter_str_release(char* s) {
+    OtterStrHeader* header = otter_str_header(s);
+    if (!header) {
+        otter_str_foreign_free(s);
+        return;
+    }
+    OTTER_STAT_ADD(frees, 1);
+    OTTER_STAT_ADD(freed_bytes, header->cap);
+    header->tag = 0;
+    otter_str_block_free((char*)header - header->pad);
+}
+
+int otter_is_valid_utf8(const unsigned char* str, size_t len) {
+    return otter_utf8_validate(str, len);
+}
+
+static int otter_str_utf8_valid(const char* s, size_t len) {
+    OtterStrHeader* header = otter_str_header(s);
+    if (header && (header->flags & OTTER_STR_FLAG_UTF8_CHECKED)) {
+        return (header->flags & OTTER_STR_FLAG_UTF8_VALID) != 0;
+    }
+    int valid = otter_is_valid_utf8((const unsigned char*)s, len);
+    if (header) {
+        header->flags |= OTTER_STR_FLAG_UTF8_CHECKED | (valid ? OTTER_STR_FLAG_UTF8_VALID : 0);
+    }
+    return valid;
+}
@@ -0,0 +1,102 @@
+// Tests for raising errors with borrowed (static) and copied messages, run
+// against the standard runtime or, with -DOTTER_TEST_WASM_RUNTIME, the wasm
+// runtime built for the host.
+//
+//   cc -O2 -Wall -Wextra -Werror -o errors_test errors_test.c && ./errors_test
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../utf8.c"
+#include "../numfmt.c"
+#include "../stats.c"
+#include "../strings.c"
+#ifdef OTTER_TEST_WASM_RUNTIME
+#include "../wasm.c"
+#else
+#include "../standard.c"
+#endif
+
+static int failures = 0;
+
+#define CHECK(cond)                                                           \
+    do {                                                                      \
+        if (!(cond)) {                                                        \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                       \
+        }                                                                     \
+    } while (0)
+
+static void check_message(const char* expected) {
+    char* message = otter_error_get_message();
+    CHECK(message && strcmp(message, expected) == 0);
+    otter_free_string(message);
+}
+
+static void test_static_and_copied_messages(void) {
+    static const char literal[] = "static failure";
+    otter_error_push_context();
+    otter_error_raise_static(literal, sizeof(literal) - 1);
+    CHECK(otter_error_has_error());
+    check_message("static failure");
+#ifndef OTTER_TEST_WASM_RUNTIME
+    // Borrowed, not copied.
+    CHECK(otter_error_current()->error_message == literal);
+#endif
+
+    char copied[] = "copied failure";
+    otter_error_raise(copied, sizeof(copied) - 1);
+    copied[0] = 'X';
+    check_message("copied failure");
+
+    otter_error_clear();
+    CHECK(!otter_error_has_error());
+    otter_error_pop_context();
+}
+
+#ifndef OTTER_TEST_WASM_RUNTIME
+// A borrowed message survives being handed to the enclosing handler.
+static void test_rethrow_keeps_borrowed_message(void) {
+    static const char literal[] = "inner failure";
+    otter_error_push_context();
+    otter_error_push_context();
+    otter_error_raise_static(literal, sizeof(literal) - 1);
+    otter_error_rethrow();
+    otter_error_pop_context();
+    CHECK(otter_error_has_error());
+    CHECK(otter_error_current()->error_message == literal);
+    check_message("inner failure");
+    otter_error_pop_context();
+}
+#endif
+
+void otter_entry(void) {
+    test_static_and_copied_messages();
+#ifndef OTTER_TEST_WASM_RUNTIME
+    test_rethrow_keeps_borrowed_message();
+#endif
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        exit(1);
+    }
+    printf("errors_test: ok\n");
+}
+
+#ifdef OTTER_TEST_WASM_RUNTIME
+void otter_env_write_stdout(const char* ptr, uint32_t len) {
+    fwrite(ptr, 1, len, stdout);
+}
+
+void otter_env_write_stderr(const char* ptr, uint32_t len) {
+    fwrite(ptr, 1, len, stderr);
+}
+
+int64_t otter_env_time_now_ms(void) {
+    return 0;
+}
+
+int main(void) {
+    otter_entry();
+    return 0;
+}
+#endif
@@ -0,0 +1,219 @@
+// Tests for runtime-owned strings (../strings.c), run against the standard
+// runtime or, with -DOTTER_TEST_WASM_RUNTIME, the wasm runtime built for the
+// host. Linux only: the page-boundary case maps its own pages.
+//
+//   cc -O2 -Wall -Wextra -Werror -o strings_test strings_test.c && ./strings_test
+//   cc -O2 -Wall -Wextra -Werror -DOTTER_TEST_WASM_RUNTIME -o strings_test strings_test.c && ./strings_test
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "../utf8.c"
+#include "../numfmt.c"
+#include "../stats.c"
+#include "../strings.c"
+#ifdef OTTER_TEST_WASM_RUNTIME
+#include "../wasm.c"
+#else
+#include "../standard.c"
+#endif
+
+static int failures = 0;
+
+#define CHECK(cond)                                                           \
+    do {                                                                      \
+        if (!(cond)) {                                                        \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                       \
+        }                                                                     \
+    } while (0)
+
+static uint64_t frees_so_far(void) {
+    OtterRuntimeStats stats;
+    otter_runtime_stats_snapshot(&stats);
+    return stats.frees;
+}
+
+static void test_len(void) {
+    char* owned = otter_format_int(-1234567);
+    CHECK(otter_str_header(owned) != NULL);
+    CHECK(otter_builtin_len_string(owned) == 8);
+    CHECK(otter_builtin_len_string("literal") == 7);
+    CHECK(otter_builtin_len_string("") == 0);
+    otter_free_string(owned);
+
+    // Bytes that look like a header in front of a borrowed string must not be
+    // trusted: the length comes from strlen.
+    struct {
+        OtterStrHeader fake;
+        char data[8];
+    } forged = { { 1000, 1000, OTTER_STR_FLAG_UTF8_CHECKED, 0, 0 }, "abc" };
+    CHECK(otter_str_header(forged.data) == NULL);
+    CHECK(otter_builtin_len_string(forged.data) == 3);
+
+    // A real header copied elsewhere carries the wrong address in its tag.
+    char* source = otter_format_int(7);
+    memcpy(&forged.fake, otter_str_header(source), sizeof(OtterStrHeader));
+    CHECK(otter_str_header(forged.data) == NULL);
+    CHECK(otter_builtin_len_string(forged.data) == 3);
+    otter_free_string(source);
+}
+
+static void test_concat(void) {
+    char* number = otter_format_int(42);
+    char* joined = otter_str_concat("answer=", number);
+    CHECK(strcmp(joined, "answer=42") == 0);
+    CHECK(otter_builtin_len_string(joined) == 9);
+
+    const char* parts[] = { "[", number, "|", joined, "]" };
+    int64_t lens[] = { 1, -1, 1, -1, 1 };
+    char* many = otter_str_concat_n(parts, lens, 5);
+    CHECK(strcmp(many, "[42|answer=42]") == 0);
+    CHECK(otter_builtin_len_string(many) == 14);
+
+    char* unmeasured = otter_str_concat_n(parts, NULL, 5);
+    CHECK(strcmp(unmeasured, many) == 0);
+
+    char* empty = otter_str_concat_n(NULL, NULL, 0);
+    CHECK(empty && empty[0] == '\0' && otter_builtin_len_string(empty) == 0);
+
+    otter_free_string(number);
+    otter_free_string(joined);
+    otter_free_string(many);
+    otter_free_string(unmeasured);
+    otter_free_string(empty);
+}
+
+// Strings the runtime did not allocate are still released: the standard
+// runtime hands them to free(), as Rust and FFI strings expect, and the wasm
+// runtime returns them to its heap. Neither counts as a runtime string free.
+static void test_release_foreign(void) {
+    uint64_t before = frees_so_far();
+#ifdef OTTER_TEST_WASM_RUNTIME
+    size_t live = otter_heap_live_bytes();
+    char* block = (char*)otter_heap_alloc(32);
+    memcpy(block, "from the heap", 14);
+    otter_free_string(block);
+    CHECK(otter_heap_live_bytes() == live);
+#else
+    char* foreign = (char*)malloc(32);
+    memcpy(foreign, "from malloc", 12);
+    CHECK(otter_builtin_len_string(foreign) == 11);
+    otter_free_string(foreign);
+#endif
+    CHECK(frees_so_far() == before);
+
+    char* owned = otter_str_concat("owned", "!");
+    otter_free_string(owned);
+    CHECK(frees_so_far() == before + 1);
+}
+
+// Borrowed strings near the very start of a page whose predecessor is
+// unmapped: nothing may read in front of them.
+static void test_borrowed_at_page_boundary(void) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    char* pages = (char*)mmap(NULL, 2 * page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    CHECK(pages != MAP_FAILED);
+    if (pages == MAP_FAILED) return;
+    CHECK(mprotect(pages, page, PROT_NONE) == 0);
+    size_t offsets[] = { 0, 8, sizeof(OtterStrHeader) - 8 };
+    for (size_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++) {
+        char* text = pages + page + offsets[i];
+        memcpy(text, "boundary", 9);
+        CHECK(otter_str_header(text) == NULL);
+        CHECK(otter_builtin_len_string(text) == 8);
+        CHECK(otter_validate_utf8(text) == 1);
+        char* joined = otter_str_concat(text, text);
+        CHECK(strcmp(joined, "boundaryboundary") == 0);
+        otter_free_string(joined);
+    }
+    munmap(pages, 2 * page);
+}
+
+// Many live strings, released out of allocation order. None of them may
+// start where its header would cross into the previous page.
+static void test_many_strings(void) {
+    enum { COUNT = 20000 };
+    char** strings = (char**)malloc(COUNT * sizeof(char*));
+    for (int i = 0; i < COUNT; i++) {
+        strings[i] = otter_format_int(i);
+        CHECK(otter_str_header(strings[i]) != NULL);
+    }
+    for (int i = 0; i < COUNT; i += 2) otter_free_string(strings[i]);
+    for (int i = 1; i < COUNT; i += 2) {
+        char expected[16];
+        snprintf(expected, sizeof(expected), "%d", i);
+        CHECK(otter_builtin_len_string(strings[i]) == (int64_t)strlen(expected));
+    }
+    uint64_t before = frees_so_far();
+    for (int i = COUNT - 1; i >= 1; i -= 2) otter_free_string(strings[i]);
+    CHECK(frees_so_far() == before + COUNT / 2);
+    free(strings);
+}
+
+static void test_utf8_flag_caching(void) {
+    char* valid = otter_str_concat("caf", "\xc3\xa9");
+    OtterStrHeader* header = otter_str_header(valid);
+    CHECK(header != NULL);
+    CHECK(header->flags == 0);
+    CHECK(otter_validate_utf8(valid) == 1);
+    CHECK(header->flags == (OTTER_STR_FLAG_UTF8_CHECKED | OTTER_STR_FLAG_UTF8_VALID));
+
+    char* invalid = otter_str_concat("bad", "\xff");
+    CHECK(otter_validate_utf8(invalid) == 0);
+    CHECK(otter_str_header(invalid)->flags == OTTER_STR_FLAG_UTF8_CHECKED);
+    CHECK(otter_validate_utf8(invalid) == 0);
+
+    // Formatted numbers are known valid, and so is their concatenation.
+    char* number = otter_format_float(2.5);
+    CHECK(otter_str_header(number)->flags & OTTER_STR_FLAG_UTF8_VALID);
+    char* twice = otter_str_concat(number, number);
+    CHECK(otter_str_header(twice)->flags & OTTER_STR_FLAG_UTF8_VALID);
+    char* mixed = otter_str_concat(number, valid);
+    CHECK(otter_str_header(mixed)->flags & OTTER_STR_FLAG_UTF8_VALID);
+
+    // Borrowed strings are validated every time and never cached.
+    CHECK(otter_validate_utf8("plain") == 1);
+    CHECK(otter_validate_utf8("\xc3") == 0);
+
+    otter_free_string(valid);
+    otter_free_string(invalid);
+    otter_free_string(number);
+    otter_free_string(twice);
+    otter_free_string(mixed);
+}
+
+void otter_entry(void) {
+    test_len();
+    test_concat();
+    test_release_foreign();
+    test_borrowed_at_page_boundary();
+    test_many_strings();
+    test_utf8_flag_caching();
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        exit(1);
+    }
+    printf("strings_test: ok\n");
+}
+
+#ifdef OTTER_TEST_WASM_RUNTIME
+void otter_env_write_stdout(const char* ptr, uint32_t len) {
+    fwrite(ptr, 1, len, stdout);
+}
+
+void otter_env_write_stderr(const char* ptr, uint32_t len) {
+    fwrite(ptr, 1, len, stderr);
+}
+
+int64_t otter_env_time_now_ms(void) {
+    return 0;
+}
+
+int main(void) {
+    otter_entry();
+    return 0;
+}
+#endif
@@ -0,0 +1,181 @@
+// Shared UTF-8 validation kernel.
+//
+// build.rs prepends this file to standard.c, wasm.c and embedded.c, so every
+// runtime validates with the same code. Pure-ASCII runs are skipped 16-32
+// bytes at a time with the widest vector unit available; only multi-byte
+// sequences go through the scalar decoder. Validation follows RFC 3629: no
+// overlong encodings, no surrogates, nothing above U+10FFFF.
+//
+// Define OTTER_UTF8_SCALAR_ONLY before this file to force the portable
+// word-at-a-time path (used by the embedded runtime).
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if !defined(OTTER_UTF8_SCALAR_ONLY)
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define OTTER_UTF8_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define OTTER_UTF8_NEON 1
+#include <arm_neon.h>
+#elif defined(__wasm_simd128__)
+#define OTTER_UTF8_WASM_SIMD 1
+#include <wasm_simd128.h>
+#endif
+#endif
+
+typedef size_t (*OtterUtf8AsciiScan)(const unsigned char* s, size_t len);
+
+// Portable fallback: test one machine word per step for high bits.
+static size_t otter_utf8_ascii_run_scalar(const unsigned char* s, size_t len) {
+    const size_t high_bits = (size_t)0x8080808080808080ULL;
+    size_t i = 0;
+    while (i + sizeof(size_t) <= len) {
+        size_t word;
+        memcpy(&word, s + i, sizeof(size_t));
+        if (word & high_bits) break;
+        i += sizeof(size_t);
+    }
+    while (i < len && s[i] < 0x80) i++;
+    return i;
+}
+
+#if defined(OTTER_UTF8_X86)
+static size_t otter_utf8_ascii_run_sse2(const unsigned char* s, size_t len) {
+    size_t i = 0;
+    while (i + 16 <= len) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(s + i));
+        int mask = _mm_movemask_epi8(chunk);
+        if (mask) return i + (size_t)__builtin_ctz((unsigned)mask);
+        i += 16;
+    }
+    return i + otter_utf8_ascii_run_scalar(s + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static size_t otter_utf8_ascii_run_avx2(const unsigned char* s, size_t len) {
+    size_t i = 0;
+    while (i + 32 <= len) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(s + i));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(chunk);
+        if (mask) return i + (size_t)__builtin_ctz(mask);
+        i += 32;
+    }
+    return i + otter_utf8_ascii_run_sse2(s + i, len - i);
+}
+
+static OtterUtf8AsciiScan otter_utf8_ascii_impl = NULL;
+
+static OtterUtf8AsciiScan otter_utf8_select_ascii_scan(void) {
+    OtterUtf8AsciiScan impl = __atomic_load_n(&otter_utf8_ascii_impl, __ATOMIC_RELAXED);
+    if (!impl) {
+        __builtin_cpu_init();
+        // SSE2 is part of the x86-64 baseline; AVX2 has to be probed.
+        impl = __builtin_cpu_supports("avx2") ? otter_utf8_ascii_run_avx2 : otter_utf8_ascii_run_sse2;
+        __atomic_store_n(&otter_utf8_ascii_impl, impl, __ATOMIC_RELAXED);
+    }
+    return impl;
+}
+#elif defined(OTTER_UTF8_NEON)
+// NEON is mandatory on AArch64, so no runtime probe is needed.
+static size_t otter_utf8_ascii_run_neon(const unsigned char* s, size_t len) {
+    size_t i = 0;
+    while (i + 32 <= len) {
+        uint8x16_t lo = vld1q_u8(s + i);
+        uint8x16_t hi = vld1q_u8(s + i + 16);
+        if (vmaxvq_u8(vorrq_u8(lo, hi)) >= 0x80) break;
+        i += 32;
+    }
+    return i + otter_utf8_ascii_run_scalar(s + i, len - i);
+}
+
+static OtterUtf8AsciiScan otter_utf8_select_ascii_scan(void) {
+    return otter_utf8_ascii_run_neon;
+}
+#elif defined(OTTER_UTF8_WASM_SIMD)
+// simd128 is a compile-time feature (-msimd128); wasm has no runtime probe.
+static size_t otter_utf8_ascii_run_simd128(const unsigned char* s, size_t len) {
+    size_t i = 0;
+    while (i + 16 <= len) {
+        v128_t chunk = wasm_v128_load(s + i);
+        uint32_t mask = wasm_i8x16_bitmask(chunk);
+        if (mask) return i + (size_t)__builtin_ctz(mask);
+        i += 16;
+    }
+    return i + otter_utf8_ascii_run_scalar(s + i, len - i);
+}
+
+static OtterUtf8AsciiScan otter_utf8_select_ascii_scan(void) {
+    return otter_utf8_ascii_run_simd128;
+}
+#else
+static OtterUtf8AsciiScan otter_utf8_select_ascii_scan(void) {
+    return otter_utf8_ascii_run_scalar;
+}
+#endif
+
+// Length of the well-formed sequence starting at `s`, or 0 if it is invalid
+// or truncated.
+static size_t otter_utf8_sequence_len(const unsigned char* s, size_t avail) {
+    unsigned char c = s[0];
+    if (c < 0x80) return 1;
+    if (c < 0xC2) return 0;
+    if (c < 0xE0) {
+        return (avail >= 2 && (s[1] & 0xC0) == 0x80) ? 2 : 0;
+    }
+    if (c < 0xF0) {
+        if (avail < 3) return 0;
+        unsigned char lo = c == 0xE0 ? 0xA0 : 0x80;
+        unsigned char hi = c == 0xED ? 0x9F : 0xBF;
+        return (s[1] >= lo && s[1] <= hi && (s[2] & 0xC0) == 0x80) ? 3 : 0;
+    }
+    if (c < 0xF5) {
+        if (avail < 4) return 0;
+        unsigned char lo = c == 0xF0 ? 0x90 : 0x80;
+        unsigned char hi = c == 0xF4 ? 0x8F : 0xBF;
+        return (s[1] >= lo && s[1] <= hi && (s[2] & 0xC0) == 0x80 && (s[3] & 0xC0) == 0x80) ? 4 : 0;
+    }
+    return 0;
+}
+
+// Number of leading bytes of `s` that form valid UTF-8.
+static size_t otter_utf8_valid_prefix(const unsigned char* s, size_t len) {
+    OtterUtf8AsciiScan ascii_run = otter_utf8_select_ascii_scan();
+    size_t i = 0;
+    while (i < len) {
+        i += ascii_run(s + i, len - i);
+        while (i < len && s[i] >= 0x80) {
+            size_t n = otter_utf8_sequence_len(s + i, len - i);
+            if (n == 0) return i;
+            i += n;
+        }
+    }
+    return i;
+}
+
+static int otter_utf8_validate(const unsigned char* s, size_t len) {
+    return otter_utf8_valid_prefix(s, len) == len;
+}
+
+// Copy `len` bytes of `src` into `dst`, replacing every byte that does not
+// start a valid sequence with U+FFFD. `dst` needs room for `len * 3` bytes.
+// Returns the number of bytes written.
+static size_t otter_utf8_repair(const unsigned char* src, size_t len, char* dst) {
+    size_t i = 0, out = 0;
+    while (i < len) {
+        size_t valid = otter_utf8_valid_prefix(src + i, len - i);
+        memcpy(dst + out, src + i, valid);
+        out += valid;
+        i += valid;
+        if (i < len) {
+            dst[out++] = (char)0xEF;
+            dst[out++] = (char)0xBF;
+            dst[out++] = (char)0xBD;
+            i++;
+        }
+    }
+    return out;
+}
+
@@ -1,202 +1,449 @@
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
-#include <stdlib.h>
 #include <string.h>
-#include <math.h>
+#ifndef __wasm__
+#include <stdlib.h>
+#endif
 
 #ifdef __wasi__
 #include <wasi/api.h>
 #else
-__attribute__((import_module("env"), import_name("otter_write_stdout")))
+// Host builds of this runtime (tests) define these functions themselves.
+#ifdef __wasm__
+#define OTTER_WASM_IMPORT(name) __attribute__((import_module("env"), import_name(name)))
+#else
+#define OTTER_WASM_IMPORT(name)
+#endif
+OTTER_WASM_IMPORT("otter_write_stdout")
 void otter_env_write_stdout(const char* ptr, uint32_t len);
-__attribute__((import_module("env"), import_name("otter_write_stderr")))
+OTTER_WASM_IMPORT("otter_write_stderr")
 void otter_env_write_stderr(const char* ptr, uint32_t len);
-__attribute__((import_module("env"), import_name("otter_time_now_ms")))
+OTTER_WASM_IMPORT("otter_time_now_ms")
 int64_t otter_env_time_now_ms(void);
 #endif
 
-static void otter_write_stdout(const char* data, size_t len) {
-    if (!data || len == 0) return;
-#ifdef __wasi__
-    __wasi_ciovec_t iov = { .buf = data, .buf_len = len };
-    size_t written = 0;
-    __wasi_fd_write(1, &iov, 1, &written);
+// Runtime entry points the host may call directly. They keep their export
+// even when the runtime is linked into the program module and internalized.
+#ifdef __wasm__
+#define OTTER_WASM_EXPORT(name) __attribute__((export_name(name)))
 #else
-    otter_env_write_stdout(data, (uint32_t)len);
+#define OTTER_WASM_EXPORT(name)
 #endif
+
+// The wasm runtime is single-threaded, so one counter block serves it.
+#if OTTER_RUNTIME_STATS
+static OtterRuntimeStats otter_stats;
+
+static inline OtterRuntimeStats* otter_stats_local(void) {
+    return &otter_stats;
 }
+#endif
 
-static void otter_write_stderr(const char* data, size_t len) {
-    if (!data || len == 0) return;
-#ifdef __wasi__
-    __wasi_ciovec_t iov = { .buf = data, .buf_len = len };
-    size_t written = 0;
-    __wasi_fd_write(2, &iov, 1, &written);
+// Size-class allocator for linear memory. The runtime makes many small,
+// short-lived strings, so blocks come in a fixed set of classes (16 bytes to
+// 2 KiB) with one free list each and are recycled without coalescing; a
+// freed block only ever serves the same class again, which keeps memory flat
+// under churn. Larger blocks are rounded to 256 bytes and reused first-fit.
+// Fresh blocks are carved from pages obtained with memory.grow. Live bytes,
+// the peak and the number of pages grown are exported to the host.
+#define OTTER_WASM_PAGE 65536u
+#define OTTER_HEAP_CLASSES 14
+#define OTTER_HEAP_SMALL_MAX 2048u
+#define OTTER_HEAP_LARGE_ALIGN 256u
+#define OTTER_BLOCK_LIVE 0x4F424C4Bu
+
+// Sits directly in front of every block's payload; `tag` is
+// OTTER_BLOCK_LIVE ^ address while allocated and 0 once freed.
+typedef struct OtterBlock {
+    uint32_t capacity;
+    uint32_t tag;
+} OtterBlock;
+
+typedef struct OtterFreeBlock {
+    struct OtterFreeBlock* next;
+} OtterFreeBlock;
+
+static const uint32_t otter_heap_class_size[OTTER_HEAP_CLASSES] = {
+    16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048,
+};
+
+static OtterFreeBlock* otter_heap_free[OTTER_HEAP_CLASSES];
+static OtterFreeBlock* otter_heap_free_large;
+static uintptr_t otter_heap_cursor;
+static uintptr_t otter_heap_limit;
+static size_t otter_heap_live;
+static size_t otter_heap_peak;
+static size_t otter_heap_pages;
+
+// Classes are 16-byte steps up to 64, then 2^k and 1.5 * 2^k.
+static unsigned otter_heap_class(size_t size) {
+    if (size <= 64) return size <= 16 ? 0 : (unsigned)((size + 15) / 16) - 1;
+    unsigned k = 31 - (unsigned)__builtin_clz((uint32_t)(size - 1));
+    size_t middle = (size_t)3 << (k - 1);
+    return 4 + (k - 6) * 2 + (size > middle ? 1 : 0);
+}
+
+// Returns the address of `pages` fresh pages, or 0 when memory cannot grow.
+static uintptr_t otter_heap_grow(size_t pages) {
+#ifdef __wasm__
+    size_t previous = __builtin_wasm_memory_grow(0, pages);
+    if (previous == (size_t)-1) return 0;
+    otter_heap_pages += pages;
+    return (uintptr_t)previous * OTTER_WASM_PAGE;
 #else
-    otter_env_write_stderr(data, (uint32_t)len);
+    // Hosted builds of this runtime (tests) have no linear memory to grow.
+    void* chunk = malloc(pages * OTTER_WASM_PAGE);
+    if (!chunk) return 0;
+    otter_heap_pages += pages;
+    return (uintptr_t)chunk;
 #endif
 }
 
+static OtterBlock* otter_heap_carve(uint32_t capacity) {
+    size_t need = sizeof(OtterBlock) + capacity;
+    if (otter_heap_limit - otter_heap_cursor < need) {
+        size_t pages = (need + OTTER_WASM_PAGE - 1) / OTTER_WASM_PAGE;
+        uintptr_t base = otter_heap_grow(pages);
+        if (!base) return NULL;
+        // Nothing else grew memory in between: extend the current region.
+        // Otherwise the old region's tail is abandoned.
+        if (base != otter_heap_limit) otter_heap_cursor = base;
+        otter_heap_limit = base + pages * OTTER_WASM_PAGE;
+    }
+    OtterBlock* block = (OtterBlock*)otter_heap_cursor;
+    otter_heap_cursor += need;
+    block->capacity = capacity;
+    return block;
+}
+
+static void* otter_heap_alloc(size_t size) {
+    OtterBlock* block = NULL;
+    if (size <= OTTER_HEAP_SMALL_MAX) {
+        unsigned index = otter_heap_class(size);
+        if (otter_heap_free[index]) {
+            block = (OtterBlock*)otter_heap_free[index] - 1;
+            otter_heap_free[index] = otter_heap_free[index]->next;
+        } else {
+            block = otter_heap_carve(otter_heap_class_size[index]);
+        }
+    } else {
+        if (size > UINT32_MAX - OTTER_WASM_PAGE) return NULL;
+        uint32_t capacity = (uint32_t)((size + OTTER_HEAP_LARGE_ALIGN - 1) & ~(size_t)(OTTER_HEAP_LARGE_ALIGN - 1));
+        // First fit, but never hand out more than twice the request.
+        OtterFreeBlock** link = &otter_heap_free_large;
+        while (*link) {
+            OtterBlock* candidate = (OtterBlock*)*link - 1;
+            if (candidate->capacity >= capacity && candidate->capacity / 2 <= capacity) {
+                *link = (*link)->next;
+                block = candidate;
+                break;
+            }
+            link = &(*link)->next;
+        }
+        if (!block) block = otter_heap_carve(capacity);
+    }
+    if (!block) return NULL;
+    block->tag = OTTER_BLOCK_LIVE ^ (uint32_t)(uintptr_t)block;
+    otter_heap_live += block->capacity;
+    if (otter_heap_live > otter_heap_peak) otter_heap_peak = otter_heap_live;
+    return block + 1;
+}
+
+static void otter_heap_free_block(void* ptr) {
+    if (!ptr) return;
+    OtterBlock* block = (OtterBlock*)ptr - 1;
+    if (block->tag != (OTTER_BLOCK_LIVE ^ (uint32_t)(uintptr_t)block)) return;
+    block->tag = 0;
+    otter_heap_live -= block->capacity;
+    OtterFreeBlock* node = (OtterFreeBlock*)ptr;
+    if (block->capacity <= OTTER_HEAP_SMALL_MAX) {
+        unsigned index = otter_heap_class(block->capacity);
+        node->next = otter_heap_free[index];
+        otter_heap_free[index] = node;
+    } else {
+        node->next = otter_heap_free_large;
+        otter_heap_free_large = node;
+    }
+}
+
+OTTER_WASM_EXPORT("otter_heap_live_bytes")
+size_t otter_heap_live_bytes(void) {
+    return otter_heap_live;
+}
+
+OTTER_WASM_EXPORT("otter_heap_peak_bytes")
+size_t otter_heap_peak_bytes(void) {
+    return otter_heap_peak;
+}
+
+OTTER_WASM_EXPORT("otter_heap_pages_grown")
+size_t otter_heap_pages_grown(void) {
+    return otter_heap_pages;
+}
+
+// String blocks come from the size-class heap above. Other pointers handed
+// back as strings are returned to that heap when they came from it; its block
+// tag leaves data-segment literals and host memory alone.
+static void* otter_str_block_alloc(size_t size) {
+    return otter_heap_alloc(size);
+}
+
+static void otter_str_block_free(void* block) {
+    otter_heap_free_block(block);
+}
+
+static void otter_str_foreign_free(char* s) {
+    otter_heap_free_block(s);
+}
+
+static char* otter_dup_slice_flags(const char* src, size_t len, uint32_t flags) {
+    return otter_str_from_slice(src, len, flags);
+}
+
 static char* otter_dup_slice(const char* src, size_t len) {
-    if (!src) return NULL;
-    char* out = (char*)malloc(len + 1);
-    if (!out) return NULL;
-    memcpy(out, src, len);
-    out[len] = '\0';
-    return out;
+    return otter_str_from_slice(src, len, 0);
 }
 
 static char* otter_dup_cstr(const char* src) {
     if (!src) return NULL;
-    return otter_dup_slice(src, strlen(src));
+    return otter_dup_slice(src, otter_str_len(src));
 }
 
-static char* otter_format_signed_uint(uint64_t magnitude, bool negative) {
-    char tmp[32];
-    size_t idx = 0;
-    do {
-        tmp[idx++] = (char)('0' + (magnitude % 10));
-        magnitude /= 10;
-    } while (magnitude > 0);
-
-    size_t total = idx + (negative ? 1 : 0);
-    char* buffer = (char*)malloc(total + 1);
-    if (!buffer) return NULL;
-
-    size_t pos = 0;
-    if (negative) buffer[pos++] = '-';
-    while (idx > 0) {
-        buffer[pos++] = tmp[--idx];
+char* otter_normalize_text(const char* input) {
+    if (!input) return NULL;
+    OTTER_STAT_ADD(normalize_calls, 1);
+    size_t len = otter_str_len(input);
+    if (otter_str_utf8_valid(input, len)) {
+        OTTER_STAT_ALLOC_KIND(OTTER_ALLOC_NORMALIZE, len);
+        return otter_dup_slice_flags(input, len, OTTER_STR_FLAG_UTF8_CHECKED | OTTER_STR_FLAG_UTF8_VALID);
     }
-    buffer[pos] = '\0';
-    return buffer;
+    char* result = otter_str_alloc(len * 3);
+    if (!result) return NULL;
+    OTTER_STAT_ADD(normalize_repairs, 1);
+    OTTER_STAT_ALLOC_KIND(OTTER_ALLOC_NORMALIZE, len * 3);
+    size_t out_pos = otter_utf8_repair((const unsigned char*)input, len, result);
+    otter_str_set_len(result, out_pos, OTTER_STR_FLAG_UTF8_CHECKED | OTTER_STR_FLAG_UTF8_VALID);
+    return result;
 }
 
-int otter_is_valid_utf8(const unsigned char* str, size_t len) {
-    size_t i = 0;
-    while (i < len) {
-        if (str[i] == 0) break;
-        int bytes_needed;
-        if ((str[i] & 0x80) == 0) {
-            bytes_needed = 1;
-        } else if ((str[i] & 0xE0) == 0xC0) {
-            bytes_needed = 2;
-        } else if ((str[i] & 0xF0) == 0xE0) {
-            bytes_needed = 3;
-        } else if ((str[i] & 0xF8) == 0xF0) {
-            bytes_needed = 4;
-        } else {
-            return 0;
+// Runtime-owned output buffers in linear memory. Prints append straight into
+// them (repairing invalid UTF-8 in place, so no normalized copy is made) and
+// reach the host in a single call per buffer: when it fills, on
+// otter_std_io_flush, and when otter_entry returns. stderr is flushed after
+// every message, and stdout is flushed before it so the two streams stay
+// ordered. Every host call crosses the wasm boundary, so these are batched
+// as coarsely as that allows.
+#define OTTER_OUT_BUFFER_SIZE (16 * 1024)
+
+typedef struct OtterOutBuffer {
+    int fd;
+    size_t len;
+    char data[OTTER_OUT_BUFFER_SIZE];
+} OtterOutBuffer;
+
+static OtterOutBuffer otter_stdout_buffer = { 1, 0, {0} };
+static OtterOutBuffer otter_stderr_buffer = { 2, 0, {0} };
+
+// Hand the buffered bytes followed by `extra` to the host.
+static void otter_out_drain(OtterOutBuffer* out, const char* extra, size_t extra_len) {
+#ifdef __wasi__
+    __wasi_ciovec_t iov[2] = {
+        { .buf = (const uint8_t*)out->data, .buf_len = out->len },
+        { .buf = (const uint8_t*)extra, .buf_len = extra_len },
+    };
+    __wasi_ciovec_t* pending = iov;
+    size_t count = 2;
+    while (count > 0) {
+        if (pending->buf_len == 0) {
+            pending++;
+            count--;
+            continue;
+        }
+        size_t written = 0;
+        __wasi_errno_t err = __wasi_fd_write(out->fd, pending, count, &written);
+        if (err != __WASI_ERRNO_SUCCESS || written == 0) break;
+        // Partial write: skip what the host took and retry the rest.
+        while (count > 0 && written >= pending->buf_len) {
+            written -= pending->buf_len;
+            pending++;
+            count--;
         }
-        if (i + bytes_needed > len) return 0;
-        for (int j = 1; j < bytes_needed; j++) {
-            if ((str[i + j] & 0xC0) != 0x80) return 0;
+        if (count > 0) {
+            pending->buf += written;
+            pending->buf_len -= written;
         }
-        i += bytes_needed;
     }
-    return 1;
+#else
+    void (*host_write)(const char*, uint32_t) = out->fd == 2 ? otter_env_write_stderr : otter_env_write_stdout;
+    if (out->len > 0) host_write(out->data, (uint32_t)out->len);
+    if (extra_len > 0) host_write(extra, (uint32_t)extra_len);
+#endif
+    out->len = 0;
 }
 
-char* otter_normalize_text(const char* input) {
-    if (!input) return NULL;
-    size_t len = strlen(input);
-    if (otter_is_valid_utf8((const unsigned char*)input, len)) {
-        char* result = (char*)malloc(len + 1);
-        if (result) {
-            memcpy(result, input, len + 1);
-        }
-        return result;
+static void otter_out_append(OtterOutBuffer* out, const char* data, size_t len) {
+    if (len <= OTTER_OUT_BUFFER_SIZE - out->len) {
+        memcpy(out->data + out->len, data, len);
+        out->len += len;
+        return;
     }
-    char* result = (char*)malloc(len * 3 + 1);
-    if (!result) return NULL;
-    size_t i = 0, out_pos = 0;
+    if (len >= OTTER_OUT_BUFFER_SIZE) {
+        otter_out_drain(out, data, len);
+        return;
+    }
+    otter_out_drain(out, NULL, 0);
+    memcpy(out->data, data, len);
+    out->len = len;
+}
+
+static void otter_out_append_text(OtterOutBuffer* out, const char* message) {
+    size_t len = otter_str_len(message);
+    if (otter_str_utf8_valid(message, len)) {
+        otter_out_append(out, message, len);
+        return;
+    }
+    const unsigned char* bytes = (const unsigned char*)message;
+    size_t i = 0;
     while (i < len) {
-        unsigned char c = (unsigned char)input[i];
-        if (c == 0) break;
-        int bytes_needed = 0, valid_sequence = 1;
-        if ((c & 0x80) == 0) bytes_needed = 1;
-        else if ((c & 0xE0) == 0xC0) bytes_needed = 2;
-        else if ((c & 0xF0) == 0xE0) bytes_needed = 3;
-        else if ((c & 0xF8) == 0xF0) bytes_needed = 4;
-        else { valid_sequence = 0; bytes_needed = 1; }
-        if (i + bytes_needed > len) valid_sequence = 0;
-        else if (bytes_needed > 1) {
-            for (int j = 1; j < bytes_needed && valid_sequence; j++) {
-                if ((input[i + j] & 0xC0) != 0x80) valid_sequence = 0;
-            }
-        }
-        if (valid_sequence) {
-            for (int j = 0; j < bytes_needed; j++) result[out_pos++] = input[i + j];
-            i += bytes_needed;
-        } else {
-            result[out_pos++] = (char)0xEF;
-            result[out_pos++] = (char)0xBF;
-            result[out_pos++] = (char)0xBD;
+        size_t valid = otter_utf8_valid_prefix(bytes + i, len - i);
+        otter_out_append(out, message + i, valid);
+        i += valid;
+        if (i < len) {
+            otter_out_append(out, "\xEF\xBF\xBD", 3);
             i++;
         }
     }
-    result[out_pos] = '\0';
-    return result;
+}
+
+static void otter_out_emit(OtterOutBuffer* out, const char* message, bool newline) {
+    if (out == &otter_stderr_buffer) {
+        otter_out_drain(&otter_stdout_buffer, NULL, 0);
+    }
+    if (message) otter_out_append_text(out, message);
+    if (newline) otter_out_append(out, "\n", 1);
+    if (out == &otter_stderr_buffer) {
+        otter_out_drain(out, NULL, 0);
+    }
+}
+
+OTTER_WASM_EXPORT("otter_std_io_flush")
+void otter_std_io_flush(void) {
+    otter_out_drain(&otter_stdout_buffer, NULL, 0);
+    otter_out_drain(&otter_stderr_buffer, NULL, 0);
 }
 
 void otter_std_io_print(const char* message) {
     if (!message) return;
-    char* normalized = otter_normalize_text(message);
-    if (!normalized) return;
-    otter_write_stdout(normalized, strlen(normalized));
-    free(normalized);
+    otter_out_emit(&otter_stdout_buffer, message, false);
 }
 
 void otter_std_io_println(const char* message) {
-    if (!message) {
-        otter_write_stdout("\n", 1);
-        return;
-    }
-    char* normalized = otter_normalize_text(message);
-    if (!normalized) return;
-    otter_write_stdout(normalized, strlen(normalized));
-    otter_write_stdout("\n", 1);
-    free(normalized);
+    otter_out_emit(&otter_stdout_buffer, message, true);
 }
 
-char* otter_std_io_read_line() {
+// Stdin is read in large chunks into a runtime-owned buffer and lines are
+// served out of it, so a filter over piped input makes one host call per
+// chunk instead of one per byte. The buffer only grows past its inline
+// storage when a single line does not fit.
+#define OTTER_STDIN_CHUNK 65536
+
+typedef struct OtterStdin {
+    char* data;
+    size_t capacity;
+    size_t start;  // first unconsumed byte
+    size_t end;    // one past the last buffered byte
+    bool eof;
+} OtterStdin;
+
+static char otter_stdin_inline[OTTER_STDIN_CHUNK];
+static OtterStdin otter_stdin = { otter_stdin_inline, OTTER_STDIN_CHUNK, 0, 0, false };
+
+// Append the next chunk of input behind the unconsumed bytes. Returns false
+// once input is exhausted (or unavailable, outside WASI).
+static bool otter_stdin_fill(void) {
 #ifdef __wasi__
-    size_t capacity = 128;
-    char* buffer = (char*)malloc(capacity);
-    if (!buffer) return NULL;
-    size_t len = 0;
-    while (1) {
-        char ch = 0;
-        __wasi_iovec_t iov = { .buf = &ch, .buf_len = 1 };
-        size_t nread = 0;
-        __wasi_errno_t err = __wasi_fd_read(0, &iov, 1, &nread);
-        if (err != __WASI_ERRNO_SUCCESS || nread == 0) break;
-        if (ch == '\r') continue;
-        if (ch == '\n') break;
-        if (len + 1 >= capacity) {
-            capacity *= 2;
-            char* tmp = (char*)realloc(buffer, capacity);
-            if (!tmp) {
-                free(buffer);
-                return NULL;
-            }
-            buffer = tmp;
+    OtterStdin* in = &otter_stdin;
+    if (in->eof) return false;
+    // Make sure a pending prompt is visible before blocking on input.
+    otter_std_io_flush();
+    if (in->start > 0) {
+        memmove(in->data, in->data + in->start, in->end - in->start);
+        in->end -= in->start;
+        in->start = 0;
+    }
+    if (in->end == in->capacity) {
+        size_t capacity = in->capacity * 2;
+        char* grown = (char*)otter_heap_alloc(capacity);
+        if (!grown) {
+            in->eof = true;
+            return false;
         }
-        buffer[len++] = ch;
+        memcpy(grown, in->data, in->end);
+        if (in->data != otter_stdin_inline) otter_heap_free_block(in->data);
+        in->data = grown;
+        in->capacity = capacity;
     }
-    if (len == 0) {
-        free(buffer);
-        return NULL;
+    __wasi_iovec_t iov = { .buf = (uint8_t*)in->data + in->end, .buf_len = in->capacity - in->end };
+    size_t nread = 0;
+    __wasi_errno_t err = __wasi_fd_read(0, &iov, 1, &nread);
+    if (err != __WASI_ERRNO_SUCCESS || nread == 0) {
+        in->eof = true;
+        return false;
     }
-    buffer[len] = '\0';
-    return buffer;
+    in->end += nread;
+    return true;
 #else
-    return NULL;
+    return false;
 #endif
 }
 
+// Line iterator over stdin. Returns the next line without its "\n" or
+// "\r\n" terminator and stores its length in `out_len`, or returns NULL at
+// end of input. The line is borrowed from the input buffer: it is not
+// NUL-terminated and stays valid only until the next read from stdin.
+//
+// Exported so a host can drain stdin line by line without a copy per line:
+// it passes the address of a size_t in linear memory as `out_len` and reads
+// the line straight out of memory. Programs go through otter_std_io_read_line.
+OTTER_WASM_EXPORT("otter_std_io_next_line")
+const char* otter_std_io_next_line(size_t* out_len) {
+    OtterStdin* in = &otter_stdin;
+    size_t scanned = 0;
+    size_t len = 0;
+    size_t consumed = 0;
+    for (;;) {
+        size_t available = in->end - in->start;
+        const char* newline = (const char*)memchr(in->data + in->start + scanned, '\n', available - scanned);
+        if (newline) {
+            len = (size_t)(newline - (in->data + in->start));
+            consumed = len + 1;
+            break;
+        }
+        scanned = available;
+        if (!otter_stdin_fill()) {
+            if (available == 0) return NULL;
+            // Final line without a trailing newline.
+            len = available;
+            consumed = available;
+            break;
+        }
+    }
+    const char* line = in->data + in->start;
+    in->start += consumed;
+    if (len > 0 && line[len - 1] == '\r') len--;
+    if (out_len) *out_len = len;
+    return line;
+}
+
+char* otter_std_io_read_line() {
+    size_t len = 0;
+    const char* line = otter_std_io_next_line(&len);
+    return line ? otter_dup_slice(line, len) : NULL;
+}
+
 void otter_std_io_free_string(char* ptr) {
-    if (ptr) free(ptr);
+    if (ptr) otter_str_release(ptr);
 }
 
 int64_t otter_std_time_now_ms() {
@@ -213,91 +460,93 @@ int64_t otter_std_time_now_ms() {
 }
 
 char* otter_format_int(int64_t value) {
-    bool negative = value < 0;
-    uint64_t magnitude = negative ? (uint64_t)(-(value + 1)) + 1 : (uint64_t)value;
-    return otter_format_signed_uint(magnitude, negative);
+    char buffer[OTTER_FMT_INT_BUFFER];
+    size_t len = otter_fmt_i64(value, buffer);
+    OTTER_STAT_ALLOC_KIND(OTTER_ALLOC_FORMAT, len);
+    return otter_dup_slice_flags(buffer, len, OTTER_STR_FLAG_UTF8_CHECKED | OTTER_STR_FLAG_UTF8_VALID);
 }
 
 char* otter_format_float(double value) {
-    if (isnan(value)) return otter_dup_cstr("nan");
-    if (isinf(value)) return value > 0 ? otter_dup_cstr("inf") : otter_dup_cstr("-inf");
-
-    bool negative = value < 0.0;
-    if (negative) value = -value;
-
-    double int_part_d = floor(value);
-    if (int_part_d > (double)INT64_MAX) {
-        return negative ? otter_dup_cstr("-inf") : otter_dup_cstr("inf");
-    }
-
-    int64_t int_part = (int64_t)int_part_d;
-    double frac = value - (double)int_part;
-    const uint64_t scale = 1000000ULL;
-    uint64_t frac_part = (uint64_t)(frac * (double)scale + 0.5);
-    if (frac_part >= scale) {
-        frac_part -= scale;
-        if (int_part < INT64_MAX) {
-            int_part += 1;
-        }
-    }
-
-    char* int_str = otter_format_signed_uint((uint64_t)int_part, negative);
-    if (!int_str) return NULL;
-
-    char frac_digits[6] = { '0','0','0','0','0','0' };
-    size_t frac_len = 0;
-    if (frac_part > 0) {
-        for (int i = 5; i >= 0; --i) {
-            frac_digits[i] = (char)('0' + (frac_part % 10));
-            frac_part /= 10;
-        }
-        frac_len = 6;
-        while (frac_len > 0 && frac_digits[frac_len - 1] == '0') {
-            frac_len--;
-        }
-    }
-
-    if (frac_len == 0) {
-        return int_str;
-    }
-
-    size_t int_len = strlen(int_str);
-    char* result = (char*)malloc(int_len + 1 + frac_len + 1);
-    if (!result) {
-        free(int_str);
-        return NULL;
-    }
-    memcpy(result, int_str, int_len);
-    result[int_len] = '.';
-    memcpy(result + int_len + 1, frac_digits, frac_len);
-    result[int_len + 1 + frac_len] = '\0';
-    free(int_str);
-    return result;
+    char buffer[OTTER_FMT_FLOAT_BUFFER];
+    size_t len = otter_fmt_f64(value, buffer);
+    OTTER_STAT_ALLOC_KIND(OTTER_ALLOC_FORMAT, len);
+    return otter_dup_slice_flags(buffer, len, OTTER_STR_FLAG_UTF8_CHECKED | OTTER_STR_FLAG_UTF8_VALID);
 }
 
 char* otter_format_bool(bool value) {
-    return otter_dup_cstr(value ? "true" : "false");
+    OTTER_STAT_ALLOC_KIND(OTTER_ALLOC_FORMAT, value ? 4 : 5);
+    return value
+        ? otter_dup_slice_flags("true", 4, OTTER_STR_FLAG_UTF8_CHECKED | OTTER_STR_FLAG_UTF8_VALID)
+        : otter_dup_slice_flags("false", 5, OTTER_STR_FLAG_UTF8_CHECKED | OTTER_STR_FLAG_UTF8_VALID);
 }
 
 char* otter_str_concat(const char* s1, const char* s2) {
     if (!s1 || !s2) return NULL;
-    size_t len1 = strlen(s1), len2 = strlen(s2);
-    char* result = (char*)malloc(len1 + len2 + 1);
+    OtterStrHeader* h1 = otter_str_header(s1);
+    OtterStrHeader* h2 = otter_str_header(s2);
+    size_t len1 = h1 ? h1->len : strlen(s1);
+    size_t len2 = h2 ? h2->len : strlen(s2);
+    char* result = otter_str_alloc(len1 + len2);
     if (result) {
+        OTTER_STAT_ALLOC_KIND(OTTER_ALLOC_CONCAT, len1 + len2);
         memcpy(result, s1, len1);
         memcpy(result + len1, s2, len2);
-        result[len1 + len2] = '\0';
+        uint32_t flags = 0;
+        if (h1 && h2 && (h1->flags & h2->flags & OTTER_STR_FLAG_UTF8_VALID)) {
+            flags = OTTER_STR_FLAG_UTF8_CHECKED | OTTER_STR_FLAG_UTF8_VALID;
+        }
+        otter_str_set_len(result, len1 + len2, flags);
     }
     return result;
 }
 
+// Concatenate `count` strings into one allocation. `lens[i]` may carry the
+// byte length of `parts[i]` when the caller already knows it (e.g. literals);
+// a negative entry, or a NULL `lens`, means the runtime measures the part.
+char* otter_str_concat_n(const char* const* parts, const int64_t* lens, int64_t count) {
+    if (count < 0 || (!parts && count > 0)) return NULL;
+    size_t total = 0;
+    bool all_valid = true;
+    for (int64_t i = 0; i < count; i++) {
+        if (!parts[i]) return NULL;
+        OtterStrHeader* header = otter_str_header(parts[i]);
+        if (!header || !(header->flags & OTTER_STR_FLAG_UTF8_VALID)) all_valid = false;
+        if (!lens || lens[i] < 0) {
+            total += header ? header->len : strlen(parts[i]);
+        } else {
+            total += (size_t)lens[i];
+        }
+    }
+    char* result = otter_str_alloc(total);
+    if (!result) return NULL;
+    OTTER_STAT_ALLOC_KIND(OTTER_ALLOC_CONCAT, total);
+    size_t pos = 0;
+    for (int64_t i = 0; i < count; i++) {
+        size_t len = (lens && lens[i] >= 0) ? (size_t)lens[i] : otter_str_len(parts[i]);
+        memcpy(result + pos, parts[i], len);
+        pos += len;
+    }
+    otter_str_set_len(result, pos, all_valid ? OTTER_STR_FLAG_UTF8_CHECKED | OTTER_STR_FLAG_UTF8_VALID : 0);
+    return result;
+}
+
 void otter_free_string(char* ptr) {
-    if (ptr) free(ptr);
+    if (ptr) otter_str_release(ptr);
 }
 
+// Owned, unless it was raised with otter_error_raise_static.
 static char* otter_last_error_message = NULL;
+static bool otter_last_error_borrowed = false;
 static bool otter_has_error_state = false;
 
+static void otter_error_drop_message(void) {
+    if (otter_last_error_message && !otter_last_error_borrowed) {
+        otter_str_release(otter_last_error_message);
+    }
+    otter_last_error_message = NULL;
+    otter_last_error_borrowed = false;
+}
+
 bool otter_error_push_context() {
     return true;
 }
@@ -307,10 +556,8 @@ bool otter_error_pop_context() {
 }
 
 bool otter_error_raise(const char* message_ptr, size_t message_len) {
-    if (otter_last_error_message) {
-        free(otter_last_error_message);
-        otter_last_error_message = NULL;
-    }
+    OTTER_STAT_ADD(exceptions_raised, 1);
+    otter_error_drop_message();
     if (message_ptr && message_len > 0) {
         otter_last_error_message = otter_dup_slice(message_ptr, message_len);
     } else {
@@ -319,18 +566,29 @@ bool otter_error_raise(const char* message_ptr, size_t message_len) {
     }
     otter_has_error_state = true;
     if (otter_last_error_message) {
-        otter_write_stderr("Exception: ", 11);
-        otter_write_stderr(otter_last_error_message, strlen(otter_last_error_message));
-        otter_write_stderr("\n", 1);
+        otter_out_append(&otter_stderr_buffer, "Exception: ", 11);
+        otter_out_emit(&otter_stderr_buffer, otter_last_error_message, true);
     }
     return true;
 }
 
+// Like otter_error_raise, but borrows the message instead of copying it. The
+// message must outlive the handler and be NUL-terminated at `message_len`,
+// as string literals are.
+bool otter_error_raise_static(const char* message_ptr, size_t message_len) {
+    if (!message_ptr || message_len == 0) return otter_error_raise(message_ptr, message_len);
+    OTTER_STAT_ADD(exceptions_raised, 1);
+    otter_error_drop_message();
+    otter_last_error_message = (char*)message_ptr;
+    otter_last_error_borrowed = true;
+    otter_has_error_state = true;
+    otter_out_append(&otter_stderr_buffer, "Exception: ", 11);
+    otter_out_emit(&otter_stderr_buffer, message_ptr, true);
+    return true;
+}
+
 bool otter_error_clear() {
-    if (otter_last_error_message) {
-        free(otter_last_error_message);
-        otter_last_error_message = NULL;
-    }
+    otter_error_drop_message();
     otter_has_error_state = false;
     return true;
 }
@@ -357,7 +615,7 @@ char* otter_builtin_stringify_float(double value) {
 }
 
 char* otter_builtin_stringify_bool(int value) {
-    return otter_dup_cstr(value ? "true" : "false");
+    return otter_format_bool(value != 0);
 }
 
 void otter_std_fmt_println(const char* msg) {
@@ -369,15 +627,7 @@ void otter_std_fmt_print(const char* msg) {
 }
 
 void otter_std_fmt_eprintln(const char* msg) {
-    if (!msg) {
-        otter_write_stderr("\n", 1);
-        return;
-    }
-    char* normalized = otter_normalize_text(msg);
-    if (!normalized) return;
-    otter_write_stderr(normalized, strlen(normalized));
-    otter_write_stderr("\n", 1);
-    free(normalized);
+    otter_out_emit(&otter_stderr_buffer, msg, true);
 }
 
 char* otter_std_fmt_stringify_float(double value) {
@@ -390,20 +640,75 @@ char* otter_std_fmt_stringify_int(int64_t value) {
 
 int otter_validate_utf8(const char* ptr) {
     if (!ptr) return 0;
-    while (*ptr) {
-        unsigned char c = (unsigned char)*ptr;
-        if (c <= 0x7F) ptr++;
-        else if (c <= 0xDF) {
-            if (!ptr[1] || (ptr[1] & 0xC0) != 0x80) return 0;
-            ptr += 2;
-        } else if (c <= 0xEF) {
-            if (!ptr[1] || !ptr[2] || (ptr[1] & 0xC0) != 0x80 || (ptr[2] & 0xC0) != 0x80) return 0;
-            ptr += 3;
-        } else if (c <= 0xF7) {
-            if (!ptr[1] || !ptr[2] || !ptr[3] ||
-                (ptr[1] & 0xC0) != 0x80 || (ptr[2] & 0xC0) != 0x80 || (ptr[3] & 0xC0) != 0x80) return 0;
-            ptr += 4;
-        } else return 0;
+    return otter_str_utf8_valid(ptr, otter_str_len(ptr));
+}
+
+int64_t otter_builtin_len_string(const char* s) {
+    if (!s) return 0;
+    return (int64_t)otter_str_len(s);
+}
+
+// Copies the runtime counters into `out`, a struct in linear memory.
+OTTER_WASM_EXPORT("otter_runtime_stats_snapshot")
+void otter_runtime_stats_snapshot(OtterRuntimeStats* out) {
+    if (!out) return;
+#if OTTER_RUNTIME_STATS
+    *out = otter_stats;
+#else
+    memset(out, 0, sizeof(*out));
+#endif
+}
+
+// The counters as `otter profile stats --file` JSON, in a runtime-owned
+// string the host releases with otter_free_string. The module has no clock
+// of its own to time the run with, so duration_seconds is 0.
+OTTER_WASM_EXPORT("otter_runtime_stats_json")
+char* otter_runtime_stats_json(void) {
+    OtterRuntimeStats stats;
+    otter_runtime_stats_snapshot(&stats);
+    size_t len = otter_runtime_stats_format_json(&stats, 0.0, NULL, 0);
+    char* json = otter_str_alloc(len);
+    if (!json) return NULL;
+    otter_runtime_stats_format_json(&stats, 0.0, json, len + 1);
+    otter_str_set_len(json, len, OTTER_STR_FLAG_UTF8_CHECKED | OTTER_STR_FLAG_UTF8_VALID);
+    return json;
+}
+
+#if OTTER_RUNTIME_STATS && defined(__wasi__)
+// Whether OTTER_RUNTIME_STATS_FILE is set in the WASI environment.
+static bool otter_stats_requested(void) {
+    size_t count = 0, size = 0;
+    if (__wasi_environ_sizes_get(&count, &size) != __WASI_ERRNO_SUCCESS || count == 0) return false;
+    char** entries = (char**)otter_heap_alloc(count * sizeof(char*));
+    char* data = (char*)otter_heap_alloc(size);
+    bool found = false;
+    if (entries && data && __wasi_environ_get((uint8_t**)entries, (uint8_t*)data) == __WASI_ERRNO_SUCCESS) {
+        static const char key[] = "OTTER_RUNTIME_STATS_FILE=";
+        for (size_t i = 0; i < count && !found; i++) {
+            found = strncmp(entries[i], key, sizeof(key) - 1) == 0 && entries[i][sizeof(key) - 1] != '\0';
+        }
     }
-    return 1;
-}
\ No newline at end of file
+    if (entries) otter_heap_free_block(entries);
+    if (data) otter_heap_free_block(data);
+    return found;
+}
+#endif
+
+// Called by the program on every return from otter_entry: flushes buffered
+// output and, when OTTER_RUNTIME_STATS_FILE is set in the WASI environment,
+// reports the counters on stderr. The runtime cannot open host files, so
+// the variable only switches the report on; redirect stderr to keep it.
+OTTER_WASM_EXPORT("otter_runtime_exit")
+void otter_runtime_exit(void) {
+#if OTTER_RUNTIME_STATS && defined(__wasi__)
+    if (otter_stats_requested()) {
+        char* json = otter_runtime_stats_json();
+        if (json) {
+            otter_out_drain(&otter_stdout_buffer, NULL, 0);
+            otter_out_append(&otter_stderr_buffer, json, otter_str_len(json));
+            otter_str_release(json);
+        }
+    }
+#endif
+    otter_std_io_flush();
+}
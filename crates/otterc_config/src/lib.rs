@@ -62,6 +62,9 @@ pub struct CodegenOptions {
     pub inline_threshold: Option<u32>,
     /// Target triple for cross-compilation (defaults to native)
     pub target: Option<TargetTriple>,
+    /// Directory of reusable per-unit object code, or `None` to always
+    /// emit every unit
+    pub object_cache_dir: Option<PathBuf>,
 }
 
 impl Default for CodegenOptions {
@@ -74,6 +77,7 @@ impl Default for CodegenOptions {
             pgo_profile_file: None,
             inline_threshold: None,
             target: None,
+            object_cache_dir: None,
         }
     }
 }
@@ -144,6 +144,7 @@ impl JitEngine {
             enable_pgo: false,
             pgo_profile_file: None,
             inline_threshold: None,
+            object_cache_dir: None,
         };
 
         let mut type_checker = TypeChecker::new().with_registry(SymbolRegistry::global());
@@ -321,6 +322,7 @@ impl JitEngine {
             enable_pgo: false,
             pgo_profile_file: None,
             inline_threshold: None,
+            object_cache_dir: None,
         };
 
         let library = self.rebuild_library("jit_program_optimized", &options)?;
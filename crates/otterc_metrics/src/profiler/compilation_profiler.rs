@@ -32,6 +32,16 @@ pub struct CompilationEvent {
     pub is_recompilation: bool,
 }
 
+/// Wall time spent in one phase of an ahead-of-time build
+#[derive(Debug, Clone)]
+pub struct CompilationPhase {
+    /// Phase name
+    pub name: String,
+
+    /// Wall-clock duration
+    pub duration: Duration,
+}
+
 /// Statistics for compilation at a specific tier
 #[derive(Debug, Clone, Default)]
 pub struct TierCompilationStats {
@@ -204,6 +214,9 @@ pub struct CompilationProfiler {
     /// Compilation event history
     event_history: Arc<RwLock<Vec<CompilationEvent>>>,
 
+    /// Build phases in the order they finished
+    phases: Arc<RwLock<Vec<CompilationPhase>>>,
+
     /// Maximum history size
     max_history_size: usize,
 }
@@ -219,6 +232,7 @@ impl CompilationProfiler {
             tier_stats: Arc::new(RwLock::new(tier_stats)),
             function_stats: Arc::new(RwLock::new(HashMap::new())),
             event_history: Arc::new(RwLock::new(Vec::new())),
+            phases: Arc::new(RwLock::new(Vec::new())),
             max_history_size: 1000,
         }
     }
@@ -271,6 +285,28 @@ impl CompilationProfiler {
         });
     }
 
+    /// Record the wall time of a build phase. Phases running on different
+    /// threads may overlap, so their durations need not add up.
+    pub fn record_phase(&self, name: &str, duration: Duration) {
+        self.phases.write().push(CompilationPhase {
+            name: name.to_string(),
+            duration,
+        });
+    }
+
+    /// Run `f` and record its wall time as a build phase
+    pub fn time_phase<T>(&self, name: &str, f: impl FnOnce() -> T) -> T {
+        let start = Instant::now();
+        let output = f();
+        self.record_phase(name, start.elapsed());
+        output
+    }
+
+    /// Get recorded build phases
+    pub fn get_phases(&self) -> Vec<CompilationPhase> {
+        self.phases.read().clone()
+    }
+
     /// Get statistics for a tier
     pub fn get_tier_stats(&self, tier: CompilationTier) -> Option<TierCompilationStats> {
         self.tier_stats.read().get(&tier).cloned()
@@ -334,6 +370,7 @@ impl CompilationProfiler {
         self.tier_stats.write().clear();
         self.function_stats.write().clear();
         self.event_history.write().clear();
+        self.phases.write().clear();
     }
 }
 
@@ -427,6 +464,24 @@ mod tests {
         assert_eq!(stats.current_tier, Some(CompilationTier::Optimized));
     }
 
+    #[test]
+    fn test_phases() {
+        let profiler = CompilationProfiler::new();
+
+        let value = profiler.time_phase("optimize", || 42);
+        profiler.record_phase("link", Duration::from_micros(1500));
+
+        assert_eq!(value, 42);
+        let phases = profiler.get_phases();
+        assert_eq!(phases.len(), 2);
+        assert_eq!(phases[0].name, "optimize");
+        assert_eq!(phases[1].name, "link");
+        assert_eq!(phases[1].duration, Duration::from_micros(1500));
+
+        profiler.clear();
+        assert!(profiler.get_phases().is_empty());
+    }
+
     #[test]
     fn test_compilation_timer() {
         let timer = CompilationTimer::new("test_fn".to_string());
@@ -6,7 +6,7 @@ pub mod memory_profiler;
 pub mod sampler;
 
 pub use call_profiler::CallProfiler;
-pub use compilation_profiler::{CompilationProfiler, CompilationTimer};
+pub use compilation_profiler::{CompilationPhase, CompilationProfiler, CompilationTimer};
 pub use hot_detector::{HotDetector, HotFunction};
 pub use memory_profiler::MemoryProfiler;
 pub use sampler::Sampler;
@@ -1,11 +1,12 @@
+use std::borrow::Cow;
 use std::cell::RefCell;
 use std::fmt;
 
 /// Represents a runtime error in OtterLang
 #[derive(Debug, Clone)]
 pub struct OtError {
-    /// Error message
-    pub message: String,
+    /// Error message, borrowed when it was raised from a string literal
+    pub message: Cow<'static, str>,
     /// Optional error code or type identifier
     pub code: Option<i32>,
     /// Optional additional data (could be extended for more complex error info)
@@ -14,7 +15,7 @@ pub struct OtError {
 
 impl OtError {
     /// Create a new error with just a message
-    pub fn new(message: impl Into<String>) -> Self {
+    pub fn new(message: impl Into<Cow<'static, str>>) -> Self {
         Self {
             message: message.into(),
             code: None,
@@ -23,7 +24,7 @@ impl OtError {
     }
 
     /// Create a new error with message and code
-    pub fn with_code(message: impl Into<String>, code: i32) -> Self {
+    pub fn with_code(message: impl Into<Cow<'static, str>>, code: i32) -> Self {
         Self {
             message: message.into(),
             code: Some(code),
@@ -32,7 +33,11 @@ impl OtError {
     }
 
     /// Create a new error with message, code, and data
-    pub fn with_data(message: impl Into<String>, code: i32, data: impl Into<String>) -> Self {
+    pub fn with_data(
+        message: impl Into<Cow<'static, str>>,
+        code: i32,
+        data: impl Into<String>,
+    ) -> Self {
         Self {
             message: message.into(),
             code: Some(code),
@@ -117,7 +122,12 @@ impl ErrorStack {
 
     /// Get the current error message as a string
     pub fn get_message() -> Option<String> {
-        Self::CURRENT_ERROR.with(|error| error.borrow().as_ref().map(|e| e.message.clone()))
+        Self::CURRENT_ERROR.with(|error| {
+            error
+                .borrow()
+                .as_ref()
+                .map(|e| e.message.clone().into_owned())
+        })
     }
 
     /// Check if there's currently an error
@@ -163,6 +173,26 @@ pub extern "C" fn otter_error_raise(message_ptr: *const i8, message_len: usize)
     ErrorStack::raise(error)
 }
 
+/// Like `otter_error_raise`, but borrows the message instead of copying it.
+/// Codegen calls this for string-literal messages, which live as long as the
+/// program.
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_error_raise_static(message_ptr: *const i8, message_len: usize) -> bool {
+    if message_ptr.is_null() {
+        return false;
+    }
+
+    // SAFETY: the caller passes a message that is never freed.
+    let message_bytes: &'static [u8] =
+        unsafe { std::slice::from_raw_parts(message_ptr as *const u8, message_len) };
+    let message = match std::str::from_utf8(message_bytes) {
+        Ok(s) => Cow::Borrowed(s),
+        Err(_) => Cow::Borrowed("Invalid UTF-8 error message"),
+    };
+
+    ErrorStack::raise(OtError::new(message))
+}
+
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_error_raise_with_code(
     message_ptr: *const i8,
@@ -277,4 +307,14 @@ mod tests {
         ErrorStack::clear();
         assert!(!ErrorStack::has_error());
     }
+
+    #[test]
+    fn test_static_raise_borrows_the_message() {
+        ErrorStack::clear();
+        static MESSAGE: &str = "literal failure";
+        otter_error_raise_static(MESSAGE.as_ptr() as *const i8, MESSAGE.len());
+        let error = ErrorStack::clear().unwrap();
+        assert!(matches!(error.message, Cow::Borrowed(text) if text.as_ptr() == MESSAGE.as_ptr()));
+        assert_eq!(error.message(), "literal failure");
+    }
 }
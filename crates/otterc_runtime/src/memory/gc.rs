@@ -1,10 +1,11 @@
 //! Garbage collection implementations
 
+use std::cell::RefCell;
 use std::collections::{HashMap, HashSet};
 use std::sync::Arc;
 use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
 
-use parking_lot::RwLock;
+use parking_lot::{Mutex, RwLock};
 
 use crate::memory::config::GcStrategy;
 use crate::memory::profiler::get_profiler;
@@ -26,6 +27,17 @@ pub trait GcStrategyTrait: Send + Sync {
     /// Register an object for GC tracking
     fn register_object(&self, ptr: usize, size: usize, kind: ObjectKind);
 
+    /// Register a batch of objects; strategies with shared tables override
+    /// this to take their lock once per batch.
+    fn register_objects(&self, objects: &[PendingObject]) {
+        for object in objects {
+            self.register_object(object.ptr, object.size, object.kind);
+        }
+    }
+
+    /// Stop tracking an object the program released itself
+    fn unregister_object(&self, _ptr: usize) {}
+
     /// Get the strategy name
     fn name(&self) -> &'static str;
 }
@@ -79,6 +91,8 @@ impl GcStrategyTrait for RcGC {
 
     fn register_object(&self, _ptr: usize, _size: usize, _kind: ObjectKind) {}
 
+    fn register_objects(&self, _objects: &[PendingObject]) {}
+
     fn name(&self) -> &'static str {
         "ReferenceCounting"
     }
@@ -96,12 +110,29 @@ pub struct MarkSweepGC {
     objects: Arc<RwLock<HashMap<usize, ObjectInfo>>>,
 }
 
-#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
 pub enum ObjectKind {
     Raw,
     CString,
 }
 
+impl ObjectKind {
+    pub fn name(self) -> &'static str {
+        match self {
+            ObjectKind::Raw => "Raw",
+            ObjectKind::CString => "CString",
+        }
+    }
+}
+
+/// An allocation waiting in a thread's registration buffer
+#[derive(Debug, Clone, Copy)]
+pub struct PendingObject {
+    pub ptr: usize,
+    pub size: usize,
+    pub kind: ObjectKind,
+}
+
 #[derive(Debug, Clone)]
 struct ObjectInfo {
     size: usize,
@@ -139,6 +170,22 @@ impl MarkSweepGC {
         );
     }
 
+    /// Register a batch of objects under a single write lock
+    fn register_batch(&self, batch: &[PendingObject]) {
+        let mut objects = self.objects.write();
+        objects.reserve(batch.len());
+        for object in batch {
+            objects.insert(
+                object.ptr,
+                ObjectInfo {
+                    size: object.size,
+                    kind: object.kind,
+                    references: Vec::new(),
+                },
+            );
+        }
+    }
+
     /// Unregister an object
     pub fn unregister_object(&self, ptr: usize) {
         self.objects.write().remove(&ptr);
@@ -249,6 +296,14 @@ impl GcStrategyTrait for MarkSweepGC {
         MarkSweepGC::register_object(self, ptr, size, kind, Vec::new());
     }
 
+    fn register_objects(&self, objects: &[PendingObject]) {
+        self.register_batch(objects);
+    }
+
+    fn unregister_object(&self, ptr: usize) {
+        MarkSweepGC::unregister_object(self, ptr);
+    }
+
     fn name(&self) -> &'static str {
         "MarkSweep"
     }
@@ -415,6 +470,15 @@ impl GcStrategyTrait for GenerationalGC {
         self.old_gen.register_object(ptr, size, kind, Vec::new());
     }
 
+    fn register_objects(&self, objects: &[PendingObject]) {
+        self.old_gen.register_batch(objects);
+    }
+
+    fn unregister_object(&self, ptr: usize) {
+        self.nursery_objects.write().remove(&ptr);
+        self.old_gen.unregister_object(ptr);
+    }
+
     fn name(&self) -> &'static str {
         "Generational"
     }
@@ -426,9 +490,72 @@ impl Default for GenerationalGC {
     }
 }
 
+/// Registrations a thread buffers before handing them to the strategy
+const REGISTRATION_BATCH: usize = 256;
+
+/// Batches that could not be registered by the thread that made them: the
+/// thread exited, or switched to buffering for another manager. The owning
+/// manager drains them on its next flush or collection.
+#[derive(Default)]
+struct RegistrationInbox {
+    batches: Mutex<Vec<Vec<PendingObject>>>,
+    pending: AtomicBool,
+}
+
+impl RegistrationInbox {
+    fn push(&self, batch: Vec<PendingObject>) {
+        if batch.is_empty() {
+            return;
+        }
+        self.batches.lock().push(batch);
+        self.pending.store(true, Ordering::Release);
+    }
+
+    fn take(&self) -> Vec<Vec<PendingObject>> {
+        if !self.pending.swap(false, Ordering::Acquire) {
+            return Vec::new();
+        }
+        std::mem::take(&mut *self.batches.lock())
+    }
+}
+
+/// A thread's unflushed registrations, all for the manager owning `inbox`
+#[derive(Default)]
+struct RegistrationBuffer {
+    inbox: Option<Arc<RegistrationInbox>>,
+    objects: Vec<PendingObject>,
+    bytes: usize,
+}
+
+impl RegistrationBuffer {
+    fn take(&mut self) -> (Vec<PendingObject>, usize) {
+        let bytes = std::mem::take(&mut self.bytes);
+        let objects = std::mem::replace(&mut self.objects, Vec::with_capacity(REGISTRATION_BATCH));
+        (objects, bytes)
+    }
+}
+
+impl Drop for RegistrationBuffer {
+    fn drop(&mut self) {
+        if let Some(inbox) = &self.inbox {
+            inbox.push(std::mem::take(&mut self.objects));
+        }
+    }
+}
+
+thread_local! {
+    static REGISTRATION_BUFFER: RefCell<RegistrationBuffer> = RefCell::default();
+}
+
 /// GC manager that handles different strategies
+///
+/// Allocations are registered through a per-thread buffer and reach the
+/// strategy in batches, so allocating threads share no lock or counter
+/// except once per batch. Objects still sitting in another thread's buffer
+/// are not tracked yet, so a collection never frees them.
 pub struct GcManager {
     strategy: Arc<RwLock<Box<dyn GcStrategyTrait>>>,
+    inbox: Arc<RegistrationInbox>,
     config: Arc<RwLock<crate::memory::config::GcConfig>>,
     gc_enabled: AtomicBool,
     disabled_bytes: AtomicUsize,
@@ -449,6 +576,7 @@ impl GcManager {
         let disabled_limit = config.disabled_heap_limit;
         Self {
             strategy: Arc::new(RwLock::new(strategy)),
+            inbox: Arc::default(),
             config: Arc::new(RwLock::new(config)),
             gc_enabled: AtomicBool::new(true),
             disabled_bytes: AtomicUsize::new(0),
@@ -462,6 +590,7 @@ impl GcManager {
         if !self.is_enabled() {
             return GcStats::default();
         }
+        self.flush_registrations();
         self.strategy.read().collect()
     }
 
@@ -488,14 +617,111 @@ impl GcManager {
     }
 
     pub fn register_object(&self, ptr: usize, size: usize, kind: ObjectKind) {
-        self.strategy.read().register_object(ptr, size, kind);
+        let profiler = get_profiler();
+        if profiler.is_enabled() && self.is_enabled() {
+            profiler.record_allocation(ptr, size, None, None, None, Some(kind));
+        }
+
+        let object = PendingObject { ptr, size, kind };
+        let full = REGISTRATION_BUFFER.try_with(|buffer| {
+            let mut buffer = buffer.borrow_mut();
+            if !buffer
+                .inbox
+                .as_ref()
+                .is_some_and(|inbox| Arc::ptr_eq(inbox, &self.inbox))
+            {
+                // Hand whatever was buffered for another manager to it.
+                let (objects, _) = buffer.take();
+                if let Some(previous) = buffer.inbox.replace(self.inbox.clone()) {
+                    previous.push(objects);
+                }
+            }
+            buffer.objects.push(object);
+            buffer.bytes += size;
+            if buffer.objects.len() >= REGISTRATION_BATCH {
+                Some(buffer.take())
+            } else {
+                None
+            }
+        });
+
+        match full {
+            Ok(Some((objects, bytes))) => self.register_batch(&objects, bytes),
+            Ok(None) => {}
+            // The thread is shutting down and its buffer is gone.
+            Err(_) => self.register_batch(&[object], size),
+        }
+    }
+
+    /// Stop tracking an object that was freed explicitly, so no collection
+    /// frees it again. A registration still buffered on the calling thread is
+    /// dropped there; batches other threads handed over are flushed first.
+    pub fn unregister_object(&self, ptr: usize) {
+        let buffered = REGISTRATION_BUFFER.try_with(|buffer| {
+            let mut buffer = buffer.borrow_mut();
+            if !buffer
+                .inbox
+                .as_ref()
+                .is_some_and(|inbox| Arc::ptr_eq(inbox, &self.inbox))
+            {
+                return false;
+            }
+            // Explicit frees usually follow the allocation closely, so
+            // search from the newest registration.
+            match buffer.objects.iter().rposition(|object| object.ptr == ptr) {
+                Some(index) => {
+                    let object = buffer.objects.swap_remove(index);
+                    buffer.bytes = buffer.bytes.saturating_sub(object.size);
+                    true
+                }
+                None => false,
+            }
+        });
+        if matches!(buffered, Ok(true)) {
+            return;
+        }
+        self.flush_registrations();
+        self.strategy.read().unregister_object(ptr);
+    }
+
+    /// Hand the calling thread's buffered registrations, and any batches
+    /// left by other threads, to the strategy
+    pub fn flush_registrations(&self) {
+        let buffered = REGISTRATION_BUFFER.try_with(|buffer| {
+            let mut buffer = buffer.borrow_mut();
+            let owned = buffer
+                .inbox
+                .as_ref()
+                .is_some_and(|inbox| Arc::ptr_eq(inbox, &self.inbox));
+            if owned { Some(buffer.take()) } else { None }
+        });
+        let strategy = self.strategy.read();
+        if let Ok(Some((objects, bytes))) = buffered {
+            strategy.register_objects(&objects);
+            if self.is_enabled() {
+                self.bytes_since_last_gc.fetch_add(bytes, Ordering::Relaxed);
+            }
+        }
+        for batch in self.inbox.take() {
+            strategy.register_objects(&batch);
+        }
+    }
+
+    fn register_batch(&self, objects: &[PendingObject], bytes: usize) {
+        {
+            let strategy = self.strategy.read();
+            strategy.register_objects(objects);
+            for batch in self.inbox.take() {
+                strategy.register_objects(&batch);
+            }
+        }
 
         // Check memory threshold and trigger GC if needed
         if self.is_enabled() {
-            let bytes = self.bytes_since_last_gc.fetch_add(size, Ordering::Relaxed);
+            let total = self.bytes_since_last_gc.fetch_add(bytes, Ordering::Relaxed) + bytes;
             let threshold = self.gc_threshold.load(Ordering::Relaxed);
 
-            if bytes > threshold {
+            if total > threshold {
                 // Reset counter before collecting to avoid multiple threads triggering
                 // Note: This is a simple heuristic, race conditions might cause slight over-triggering or under-counting
                 // but it's fine for this GC implementation.
@@ -504,16 +730,6 @@ impl GcManager {
                 // Trigger collection
                 let _ = self.collect();
             }
-
-            // Update profiler
-            get_profiler().record_allocation(
-                ptr,
-                size,
-                None,
-                None,
-                None,
-                Some(format!("{:?}", kind)),
-            );
         }
     }
 
@@ -573,6 +789,8 @@ impl GcStrategyTrait for NoOpGC {
 
     fn register_object(&self, _ptr: usize, _size: usize, _kind: ObjectKind) {}
 
+    fn register_objects(&self, _objects: &[PendingObject]) {}
+
     fn name(&self) -> &'static str {
         "None"
     }
@@ -588,3 +806,107 @@ static GLOBAL_GC: once_cell::sync::Lazy<GcManager> = once_cell::sync::Lazy::new(
 pub fn get_gc() -> &'static GcManager {
     &GLOBAL_GC
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::benchmark::Benchmark;
+    use crate::memory::config::GcConfig;
+
+    fn mark_sweep() -> GcManager {
+        GcManager::new(GcConfig::new(GcStrategy::MarkSweep))
+    }
+
+    fn alloc_raw(gc: &GcManager, size: usize) {
+        let ptr = gc.alloc(size).expect("allocation failed");
+        gc.register_object(ptr as usize, size, ObjectKind::Raw);
+    }
+
+    #[test]
+    fn test_batched_registrations_are_collected() {
+        let gc = mark_sweep();
+        for _ in 0..REGISTRATION_BATCH * 3 + 7 {
+            alloc_raw(&gc, 16);
+        }
+        let stats = gc.collect();
+        assert_eq!(stats.objects_collected, REGISTRATION_BATCH * 3 + 7);
+        assert_eq!(gc.collect().objects_collected, 0);
+    }
+
+    #[test]
+    fn test_exited_threads_hand_over_their_buffers() {
+        let gc = mark_sweep();
+        std::thread::scope(|scope| {
+            for _ in 0..4 {
+                scope.spawn(|| {
+                    for _ in 0..10 {
+                        alloc_raw(&gc, 24);
+                    }
+                });
+            }
+        });
+        let stats = gc.collect();
+        assert_eq!(stats.objects_collected, 40);
+        assert_eq!(stats.bytes_freed, 40 * 24);
+    }
+
+    #[test]
+    fn test_buffer_follows_the_registering_manager() {
+        let first = mark_sweep();
+        let second = mark_sweep();
+        alloc_raw(&first, 8);
+        alloc_raw(&second, 8);
+        alloc_raw(&second, 8);
+        assert_eq!(first.collect().objects_collected, 1);
+        assert_eq!(second.collect().objects_collected, 2);
+    }
+
+    #[test]
+    fn test_unregistered_objects_are_not_collected() {
+        let gc = mark_sweep();
+        alloc_raw(&gc, 8);
+        // One registration still sits in this thread's buffer, the other has
+        // reached the strategy; neither may be freed again by a collection.
+        let buffered = gc.alloc(16).expect("allocation failed") as usize;
+        gc.register_object(buffered, 16, ObjectKind::Raw);
+        gc.unregister_object(buffered);
+        let flushed = gc.alloc(16).expect("allocation failed") as usize;
+        gc.register_object(flushed, 16, ObjectKind::Raw);
+        gc.flush_registrations();
+        gc.unregister_object(flushed);
+
+        let stats = gc.collect();
+        assert_eq!(stats.objects_collected, 1);
+        assert_eq!(stats.bytes_freed, 8);
+
+        let layout = std::alloc::Layout::from_size_align(16, 8).unwrap();
+        for ptr in [buffered, flushed] {
+            unsafe { std::alloc::dealloc(ptr as *mut u8, layout) };
+        }
+    }
+
+    // Run with: cargo test -p otterc_runtime --release gc_registration_benchmark -- --ignored --nocapture
+    #[test]
+    #[ignore]
+    fn gc_registration_benchmark() {
+        const THREADS: usize = 16;
+        const PER_THREAD: usize = 50_000;
+
+        let gc = mark_sweep();
+        Benchmark::new(format!("register_object x{THREADS} threads"))
+            .warmup(1)
+            .iterations(5)
+            .run_and_print(|| {
+                std::thread::scope(|scope| {
+                    for _ in 0..THREADS {
+                        scope.spawn(|| {
+                            for _ in 0..PER_THREAD {
+                                alloc_raw(&gc, 32);
+                            }
+                        });
+                    }
+                });
+                gc.collect();
+            });
+    }
+}
@@ -1,6 +1,6 @@
 //! Memory profiling and allocation tracking
 
-use std::collections::HashMap;
+use std::collections::{BTreeMap, HashMap};
 use std::sync::Arc;
 use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
 use std::time::Instant;
@@ -8,6 +8,8 @@ use std::time::Instant;
 use parking_lot::RwLock;
 use serde::{Deserialize, Serialize};
 
+use crate::memory::gc::ObjectKind;
+
 /// Information about a single allocation
 #[derive(Debug, Clone)]
 pub struct AllocationInfo {
@@ -21,8 +23,8 @@ pub struct AllocationInfo {
     pub line: Option<u32>,
     /// Timestamp when allocation occurred
     pub timestamp: Instant,
-    /// Object type/class name
-    pub object_type: Option<String>,
+    /// Kind of object allocated
+    pub object_type: Option<ObjectKind>,
 }
 
 impl serde::Serialize for AllocationInfo {
@@ -37,7 +39,7 @@ impl serde::Serialize for AllocationInfo {
         state.serialize_field("file", &self.file)?;
         state.serialize_field("line", &self.line)?;
         state.serialize_field("timestamp_secs", &self.timestamp.elapsed().as_secs_f64())?;
-        state.serialize_field("object_type", &self.object_type)?;
+        state.serialize_field("object_type", &self.object_type.map(ObjectKind::name))?;
         state.end()
     }
 }
@@ -95,7 +97,7 @@ impl MemoryProfiler {
         function: Option<String>,
         file: Option<String>,
         line: Option<u32>,
-        object_type: Option<String>,
+        object_type: Option<ObjectKind>,
     ) {
         if !self.is_enabled() {
             return;
@@ -110,7 +112,7 @@ impl MemoryProfiler {
             object_type,
         };
 
-        self.allocations.write().insert(ptr, info.clone());
+        self.allocations.write().insert(ptr, info);
         self.total_allocated.fetch_add(size, Ordering::SeqCst);
         let current = self.current_memory.fetch_add(size, Ordering::SeqCst) + size;
 
@@ -178,6 +180,7 @@ impl MemoryProfiler {
                 v.sort_by(|a, b| b.1.0.cmp(&a.1.0));
                 v.into_iter().take(10).collect()
             },
+            runtime_counters: BTreeMap::new(),
         }
     }
 
@@ -193,7 +196,7 @@ impl MemoryProfiler {
                 function: info.function.clone(),
                 file: info.file.clone(),
                 line: info.line,
-                object_type: info.object_type.clone(),
+                object_type: info.object_type.map(|kind| kind.name().to_string()),
                 age_seconds: info.timestamp.elapsed().as_secs_f64(),
             });
         }
@@ -221,6 +224,10 @@ pub struct ProfilingStats {
     pub duration_seconds: f64,
     pub size_histogram: HashMap<usize, usize>,
     pub top_allocators: Vec<(String, (usize, usize))>, // (function_name, (total_bytes, count))
+    /// Counters without a field of their own, as reported by the C runtime
+    /// through `OTTER_RUNTIME_STATS_FILE`.
+    #[serde(default)]
+    pub runtime_counters: BTreeMap<String, u64>,
 }
 
 /// Information about a memory leak
@@ -6,6 +6,10 @@ use std::sync::atomic::{AtomicU64, Ordering};
 use once_cell::sync::Lazy;
 use parking_lot::RwLock;
 
+use crate::stdlib::handle_table::HandleTable;
+use crate::stdlib::key_map::KeyMap;
+use crate::stdlib::list_kernels;
+use otterc_symbol::key_hash::hash_map_key;
 use otterc_symbol::registry::{FfiFunction, FfiSignature, FfiType, SymbolRegistry};
 
 // ============================================================================
@@ -14,6 +18,19 @@ use otterc_symbol::registry::{FfiFunction, FfiSignature, FfiType, SymbolRegistry
 // ============================================================================
 
 type HandleId = u64;
+
+// Each handle table tags its handles, so a handle passed to the wrong kind
+// of builtin misses instead of aliasing another object.
+const RUNTIME_VALUE_TABLE: u8 = 1;
+const LIST_TABLE: u8 = 2;
+const MAP_TABLE: u8 = 3;
+const ARRAY_ITERATOR_TABLE: u8 = 4;
+const STRING_ITERATOR_TABLE: u8 = 5;
+pub(crate) const LINE_ITERATOR_TABLE: u8 = 6;
+pub(crate) const JSON_STREAM_TABLE: u8 = 7;
+pub(crate) const BOUNDED_CHANNEL_TABLE: u8 = 8;
+
+// Errors and try results still draw plain ids from this counter.
 static NEXT_HANDLE_ID: AtomicU64 = AtomicU64::new(1);
 
 fn next_handle_id() -> HandleId {
@@ -51,8 +68,8 @@ struct RuntimeValue {
     value: Value,
 }
 
-static RUNTIME_VALUES: Lazy<RwLock<std::collections::HashMap<HandleId, RuntimeValue>>> =
-    Lazy::new(|| RwLock::new(std::collections::HashMap::new()));
+static RUNTIME_VALUES: Lazy<HandleTable<RuntimeValue>> =
+    Lazy::new(|| HandleTable::new(RUNTIME_VALUE_TABLE));
 
 // Encode value handle with type tag in upper 8 bits, handle ID in lower 56 bits
 // This gives us full precision for all types
@@ -69,24 +86,16 @@ pub(crate) fn encode_runtime_value(value: &Value) -> u64 {
         }
         Value::I64(_i) => {
             // For I64, we need full 64-bit precision, so use handle
-            let handle_id = next_handle_id();
-            RUNTIME_VALUES.write().insert(
-                handle_id,
-                RuntimeValue {
-                    value: value.clone(),
-                },
-            );
+            let handle_id = RUNTIME_VALUES.insert(RuntimeValue {
+                value: value.clone(),
+            });
             ((ValueKind::I64 as u64) << TAG_SHIFT) | (handle_id & HANDLE_MASK)
         }
         Value::F64(_f) => {
             // For F64, we need full 64-bit precision, so use handle
-            let handle_id = next_handle_id();
-            RUNTIME_VALUES.write().insert(
-                handle_id,
-                RuntimeValue {
-                    value: value.clone(),
-                },
-            );
+            let handle_id = RUNTIME_VALUES.insert(RuntimeValue {
+                value: value.clone(),
+            });
             ((ValueKind::F64 as u64) << TAG_SHIFT) | (handle_id & HANDLE_MASK)
         }
         Value::String(s) => {
@@ -124,34 +133,278 @@ pub fn decode_value_handle(encoded: u64) -> u64 {
 }
 
 pub struct List {
-    pub items: Vec<Value>,
+    pub items: ListItems,
+}
+
+/// Backing store of a list. Homogeneous scalar lists keep their elements
+/// unboxed in one contiguous buffer, which the bulk builtins (`list.sum_int`
+/// and friends) run over directly. Pushing an element of another kind turns
+/// the list into a `Values` list; an empty list adopts the kind of its first
+/// element.
+pub enum ListItems {
+    Values(Vec<Value>),
+    Int(Vec<i64>),
+    Float(Vec<f64>),
+    Bool(Vec<bool>),
+    Str(Vec<String>),
+}
+
+impl ListItems {
+    pub fn len(&self) -> usize {
+        match self {
+            ListItems::Values(items) => items.len(),
+            ListItems::Int(items) => items.len(),
+            ListItems::Float(items) => items.len(),
+            ListItems::Bool(items) => items.len(),
+            ListItems::Str(items) => items.len(),
+        }
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    pub fn capacity(&self) -> usize {
+        match self {
+            ListItems::Values(items) => items.capacity(),
+            ListItems::Int(items) => items.capacity(),
+            ListItems::Float(items) => items.capacity(),
+            ListItems::Bool(items) => items.capacity(),
+            ListItems::Str(items) => items.capacity(),
+        }
+    }
+
+    pub fn get(&self, index: usize) -> Option<Value> {
+        match self {
+            ListItems::Values(items) => items.get(index).cloned(),
+            ListItems::Int(items) => items.get(index).copied().map(Value::I64),
+            ListItems::Float(items) => items.get(index).copied().map(Value::F64),
+            ListItems::Bool(items) => items.get(index).copied().map(Value::Bool),
+            ListItems::Str(items) => items.get(index).cloned().map(Value::String),
+        }
+    }
+
+    pub fn values(&self) -> impl Iterator<Item = Value> + '_ {
+        (0..self.len()).filter_map(|index| self.get(index))
+    }
+
+    pub fn to_values(&self) -> Vec<Value> {
+        match self {
+            ListItems::Values(items) => items.clone(),
+            _ => self.values().collect(),
+        }
+    }
+
+    pub fn push(&mut self, value: Value) {
+        let value = match (&mut *self, value) {
+            (ListItems::Values(items), value) if !items.is_empty() => {
+                items.push(value);
+                return;
+            }
+            (ListItems::Int(items), Value::I64(value)) => {
+                items.push(value);
+                return;
+            }
+            (ListItems::Float(items), Value::F64(value)) => {
+                items.push(value);
+                return;
+            }
+            (ListItems::Bool(items), Value::Bool(value)) => {
+                items.push(value);
+                return;
+            }
+            (ListItems::Str(items), Value::String(value)) => {
+                items.push(value);
+                return;
+            }
+            (_, value) => value,
+        };
+
+        if self.is_empty() {
+            let capacity = self.capacity().max(1);
+            *self = match value {
+                Value::I64(value) => ListItems::Int(Self::first(capacity, value)),
+                Value::F64(value) => ListItems::Float(Self::first(capacity, value)),
+                Value::Bool(value) => ListItems::Bool(Self::first(capacity, value)),
+                Value::String(value) => ListItems::Str(Self::first(capacity, value)),
+                value => ListItems::Values(Self::first(capacity, value)),
+            };
+        } else {
+            let mut items = self.to_values();
+            items.push(value);
+            *self = ListItems::Values(items);
+        }
+    }
+
+    fn first<T>(capacity: usize, value: T) -> Vec<T> {
+        let mut items = Vec::with_capacity(capacity);
+        items.push(value);
+        items
+    }
+
+    /// The elements as ints, converted like `list.get_int` when the list is
+    /// not an int list.
+    pub fn ints(&self) -> std::borrow::Cow<'_, [i64]> {
+        match self {
+            ListItems::Int(items) => std::borrow::Cow::Borrowed(items),
+            _ => self.values().map(|value| value_as_i64(&value)).collect(),
+        }
+    }
+
+    /// The elements as floats, converted like `list.get_float` when the list
+    /// is not a float list.
+    pub fn floats(&self) -> std::borrow::Cow<'_, [f64]> {
+        match self {
+            ListItems::Float(items) => std::borrow::Cow::Borrowed(items),
+            _ => self.values().map(|value| value_as_f64(&value)).collect(),
+        }
+    }
+
+    /// The elements as strings, converted like `list.get` when the list is
+    /// not a string list.
+    pub fn strings(&self) -> std::borrow::Cow<'_, [String]> {
+        match self {
+            ListItems::Str(items) => std::borrow::Cow::Borrowed(items),
+            _ => self.values().map(|value| value_to_string(&value)).collect(),
+        }
+    }
+
+    /// Move a `Values` list whose elements all have one scalar kind into the
+    /// matching typed backing, so in-place kernels can run over it.
+    fn specialize(&mut self) {
+        let ListItems::Values(items) = self else {
+            return;
+        };
+        let specialized = match items.first() {
+            Some(Value::I64(_)) => items
+                .iter()
+                .map(|value| match value {
+                    Value::I64(value) => Some(*value),
+                    _ => None,
+                })
+                .collect::<Option<Vec<_>>>()
+                .map(ListItems::Int),
+            Some(Value::F64(_)) => items
+                .iter()
+                .map(|value| match value {
+                    Value::F64(value) => Some(*value),
+                    _ => None,
+                })
+                .collect::<Option<Vec<_>>>()
+                .map(ListItems::Float),
+            Some(Value::Bool(_)) => items
+                .iter()
+                .map(|value| match value {
+                    Value::Bool(value) => Some(*value),
+                    _ => None,
+                })
+                .collect::<Option<Vec<_>>>()
+                .map(ListItems::Bool),
+            Some(Value::String(_)) => items
+                .iter()
+                .map(|value| match value {
+                    Value::String(value) => Some(value.clone()),
+                    _ => None,
+                })
+                .collect::<Option<Vec<_>>>()
+                .map(ListItems::Str),
+            _ => None,
+        };
+        if let Some(specialized) = specialized {
+            *self = specialized;
+        }
+    }
 }
 
-pub static LISTS: Lazy<RwLock<std::collections::HashMap<HandleId, List>>> =
-    Lazy::new(|| RwLock::new(std::collections::HashMap::new()));
+fn value_as_i64(value: &Value) -> i64 {
+    match *value {
+        Value::I64(i) => i,
+        Value::F64(f) => f as i64,
+        Value::Bool(b) => i64::from(b),
+        _ => 0,
+    }
+}
 
-struct Map {
-    items: std::collections::HashMap<String, Value>,
+fn value_as_bool(value: &Value) -> bool {
+    match *value {
+        Value::Bool(b) => b,
+        Value::I64(i) => i != 0,
+        Value::F64(f) => f != 0.0,
+        _ => false,
+    }
 }
 
-static MAPS: Lazy<RwLock<std::collections::HashMap<HandleId, Map>>> =
-    Lazy::new(|| RwLock::new(std::collections::HashMap::new()));
+fn value_as_f64(value: &Value) -> f64 {
+    match *value {
+        Value::F64(f) => f,
+        Value::I64(i) => i as f64,
+        Value::Bool(b) => {
+            if b {
+                1.0
+            } else {
+                0.0
+            }
+        }
+        _ => 0.0,
+    }
+}
+
+pub static LISTS: Lazy<HandleTable<List>> = Lazy::new(|| HandleTable::new(LIST_TABLE));
+
+pub struct Map {
+    pub items: KeyMap<Value>,
+}
+
+/// A map key borrowed from compiled code, with its hash
+#[derive(Clone, Copy)]
+struct MapKey<'a> {
+    bytes: &'a [u8],
+    hash: u64,
+}
+
+impl MapKey<'_> {
+    /// # Safety
+    ///
+    /// `key` must be a valid NUL-terminated string that outlives the result.
+    unsafe fn from_c<'a>(key: *const c_char) -> MapKey<'a> {
+        let bytes = unsafe { CStr::from_ptr(key) }.to_bytes();
+        MapKey {
+            bytes,
+            hash: hash_map_key(bytes),
+        }
+    }
+
+    /// A string-literal key the compiler already measured and hashed
+    ///
+    /// # Safety
+    ///
+    /// `key` must point to `len` readable bytes that outlive the result.
+    unsafe fn prehashed<'a>(key: *const c_char, len: i64, hash: u64) -> MapKey<'a> {
+        let len = usize::try_from(len).unwrap_or(0);
+        MapKey {
+            bytes: unsafe { std::slice::from_raw_parts(key.cast::<u8>(), len) },
+            hash,
+        }
+    }
+}
+
+pub static MAPS: Lazy<HandleTable<Map>> = Lazy::new(|| HandleTable::new(MAP_TABLE));
 
 struct ArrayIterator {
     handle: HandleId,
     index: usize,
 }
 
-static ARRAY_ITERATORS: Lazy<RwLock<std::collections::HashMap<HandleId, ArrayIterator>>> =
-    Lazy::new(|| RwLock::new(std::collections::HashMap::new()));
+static ARRAY_ITERATORS: Lazy<HandleTable<ArrayIterator>> =
+    Lazy::new(|| HandleTable::new(ARRAY_ITERATOR_TABLE));
 
 struct StringIterator {
     string: String,
     index: usize,
 }
 
-static STRING_ITERATORS: Lazy<RwLock<std::collections::HashMap<HandleId, StringIterator>>> =
-    Lazy::new(|| RwLock::new(std::collections::HashMap::new()));
+static STRING_ITERATORS: Lazy<HandleTable<StringIterator>> =
+    Lazy::new(|| HandleTable::new(STRING_ITERATOR_TABLE));
 
 fn value_to_string(value: &Value) -> String {
     match value {
@@ -175,10 +428,24 @@ fn list_value(handle: HandleId, index: i64) -> Option<Value> {
     if index < 0 {
         return None;
     }
-    let lists = LISTS.read();
-    lists
-        .get(&handle)
-        .and_then(|list| list.items.get(index as usize).cloned())
+    LISTS
+        .with(handle, |list| list.items.get(index as usize))
+        .flatten()
+}
+
+fn append_to_list(handle: HandleId, value: Value) -> i32 {
+    i32::from(
+        LISTS
+            .with_mut(handle, |list| list.items.push(value))
+            .is_some(),
+    )
+}
+
+fn insert_into_map(handle: HandleId, key: MapKey<'_>, value: Value) -> i32 {
+    i32::from(
+        MAPS.with_mut(handle, |map| map.items.insert(key.hash, key.bytes, value))
+            .is_some(),
+    )
 }
 
 #[unsafe(no_mangle)]
@@ -193,34 +460,40 @@ pub extern "C" fn otter_runtime_list_get(handle: u64, index: i64) -> u64 {
         .unwrap_or(0)
 }
 
-fn map_value(handle: HandleId, key: &str) -> Option<Value> {
-    let maps = MAPS.read();
-    maps.get(&handle)
-        .and_then(|map| map.items.get(key).cloned())
+fn map_value(handle: HandleId, key: MapKey<'_>) -> Option<Value> {
+    MAPS.with(handle, |map| map.items.get(key.hash, key.bytes).cloned())
+        .flatten()
 }
 
 fn stringify_list_handle(handle: HandleId) -> String {
-    let lists = LISTS.read();
-    if let Some(list) = lists.get(&handle) {
-        let items = list.items.iter().map(value_to_string).collect::<Vec<_>>();
-        format!("[{}]", items.join(", "))
-    } else {
-        "[]".to_string()
-    }
+    LISTS
+        .with(handle, |list| {
+            let items = list
+                .items
+                .values()
+                .map(|value| value_to_string(&value))
+                .collect::<Vec<_>>();
+            format!("[{}]", items.join(", "))
+        })
+        .unwrap_or_else(|| "[]".to_string())
 }
 
 fn stringify_map_handle(handle: HandleId) -> String {
-    let maps = MAPS.read();
-    if let Some(map) = maps.get(&handle) {
+    MAPS.with(handle, |map| {
         let items = map
             .items
             .iter()
-            .map(|(key, value)| format!("{}: {}", key, value_to_string(value)))
+            .map(|(key, value)| {
+                format!(
+                    "{}: {}",
+                    String::from_utf8_lossy(key),
+                    value_to_string(value)
+                )
+            })
             .collect::<Vec<_>>();
         format!("{{{}}}", items.join(", "))
-    } else {
-        "{}".to_string()
-    }
+    })
+    .unwrap_or_else(|| "{}".to_string())
 }
 
 // ============================================================================
@@ -271,22 +544,14 @@ pub unsafe extern "C" fn otter_builtin_len_string(s: *const c_char) -> i64 {
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_len_list(handle: u64) -> i64 {
-    let lists = LISTS.read();
-    if let Some(list) = lists.get(&handle) {
-        list.items.len() as i64
-    } else {
-        0
-    }
+    LISTS
+        .with(handle, |list| list.items.len() as i64)
+        .unwrap_or(0)
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_len_map(handle: u64) -> i64 {
-    let maps = MAPS.read();
-    if let Some(map) = maps.get(&handle) {
-        map.items.len() as i64
-    } else {
-        0
-    }
+    MAPS.with(handle, |map| map.items.len() as i64).unwrap_or(0)
 }
 
 // ============================================================================
@@ -295,12 +560,9 @@ pub extern "C" fn otter_builtin_len_map(handle: u64) -> i64 {
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_cap_list(handle: u64) -> i64 {
-    let lists = LISTS.read();
-    if let Some(list) = lists.get(&handle) {
-        list.items.capacity() as i64
-    } else {
-        0
-    }
+    LISTS
+        .with(handle, |list| list.items.capacity() as i64)
+        .unwrap_or(0)
 }
 
 /// get the capacity of the given string
@@ -369,68 +631,32 @@ pub unsafe extern "C" fn otter_builtin_append_list_string(handle: u64, val: *con
 
     let val_str = unsafe { CStr::from_ptr(val).to_str().unwrap_or("").to_string() };
 
-    let mut lists = LISTS.write();
-    if let Some(list) = lists.get_mut(&handle) {
-        list.items.push(Value::String(val_str));
-        1
-    } else {
-        0
-    }
+    append_to_list(handle, Value::String(val_str))
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_append_list_int(handle: u64, val: i64) -> i32 {
-    let mut lists = LISTS.write();
-    if let Some(list) = lists.get_mut(&handle) {
-        list.items.push(Value::I64(val));
-        1
-    } else {
-        0
-    }
+    append_to_list(handle, Value::I64(val))
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_append_list_float(handle: u64, val: f64) -> i32 {
-    let mut lists = LISTS.write();
-    if let Some(list) = lists.get_mut(&handle) {
-        list.items.push(Value::F64(val));
-        1
-    } else {
-        0
-    }
+    append_to_list(handle, Value::F64(val))
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_append_list_bool(handle: u64, val: bool) -> i32 {
-    let mut lists = LISTS.write();
-    if let Some(list) = lists.get_mut(&handle) {
-        list.items.push(Value::Bool(val));
-        1
-    } else {
-        0
-    }
+    append_to_list(handle, Value::Bool(val))
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_append_list_list(handle: u64, value_handle: u64) -> i32 {
-    let mut lists = LISTS.write();
-    if let Some(list) = lists.get_mut(&handle) {
-        list.items.push(Value::List(value_handle));
-        1
-    } else {
-        0
-    }
+    append_to_list(handle, Value::List(value_handle))
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_append_list_map(handle: u64, value_handle: u64) -> i32 {
-    let mut lists = LISTS.write();
-    if let Some(list) = lists.get_mut(&handle) {
-        list.items.push(Value::Map(value_handle));
-        1
-    } else {
-        0
-    }
+    append_to_list(handle, Value::Map(value_handle))
 }
 
 // ============================================================================
@@ -448,18 +674,12 @@ pub unsafe extern "C" fn otter_builtin_delete_map(handle: u64, key: *const c_cha
         return 0;
     }
 
-    let key_str = unsafe { CStr::from_ptr(key).to_str().unwrap_or("").to_string() };
+    let key = unsafe { MapKey::from_c(key) };
 
-    let mut maps = MAPS.write();
-    if let Some(map) = maps.get_mut(&handle) {
-        if map.items.remove(&key_str).is_some() {
-            1
-        } else {
-            0
-        }
-    } else {
-        0
-    }
+    MAPS.with_mut(handle, |map| {
+        i32::from(map.items.remove(key.hash, key.bytes).is_some())
+    })
+    .unwrap_or(0)
 }
 
 // ============================================================================
@@ -468,36 +688,32 @@ pub unsafe extern "C" fn otter_builtin_delete_map(handle: u64, key: *const c_cha
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_range_int(start: i64, end: i64) -> u64 {
-    let id = next_handle_id();
-    let mut items = Vec::new();
-
-    if start <= end {
-        for i in start..end {
-            items.push(Value::I64(i));
-        }
-    }
+    let items = if start <= end {
+        (start..end).collect()
+    } else {
+        Vec::new()
+    };
 
-    let list = List { items };
-    LISTS.write().insert(id, list);
-    id
+    LISTS.insert(List {
+        items: ListItems::Int(items),
+    })
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_range_float(start: f64, end: f64) -> u64 {
-    let id = next_handle_id();
     let mut items = Vec::new();
 
     if start <= end {
         let mut current = start;
         while current < end {
-            items.push(Value::F64(current));
+            items.push(current);
             current += 1.0;
         }
     }
 
-    let list = List { items };
-    LISTS.write().insert(id, list);
-    id
+    LISTS.insert(List {
+        items: ListItems::Float(items),
+    })
 }
 
 // ============================================================================
@@ -507,28 +723,20 @@ pub extern "C" fn otter_builtin_range_float(start: f64, end: f64) -> u64 {
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_enumerate_list(handle: u64) -> u64 {
-    let lists = LISTS.read();
-    let id = next_handle_id();
-
-    if let Some(list) = lists.get(&handle) {
-        let enumerated: Vec<Value> = list
-            .items
-            .iter()
-            .enumerate()
-            .map(|(idx, val)| Value::String(format!("{}:{}", idx, value_to_string(val))))
-            .collect();
-
-        let new_list = List { items: enumerated };
-        drop(lists); // Release read lock
-        LISTS.write().insert(id, new_list);
-    } else {
-        // Return empty list if input handle invalid
-        let empty_list = List { items: Vec::new() };
-        drop(lists);
-        LISTS.write().insert(id, empty_list);
-    }
+    // An invalid input handle enumerates as an empty list.
+    let items = LISTS
+        .with(handle, |list| {
+            list.items
+                .values()
+                .enumerate()
+                .map(|(idx, val)| format!("{}:{}", idx, value_to_string(&val)))
+                .collect()
+        })
+        .unwrap_or_default();
 
-    id
+    LISTS.insert(List {
+        items: ListItems::Str(items),
+    })
 }
 
 // ============================================================================
@@ -537,20 +745,51 @@ pub extern "C" fn otter_builtin_enumerate_list(handle: u64) -> u64 {
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_list_new() -> u64 {
-    let id = next_handle_id();
-    let list = List { items: Vec::new() };
-    LISTS.write().insert(id, list);
-    id
+    LISTS.insert(List {
+        items: ListItems::Values(Vec::new()),
+    })
+}
+
+// Typed constructors, chosen by the compiler when a list literal's element
+// type is known; `capacity` is a hint.
+
+fn with_capacity<T>(capacity: i64) -> Vec<T> {
+    Vec::with_capacity(usize::try_from(capacity).unwrap_or(0))
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_builtin_list_new_int(capacity: i64) -> u64 {
+    LISTS.insert(List {
+        items: ListItems::Int(with_capacity(capacity)),
+    })
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_builtin_list_new_float(capacity: i64) -> u64 {
+    LISTS.insert(List {
+        items: ListItems::Float(with_capacity(capacity)),
+    })
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_builtin_list_new_bool(capacity: i64) -> u64 {
+    LISTS.insert(List {
+        items: ListItems::Bool(with_capacity(capacity)),
+    })
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_builtin_list_new_string(capacity: i64) -> u64 {
+    LISTS.insert(List {
+        items: ListItems::Str(with_capacity(capacity)),
+    })
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_map_new() -> u64 {
-    let id = next_handle_id();
-    let map = Map {
-        items: std::collections::HashMap::new(),
-    };
-    MAPS.write().insert(id, map);
-    id
+    MAPS.insert(Map {
+        items: KeyMap::new(),
+    })
 }
 
 #[unsafe(no_mangle)]
@@ -575,9 +814,9 @@ pub unsafe extern "C" fn otter_builtin_map_get(handle: u64, key: *const c_char)
         return std::ptr::null_mut();
     }
 
-    let key_str = unsafe { CStr::from_ptr(key).to_str().unwrap_or("").to_string() };
+    let key = unsafe { MapKey::from_c(key) };
 
-    match map_value(handle, &key_str) {
+    match map_value(handle, key) {
         Some(value) => CString::new(value_to_string(&value))
             .ok()
             .map(CString::into_raw)
@@ -588,44 +827,37 @@ pub unsafe extern "C" fn otter_builtin_map_get(handle: u64, key: *const c_char)
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_list_get_int(handle: u64, index: i64) -> i64 {
-    match list_value(handle, index) {
-        Some(Value::I64(i)) => i,
-        Some(Value::F64(f)) => f as i64,
-        Some(Value::Bool(b)) => {
-            if b {
-                1
-            } else {
-                0
-            }
-        }
-        _ => 0,
-    }
+    let Ok(index) = usize::try_from(index) else {
+        return 0;
+    };
+    LISTS
+        .with(handle, |list| match &list.items {
+            ListItems::Int(items) => items.get(index).copied(),
+            items => items.get(index).map(|value| value_as_i64(&value)),
+        })
+        .flatten()
+        .unwrap_or(0)
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_list_get_float(handle: u64, index: i64) -> f64 {
-    match list_value(handle, index) {
-        Some(Value::F64(f)) => f,
-        Some(Value::I64(i)) => i as f64,
-        Some(Value::Bool(b)) => {
-            if b {
-                1.0
-            } else {
-                0.0
-            }
-        }
-        _ => 0.0,
-    }
+    let Ok(index) = usize::try_from(index) else {
+        return 0.0;
+    };
+    LISTS
+        .with(handle, |list| match &list.items {
+            ListItems::Float(items) => items.get(index).copied(),
+            items => items.get(index).map(|value| value_as_f64(&value)),
+        })
+        .flatten()
+        .unwrap_or(0.0)
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_list_get_bool(handle: u64, index: i64) -> bool {
-    match list_value(handle, index) {
-        Some(Value::Bool(b)) => b,
-        Some(Value::I64(i)) => i != 0,
-        Some(Value::F64(f)) => f != 0.0,
-        _ => false,
-    }
+    list_value(handle, index)
+        .map(|value| value_as_bool(&value))
+        .unwrap_or(false)
 }
 
 #[unsafe(no_mangle)]
@@ -644,6 +876,143 @@ pub extern "C" fn otter_builtin_list_get_map(handle: u64, index: i64) -> u64 {
     }
 }
 
+// ============================================================================
+// Bulk list operations - run over a typed list's buffer in one call
+// Lists of another kind are converted element by element first, like the
+// typed getters do.
+// ============================================================================
+
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_builtin_list_sum_int(handle: u64) -> i64 {
+    LISTS
+        .with(handle, |list| list_kernels::sum_i64(&list.items.ints()))
+        .unwrap_or(0)
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_builtin_list_sum_float(handle: u64) -> f64 {
+    LISTS
+        .with(handle, |list| list_kernels::sum_f64(&list.items.floats()))
+        .unwrap_or(0.0)
+}
+
+/// Smallest element, or 0 for an empty list
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_builtin_list_min_int(handle: u64) -> i64 {
+    LISTS
+        .with(handle, |list| list_kernels::min_i64(&list.items.ints()))
+        .flatten()
+        .unwrap_or(0)
+}
+
+/// Largest element, or 0 for an empty list
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_builtin_list_max_int(handle: u64) -> i64 {
+    LISTS
+        .with(handle, |list| list_kernels::max_i64(&list.items.ints()))
+        .flatten()
+        .unwrap_or(0)
+}
+
+/// Smallest element, or 0.0 for an empty list
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_builtin_list_min_float(handle: u64) -> f64 {
+    LISTS
+        .with(handle, |list| list_kernels::min_f64(&list.items.floats()))
+        .flatten()
+        .unwrap_or(0.0)
+}
+
+/// Largest element, or 0.0 for an empty list
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_builtin_list_max_float(handle: u64) -> f64 {
+    LISTS
+        .with(handle, |list| list_kernels::max_f64(&list.items.floats()))
+        .flatten()
+        .unwrap_or(0.0)
+}
+
+/// Dot product over the shorter of the two lists
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_builtin_list_dot_int(a: u64, b: u64) -> i64 {
+    LISTS
+        .with(a, |a| {
+            LISTS.with(b, |b| {
+                list_kernels::dot_i64(&a.items.ints(), &b.items.ints())
+            })
+        })
+        .flatten()
+        .unwrap_or(0)
+}
+
+/// Dot product over the shorter of the two lists
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_builtin_list_dot_float(a: u64, b: u64) -> f64 {
+    LISTS
+        .with(a, |a| {
+            LISTS.with(b, |b| {
+                list_kernels::dot_f64(&a.items.floats(), &b.items.floats())
+            })
+        })
+        .flatten()
+        .unwrap_or(0.0)
+}
+
+/// Replace every element `x` of an int list with `x * mul + add`. Returns 0
+/// if the list holds anything but ints.
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_builtin_list_scale_int(handle: u64, mul: i64, add: i64) -> i32 {
+    LISTS
+        .with_mut(handle, |list| {
+            list.items.specialize();
+            match &mut list.items {
+                ListItems::Int(items) => {
+                    list_kernels::scale_i64(items, mul, add);
+                    1
+                }
+                items => i32::from(items.is_empty()),
+            }
+        })
+        .unwrap_or(0)
+}
+
+/// Replace every element `x` of a float list with `x * mul + add`. Returns 0
+/// if the list holds anything but floats.
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_builtin_list_scale_float(handle: u64, mul: f64, add: f64) -> i32 {
+    LISTS
+        .with_mut(handle, |list| {
+            list.items.specialize();
+            match &mut list.items {
+                ListItems::Float(items) => {
+                    list_kernels::scale_f64(items, mul, add);
+                    1
+                }
+                items => i32::from(items.is_empty()),
+            }
+        })
+        .unwrap_or(0)
+}
+
+/// Sort a list of ints, floats, bools or strings in place. Returns 0 for a
+/// list that mixes kinds or holds lists or maps.
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_builtin_list_sort(handle: u64) -> i32 {
+    LISTS
+        .with_mut(handle, |list| {
+            list.items.specialize();
+            match &mut list.items {
+                ListItems::Int(items) => list_kernels::sort_i64(items),
+                ListItems::Float(items) => list_kernels::sort_f64(items),
+                ListItems::Bool(items) => list_kernels::sort_bool(items),
+                ListItems::Str(items) => items.sort_unstable(),
+                ListItems::Values(items) => return i32::from(items.is_empty()),
+            }
+            1
+        })
+        .unwrap_or(0)
+}
+
 /// insert a string key-value pair into a map
 ///
 /// # Safety
@@ -659,17 +1028,11 @@ pub unsafe extern "C" fn otter_builtin_map_set(
         return 0;
     }
 
-    let key_str = unsafe { CStr::from_ptr(key).to_str().unwrap_or("").to_string() };
+    let key = unsafe { MapKey::from_c(key) };
 
     let value_str = unsafe { CStr::from_ptr(value).to_str().unwrap_or("").to_string() };
 
-    let mut maps = MAPS.write();
-    if let Some(map) = maps.get_mut(&handle) {
-        map.items.insert(key_str, Value::String(value_str));
-        1
-    } else {
-        0
-    }
+    insert_into_map(handle, key, Value::String(value_str))
 }
 
 /// retrieves a key `key` from the map pointed to by `handle` and attempts a cast to an i64
@@ -682,19 +1045,10 @@ pub unsafe extern "C" fn otter_builtin_map_get_int(handle: u64, key: *const c_ch
     if key.is_null() {
         return 0;
     }
-    let key_str = unsafe { CStr::from_ptr(key).to_str().unwrap_or("").to_string() };
-    match map_value(handle, &key_str) {
-        Some(Value::I64(i)) => i,
-        Some(Value::F64(f)) => f as i64,
-        Some(Value::Bool(b)) => {
-            if b {
-                1
-            } else {
-                0
-            }
-        }
-        _ => 0,
-    }
+    let key = unsafe { MapKey::from_c(key) };
+    map_value(handle, key)
+        .map(|value| value_as_i64(&value))
+        .unwrap_or(0)
 }
 
 /// retrieves a key `key` from the map pointed to by `handle` and attempts a cast to an f64
@@ -707,19 +1061,10 @@ pub unsafe extern "C" fn otter_builtin_map_get_float(handle: u64, key: *const c_
     if key.is_null() {
         return 0.0;
     }
-    let key_str = unsafe { CStr::from_ptr(key).to_str().unwrap_or("").to_string() };
-    match map_value(handle, &key_str) {
-        Some(Value::F64(f)) => f,
-        Some(Value::I64(i)) => i as f64,
-        Some(Value::Bool(b)) => {
-            if b {
-                1.0
-            } else {
-                0.0
-            }
-        }
-        _ => 0.0,
-    }
+    let key = unsafe { MapKey::from_c(key) };
+    map_value(handle, key)
+        .map(|value| value_as_f64(&value))
+        .unwrap_or(0.0)
 }
 
 /// retrieves a key `key` from the map pointed to by `handle` and attempts a cast to a bool
@@ -732,13 +1077,10 @@ pub unsafe extern "C" fn otter_builtin_map_get_bool(handle: u64, key: *const c_c
     if key.is_null() {
         return false;
     }
-    let key_str = unsafe { CStr::from_ptr(key).to_str().unwrap_or("").to_string() };
-    match map_value(handle, &key_str) {
-        Some(Value::Bool(b)) => b,
-        Some(Value::I64(i)) => i != 0,
-        Some(Value::F64(f)) => f != 0.0,
-        _ => false,
-    }
+    let key = unsafe { MapKey::from_c(key) };
+    map_value(handle, key)
+        .map(|value| value_as_bool(&value))
+        .unwrap_or(false)
 }
 
 /// retrieves a key `key` from the map pointed to by `handle` and attempts to
@@ -752,8 +1094,8 @@ pub unsafe extern "C" fn otter_builtin_map_get_list(handle: u64, key: *const c_c
     if key.is_null() {
         return 0;
     }
-    let key_str = unsafe { CStr::from_ptr(key).to_str().unwrap_or("").to_string() };
-    match map_value(handle, &key_str) {
+    let key = unsafe { MapKey::from_c(key) };
+    match map_value(handle, key) {
         Some(Value::List(inner)) => inner,
         _ => 0,
     }
@@ -770,146 +1112,271 @@ pub unsafe extern "C" fn otter_builtin_map_get_map(handle: u64, key: *const c_ch
     if key.is_null() {
         return 0;
     }
-    let key_str = unsafe { CStr::from_ptr(key).to_str().unwrap_or("").to_string() };
-    match map_value(handle, &key_str) {
+    let key = unsafe { MapKey::from_c(key) };
+    match map_value(handle, key) {
         Some(Value::Map(inner)) => inner,
         _ => 0,
     }
 }
 
-/// retrieves a key `key` from the map pointed to by `handle` and sets the
-/// current value to the new value `value`
+/// retrieves a key `key` from the map pointed to by `handle` and sets the
+/// current value to the new value `value`
+///
+/// # Safety
+///
+/// this function dereferences a raw pointer
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn otter_builtin_map_set_int(
+    handle: u64,
+    key: *const c_char,
+    value: i64,
+) -> i32 {
+    if key.is_null() {
+        return 0;
+    }
+
+    let key = unsafe { MapKey::from_c(key) };
+
+    insert_into_map(handle, key, Value::I64(value))
+}
+
+/// retrieves a key `key` from the map pointed to by `handle` and sets the
+/// current value to the new value `value`
+///
+/// # Safety
+///
+/// this function dereferences a raw pointer
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn otter_builtin_map_set_float(
+    handle: u64,
+    key: *const c_char,
+    value: f64,
+) -> i32 {
+    if key.is_null() {
+        return 0;
+    }
+
+    let key = unsafe { MapKey::from_c(key) };
+
+    insert_into_map(handle, key, Value::F64(value))
+}
+
+/// retrieves a key `key` from the map pointed to by `handle` and sets the
+/// current value to the new value `value`
+///
+/// # Safety
+///
+/// this function dereferences a raw pointer
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn otter_builtin_map_set_bool(
+    handle: u64,
+    key: *const c_char,
+    value: bool,
+) -> i32 {
+    if key.is_null() {
+        return 0;
+    }
+
+    let key = unsafe { MapKey::from_c(key) };
+
+    insert_into_map(handle, key, Value::Bool(value))
+}
+
+/// retrieves a key `key` from the map pointed to by `handle` and sets the
+/// current value to the new value `value_handle`
+///
+/// # Safety
+///
+/// this function dereferences a raw pointer
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn otter_builtin_map_set_list(
+    handle: u64,
+    key: *const c_char,
+    value_handle: u64,
+) -> i32 {
+    if key.is_null() {
+        return 0;
+    }
+
+    let key = unsafe { MapKey::from_c(key) };
+
+    insert_into_map(handle, key, Value::List(value_handle))
+}
+
+/// retrieves a key `key` from the map pointed to by `handle` and sets the
+/// current value to the new value `value_handle`
+///
+/// # Safety
+///
+/// this function dereferences a raw pointer
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn otter_builtin_map_set_map(
+    handle: u64,
+    key: *const c_char,
+    value_handle: u64,
+) -> i32 {
+    if key.is_null() {
+        return 0;
+    }
+
+    let key = unsafe { MapKey::from_c(key) };
+
+    insert_into_map(handle, key, Value::Map(value_handle))
+}
+
+// `<prehashed>` variants: the compiler passes a string-literal key with its
+// length and `hash_map_key` hash, so the lookup skips both the `strlen` and
+// the hash of the C-string builtins above.
+
+/// [`otter_builtin_map_get`] with a precomputed key length and hash
+///
+/// # Safety
+///
+/// `key` must point to `key_len` readable bytes
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn otter_builtin_map_get_prehashed(
+    handle: u64,
+    key: *const c_char,
+    key_len: i64,
+    key_hash: u64,
+) -> *mut c_char {
+    if key.is_null() {
+        return std::ptr::null_mut();
+    }
+    let key = unsafe { MapKey::prehashed(key, key_len, key_hash) };
+    map_value(handle, key)
+        .and_then(|value| CString::new(value_to_string(&value)).ok())
+        .map(CString::into_raw)
+        .unwrap_or(std::ptr::null_mut())
+}
+
+/// [`otter_builtin_map_get_int`] with a precomputed key length and hash
 ///
 /// # Safety
 ///
-/// this function dereferences a raw pointer
+/// `key` must point to `key_len` readable bytes
 #[unsafe(no_mangle)]
-pub unsafe extern "C" fn otter_builtin_map_set_int(
+pub unsafe extern "C" fn otter_builtin_map_get_int_prehashed(
     handle: u64,
     key: *const c_char,
-    value: i64,
-) -> i32 {
+    key_len: i64,
+    key_hash: u64,
+) -> i64 {
     if key.is_null() {
         return 0;
     }
-
-    let key_str = unsafe { CStr::from_ptr(key).to_str().unwrap_or("").to_string() };
-
-    let mut maps = MAPS.write();
-    if let Some(map) = maps.get_mut(&handle) {
-        map.items.insert(key_str, Value::I64(value));
-        1
-    } else {
-        0
-    }
+    let key = unsafe { MapKey::prehashed(key, key_len, key_hash) };
+    map_value(handle, key)
+        .map(|value| value_as_i64(&value))
+        .unwrap_or(0)
 }
 
-/// retrieves a key `key` from the map pointed to by `handle` and sets the
-/// current value to the new value `value`
+/// [`otter_builtin_map_get_float`] with a precomputed key length and hash
 ///
 /// # Safety
 ///
-/// this function dereferences a raw pointer
+/// `key` must point to `key_len` readable bytes
 #[unsafe(no_mangle)]
-pub unsafe extern "C" fn otter_builtin_map_set_float(
+pub unsafe extern "C" fn otter_builtin_map_get_float_prehashed(
     handle: u64,
     key: *const c_char,
-    value: f64,
-) -> i32 {
+    key_len: i64,
+    key_hash: u64,
+) -> f64 {
     if key.is_null() {
-        return 0;
+        return 0.0;
     }
+    let key = unsafe { MapKey::prehashed(key, key_len, key_hash) };
+    map_value(handle, key)
+        .map(|value| value_as_f64(&value))
+        .unwrap_or(0.0)
+}
 
-    let key_str = unsafe { CStr::from_ptr(key).to_str().unwrap_or("").to_string() };
-
-    let mut maps = MAPS.write();
-    if let Some(map) = maps.get_mut(&handle) {
-        map.items.insert(key_str, Value::F64(value));
-        1
-    } else {
-        0
+/// [`otter_builtin_map_get_bool`] with a precomputed key length and hash
+///
+/// # Safety
+///
+/// `key` must point to `key_len` readable bytes
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn otter_builtin_map_get_bool_prehashed(
+    handle: u64,
+    key: *const c_char,
+    key_len: i64,
+    key_hash: u64,
+) -> bool {
+    if key.is_null() {
+        return false;
     }
+    let key = unsafe { MapKey::prehashed(key, key_len, key_hash) };
+    map_value(handle, key)
+        .map(|value| value_as_bool(&value))
+        .unwrap_or(false)
 }
 
-/// retrieves a key `key` from the map pointed to by `handle` and sets the
-/// current value to the new value `value`
+/// [`otter_builtin_map_get_list`] with a precomputed key length and hash
 ///
 /// # Safety
 ///
-/// this function dereferences a raw pointer
+/// `key` must point to `key_len` readable bytes
 #[unsafe(no_mangle)]
-pub unsafe extern "C" fn otter_builtin_map_set_bool(
+pub unsafe extern "C" fn otter_builtin_map_get_list_prehashed(
     handle: u64,
     key: *const c_char,
-    value: bool,
-) -> i32 {
+    key_len: i64,
+    key_hash: u64,
+) -> u64 {
     if key.is_null() {
         return 0;
     }
-
-    let key_str = unsafe { CStr::from_ptr(key).to_str().unwrap_or("").to_string() };
-
-    let mut maps = MAPS.write();
-    if let Some(map) = maps.get_mut(&handle) {
-        map.items.insert(key_str, Value::Bool(value));
-        1
-    } else {
-        0
+    let key = unsafe { MapKey::prehashed(key, key_len, key_hash) };
+    match map_value(handle, key) {
+        Some(Value::List(inner)) => inner,
+        _ => 0,
     }
 }
 
-/// retrieves a key `key` from the map pointed to by `handle` and sets the
-/// current value to the new value `value_handle`
+/// [`otter_builtin_map_get_map`] with a precomputed key length and hash
 ///
 /// # Safety
 ///
-/// this function dereferences a raw pointer
+/// `key` must point to `key_len` readable bytes
 #[unsafe(no_mangle)]
-pub unsafe extern "C" fn otter_builtin_map_set_list(
+pub unsafe extern "C" fn otter_builtin_map_get_map_prehashed(
     handle: u64,
     key: *const c_char,
-    value_handle: u64,
-) -> i32 {
+    key_len: i64,
+    key_hash: u64,
+) -> u64 {
     if key.is_null() {
         return 0;
     }
-
-    let key_str = unsafe { CStr::from_ptr(key).to_str().unwrap_or("").to_string() };
-
-    let mut maps = MAPS.write();
-    if let Some(map) = maps.get_mut(&handle) {
-        map.items.insert(key_str, Value::List(value_handle));
-        1
-    } else {
-        0
+    let key = unsafe { MapKey::prehashed(key, key_len, key_hash) };
+    match map_value(handle, key) {
+        Some(Value::Map(inner)) => inner,
+        _ => 0,
     }
 }
 
-/// retrieves a key `key` from the map pointed to by `handle` and sets the
-/// current value to the new value `value_handle`
+/// [`otter_builtin_map_set`] with a precomputed key length and hash
 ///
 /// # Safety
 ///
-/// this function dereferences a raw pointer
+/// `key` must point to `key_len` readable bytes and `value` must be a valid
+/// C string
 #[unsafe(no_mangle)]
-pub unsafe extern "C" fn otter_builtin_map_set_map(
+pub unsafe extern "C" fn otter_builtin_map_set_prehashed(
     handle: u64,
     key: *const c_char,
-    value_handle: u64,
+    key_len: i64,
+    key_hash: u64,
+    value: *const c_char,
 ) -> i32 {
-    if key.is_null() {
+    if key.is_null() || value.is_null() {
         return 0;
     }
-
-    let key_str = unsafe { CStr::from_ptr(key).to_str().unwrap_or("").to_string() };
-
-    let mut maps = MAPS.write();
-    if let Some(map) = maps.get_mut(&handle) {
-        map.items.insert(key_str, Value::Map(value_handle));
-        1
-    } else {
-        0
-    }
+    let key = unsafe { MapKey::prehashed(key, key_len, key_hash) };
+    let value_str = unsafe { CStr::from_ptr(value).to_str().unwrap_or("").to_string() };
+    insert_into_map(handle, key, Value::String(value_str))
 }
 
 // ============================================================================
@@ -922,45 +1389,34 @@ pub unsafe extern "C" fn otter_builtin_map_set_map(
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_iter_array(handle: u64) -> u64 {
-    let id = next_handle_id();
-    let iter = ArrayIterator { handle, index: 0 };
-    ARRAY_ITERATORS.write().insert(id, iter);
-    id
+    ARRAY_ITERATORS.insert(ArrayIterator { handle, index: 0 })
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_iter_has_next_array(iter_handle: u64) -> bool {
-    let iterators = ARRAY_ITERATORS.read();
-    if let Some(iter) = iterators.get(&iter_handle) {
-        let lists = LISTS.read();
-        if let Some(list) = lists.get(&iter.handle) {
-            iter.index < list.items.len()
-        } else {
-            false
-        }
-    } else {
-        false
-    }
+    ARRAY_ITERATORS
+        .with(iter_handle, |iter| {
+            LISTS.with(iter.handle, |list| iter.index < list.items.len())
+        })
+        .flatten()
+        .unwrap_or(false)
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_iter_next_array(iter_handle: u64) -> u64 {
-    let mut iterators = ARRAY_ITERATORS.write();
-    if let Some(iter) = iterators.get_mut(&iter_handle) {
-        if let Some(val) = list_value(iter.handle, iter.index as i64) {
+    ARRAY_ITERATORS
+        .with_mut(iter_handle, |iter| {
+            let val = list_value(iter.handle, iter.index as i64)?;
             iter.index += 1;
-            encode_runtime_value(&val)
-        } else {
-            0
-        }
-    } else {
-        0
-    }
+            Some(encode_runtime_value(&val))
+        })
+        .flatten()
+        .unwrap_or(0)
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_iter_free_array(iter_handle: u64) {
-    ARRAY_ITERATORS.write().remove(&iter_handle);
+    ARRAY_ITERATORS.remove(iter_handle);
 }
 
 /// # Safety
@@ -970,51 +1426,35 @@ pub extern "C" fn otter_builtin_iter_free_array(iter_handle: u64) {
 #[unsafe(no_mangle)]
 pub unsafe extern "C" fn otter_builtin_iter_string(ptr: *const c_char) -> u64 {
     let s = unsafe { CStr::from_ptr(ptr).to_string_lossy().into_owned() };
-    let id = next_handle_id();
-    let iter = StringIterator {
+    STRING_ITERATORS.insert(StringIterator {
         string: s,
         index: 0,
-    };
-    STRING_ITERATORS.write().insert(id, iter);
-    id
+    })
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_iter_has_next_string(iter_handle: u64) -> bool {
-    let iterators = STRING_ITERATORS.read();
-    if let Some(iter) = iterators.get(&iter_handle) {
-        iter.index < iter.string.len()
-    } else {
-        false
-    }
+    STRING_ITERATORS
+        .with(iter_handle, |iter| iter.index < iter.string.len())
+        .unwrap_or(false)
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_iter_next_string(iter_handle: u64) -> u64 {
-    let mut iterators = STRING_ITERATORS.write();
-    if let Some(iter) = iterators.get_mut(&iter_handle) {
-        if iter.index < iter.string.len() {
-            let mut chars = iter.string[iter.index..].chars();
-            if let Some(c) = chars.next() {
-                let char_len = c.len_utf8();
-                iter.index += char_len;
-                let s = c.to_string();
-                // Return encoded value instead of raw pointer
-                encode_runtime_value(&Value::String(s))
-            } else {
-                0
-            }
-        } else {
-            0
-        }
-    } else {
-        0
-    }
+    STRING_ITERATORS
+        .with_mut(iter_handle, |iter| {
+            let c = iter.string.get(iter.index..)?.chars().next()?;
+            iter.index += c.len_utf8();
+            // Return encoded value instead of raw pointer
+            Some(encode_runtime_value(&Value::String(c.to_string())))
+        })
+        .flatten()
+        .unwrap_or(0)
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_iter_free_string(iter_handle: u64) {
-    STRING_ITERATORS.write().remove(&iter_handle);
+    STRING_ITERATORS.remove(iter_handle);
 }
 
 /// otter-lang's builtin panic function
@@ -1363,42 +1803,38 @@ pub unsafe extern "C" fn otter_builtin_stringify_string(s: *const c_char) -> *mu
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_stringify_list(handle: u64) -> *mut c_char {
-    let lists = LISTS.read();
-    if let Some(list) = lists.get(&handle) {
-        let items: Vec<String> = list.items.iter().map(value_to_string).collect();
-        let json = format!("[{}]", items.join(", "));
-        CString::new(json)
-            .ok()
-            .map(CString::into_raw)
-            .unwrap_or(std::ptr::null_mut())
-    } else {
-        CString::new("[]")
-            .ok()
-            .map(CString::into_raw)
-            .unwrap_or(std::ptr::null_mut())
-    }
+    let json = LISTS
+        .with(handle, |list| {
+            let items: Vec<String> = list
+                .items
+                .values()
+                .map(|value| value_to_string(&value))
+                .collect();
+            format!("[{}]", items.join(", "))
+        })
+        .unwrap_or_else(|| "[]".to_string());
+    CString::new(json)
+        .ok()
+        .map(CString::into_raw)
+        .unwrap_or(std::ptr::null_mut())
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_builtin_stringify_map(handle: u64) -> *mut c_char {
-    let maps = MAPS.read();
-    if let Some(map) = maps.get(&handle) {
-        let items: Vec<String> = map
-            .items
-            .iter()
-            .map(|(k, v)| format!("\"{}\": {}", k, value_to_string(v)))
-            .collect();
-        let json = format!("{{{}}}", items.join(", "));
-        CString::new(json)
-            .ok()
-            .map(CString::into_raw)
-            .unwrap_or(std::ptr::null_mut())
-    } else {
-        CString::new("{}")
-            .ok()
-            .map(CString::into_raw)
-            .unwrap_or(std::ptr::null_mut())
-    }
+    let json = MAPS
+        .with(handle, |map| {
+            let items: Vec<String> = map
+                .items
+                .iter()
+                .map(|(k, v)| format!("\"{}\": {}", String::from_utf8_lossy(k), value_to_string(v)))
+                .collect();
+            format!("{{{}}}", items.join(", "))
+        })
+        .unwrap_or_else(|| "{}".to_string());
+    CString::new(json)
+        .ok()
+        .map(CString::into_raw)
+        .unwrap_or(std::ptr::null_mut())
 }
 
 // ============================================================================
@@ -1614,6 +2050,30 @@ fn register_builtin_symbols(registry: &SymbolRegistry) {
         signature: FfiSignature::new(vec![], FfiType::List),
     });
 
+    registry.register(FfiFunction {
+        name: "list.new<int>".into(),
+        symbol: "otter_builtin_list_new_int".into(),
+        signature: FfiSignature::new(vec![FfiType::I64], FfiType::List),
+    });
+
+    registry.register(FfiFunction {
+        name: "list.new<float>".into(),
+        symbol: "otter_builtin_list_new_float".into(),
+        signature: FfiSignature::new(vec![FfiType::I64], FfiType::List),
+    });
+
+    registry.register(FfiFunction {
+        name: "list.new<bool>".into(),
+        symbol: "otter_builtin_list_new_bool".into(),
+        signature: FfiSignature::new(vec![FfiType::I64], FfiType::List),
+    });
+
+    registry.register(FfiFunction {
+        name: "list.new<string>".into(),
+        symbol: "otter_builtin_list_new_string".into(),
+        signature: FfiSignature::new(vec![FfiType::I64], FfiType::List),
+    });
+
     registry.register(FfiFunction {
         name: "runtime.list.length".into(),
         symbol: "otter_runtime_list_length".into(),
@@ -1668,6 +2128,78 @@ fn register_builtin_symbols(registry: &SymbolRegistry) {
         signature: FfiSignature::new(vec![FfiType::List, FfiType::I64], FfiType::Map),
     });
 
+    registry.register(FfiFunction {
+        name: "list.sum_int".into(),
+        symbol: "otter_builtin_list_sum_int".into(),
+        signature: FfiSignature::new(vec![FfiType::List], FfiType::I64),
+    });
+
+    registry.register(FfiFunction {
+        name: "list.sum_float".into(),
+        symbol: "otter_builtin_list_sum_float".into(),
+        signature: FfiSignature::new(vec![FfiType::List], FfiType::F64),
+    });
+
+    registry.register(FfiFunction {
+        name: "list.min_int".into(),
+        symbol: "otter_builtin_list_min_int".into(),
+        signature: FfiSignature::new(vec![FfiType::List], FfiType::I64),
+    });
+
+    registry.register(FfiFunction {
+        name: "list.min_float".into(),
+        symbol: "otter_builtin_list_min_float".into(),
+        signature: FfiSignature::new(vec![FfiType::List], FfiType::F64),
+    });
+
+    registry.register(FfiFunction {
+        name: "list.max_int".into(),
+        symbol: "otter_builtin_list_max_int".into(),
+        signature: FfiSignature::new(vec![FfiType::List], FfiType::I64),
+    });
+
+    registry.register(FfiFunction {
+        name: "list.max_float".into(),
+        symbol: "otter_builtin_list_max_float".into(),
+        signature: FfiSignature::new(vec![FfiType::List], FfiType::F64),
+    });
+
+    registry.register(FfiFunction {
+        name: "list.dot_int".into(),
+        symbol: "otter_builtin_list_dot_int".into(),
+        signature: FfiSignature::new(vec![FfiType::List, FfiType::List], FfiType::I64),
+    });
+
+    registry.register(FfiFunction {
+        name: "list.dot_float".into(),
+        symbol: "otter_builtin_list_dot_float".into(),
+        signature: FfiSignature::new(vec![FfiType::List, FfiType::List], FfiType::F64),
+    });
+
+    registry.register(FfiFunction {
+        name: "list.scale_int".into(),
+        symbol: "otter_builtin_list_scale_int".into(),
+        signature: FfiSignature::new(
+            vec![FfiType::List, FfiType::I64, FfiType::I64],
+            FfiType::I32,
+        ),
+    });
+
+    registry.register(FfiFunction {
+        name: "list.scale_float".into(),
+        symbol: "otter_builtin_list_scale_float".into(),
+        signature: FfiSignature::new(
+            vec![FfiType::List, FfiType::F64, FfiType::F64],
+            FfiType::I32,
+        ),
+    });
+
+    registry.register(FfiFunction {
+        name: "list.sort".into(),
+        symbol: "otter_builtin_list_sort".into(),
+        signature: FfiSignature::new(vec![FfiType::List], FfiType::I32),
+    });
+
     registry.register(FfiFunction {
         name: "map.get".into(),
         symbol: "otter_builtin_map_get".into(),
@@ -1710,6 +2242,75 @@ fn register_builtin_symbols(registry: &SymbolRegistry) {
         signature: FfiSignature::new(vec![FfiType::Map, FfiType::Str, FfiType::Str], FfiType::I32),
     });
 
+    registry.register(FfiFunction {
+        name: "map.get<prehashed>".into(),
+        symbol: "otter_builtin_map_get_prehashed".into(),
+        signature: FfiSignature::new(
+            vec![FfiType::Map, FfiType::Str, FfiType::I64, FfiType::I64],
+            FfiType::Str,
+        ),
+    });
+
+    registry.register(FfiFunction {
+        name: "map.get_int<prehashed>".into(),
+        symbol: "otter_builtin_map_get_int_prehashed".into(),
+        signature: FfiSignature::new(
+            vec![FfiType::Map, FfiType::Str, FfiType::I64, FfiType::I64],
+            FfiType::I64,
+        ),
+    });
+
+    registry.register(FfiFunction {
+        name: "map.get_float<prehashed>".into(),
+        symbol: "otter_builtin_map_get_float_prehashed".into(),
+        signature: FfiSignature::new(
+            vec![FfiType::Map, FfiType::Str, FfiType::I64, FfiType::I64],
+            FfiType::F64,
+        ),
+    });
+
+    registry.register(FfiFunction {
+        name: "map.get_bool<prehashed>".into(),
+        symbol: "otter_builtin_map_get_bool_prehashed".into(),
+        signature: FfiSignature::new(
+            vec![FfiType::Map, FfiType::Str, FfiType::I64, FfiType::I64],
+            FfiType::Bool,
+        ),
+    });
+
+    registry.register(FfiFunction {
+        name: "map.get_list<prehashed>".into(),
+        symbol: "otter_builtin_map_get_list_prehashed".into(),
+        signature: FfiSignature::new(
+            vec![FfiType::Map, FfiType::Str, FfiType::I64, FfiType::I64],
+            FfiType::List,
+        ),
+    });
+
+    registry.register(FfiFunction {
+        name: "map.get_map<prehashed>".into(),
+        symbol: "otter_builtin_map_get_map_prehashed".into(),
+        signature: FfiSignature::new(
+            vec![FfiType::Map, FfiType::Str, FfiType::I64, FfiType::I64],
+            FfiType::Map,
+        ),
+    });
+
+    registry.register(FfiFunction {
+        name: "map.set<prehashed>".into(),
+        symbol: "otter_builtin_map_set_prehashed".into(),
+        signature: FfiSignature::new(
+            vec![
+                FfiType::Map,
+                FfiType::Str,
+                FfiType::I64,
+                FfiType::I64,
+                FfiType::Str,
+            ],
+            FfiType::I32,
+        ),
+    });
+
     registry.register(FfiFunction {
         name: "set<map,int>".into(),
         symbol: "otter_builtin_map_set_int".into(),
@@ -2135,11 +2736,10 @@ pub extern "C" fn otter_decode_value_as_i64(encoded: u64) -> i64 {
     match kind {
         ValueKind::I64 => {
             // Look up in registry for full precision
-            let values = RUNTIME_VALUES.read();
-            if let Some(Value::I64(i)) = values.get(&handle).map(|rv| rv.value.clone()) {
-                return i;
+            match RUNTIME_VALUES.with(handle, |rv| rv.value.clone()) {
+                Some(Value::I64(i)) => i,
+                _ => 0,
             }
-            0
         }
         _ => 0,
     }
@@ -2153,11 +2753,10 @@ pub extern "C" fn otter_decode_value_as_f64(encoded: u64) -> f64 {
     match kind {
         ValueKind::F64 => {
             // Look up in registry for full precision
-            let values = RUNTIME_VALUES.read();
-            if let Some(Value::F64(f)) = values.get(&handle).map(|rv| rv.value.clone()) {
-                return f;
+            match RUNTIME_VALUES.with(handle, |rv| rv.value.clone()) {
+                Some(Value::F64(f)) => f,
+                _ => 0.0,
             }
-            0.0
         }
         _ => 0.0,
     }
@@ -2208,7 +2807,7 @@ pub extern "C" fn otter_free_runtime_value(encoded: u64) {
 
     // Only free registry entries for I64 and F64 which use handles
     if matches!(kind, ValueKind::I64 | ValueKind::F64) {
-        RUNTIME_VALUES.write().remove(&handle);
+        RUNTIME_VALUES.remove(handle);
     }
 }
 
@@ -2234,3 +2833,200 @@ inventory::submit! {
         register: register_builtin_symbols,
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::benchmark::Benchmark;
+
+    #[test]
+    fn test_list_and_map_handles_do_not_alias() {
+        let list = otter_builtin_list_new();
+        let map = otter_builtin_map_new();
+        assert_eq!(otter_builtin_append_list_int(list, 7), 1);
+        assert_eq!(otter_builtin_append_list_int(map, 7), 0);
+        assert_eq!(otter_builtin_len_list(list), 1);
+        assert_eq!(otter_builtin_len_map(list), 0);
+        assert_eq!(otter_builtin_list_get_int(list, 0), 7);
+        assert_eq!(otter_builtin_list_get_int(list, 1), 0);
+        assert_eq!(otter_builtin_list_get_int(list, -1), 0);
+    }
+
+    #[test]
+    fn test_freed_iterator_handles_go_stale() {
+        let list = otter_builtin_range_int(0, 3);
+        let iter = otter_builtin_iter_array(list);
+        assert!(otter_builtin_iter_has_next_array(iter));
+        otter_builtin_iter_free_array(iter);
+        assert!(!otter_builtin_iter_has_next_array(iter));
+        assert_eq!(otter_builtin_iter_next_array(iter), 0);
+
+        let encoded = encode_runtime_value(&Value::I64(i64::MIN));
+        assert_eq!(otter_decode_value_as_i64(encoded), i64::MIN);
+        otter_free_runtime_value(encoded);
+        assert_eq!(otter_decode_value_as_i64(encoded), 0);
+    }
+
+    #[test]
+    fn test_typed_lists_adopt_and_degrade() {
+        let list = otter_builtin_list_new();
+        otter_builtin_append_list_float(list, 1.5);
+        otter_builtin_append_list_float(list, -2.0);
+        assert!(LISTS.with(list, |list| matches!(list.items, ListItems::Float(_))) == Some(true));
+        assert_eq!(otter_builtin_list_sum_float(list), -0.5);
+
+        otter_builtin_append_list_int(list, 4);
+        assert!(LISTS.with(list, |list| matches!(list.items, ListItems::Values(_))) == Some(true));
+        assert_eq!(otter_builtin_list_get_float(list, 0), 1.5);
+        assert_eq!(otter_builtin_list_get_int(list, 2), 4);
+        assert_eq!(otter_builtin_list_max_float(list), 4.0);
+        assert_eq!(otter_builtin_list_sort(list), 0);
+    }
+
+    #[test]
+    fn test_bulk_list_builtins() {
+        let list = otter_builtin_list_new_int(4);
+        for value in [5, -3, 9, 1] {
+            otter_builtin_append_list_int(list, value);
+        }
+        assert_eq!(otter_builtin_list_sum_int(list), 12);
+        assert_eq!(otter_builtin_list_min_int(list), -3);
+        assert_eq!(otter_builtin_list_max_int(list), 9);
+        assert_eq!(otter_builtin_list_dot_int(list, list), 116);
+
+        assert_eq!(otter_builtin_list_scale_int(list, 2, 1), 1);
+        assert_eq!(otter_builtin_list_sort(list), 1);
+        let sorted: Vec<i64> = (0..4)
+            .map(|i| otter_builtin_list_get_int(list, i))
+            .collect();
+        assert_eq!(sorted, [-5, 3, 11, 19]);
+
+        let empty = otter_builtin_list_new();
+        assert_eq!(otter_builtin_list_min_int(empty), 0);
+        assert_eq!(otter_builtin_list_scale_float(empty, 2.0, 0.0), 1);
+    }
+
+    #[test]
+    fn test_prehashed_map_keys_match_c_string_keys() {
+        let map = otter_builtin_map_new();
+        let key = c"port";
+        let (len, hash) = (4, hash_map_key(b"port"));
+        unsafe {
+            assert_eq!(otter_builtin_map_set_int(map, key.as_ptr(), 8080), 1);
+            assert_eq!(
+                otter_builtin_map_get_int_prehashed(map, key.as_ptr(), len, hash),
+                8080
+            );
+            assert_eq!(
+                otter_builtin_map_set_prehashed(map, key.as_ptr(), len, hash, c"http".as_ptr()),
+                1
+            );
+            assert_eq!(otter_builtin_len_map(map), 1);
+            let value = otter_builtin_map_get(map, key.as_ptr());
+            assert_eq!(CStr::from_ptr(value).to_bytes(), b"http");
+            drop(CString::from_raw(value));
+
+            // The length bounds the key, so a prefix is a different key.
+            let prefix = (3, hash_map_key(b"por"));
+            assert!(
+                otter_builtin_map_get_prehashed(map, key.as_ptr(), prefix.0, prefix.1).is_null()
+            );
+            assert_eq!(otter_builtin_delete_map(map, key.as_ptr()), 1);
+            assert_eq!(
+                otter_builtin_map_get_int_prehashed(map, key.as_ptr(), len, hash),
+                0
+            );
+        }
+    }
+
+    // Run with: cargo test -p otterc_runtime --release list_bulk_sum_benchmark -- --ignored --nocapture
+    #[test]
+    #[ignore]
+    fn list_bulk_sum_benchmark() {
+        const LEN: i64 = 1_000_000;
+
+        let list = otter_builtin_range_int(0, LEN);
+        Benchmark::new(format!("list_sum_int over {LEN} items"))
+            .warmup(2)
+            .iterations(20)
+            .run_and_print(|| {
+                assert_eq!(otter_builtin_list_sum_int(list), LEN * (LEN - 1) / 2);
+            });
+    }
+
+    // Run with: cargo test -p otterc_runtime --release list_indexed_loop_benchmark -- --ignored --nocapture
+    #[test]
+    #[ignore]
+    fn list_indexed_loop_benchmark() {
+        const LEN: i64 = 100_000;
+
+        let list = otter_builtin_range_int(0, LEN);
+        Benchmark::new(format!("list_get_int over {LEN} items"))
+            .warmup(2)
+            .iterations(20)
+            .run_and_print(|| {
+                let mut sum = 0i64;
+                for index in 0..otter_builtin_len_list(list) {
+                    sum += otter_builtin_list_get_int(list, index);
+                }
+                assert_eq!(sum, LEN * (LEN - 1) / 2);
+            });
+    }
+
+    // Run with: cargo test -p otterc_runtime --release list_parallel_append_benchmark -- --ignored --nocapture
+    #[test]
+    #[ignore]
+    fn list_parallel_append_benchmark() {
+        const THREADS: usize = 16;
+        const PER_THREAD: i64 = 50_000;
+
+        Benchmark::new(format!("append_list_int x{THREADS} threads"))
+            .warmup(1)
+            .iterations(5)
+            .run_and_print(|| {
+                std::thread::scope(|scope| {
+                    for _ in 0..THREADS {
+                        scope.spawn(|| {
+                            let list = otter_builtin_list_new();
+                            for value in 0..PER_THREAD {
+                                otter_builtin_append_list_int(list, value);
+                            }
+                            assert_eq!(otter_builtin_len_list(list), PER_THREAD);
+                        });
+                    }
+                });
+            });
+    }
+
+    // Run with: cargo test -p otterc_runtime --release map_literal_key_benchmark -- --ignored --nocapture
+    #[test]
+    #[ignore]
+    fn map_literal_key_benchmark() {
+        const LOOKUPS: i64 = 100_000;
+
+        let map = otter_builtin_map_new();
+        let key = c"request_timeout_ms";
+        let (len, hash) = (key.count_bytes() as i64, hash_map_key(key.to_bytes()));
+        unsafe { otter_builtin_map_set_int(map, key.as_ptr(), 1) };
+        Benchmark::new(format!("map_get_int x{LOOKUPS}"))
+            .warmup(2)
+            .iterations(20)
+            .run_and_print(|| {
+                let sum: i64 = (0..LOOKUPS)
+                    .map(|_| unsafe { otter_builtin_map_get_int(map, key.as_ptr()) })
+                    .sum();
+                assert_eq!(sum, LOOKUPS);
+            });
+        Benchmark::new(format!("map_get_int_prehashed x{LOOKUPS}"))
+            .warmup(2)
+            .iterations(20)
+            .run_and_print(|| {
+                let sum: i64 = (0..LOOKUPS)
+                    .map(|_| unsafe {
+                        otter_builtin_map_get_int_prehashed(map, key.as_ptr(), len, hash)
+                    })
+                    .sum();
+                assert_eq!(sum, LOOKUPS);
+            });
+    }
+}
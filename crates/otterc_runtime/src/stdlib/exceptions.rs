@@ -337,10 +337,8 @@ pub unsafe extern "C" fn otter_iter_array(
     let handle_id = unsafe { *handle };
 
     // Look up the list in the global lists map
-    let lists = LISTS.read();
-    let values = lists
-        .get(&handle_id)
-        .map(|list| list.items.clone())
+    let values = LISTS
+        .with(handle_id, |list| list.items.to_values())
         .unwrap_or_default();
 
     let iter = Box::new(OtterArrayIterator { values, index: 0 });
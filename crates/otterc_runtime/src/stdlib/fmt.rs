@@ -19,6 +19,14 @@ fn register_std_error_symbols(registry: &SymbolRegistry) {
         signature: FfiSignature::new(vec![FfiType::Opaque, FfiType::I64], FfiType::Unit),
     });
 
+    // `runtime.raise` with a string-literal message; codegen picks it so
+    // the literal is borrowed instead of copied.
+    registry.register(FfiFunction {
+        name: "runtime.raise<static>".into(),
+        symbol: "otter_error_raise_static".into(),
+        signature: FfiSignature::new(vec![FfiType::Opaque, FfiType::I64], FfiType::Unit),
+    });
+
     registry.register(FfiFunction {
         name: "runtime.clear".into(),
         symbol: "otter_error_clear".into(),
@@ -0,0 +1,400 @@
+//! Generation-checked handle tables for runtime objects
+//!
+//! A handle is `[tag:4][generation:20][index:32]`, which fits the 56 bits a
+//! tagged runtime value leaves for it. The index addresses a slot in a slab
+//! of buckets that are allocated on demand and never move, so finding a slot
+//! is a few arithmetic operations and one atomic load, with no table-wide
+//! lock. Removing an object bumps its slot's generation, so stale handles
+//! miss instead of reaching whatever reuses the slot; a slot whose generation
+//! would wrap is retired instead of reused. The tag keeps handles from
+//! different tables apart, so a map handle passed where a list is expected
+//! misses too.
+//!
+//! A slot's generation and whether it holds an object sit in one atomic word
+//! beside the value, so validating a handle takes no lock: stale and foreign
+//! handles miss, and [`HandleTable::contains`] answers, without locking.
+//! Reaching the value itself does lock, with the slot's own read or write
+//! lock. Reads are therefore not lock-free: the runtime grows lists and maps
+//! in place, and a reader walking a `Vec` that a writer reallocates would
+//! read freed memory. Threads working on different objects still never touch
+//! the same lock.
+
+use std::cell::Cell;
+use std::ptr;
+use std::sync::atomic::{AtomicPtr, AtomicU32, AtomicUsize, Ordering};
+
+use crossbeam_utils::CachePadded;
+use parking_lot::{Mutex, RwLock};
+
+const INDEX_BITS: u32 = 32;
+const GENERATION_BITS: u32 = 20;
+const GENERATION_MASK: u32 = (1 << GENERATION_BITS) - 1;
+const TAG_SHIFT: u32 = INDEX_BITS + GENERATION_BITS;
+const TAG_MASK: u64 = 0xF;
+
+/// Slots in bucket 0; bucket `b` holds `FIRST_BUCKET_SLOTS << b`.
+const FIRST_BUCKET_SHIFT: u32 = 6;
+const FIRST_BUCKET_SLOTS: usize = 1 << FIRST_BUCKET_SHIFT;
+const BUCKETS: usize = (INDEX_BITS - FIRST_BUCKET_SHIFT) as usize + 1;
+
+/// Free lists are sharded so that threads recycling slots do not queue on
+/// one lock. A thread whose own shard is empty takes a slot from another
+/// before growing the slab, so producer/consumer pairs reuse slots too.
+const FREE_SHARDS: usize = 16;
+
+/// Set in a slot's state word while it holds an object.
+const LIVE: u32 = 1 << 31;
+
+struct Slot<T> {
+    /// The slot's generation, plus [`LIVE`] while it holds an object.
+    /// Changed only under the write lock of `value`.
+    state: AtomicU32,
+    value: RwLock<Option<T>>,
+}
+
+pub struct HandleTable<T> {
+    tag: u64,
+    buckets: [AtomicPtr<Slot<T>>; BUCKETS],
+    next_index: AtomicU32,
+    free: [CachePadded<Mutex<Vec<u32>>>; FREE_SHARDS],
+    /// Indices across all free lists, so an empty table skips the search
+    free_count: AtomicUsize,
+}
+
+// SAFETY: values are only reached through their slot's lock.
+unsafe impl<T: Send> Send for HandleTable<T> {}
+unsafe impl<T: Send + Sync> Sync for HandleTable<T> {}
+
+thread_local! {
+    static FREE_SHARD: Cell<usize> = const { Cell::new(usize::MAX) };
+}
+
+fn free_shard() -> usize {
+    static NEXT_SHARD: AtomicUsize = AtomicUsize::new(0);
+    FREE_SHARD
+        .try_with(|shard| {
+            if shard.get() == usize::MAX {
+                shard.set(NEXT_SHARD.fetch_add(1, Ordering::Relaxed) % FREE_SHARDS);
+            }
+            shard.get()
+        })
+        .unwrap_or(0)
+}
+
+/// Bucket and offset of a slot index.
+fn locate(index: u32) -> (usize, usize) {
+    let biased = index as usize + FIRST_BUCKET_SLOTS;
+    let bucket = (usize::BITS - 1 - biased.leading_zeros()) as usize - FIRST_BUCKET_SHIFT as usize;
+    (bucket, biased - (FIRST_BUCKET_SLOTS << bucket))
+}
+
+/// The generation after `generation`, or `None` once it would wrap: a reused
+/// generation would make old handles resolve again. Zero is never handed
+/// out, so no valid handle is 0 and a retired slot (generation 0) matches
+/// nothing.
+fn next_generation(generation: u32) -> Option<u32> {
+    (generation < GENERATION_MASK).then_some(generation + 1)
+}
+
+impl<T> HandleTable<T> {
+    /// Create an empty table whose handles carry `tag` (1 to 15)
+    pub fn new(tag: u8) -> Self {
+        debug_assert!(tag != 0 && u64::from(tag) <= TAG_MASK);
+        Self {
+            tag: u64::from(tag),
+            buckets: std::array::from_fn(|_| AtomicPtr::new(ptr::null_mut())),
+            next_index: AtomicU32::new(0),
+            free: std::array::from_fn(|_| CachePadded::new(Mutex::new(Vec::new()))),
+            free_count: AtomicUsize::new(0),
+        }
+    }
+
+    fn encode(&self, index: u32, generation: u32) -> u64 {
+        (self.tag << TAG_SHIFT) | (u64::from(generation) << INDEX_BITS) | u64::from(index)
+    }
+
+    fn decode(&self, handle: u64) -> Option<(u32, u32)> {
+        if (handle >> TAG_SHIFT) & TAG_MASK != self.tag {
+            return None;
+        }
+        let generation = (handle >> INDEX_BITS) as u32 & GENERATION_MASK;
+        Some((handle as u32, generation))
+    }
+
+    fn slot(&self, index: u32) -> Option<&Slot<T>> {
+        let (bucket, offset) = locate(index);
+        let slots = self.buckets[bucket].load(Ordering::Acquire);
+        if slots.is_null() {
+            return None;
+        }
+        // SAFETY: a published bucket holds `FIRST_BUCKET_SLOTS << bucket`
+        // slots and lives as long as the table.
+        Some(unsafe { &*slots.add(offset) })
+    }
+
+    fn slot_or_alloc(&self, index: u32) -> &Slot<T> {
+        let (bucket, offset) = locate(index);
+        let mut slots = self.buckets[bucket].load(Ordering::Acquire);
+        if slots.is_null() {
+            let fresh: Box<[Slot<T>]> = (0..FIRST_BUCKET_SLOTS << bucket)
+                .map(|_| Slot {
+                    state: AtomicU32::new(1),
+                    value: RwLock::new(None),
+                })
+                .collect();
+            let fresh = Box::into_raw(fresh).cast::<Slot<T>>();
+            slots = match self.buckets[bucket].compare_exchange(
+                ptr::null_mut(),
+                fresh,
+                Ordering::AcqRel,
+                Ordering::Acquire,
+            ) {
+                Ok(_) => fresh,
+                Err(published) => {
+                    // SAFETY: `fresh` lost the race and was never shared.
+                    unsafe { drop(Self::bucket_from_raw(fresh, bucket)) };
+                    published
+                }
+            };
+        }
+        // SAFETY: as in `slot`.
+        unsafe { &*slots.add(offset) }
+    }
+
+    /// # Safety
+    ///
+    /// `slots` must come from `Box::into_raw` on a bucket of index `bucket`.
+    unsafe fn bucket_from_raw(slots: *mut Slot<T>, bucket: usize) -> Box<[Slot<T>]> {
+        let len = FIRST_BUCKET_SLOTS << bucket;
+        unsafe { Box::from_raw(ptr::slice_from_raw_parts_mut(slots, len)) }
+    }
+
+    /// A freed index, from the calling thread's shard if it has one and
+    /// otherwise from whichever shard does
+    fn pop_free(&self) -> Option<u32> {
+        if self.free_count.load(Ordering::Relaxed) == 0 {
+            return None;
+        }
+        let home = free_shard();
+        let index = (0..FREE_SHARDS).find_map(|step| {
+            let shard = &self.free[(home + step) % FREE_SHARDS];
+            if step == 0 {
+                shard.lock().pop()
+            } else {
+                shard.try_lock()?.pop()
+            }
+        })?;
+        self.free_count.fetch_sub(1, Ordering::Relaxed);
+        Some(index)
+    }
+
+    /// Store `value` and return its handle
+    pub fn insert(&self, value: T) -> u64 {
+        let index = self.pop_free().unwrap_or_else(|| {
+            let index = self.next_index.fetch_add(1, Ordering::Relaxed);
+            assert!(index != u32::MAX, "handle table exhausted");
+            index
+        });
+        let slot = self.slot_or_alloc(index);
+        let mut guard = slot.value.write();
+        *guard = Some(value);
+        let generation = slot.state.load(Ordering::Relaxed);
+        slot.state.store(generation | LIVE, Ordering::Release);
+        self.encode(index, generation)
+    }
+
+    /// The slot `handle` names if it currently holds the object the handle
+    /// was issued for. Takes no lock; callers that go on to the value check
+    /// again under the slot's lock, since a remove may run in between.
+    fn live_slot(&self, handle: u64) -> Option<(&Slot<T>, u32)> {
+        let (index, generation) = self.decode(handle)?;
+        let slot = self.slot(index)?;
+        (slot.state.load(Ordering::Acquire) == generation | LIVE).then_some((slot, generation))
+    }
+
+    /// Run `f` on the object behind `handle`, or return `None` if the handle
+    /// is stale or belongs to another table
+    pub fn with<R>(&self, handle: u64, f: impl FnOnce(&T) -> R) -> Option<R> {
+        let (slot, generation) = self.live_slot(handle)?;
+        // Recursive, so nested collections that contain themselves can be
+        // walked without deadlocking against a queued writer.
+        let value = slot.value.read_recursive();
+        if slot.state.load(Ordering::Relaxed) != generation | LIVE {
+            return None;
+        }
+        value.as_ref().map(f)
+    }
+
+    /// Like [`HandleTable::with`], with exclusive access
+    pub fn with_mut<R>(&self, handle: u64, f: impl FnOnce(&mut T) -> R) -> Option<R> {
+        let (slot, generation) = self.live_slot(handle)?;
+        let mut value = slot.value.write();
+        if slot.state.load(Ordering::Relaxed) != generation | LIVE {
+            return None;
+        }
+        value.as_mut().map(f)
+    }
+
+    /// Whether `handle` resolves, checked without taking any lock
+    pub fn contains(&self, handle: u64) -> bool {
+        self.live_slot(handle).is_some()
+    }
+
+    /// Take the object out of the table; `handle` and any copies of it stop
+    /// resolving
+    pub fn remove(&self, handle: u64) -> Option<T> {
+        let (slot, generation) = self.live_slot(handle)?;
+        let value = {
+            let mut guard = slot.value.write();
+            if slot.state.load(Ordering::Relaxed) != generation | LIVE {
+                return None;
+            }
+            let value = guard.take()?;
+            match next_generation(generation) {
+                Some(next) => slot.state.store(next, Ordering::Release),
+                None => {
+                    slot.state.store(0, Ordering::Release);
+                    return Some(value);
+                }
+            }
+            value
+        };
+        let index = handle as u32;
+        self.free[free_shard()].lock().push(index);
+        self.free_count.fetch_add(1, Ordering::Relaxed);
+        Some(value)
+    }
+}
+
+impl<T> Drop for HandleTable<T> {
+    fn drop(&mut self) {
+        for (bucket, slots) in self.buckets.iter_mut().enumerate() {
+            let slots = *slots.get_mut();
+            if !slots.is_null() {
+                // SAFETY: published buckets come from `slot_or_alloc`.
+                unsafe { drop(Self::bucket_from_raw(slots, bucket)) };
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_locate_covers_indices_contiguously() {
+        assert_eq!(locate(0), (0, 0));
+        assert_eq!(
+            locate(FIRST_BUCKET_SLOTS as u32 - 1),
+            (0, FIRST_BUCKET_SLOTS - 1)
+        );
+        assert_eq!(locate(FIRST_BUCKET_SLOTS as u32), (1, 0));
+        assert_eq!(locate(3 * FIRST_BUCKET_SLOTS as u32), (2, 0));
+        assert_eq!(locate(u32::MAX).0, BUCKETS - 1);
+    }
+
+    #[test]
+    fn test_stale_and_foreign_handles_miss() {
+        let lists: HandleTable<Vec<i64>> = HandleTable::new(1);
+        let maps: HandleTable<Vec<i64>> = HandleTable::new(2);
+
+        let first = lists.insert(vec![1]);
+        assert_ne!(first, 0);
+        assert_eq!(lists.with(first, |items| items[0]), Some(1));
+        assert_eq!(maps.with(first, |items| items[0]), None);
+
+        assert_eq!(lists.remove(first), Some(vec![1]));
+        assert!(!lists.contains(first));
+        assert_eq!(lists.remove(first), None);
+
+        // The slot is reused under a new generation.
+        let second = lists.insert(vec![2]);
+        assert_eq!(second as u32, first as u32);
+        assert_ne!(second, first);
+        assert_eq!(lists.with(first, |items| items[0]), None);
+        assert_eq!(lists.with(second, |items| items[0]), Some(2));
+    }
+
+    #[test]
+    fn test_contains_does_not_wait_for_the_slot_lock() {
+        let table: HandleTable<Vec<i64>> = HandleTable::new(1);
+        let handle = table.insert(Vec::new());
+        // The slot's write lock is held here; a locking check would deadlock.
+        table.with_mut(handle, |items| {
+            items.push(1);
+            assert!(table.contains(handle));
+            assert!(!table.contains(handle + 1));
+        });
+        assert_eq!(table.with(handle, |items| items.len()), Some(1));
+    }
+
+    #[test]
+    fn test_parallel_inserts_and_appends() {
+        let table: HandleTable<Vec<usize>> = HandleTable::new(1);
+        let handles: Vec<u64> = std::thread::scope(|scope| {
+            let workers: Vec<_> = (0..8)
+                .map(|worker| {
+                    let table = &table;
+                    scope.spawn(move || {
+                        let handle = table.insert(Vec::new());
+                        for i in 0..1000 {
+                            table.with_mut(handle, |items| items.push(worker * 1000 + i));
+                        }
+                        handle
+                    })
+                })
+                .collect();
+            workers
+                .into_iter()
+                .map(|worker| worker.join().unwrap())
+                .collect()
+        });
+        for (worker, handle) in handles.into_iter().enumerate() {
+            let items = table.with(handle, |items| items.clone()).unwrap();
+            assert_eq!(items.len(), 1000);
+            assert_eq!(items[999], worker * 1000 + 999);
+        }
+    }
+
+    #[test]
+    fn test_slots_freed_on_another_thread_are_reused() {
+        let table: HandleTable<u64> = HandleTable::new(1);
+        let (sender, receiver) = std::sync::mpsc::sync_channel(4);
+        std::thread::scope(|scope| {
+            let table = &table;
+            scope.spawn(move || {
+                for (i, handle) in receiver.into_iter().enumerate() {
+                    assert_eq!(table.remove(handle), Some(i as u64));
+                }
+            });
+            for i in 0..10_000u64 {
+                sender.send(table.insert(i)).unwrap();
+            }
+            drop(sender);
+        });
+        // Only as many slots as were in flight at once, not one per insert.
+        assert!(table.next_index.load(Ordering::Relaxed) < 64);
+    }
+
+    #[test]
+    fn test_slot_is_retired_when_its_generation_would_wrap() {
+        let table: HandleTable<i64> = HandleTable::new(1);
+        let first = table.insert(1);
+        table
+            .slot(first as u32)
+            .unwrap()
+            .state
+            .store(GENERATION_MASK | LIVE, Ordering::Relaxed);
+        let last = table.encode(first as u32, GENERATION_MASK);
+
+        assert_eq!(table.remove(last), Some(1));
+        assert!(!table.contains(last));
+        let second = table.insert(2);
+        assert_ne!(second as u32, first as u32);
+        // No handle of any generation reaches the retired slot.
+        for generation in [0, 1, GENERATION_MASK] {
+            assert!(!table.contains(table.encode(first as u32, generation)));
+        }
+    }
+}
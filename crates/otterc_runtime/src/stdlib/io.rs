@@ -1,12 +1,15 @@
 use std::ffi::{CStr, CString};
 use std::fs;
-use std::io::{self, BufRead, BufReader, Write};
+use std::io::{self, BufRead, Write};
 use std::os::raw::c_char;
 use std::sync::atomic::{AtomicU64, Ordering};
 
 use once_cell::sync::Lazy;
 use parking_lot::RwLock;
 
+use crate::stdlib::builtins::{LINE_ITERATOR_TABLE, LISTS, List, ListItems};
+use crate::stdlib::handle_table::HandleTable;
+use crate::stdlib::line_reader::LineReader;
 use otterc_symbol::registry::{FfiFunction, FfiSignature, FfiType, SymbolRegistry};
 
 // ============================================================================
@@ -102,6 +105,13 @@ pub unsafe extern "C" fn otter_std_io_eprintln(message: *const c_char) {
     }
 }
 
+/// flushes any buffered stdout and stderr output
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_std_io_flush() {
+    let _ = io::stdout().lock().flush();
+    let _ = io::stderr().lock().flush();
+}
+
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_std_io_read_line() -> *mut c_char {
     let mut line = String::new();
@@ -196,7 +206,7 @@ pub unsafe extern "C" fn otter_std_io_copy(src: *const c_char, dst: *const c_cha
     }
 }
 
-///
+/// reads the file at `path` into a list of its lines
 ///
 /// # Safety
 ///
@@ -209,39 +219,113 @@ pub unsafe extern "C" fn otter_std_io_lines(path: *const c_char) -> u64 {
 
     let path_str = unsafe { CStr::from_ptr(path).to_str().unwrap_or("").to_string() };
 
-    match fs::File::open(&path_str) {
-        Ok(file) => {
-            let reader = BufReader::new(file);
-            let mut lines_list = Vec::new();
-
-            for line_str in reader.lines().map_while(Result::ok) {
-                lines_list.push(line_str);
+    match LineReader::open(&path_str) {
+        Ok(mut reader) => {
+            let mut lines = Vec::new();
+            while let Ok(Some(line)) = reader.next_line() {
+                lines.push(String::from_utf8_lossy(line).into_owned());
             }
+            LISTS.insert(List {
+                items: ListItems::Str(lines),
+            })
+        }
+        Err(_) => 0,
+    }
+}
 
-            // Create a list handle using builtins module
-            // We'll use the builtin list functions directly
-            unsafe extern "C" {
-                fn otter_builtin_list_new() -> u64;
-                fn otter_builtin_append_list_string(handle: u64, val: *const c_char) -> i32;
-            }
+// ============================================================================
+// Streaming Lines
+// `for line in io.lines(path)` compiles to these instead of building the
+// list, so only the current line is held in memory.
+// ============================================================================
 
-            let list_handle = unsafe { otter_builtin_list_new() };
+struct LineIterator {
+    reader: LineReader,
+    /// The next line, already in the form the loop variable takes
+    next: Option<CString>,
+    done: bool,
+}
 
-            for line in lines_list {
-                let cstr = CString::new(line).unwrap();
-                let ptr = cstr.into_raw();
-                unsafe {
-                    let _ = otter_builtin_append_list_string(list_handle, ptr);
-                    let _ = CString::from_raw(ptr);
-                }
+impl LineIterator {
+    /// Read the next line unless one is already waiting
+    fn fill(&mut self) -> bool {
+        if self.next.is_none() && !self.done {
+            match self.reader.next_line() {
+                Ok(Some(line)) => self.next = Some(owned_line(line)),
+                Ok(None) | Err(_) => self.done = true,
             }
-
-            list_handle
         }
+        self.next.is_some()
+    }
+}
+
+/// Copy a line straight out of the reader's mapping or buffer into the
+/// string the program receives. Valid UTF-8 is copied once; a line stops at
+/// an interior NUL, as the C string it becomes would.
+fn owned_line(line: &[u8]) -> CString {
+    let line = line
+        .iter()
+        .position(|&byte| byte == 0)
+        .map_or(line, |nul| &line[..nul]);
+    let text = String::from_utf8_lossy(line);
+    let mut bytes = Vec::with_capacity(text.len() + 1);
+    bytes.extend_from_slice(text.as_bytes());
+    // SAFETY: NUL bytes were cut off above and lossy decoding adds none.
+    unsafe { CString::from_vec_unchecked(bytes) }
+}
+
+static LINE_ITERATORS: Lazy<HandleTable<LineIterator>> =
+    Lazy::new(|| HandleTable::new(LINE_ITERATOR_TABLE));
+
+/// opens the file at `path` for line-by-line iteration
+///
+/// # Safety
+///
+/// this function dereferences a raw pointer
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn otter_std_io_iter_lines(path: *const c_char) -> u64 {
+    if path.is_null() {
+        return 0;
+    }
+
+    let path_str = unsafe { CStr::from_ptr(path).to_str().unwrap_or("").to_string() };
+
+    match LineReader::open(&path_str) {
+        Ok(reader) => LINE_ITERATORS.insert(LineIterator {
+            reader,
+            next: None,
+            done: false,
+        }),
         Err(_) => 0,
     }
 }
 
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_std_io_iter_has_next_lines(iter_handle: u64) -> bool {
+    LINE_ITERATORS
+        .with_mut(iter_handle, LineIterator::fill)
+        .unwrap_or(false)
+}
+
+/// The next line as a string the program owns, or null at the end. The
+/// loop takes it as is, with no tagged-value decoding.
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_std_io_iter_next_lines(iter_handle: u64) -> *mut c_char {
+    LINE_ITERATORS
+        .with_mut(iter_handle, |iter| {
+            iter.fill();
+            iter.next
+                .take()
+                .map_or(std::ptr::null_mut(), CString::into_raw)
+        })
+        .unwrap_or(std::ptr::null_mut())
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_std_io_iter_free_lines(iter_handle: u64) {
+    LINE_ITERATORS.remove(iter_handle);
+}
+
 // ============================================================================
 // Buffer Operations
 // ============================================================================
@@ -566,6 +650,18 @@ fn register_std_io_symbols(registry: &SymbolRegistry) {
         signature: FfiSignature::new(vec![FfiType::Str], FfiType::Unit),
     });
 
+    registry.register(FfiFunction {
+        name: "std.io.flush".into(),
+        symbol: "otter_std_io_flush".into(),
+        signature: FfiSignature::new(vec![], FfiType::Unit),
+    });
+
+    registry.register(FfiFunction {
+        name: "io.flush".into(),
+        symbol: "otter_std_io_flush".into(),
+        signature: FfiSignature::new(vec![], FfiType::Unit),
+    });
+
     registry.register(FfiFunction {
         name: "std.io.read_line".into(),
         symbol: "otter_std_io_read_line".into(),
@@ -602,6 +698,30 @@ fn register_std_io_symbols(registry: &SymbolRegistry) {
         signature: FfiSignature::new(vec![FfiType::Str], FfiType::Opaque),
     });
 
+    registry.register(FfiFunction {
+        name: "__otter_iter_lines".into(),
+        symbol: "otter_std_io_iter_lines".into(),
+        signature: FfiSignature::new(vec![FfiType::Str], FfiType::Opaque),
+    });
+
+    registry.register(FfiFunction {
+        name: "__otter_iter_has_next_lines".into(),
+        symbol: "otter_std_io_iter_has_next_lines".into(),
+        signature: FfiSignature::new(vec![FfiType::Opaque], FfiType::Bool),
+    });
+
+    registry.register(FfiFunction {
+        name: "__otter_iter_next_lines".into(),
+        symbol: "otter_std_io_iter_next_lines".into(),
+        signature: FfiSignature::new(vec![FfiType::Opaque], FfiType::Str),
+    });
+
+    registry.register(FfiFunction {
+        name: "__otter_iter_free_lines".into(),
+        symbol: "otter_std_io_iter_free_lines".into(),
+        signature: FfiSignature::new(vec![FfiType::Opaque], FfiType::Unit),
+    });
+
     registry.register(FfiFunction {
         name: "io.buffer".into(),
         symbol: "otter_std_io_buffer".into(),
@@ -696,3 +816,39 @@ inventory::submit! {
         register: register_std_io_symbols,
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::stdlib::builtins::{otter_builtin_len_list, otter_builtin_list_get};
+
+    #[test]
+    fn test_streamed_lines_match_lines_list() {
+        let path = std::env::temp_dir().join(format!("otter_io_lines_{}.txt", std::process::id()));
+        fs::write(&path, b"alpha\r\n\nbeta\ngam\xffma").unwrap();
+        let c_path = CString::new(path.to_str().unwrap()).unwrap();
+
+        let list = unsafe { otter_std_io_lines(c_path.as_ptr()) };
+        let iter = unsafe { otter_std_io_iter_lines(c_path.as_ptr()) };
+        fs::remove_file(&path).unwrap();
+
+        let mut streamed = Vec::new();
+        while otter_std_io_iter_has_next_lines(iter) {
+            let line = otter_std_io_iter_next_lines(iter);
+            streamed.push(unsafe { CString::from_raw(line) }.into_string().unwrap());
+        }
+        assert!(otter_std_io_iter_next_lines(iter).is_null());
+        otter_std_io_iter_free_lines(iter);
+        assert_eq!(streamed, ["alpha", "", "beta", "gam\u{fffd}ma"]);
+        assert!(!otter_std_io_iter_has_next_lines(iter));
+
+        assert_eq!(otter_builtin_len_list(list), 4);
+        for (index, expected) in streamed.iter().enumerate() {
+            let line = otter_builtin_list_get(list, index as i64);
+            assert_eq!(
+                unsafe { CString::from_raw(line) }.to_str().unwrap(),
+                expected
+            );
+        }
+    }
+}
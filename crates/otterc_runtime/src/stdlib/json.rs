@@ -1,16 +1,24 @@
 use std::ffi::{CStr, CString};
+use std::fs::File;
 use std::os::raw::c_char;
 
-use serde_json::Value;
+use once_cell::sync::Lazy;
 
+use crate::stdlib::builtins::{
+    JSON_STREAM_TABLE, LISTS, List, ListItems, MAPS, Value, encode_runtime_value,
+};
+use crate::stdlib::handle_table::HandleTable;
+use crate::stdlib::json_decode::{self, JsonStream};
+use crate::stdlib::json_encode;
 use otterc_symbol::registry::{FfiFunction, FfiSignature, FfiType, SymbolRegistry};
 
-fn read_c_string(ptr: *const c_char) -> Option<String> {
+/// Borrow a C string from compiled code without copying it
+fn read_c_str<'a>(ptr: *const c_char) -> Option<&'a str> {
     if ptr.is_null() {
         return None;
     }
 
-    unsafe { CStr::from_ptr(ptr).to_str().ok().map(|s| s.to_string()) }
+    unsafe { CStr::from_ptr(ptr).to_str().ok() }
 }
 
 fn into_c_string<S: Into<String>>(value: S) -> *mut c_char {
@@ -20,45 +28,185 @@ fn into_c_string<S: Into<String>>(value: S) -> *mut c_char {
         .unwrap_or(std::ptr::null_mut())
 }
 
-fn normalize_json(text: &str) -> Option<String> {
-    serde_json::from_str::<Value>(text)
-        .ok()
-        .and_then(|value| serde_json::to_string(&value).ok())
+/// Decode and re-encode `text`, freeing the intermediate lists and maps
+fn reformat(text: *const c_char, pretty: bool) -> *mut c_char {
+    let Some(value) = read_c_str(text).and_then(|text| json_decode::decode(text).ok()) else {
+        return std::ptr::null_mut();
+    };
+    let encoded = json_encode::encode(&value, pretty);
+    json_decode::release(value);
+    encoded.map_or(std::ptr::null_mut(), into_c_string)
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_std_json_encode(obj: *const c_char) -> *mut c_char {
-    if let Some(text) = read_c_string(obj) {
-        normalize_json(&text).map_or(std::ptr::null_mut(), into_c_string)
-    } else {
-        std::ptr::null_mut()
-    }
+    reformat(obj, false)
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_std_json_decode(json_str: *const c_char) -> *mut c_char {
-    if let Some(text) = read_c_string(json_str) {
-        normalize_json(&text).map_or(std::ptr::null_mut(), into_c_string)
-    } else {
-        std::ptr::null_mut()
-    }
+    reformat(json_str, false)
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_std_json_pretty(json_str: *const c_char) -> *mut c_char {
-    read_c_string(json_str)
-        .and_then(|text| serde_json::from_str::<Value>(&text).ok())
-        .and_then(|value| serde_json::to_string_pretty(&value).ok())
-        .map_or(std::ptr::null_mut(), into_c_string)
+    reformat(json_str, true)
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_std_json_validate(json_str: *const c_char) -> bool {
-    read_c_string(json_str)
-        .map(|text| serde_json::from_str::<Value>(&text).is_ok())
+    read_c_str(json_str).is_some_and(|text| json_decode::validate(text).is_ok())
+}
+
+/// Decode a document whose top level is an object into a map handle, or 0
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_std_json_parse(json_str: *const c_char) -> u64 {
+    match read_c_str(json_str).and_then(|text| json_decode::decode(text).ok()) {
+        Some(Value::Map(handle)) => handle,
+        Some(other) => {
+            json_decode::release(other);
+            0
+        }
+        None => 0,
+    }
+}
+
+/// Decode a document whose top level is an array into a list handle, or 0
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_std_json_parse_list(json_str: *const c_char) -> u64 {
+    match read_c_str(json_str).and_then(|text| json_decode::decode(text).ok()) {
+        Some(Value::List(handle)) => handle,
+        Some(other) => {
+            json_decode::release(other);
+            0
+        }
+        None => 0,
+    }
+}
+
+fn list_of(values: Vec<Value>) -> u64 {
+    let mut items = ListItems::Values(Vec::with_capacity(values.len()));
+    for value in values {
+        items.push(value);
+    }
+    LISTS.insert(List { items })
+}
+
+/// Decode every document of NDJSON text into one list; 0 if any is invalid
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_std_json_parse_lines(json_str: *const c_char) -> u64 {
+    read_c_str(json_str)
+        .and_then(|text| json_decode::decode_sequence(text).ok())
+        .map_or(0, list_of)
+}
+
+/// Encode a list or map handle as compact JSON
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_std_json_stringify(handle: u64) -> *mut c_char {
+    let value = if MAPS.contains(handle) {
+        Value::Map(handle)
+    } else if LISTS.contains(handle) {
+        Value::List(handle)
+    } else {
+        Value::Unit
+    };
+    json_encode::encode(&value, false).map_or(std::ptr::null_mut(), into_c_string)
+}
+
+fn open_stream(path: *const c_char) -> Option<JsonStream> {
+    let file = File::open(read_c_str(path)?).ok()?;
+    Some(JsonStream::new(file))
+}
+
+/// Read every value of an NDJSON file, or the elements of a file holding
+/// one array, into a list. Reading stops at the first invalid value.
+///
+/// The whole file is decoded before the list is returned; `json.stream`
+/// yields the same values one at a time.
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_std_json_read_all(path: *const c_char) -> u64 {
+    let Some(mut stream) = open_stream(path) else {
+        return 0;
+    };
+    let mut values = Vec::new();
+    while let Ok(Some(value)) = stream.next_value() {
+        values.push(value);
+    }
+    list_of(values)
+}
+
+// ============================================================================
+// Streaming Reads
+// ============================================================================
+
+/// A file opened with `json.stream`: the values `json.read_all` would return,
+/// decoded one at a time as the program asks for them
+struct ValueStream {
+    stream: JsonStream,
+    next: Option<Value>,
+    done: bool,
+}
+
+impl ValueStream {
+    /// Decode the next value unless one is already waiting. Like
+    /// `json.read_all`, the first invalid value ends the stream.
+    fn fill(&mut self) -> bool {
+        if self.next.is_none() && !self.done {
+            match self.stream.next_value() {
+                Ok(Some(value)) => self.next = Some(value),
+                Ok(None) | Err(_) => self.done = true,
+            }
+        }
+        self.next.is_some()
+    }
+}
+
+static VALUE_STREAMS: Lazy<HandleTable<ValueStream>> =
+    Lazy::new(|| HandleTable::new(JSON_STREAM_TABLE));
+
+/// Open `path` for `json.stream.next`, or 0 if it cannot be read
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_std_json_stream(path: *const c_char) -> u64 {
+    open_stream(path).map_or(0, |stream| {
+        VALUE_STREAMS.insert(ValueStream {
+            stream,
+            next: None,
+            done: false,
+        })
+    })
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_std_json_stream_has_next(stream: u64) -> bool {
+    VALUE_STREAMS
+        .with_mut(stream, ValueStream::fill)
         .unwrap_or(false)
 }
 
+/// The next value as a list element would hold it, or 0 at the end
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_std_json_stream_next(stream: u64) -> u64 {
+    VALUE_STREAMS
+        .with_mut(stream, |stream| {
+            stream.fill();
+            stream
+                .next
+                .take()
+                .map_or(0, |value| encode_runtime_value(&value))
+        })
+        .unwrap_or(0)
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_std_json_stream_close(stream: u64) {
+    if let Some(ValueStream {
+        next: Some(value), ..
+    }) = VALUE_STREAMS.remove(stream)
+    {
+        json_decode::release(value);
+    }
+}
+
 fn register_std_json_symbols(registry: &SymbolRegistry) {
     registry.register(FfiFunction {
         name: "std.json.encode".into(),
@@ -83,6 +231,60 @@ fn register_std_json_symbols(registry: &SymbolRegistry) {
         symbol: "otter_std_json_validate".into(),
         signature: FfiSignature::new(vec![FfiType::Str], FfiType::Bool),
     });
+
+    registry.register(FfiFunction {
+        name: "json.parse".into(),
+        symbol: "otter_std_json_parse".into(),
+        signature: FfiSignature::new(vec![FfiType::Str], FfiType::Map),
+    });
+
+    registry.register(FfiFunction {
+        name: "json.parse_list".into(),
+        symbol: "otter_std_json_parse_list".into(),
+        signature: FfiSignature::new(vec![FfiType::Str], FfiType::List),
+    });
+
+    registry.register(FfiFunction {
+        name: "json.parse_lines".into(),
+        symbol: "otter_std_json_parse_lines".into(),
+        signature: FfiSignature::new(vec![FfiType::Str], FfiType::List),
+    });
+
+    registry.register(FfiFunction {
+        name: "json.stringify".into(),
+        symbol: "otter_std_json_stringify".into(),
+        signature: FfiSignature::new(vec![FfiType::Opaque], FfiType::Str),
+    });
+
+    registry.register(FfiFunction {
+        name: "json.read_all".into(),
+        symbol: "otter_std_json_read_all".into(),
+        signature: FfiSignature::new(vec![FfiType::Str], FfiType::List),
+    });
+
+    registry.register(FfiFunction {
+        name: "json.stream".into(),
+        symbol: "otter_std_json_stream".into(),
+        signature: FfiSignature::new(vec![FfiType::Str], FfiType::Opaque),
+    });
+
+    registry.register(FfiFunction {
+        name: "json.stream.has_next".into(),
+        symbol: "otter_std_json_stream_has_next".into(),
+        signature: FfiSignature::new(vec![FfiType::Opaque], FfiType::Bool),
+    });
+
+    registry.register(FfiFunction {
+        name: "json.stream.next".into(),
+        symbol: "otter_std_json_stream_next".into(),
+        signature: FfiSignature::new(vec![FfiType::Opaque], FfiType::Opaque),
+    });
+
+    registry.register(FfiFunction {
+        name: "json.stream.close".into(),
+        symbol: "otter_std_json_stream_close".into(),
+        signature: FfiSignature::new(vec![FfiType::Opaque], FfiType::Unit),
+    });
 }
 
 inventory::submit! {
@@ -92,3 +294,105 @@ inventory::submit! {
         register: register_std_json_symbols,
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::stdlib::builtins::{
+        ValueKind, decode_value_handle, decode_value_kind, otter_decode_value_as_i64,
+    };
+
+    fn c(text: &str) -> CString {
+        CString::new(text).unwrap()
+    }
+
+    fn take(ptr: *mut c_char) -> String {
+        assert!(!ptr.is_null());
+        unsafe { CString::from_raw(ptr) }.into_string().unwrap()
+    }
+
+    #[test]
+    fn test_parse_and_stringify_round_trip() {
+        let map = otter_std_json_parse(c(r#"{"scores": [1, 2, 3]}"#).as_ptr());
+        assert!(MAPS.contains(map));
+        assert_eq!(take(otter_std_json_stringify(map)), r#"{"scores":[1,2,3]}"#);
+        json_decode::release(Value::Map(map));
+
+        // The wrong top-level kind is 0 and leaves nothing behind.
+        assert_eq!(otter_std_json_parse(c("[{}]").as_ptr()), 0);
+        assert_eq!(otter_std_json_parse_list(c("{}").as_ptr()), 0);
+        assert_eq!(otter_std_json_parse(c("{").as_ptr()), 0);
+
+        let lines = otter_std_json_parse_lines(c("1\n{\"a\":true}\n\n[]").as_ptr());
+        assert_eq!(
+            take(otter_std_json_stringify(lines)),
+            r#"[1,{"a":true},[]]"#
+        );
+        json_decode::release(Value::List(lines));
+    }
+
+    #[test]
+    fn test_std_json_functions_keep_their_contracts() {
+        assert_eq!(
+            take(otter_std_json_decode(
+                c(" { \"a\" : [ 1 , 2.5 ] } ").as_ptr()
+            )),
+            r#"{"a":[1,2.5]}"#
+        );
+        assert_eq!(
+            take(otter_std_json_pretty(c("[1,{}]").as_ptr())),
+            "[\n  1,\n  {}\n]"
+        );
+        assert!(otter_std_json_encode(c("{oops}").as_ptr()).is_null());
+        assert!(otter_std_json_validate(c("[true, null]").as_ptr()));
+        assert!(!otter_std_json_validate(c("[true,]").as_ptr()));
+        assert!(!otter_std_json_validate(std::ptr::null()));
+    }
+
+    #[test]
+    fn test_stream_yields_the_values_read_all_returns() {
+        let path =
+            std::env::temp_dir().join(format!("otter_json_stream_{}.ndjson", std::process::id()));
+        std::fs::write(&path, "{\"id\":1}\n[2]\n3\n{\"id\":4}\n{oops}\n5\n").unwrap();
+        let c_path = c(path.to_str().unwrap());
+
+        let all = otter_std_json_read_all(c_path.as_ptr());
+        let expected = r#"[{"id":1},[2],3,{"id":4}]"#;
+        assert_eq!(take(otter_std_json_stringify(all)), expected);
+        json_decode::release(Value::List(all));
+
+        let stream = otter_std_json_stream(c_path.as_ptr());
+        let mut streamed = Vec::new();
+        while otter_std_json_stream_has_next(stream) {
+            let encoded = otter_std_json_stream_next(stream);
+            let handle = decode_value_handle(encoded);
+            streamed.push(match decode_value_kind(encoded) {
+                ValueKind::Map => {
+                    let text = take(otter_std_json_stringify(handle));
+                    json_decode::release(Value::Map(handle));
+                    text
+                }
+                ValueKind::List => {
+                    let text = take(otter_std_json_stringify(handle));
+                    json_decode::release(Value::List(handle));
+                    text
+                }
+                ValueKind::I64 => otter_decode_value_as_i64(encoded).to_string(),
+                _ => panic!("unexpected value {encoded:#x}"),
+            });
+        }
+        assert_eq!(otter_std_json_stream_next(stream), 0);
+        otter_std_json_stream_close(stream);
+        assert_eq!(streamed, [r#"{"id":1}"#, "[2]", "3", r#"{"id":4}"#]);
+
+        // Closing a stream with a decoded value still pending releases it.
+        let stream = otter_std_json_stream(c_path.as_ptr());
+        assert!(otter_std_json_stream_has_next(stream));
+        otter_std_json_stream_close(stream);
+        assert!(!otter_std_json_stream_has_next(stream));
+
+        std::fs::remove_file(&path).unwrap();
+        assert_eq!(otter_std_json_read_all(c_path.as_ptr()), 0);
+        assert_eq!(otter_std_json_stream(c_path.as_ptr()), 0);
+    }
+}
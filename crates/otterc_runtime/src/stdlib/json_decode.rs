@@ -0,0 +1,887 @@
+//! JSON decoder that builds runtime lists and maps directly
+//!
+//! Text is parsed once, and objects and arrays go straight into the
+//! `MAPS` and `LISTS` handle tables, with no intermediate tree. Arrays use
+//! the typed list backings, so an array of numbers decodes into one unboxed
+//! buffer. String bodies are scanned eight bytes at a time for the bytes
+//! that end a run (quote, backslash, control character). A string without
+//! escapes is copied in one piece.
+//!
+//! [`JsonStream`] reads a sequence of documents (NDJSON, or values that are
+//! simply concatenated), or the elements of one top-level array, from a
+//! reader. It holds one value's text at a time. A structural scan finds
+//! where each value ends, and that state survives buffer refills, so a
+//! large value is scanned once however many reads it spans.
+
+use std::borrow::Cow;
+use std::io::{self, Read};
+
+use crate::stdlib::builtins::{LISTS, List, ListItems, MAPS, Map, Value};
+use crate::stdlib::key_map::KeyMap;
+
+/// Nesting deeper than this is rejected rather than risking the stack
+const MAX_DEPTH: usize = 128;
+
+/// Initial size of a stream's read buffer
+const READ_BUFFER: usize = 64 << 10;
+
+#[derive(Debug, Clone, PartialEq)]
+pub struct DecodeError {
+    /// Byte offset of the error in the decoded text
+    pub offset: usize,
+    pub message: &'static str,
+}
+
+/// Decode one JSON document. Lists and maps in the result are owned by the
+/// caller; [`release`] frees them.
+pub fn decode(text: &str) -> Result<Value, DecodeError> {
+    let mut decoder = Decoder::new(text, true);
+    let value = decoder.document()?;
+    Ok(value)
+}
+
+/// Check that `text` is one well-formed JSON document without building it
+pub fn validate(text: &str) -> Result<(), DecodeError> {
+    Decoder::new(text, false).document().map(drop)
+}
+
+/// Decode every document in `text`, such as the lines of an NDJSON file
+pub fn decode_sequence(text: &str) -> Result<Vec<Value>, DecodeError> {
+    let mut decoder = Decoder::new(text, true);
+    let mut values = Vec::new();
+    loop {
+        decoder.skip_whitespace();
+        if decoder.at_end() {
+            return Ok(values);
+        }
+        match decoder.value(0) {
+            Ok(value) => values.push(value),
+            Err(err) => {
+                values.into_iter().for_each(release);
+                return Err(err);
+            }
+        }
+    }
+}
+
+/// Free the lists and maps of a decoded value, including nested ones
+pub fn release(value: Value) {
+    match value {
+        Value::List(handle) => {
+            if let Some(List {
+                items: ListItems::Values(items),
+            }) = LISTS.remove(handle)
+            {
+                items.into_iter().for_each(release);
+            }
+        }
+        Value::Map(handle) => {
+            if let Some(map) = MAPS.remove(handle) {
+                for (_, value) in map.items.iter() {
+                    if matches!(value, Value::List(_) | Value::Map(_)) {
+                        release(value.clone());
+                    }
+                }
+            }
+        }
+        _ => {}
+    }
+}
+
+struct Decoder<'a> {
+    text: &'a str,
+    bytes: &'a [u8],
+    pos: usize,
+    /// Without `build`, values are checked but not materialised.
+    build: bool,
+}
+
+impl<'a> Decoder<'a> {
+    fn new(text: &'a str, build: bool) -> Self {
+        Self {
+            text,
+            bytes: text.as_bytes(),
+            pos: 0,
+            build,
+        }
+    }
+
+    fn error<T>(&self, message: &'static str) -> Result<T, DecodeError> {
+        Err(DecodeError {
+            offset: self.pos,
+            message,
+        })
+    }
+
+    fn at_end(&self) -> bool {
+        self.pos == self.bytes.len()
+    }
+
+    fn peek(&self) -> Option<u8> {
+        self.bytes.get(self.pos).copied()
+    }
+
+    fn skip_whitespace(&mut self) {
+        while let Some(b' ' | b'\t' | b'\n' | b'\r') = self.peek() {
+            self.pos += 1;
+        }
+    }
+
+    fn expect(&mut self, byte: u8, message: &'static str) -> Result<(), DecodeError> {
+        self.skip_whitespace();
+        if self.peek() != Some(byte) {
+            return self.error(message);
+        }
+        self.pos += 1;
+        Ok(())
+    }
+
+    /// One value with nothing but whitespace around it
+    fn document(&mut self) -> Result<Value, DecodeError> {
+        let value = self.value(0)?;
+        self.skip_whitespace();
+        if !self.at_end() {
+            release(value);
+            return self.error("trailing characters");
+        }
+        Ok(value)
+    }
+
+    fn value(&mut self, depth: usize) -> Result<Value, DecodeError> {
+        self.skip_whitespace();
+        match self.peek() {
+            Some(b'{') => self.object(depth + 1),
+            Some(b'[') => self.array(depth + 1),
+            Some(b'"') => {
+                let text = self.string()?;
+                Ok(if self.build {
+                    Value::String(text.into_owned())
+                } else {
+                    Value::Unit
+                })
+            }
+            Some(b't') => self.literal("true", Value::Bool(true)),
+            Some(b'f') => self.literal("false", Value::Bool(false)),
+            Some(b'n') => self.literal("null", Value::Unit),
+            Some(b'-' | b'0'..=b'9') => self.number(),
+            Some(_) => self.error("expected a value"),
+            None => self.error("unexpected end of input"),
+        }
+    }
+
+    fn literal(&mut self, word: &'static str, value: Value) -> Result<Value, DecodeError> {
+        if !self.bytes[self.pos..].starts_with(word.as_bytes()) {
+            return self.error("invalid literal");
+        }
+        self.pos += word.len();
+        Ok(value)
+    }
+
+    fn object(&mut self, depth: usize) -> Result<Value, DecodeError> {
+        if depth > MAX_DEPTH {
+            return self.error("nesting too deep");
+        }
+        self.pos += 1;
+        let mut items = KeyMap::new();
+        let result = self.object_items(depth, &mut items);
+        if !self.build {
+            return result.map(|()| Value::Unit);
+        }
+        match result {
+            Ok(()) => Ok(Value::Map(MAPS.insert(Map { items }))),
+            Err(err) => {
+                for (_, value) in items.iter() {
+                    release(value.clone());
+                }
+                Err(err)
+            }
+        }
+    }
+
+    fn object_items(&mut self, depth: usize, items: &mut KeyMap<Value>) -> Result<(), DecodeError> {
+        self.skip_whitespace();
+        if self.peek() == Some(b'}') {
+            self.pos += 1;
+            return Ok(());
+        }
+        loop {
+            self.skip_whitespace();
+            if self.peek() != Some(b'"') {
+                return self.error("expected a string key");
+            }
+            let key = self.string()?;
+            self.expect(b':', "expected ':'")?;
+            let value = self.value(depth)?;
+            if self.build {
+                // Later duplicates win, as in most decoders.
+                if let Some(replaced) = items.insert_key(key.as_bytes(), value) {
+                    release(replaced);
+                }
+            }
+            self.skip_whitespace();
+            match self.peek() {
+                Some(b',') => self.pos += 1,
+                Some(b'}') => {
+                    self.pos += 1;
+                    return Ok(());
+                }
+                _ => return self.error("expected ',' or '}'"),
+            }
+        }
+    }
+
+    fn array(&mut self, depth: usize) -> Result<Value, DecodeError> {
+        if depth > MAX_DEPTH {
+            return self.error("nesting too deep");
+        }
+        self.pos += 1;
+        let mut items = ListItems::Values(Vec::new());
+        let result = self.array_items(depth, &mut items);
+        if !self.build {
+            return result.map(|()| Value::Unit);
+        }
+        match result {
+            Ok(()) => Ok(Value::List(LISTS.insert(List { items }))),
+            Err(err) => {
+                if let ListItems::Values(items) = items {
+                    items.into_iter().for_each(release);
+                }
+                Err(err)
+            }
+        }
+    }
+
+    fn array_items(&mut self, depth: usize, items: &mut ListItems) -> Result<(), DecodeError> {
+        self.skip_whitespace();
+        if self.peek() == Some(b']') {
+            self.pos += 1;
+            return Ok(());
+        }
+        loop {
+            let value = self.value(depth)?;
+            if self.build {
+                items.push(value);
+            }
+            self.skip_whitespace();
+            match self.peek() {
+                Some(b',') => self.pos += 1,
+                Some(b']') => {
+                    self.pos += 1;
+                    return Ok(());
+                }
+                _ => return self.error("expected ',' or ']'"),
+            }
+        }
+    }
+
+    /// A string starting at the opening quote; borrowed from the input when
+    /// it has no escapes
+    fn string(&mut self) -> Result<Cow<'a, str>, DecodeError> {
+        self.pos += 1;
+        let mut owned: Option<String> = None;
+        let mut run_start = self.pos;
+        loop {
+            let Some(special) = find_string_special(&self.bytes[self.pos..]) else {
+                self.pos = self.bytes.len();
+                return self.error("unterminated string");
+            };
+            self.pos += special;
+            let run = &self.text[run_start..self.pos];
+            match self.bytes[self.pos] {
+                b'"' => {
+                    self.pos += 1;
+                    return Ok(match owned {
+                        Some(mut text) => {
+                            text.push_str(run);
+                            Cow::Owned(text)
+                        }
+                        None => Cow::Borrowed(run),
+                    });
+                }
+                b'\\' => {
+                    let text = owned.get_or_insert_with(String::new);
+                    text.push_str(run);
+                    self.pos += 1;
+                    let decoded = self.escape()?;
+                    text.push(decoded);
+                    run_start = self.pos;
+                }
+                _ => return self.error("control character in string"),
+            }
+        }
+    }
+
+    /// The character of an escape sequence, after its backslash
+    fn escape(&mut self) -> Result<char, DecodeError> {
+        let Some(byte) = self.peek() else {
+            return self.error("unterminated string");
+        };
+        self.pos += 1;
+        Ok(match byte {
+            b'"' => '"',
+            b'\\' => '\\',
+            b'/' => '/',
+            b'b' => '\u{8}',
+            b'f' => '\u{c}',
+            b'n' => '\n',
+            b'r' => '\r',
+            b't' => '\t',
+            b'u' => {
+                let unit = self.hex4()?;
+                let code = match unit {
+                    0xD800..=0xDBFF => {
+                        if !self.bytes[self.pos..].starts_with(b"\\u") {
+                            return self.error("unpaired surrogate");
+                        }
+                        self.pos += 2;
+                        let low = self.hex4()?;
+                        if !(0xDC00..=0xDFFF).contains(&low) {
+                            return self.error("unpaired surrogate");
+                        }
+                        0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00)
+                    }
+                    0xDC00..=0xDFFF => return self.error("unpaired surrogate"),
+                    unit => unit,
+                };
+                match char::from_u32(code) {
+                    Some(decoded) => decoded,
+                    None => return self.error("invalid escape"),
+                }
+            }
+            _ => {
+                self.pos -= 1;
+                return self.error("invalid escape");
+            }
+        })
+    }
+
+    fn hex4(&mut self) -> Result<u32, DecodeError> {
+        let Some(digits) = self.bytes.get(self.pos..self.pos + 4) else {
+            return self.error("invalid \\u escape");
+        };
+        let mut unit = 0;
+        for digit in digits {
+            let Some(nibble) = char::from(*digit).to_digit(16) else {
+                return self.error("invalid \\u escape");
+            };
+            unit = unit * 16 + nibble;
+        }
+        self.pos += 4;
+        Ok(unit)
+    }
+
+    /// Integers that fit are exact `I64`s; everything else is an `F64`.
+    fn number(&mut self) -> Result<Value, DecodeError> {
+        let start = self.pos;
+        let negative = self.peek() == Some(b'-');
+        if negative {
+            self.pos += 1;
+        }
+        let digits_start = self.pos;
+        let mut magnitude: u64 = 0;
+        let mut overflow = false;
+        while let Some(digit @ b'0'..=b'9') = self.peek() {
+            match magnitude
+                .checked_mul(10)
+                .and_then(|m| m.checked_add(u64::from(digit - b'0')))
+            {
+                Some(next) => magnitude = next,
+                None => overflow = true,
+            }
+            self.pos += 1;
+        }
+        let digits = self.pos - digits_start;
+        if digits == 0 {
+            return self.error("expected a digit");
+        }
+        if digits > 1 && self.bytes[digits_start] == b'0' {
+            self.pos = digits_start + 1;
+            return self.error("leading zero");
+        }
+
+        let mut integral = true;
+        if self.peek() == Some(b'.') {
+            integral = false;
+            self.pos += 1;
+            self.digits()?;
+        }
+        if let Some(b'e' | b'E') = self.peek() {
+            integral = false;
+            self.pos += 1;
+            if let Some(b'+' | b'-') = self.peek() {
+                self.pos += 1;
+            }
+            self.digits()?;
+        }
+
+        if integral && !overflow {
+            let value = if negative {
+                0i64.checked_sub_unsigned(magnitude)
+            } else {
+                i64::try_from(magnitude).ok()
+            };
+            if let Some(value) = value {
+                return Ok(Value::I64(value));
+            }
+        }
+        match self.text[start..self.pos].parse::<f64>() {
+            Ok(value) => Ok(Value::F64(value)),
+            Err(_) => self.error("invalid number"),
+        }
+    }
+
+    fn digits(&mut self) -> Result<(), DecodeError> {
+        let start = self.pos;
+        while let Some(b'0'..=b'9') = self.peek() {
+            self.pos += 1;
+        }
+        if self.pos == start {
+            return self.error("expected a digit");
+        }
+        Ok(())
+    }
+}
+
+const ONES: u64 = u64::from_ne_bytes([0x01; 8]);
+const HIGHS: u64 = u64::from_ne_bytes([0x80; 8]);
+
+/// Flags the bytes of `word` that are zero. Flags above a real zero can be
+/// spurious, so only the lowest flag is reliable.
+fn zero_bytes(word: u64) -> u64 {
+    word.wrapping_sub(ONES) & !word & HIGHS
+}
+
+/// Index of the first `"`, `\` or control character, testing a word of
+/// bytes at a time
+pub(crate) fn find_string_special(bytes: &[u8]) -> Option<usize> {
+    const QUOTES: u64 = u64::from_ne_bytes([b'"'; 8]);
+    const BACKSLASHES: u64 = u64::from_ne_bytes([b'\\'; 8]);
+    const SPACES: u64 = u64::from_ne_bytes([0x20; 8]);
+
+    let mut words = bytes.chunks_exact(8);
+    for (index, word) in (&mut words).enumerate() {
+        let mut buf = [0u8; 8];
+        buf.copy_from_slice(word);
+        let word = u64::from_le_bytes(buf);
+        // `word - 0x20` borrows exactly in the bytes below 0x20, like the
+        // zero test; each test's lowest flag is exact, so the lowest flag
+        // of all three is the first special byte.
+        let below_space = word.wrapping_sub(SPACES) & !word & HIGHS;
+        let found = zero_bytes(word ^ QUOTES) | zero_bytes(word ^ BACKSLASHES) | below_space;
+        if found != 0 {
+            return Some(index * 8 + found.trailing_zeros() as usize / 8);
+        }
+    }
+    let tail = words.remainder();
+    let tail_start = bytes.len() - tail.len();
+    tail.iter()
+        .position(|byte| matches!(byte, b'"' | b'\\' | 0..=0x1f))
+        .map(|offset| tail_start + offset)
+}
+
+/// Where the value at the start of a stream's window ends, tracked across
+/// refills
+#[derive(Default)]
+struct ValueScan {
+    /// Bytes of the value scanned so far
+    scanned: usize,
+    depth: usize,
+    in_string: bool,
+    /// The last byte scanned was a backslash inside a string.
+    escaped: bool,
+}
+
+impl ValueScan {
+    /// Length of the value at the start of `bytes`, or `None` if it may
+    /// continue past them. At end of input a scalar ends with the bytes.
+    fn resume(&mut self, bytes: &[u8], eof: bool) -> Option<usize> {
+        let scalar = !matches!(bytes.first(), Some(b'{' | b'[' | b'"'));
+        while self.scanned < bytes.len() {
+            if self.in_string {
+                if self.escaped {
+                    self.escaped = false;
+                    self.scanned += 1;
+                    continue;
+                }
+                let rest = &bytes[self.scanned..];
+                let Some(special) = find_string_special(rest) else {
+                    self.scanned = bytes.len();
+                    break;
+                };
+                self.scanned += special + 1;
+                match rest[special] {
+                    b'"' => {
+                        self.in_string = false;
+                        if self.depth == 0 {
+                            return Some(self.scanned);
+                        }
+                    }
+                    b'\\' => self.escaped = true,
+                    // Control characters are left for the decoder to reject.
+                    _ => {}
+                }
+                continue;
+            }
+            let byte = bytes[self.scanned];
+            if scalar {
+                if matches!(byte, b' ' | b'\t' | b'\n' | b'\r' | b',' | b']' | b'}') {
+                    return Some(self.scanned);
+                }
+                self.scanned += 1;
+                continue;
+            }
+            self.scanned += 1;
+            match byte {
+                b'"' => self.in_string = true,
+                b'{' | b'[' => self.depth += 1,
+                b'}' | b']' => {
+                    self.depth = self.depth.saturating_sub(1);
+                    if self.depth == 0 {
+                        return Some(self.scanned);
+                    }
+                }
+                _ => {}
+            }
+        }
+        (eof && scalar && !bytes.is_empty()).then_some(bytes.len())
+    }
+}
+
+#[derive(Clone, Copy, PartialEq)]
+enum StreamShape {
+    /// Nothing read yet
+    Unknown,
+    /// Whitespace-separated documents, as in NDJSON
+    Sequence,
+    /// Elements of one top-level array
+    Array,
+    Finished,
+}
+
+/// Reads JSON values one at a time; see the module docs
+pub struct JsonStream {
+    reader: Box<dyn Read + Send + Sync>,
+    buf: Vec<u8>,
+    start: usize,
+    end: usize,
+    eof: bool,
+    shape: StreamShape,
+    /// Offset of `buf[0]` in the whole input, for error offsets
+    consumed: usize,
+}
+
+impl JsonStream {
+    pub fn new(reader: impl Read + Send + Sync + 'static) -> Self {
+        Self::with_capacity(reader, READ_BUFFER)
+    }
+
+    fn with_capacity(reader: impl Read + Send + Sync + 'static, capacity: usize) -> Self {
+        Self {
+            reader: Box::new(reader),
+            buf: vec![0; capacity.max(1)],
+            start: 0,
+            end: 0,
+            eof: false,
+            shape: StreamShape::Unknown,
+            consumed: 0,
+        }
+    }
+
+    /// Read more input, making room first. Returns `false` at end of input.
+    fn fill(&mut self) -> io::Result<bool> {
+        if self.eof {
+            return Ok(false);
+        }
+        if self.start > 0 {
+            self.buf.copy_within(self.start..self.end, 0);
+            self.end -= self.start;
+            self.consumed += self.start;
+            self.start = 0;
+        }
+        if self.end == self.buf.len() {
+            self.buf.resize(self.buf.len() * 2, 0);
+        }
+        loop {
+            match self.reader.read(&mut self.buf[self.end..]) {
+                Ok(0) => {
+                    self.eof = true;
+                    return Ok(false);
+                }
+                Ok(read) => {
+                    self.end += read;
+                    return Ok(true);
+                }
+                Err(err) if err.kind() == io::ErrorKind::Interrupted => {}
+                Err(err) => return Err(err),
+            }
+        }
+    }
+
+    /// The next non-whitespace byte, reading more input as needed
+    fn next_byte(&mut self) -> Result<Option<u8>, DecodeError> {
+        loop {
+            while self.start < self.end {
+                match self.buf[self.start] {
+                    b' ' | b'\t' | b'\n' | b'\r' => self.start += 1,
+                    byte => return Ok(Some(byte)),
+                }
+            }
+            if !self.fill().map_err(|_| self.error("read failed"))? {
+                return Ok(None);
+            }
+        }
+    }
+
+    fn error(&self, message: &'static str) -> DecodeError {
+        DecodeError {
+            offset: self.consumed + self.start,
+            message,
+        }
+    }
+
+    /// The next value, `Ok(None)` at the end, or the first error. The
+    /// stream is finished after an error.
+    pub fn next_value(&mut self) -> Result<Option<Value>, DecodeError> {
+        let result = self.advance();
+        if !matches!(result, Ok(Some(_))) {
+            self.shape = StreamShape::Finished;
+        }
+        result
+    }
+
+    fn advance(&mut self) -> Result<Option<Value>, DecodeError> {
+        match self.shape {
+            StreamShape::Finished => return Ok(None),
+            StreamShape::Unknown => match self.next_byte()? {
+                None => return Ok(None),
+                Some(b'[') => {
+                    self.start += 1;
+                    self.shape = StreamShape::Array;
+                    if self.next_byte()? == Some(b']') {
+                        self.start += 1;
+                        return self.finish_array();
+                    }
+                }
+                Some(_) => self.shape = StreamShape::Sequence,
+            },
+            StreamShape::Sequence => {}
+            StreamShape::Array => match self.next_byte()? {
+                Some(b',') => self.start += 1,
+                Some(b']') => {
+                    self.start += 1;
+                    return self.finish_array();
+                }
+                _ => return Err(self.error("expected ',' or ']'")),
+            },
+        }
+
+        if self.next_byte()?.is_none() {
+            return match self.shape {
+                StreamShape::Array => Err(self.error("unexpected end of input")),
+                _ => Ok(None),
+            };
+        }
+        let mut scan = ValueScan::default();
+        let len = loop {
+            if let Some(len) = scan.resume(&self.buf[self.start..self.end], self.eof) {
+                break len;
+            }
+            if !self.fill().map_err(|_| self.error("read failed"))? && self.eof {
+                match scan.resume(&self.buf[self.start..self.end], true) {
+                    Some(len) => break len,
+                    None => return Err(self.error("unexpected end of input")),
+                }
+            }
+        };
+        let offset = self.consumed + self.start;
+        let text = std::str::from_utf8(&self.buf[self.start..self.start + len])
+            .map_err(|_| self.error("invalid UTF-8"))?;
+        let value = decode(text).map_err(|err| DecodeError {
+            offset: offset + err.offset,
+            ..err
+        })?;
+        self.start += len;
+        Ok(Some(value))
+    }
+
+    /// After the closing `]`, only whitespace may follow.
+    fn finish_array(&mut self) -> Result<Option<Value>, DecodeError> {
+        match self.next_byte()? {
+            None => Ok(None),
+            Some(_) => Err(self.error("trailing characters")),
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::stdlib::json_encode::encode;
+
+    fn round_trip(text: &str) -> String {
+        let value = decode(text).unwrap();
+        let encoded = encode(&value, false).unwrap();
+        release(value);
+        encoded
+    }
+
+    #[test]
+    fn test_decode_matches_serde_json() {
+        let documents = [
+            r#"{"name":"Otter","age":42,"tags":["a","b"],"ok":true,"none":null}"#,
+            r#"[1, -2, 3.5, 1e3, -0.0, 18446744073709551616, -9223372036854775808]"#,
+            r#""esc\"aped \\ \/ \b\f\n\r\t \u00e9 \ud83e\udda6""#,
+            r#"{"nested":{"deep":[[[]],{}]}, "unicode":"日本語"}"#,
+            "  [ ]  ",
+        ];
+        for text in documents {
+            let ours: serde_json::Value = serde_json::from_str(&round_trip(text)).unwrap();
+            let theirs: serde_json::Value = serde_json::from_str(text).unwrap();
+            assert_eq!(ours, theirs, "document {text}");
+        }
+        // Without floats the text matches too, keys in serde's order.
+        let theirs: serde_json::Value = serde_json::from_str(documents[0]).unwrap();
+        assert_eq!(
+            round_trip(documents[0]),
+            serde_json::to_string(&theirs).unwrap()
+        );
+    }
+
+    #[test]
+    fn test_rejects_malformed_documents() {
+        let documents = [
+            "",
+            "[1,]",
+            "{\"a\" 1}",
+            "{\"a\":1,}",
+            "01",
+            "1.",
+            "-",
+            "tru",
+            "\"\u{1}\"",
+            "\"\\x\"",
+            "\"\\ud800\"",
+            "[1] 2",
+            "{1:2}",
+            "\"open",
+        ];
+        for text in documents {
+            assert!(decode(text).is_err(), "accepted {text:?}");
+            assert!(validate(text).is_err(), "validated {text:?}");
+            assert!(serde_json::from_str::<serde_json::Value>(text).is_err());
+        }
+        let deep = "[".repeat(MAX_DEPTH + 1) + &"]".repeat(MAX_DEPTH + 1);
+        assert_eq!(decode(&deep).unwrap_err().message, "nesting too deep");
+    }
+
+    #[test]
+    fn test_numbers_keep_integers_exact() {
+        let value = decode("[9007199254740993, 2.5]").unwrap();
+        let Value::List(handle) = value else {
+            panic!("expected a list");
+        };
+        let items = LISTS.with(handle, |list| list.items.to_values()).unwrap();
+        assert!(matches!(items[0], Value::I64(9_007_199_254_740_993)));
+        assert!(matches!(items[1], Value::F64(2.5)));
+        release(value);
+        assert!(!LISTS.contains(handle));
+    }
+
+    #[test]
+    fn test_find_string_special_at_every_offset() {
+        for len in 0..24 {
+            // Neighbours of the special bytes catch borrows in the word test.
+            let filler: Vec<u8> = (0..len).map(|i| [b'#', b'!', b']', b' '][i % 4]).collect();
+            assert_eq!(find_string_special(&filler), None);
+            for at in 0..len {
+                for special in [b'"', b'\\', b'\n', 0x1f] {
+                    let mut bytes = filler.clone();
+                    bytes[at] = special;
+                    bytes[len - 1] = b'"';
+                    assert_eq!(find_string_special(&bytes), Some(at));
+                }
+            }
+        }
+    }
+
+    fn collect_stream(input: &'static str, capacity: usize) -> Result<Vec<String>, DecodeError> {
+        let mut stream = JsonStream::with_capacity(input.as_bytes(), capacity);
+        let mut values = Vec::new();
+        while let Some(value) = stream.next_value()? {
+            values.push(encode(&value, false).unwrap());
+            release(value);
+        }
+        Ok(values)
+    }
+
+    #[test]
+    fn test_stream_reads_sequences_and_arrays() {
+        let ndjson = "{\"id\":1,\"msg\":\"a \\\"quoted\\\" }\"}\n\n{\"id\":2}\r\n3\n\"s\"\ntrue";
+        let array = " [ {\"id\":1,\"msg\":\"a \\\"quoted\\\" }\"} , {\"id\":2},3,\"s\",true ] ";
+        let expected = [
+            "{\"id\":1,\"msg\":\"a \\\"quoted\\\" }\"}",
+            "{\"id\":2}",
+            "3",
+            "\"s\"",
+            "true",
+        ];
+        // Tiny buffers split values, strings and escapes across refills.
+        for capacity in [1, 2, 3, 7, 64] {
+            for input in [ndjson, array] {
+                let values = collect_stream(input, capacity).unwrap();
+                let values: Vec<serde_json::Value> = values
+                    .iter()
+                    .map(|v| serde_json::from_str(v).unwrap())
+                    .collect();
+                let expected: Vec<serde_json::Value> = expected
+                    .iter()
+                    .map(|v| serde_json::from_str(v).unwrap())
+                    .collect();
+                assert_eq!(values, expected, "capacity {capacity}, input {input:?}");
+            }
+        }
+        assert_eq!(collect_stream("[]", 1).unwrap(), Vec::<String>::new());
+        assert!(collect_stream("[1 2]", 4).is_err());
+        assert!(collect_stream("[1,", 4).is_err());
+        assert!(collect_stream("{\"a\":1}\n{\"b\":", 4).is_err());
+        assert_eq!(
+            collect_stream("{\"a\":1}\n{oops}", 4).unwrap_err().offset,
+            9
+        );
+    }
+
+    // Run with: cargo test -p otterc_runtime --release json_decode_benchmark -- --ignored --nocapture
+    #[test]
+    #[ignore]
+    fn json_decode_benchmark() {
+        const RECORDS: usize = 50_000;
+
+        let text = format!(
+            "[{}]",
+            (0..RECORDS)
+                .map(|i| {
+                    format!(
+                        r#"{{"id":{i},"name":"user {i}","score":{}.5,"tags":["a","b\n"],"active":true}}"#,
+                        i % 100
+                    )
+                })
+                .collect::<Vec<_>>()
+                .join(",")
+        );
+
+        crate::benchmark::Benchmark::new(format!("serde_json::Value over {RECORDS} records"))
+            .warmup(1)
+            .iterations(5)
+            .run_and_print(|| {
+                let value: serde_json::Value = serde_json::from_str(&text).unwrap();
+                assert_eq!(value.as_array().unwrap().len(), RECORDS);
+            });
+        crate::benchmark::Benchmark::new(format!("json_decode over {RECORDS} records"))
+            .warmup(1)
+            .iterations(5)
+            .run_and_print(|| {
+                let value = decode(&text).unwrap();
+                release(value);
+            });
+    }
+}
@@ -0,0 +1,264 @@
+//! JSON encoder over runtime values
+//!
+//! Lists and maps are written straight from their handle tables into one
+//! output string. Typed list backings are written without boxing each
+//! element. String runs that need no escaping are copied in one piece, and
+//! a word-at-a-time scan finds where each run ends.
+//!
+//! Object keys come out sorted by their bytes, the order serde_json's
+//! default map gives, so output does not depend on the table layout or the
+//! build's hash seed.
+//! Floats that are not finite have no JSON form and are written as `null`.
+
+use std::fmt::Write;
+
+use crate::stdlib::builtins::{LISTS, ListItems, MAPS, Value};
+use crate::stdlib::json_decode::find_string_special;
+
+/// Deeper nesting is reported as an error; a list or map that contains
+/// itself ends up here.
+const MAX_DEPTH: usize = 128;
+
+#[derive(Debug, Clone, PartialEq)]
+pub struct EncodeError {
+    pub message: &'static str,
+}
+
+/// Encode `value`; `pretty` indents nested values by two spaces
+pub fn encode(value: &Value, pretty: bool) -> Result<String, EncodeError> {
+    let mut encoder = Encoder {
+        out: String::new(),
+        pretty,
+    };
+    encoder.value(value, 0)?;
+    Ok(encoder.out)
+}
+
+struct Encoder {
+    out: String,
+    pretty: bool,
+}
+
+impl Encoder {
+    fn value(&mut self, value: &Value, depth: usize) -> Result<(), EncodeError> {
+        match value {
+            Value::Unit => self.out.push_str("null"),
+            Value::Bool(value) => self.bool(*value),
+            Value::I64(value) => self.int(*value),
+            Value::F64(value) => self.float(*value),
+            Value::String(value) => self.string(value),
+            Value::List(handle) => self.list(*handle, depth + 1)?,
+            Value::Map(handle) => self.map(*handle, depth + 1)?,
+        }
+        Ok(())
+    }
+
+    fn bool(&mut self, value: bool) {
+        self.out.push_str(if value { "true" } else { "false" });
+    }
+
+    fn int(&mut self, value: i64) {
+        let _ = write!(self.out, "{value}");
+    }
+
+    fn float(&mut self, value: f64) {
+        if value.is_finite() {
+            // `Debug` keeps the `.0` of integral floats, so they decode back
+            // as floats.
+            let _ = write!(self.out, "{value:?}");
+        } else {
+            self.out.push_str("null");
+        }
+    }
+
+    /// Start the next element of a list or map
+    fn separator(&mut self, first: bool, depth: usize) {
+        if !first {
+            self.out.push(',');
+        }
+        self.newline(depth);
+    }
+
+    fn newline(&mut self, depth: usize) {
+        if self.pretty {
+            self.out.push('\n');
+            for _ in 0..depth {
+                self.out.push_str("  ");
+            }
+        }
+    }
+
+    fn list(&mut self, handle: u64, depth: usize) -> Result<(), EncodeError> {
+        if depth > MAX_DEPTH {
+            return Err(EncodeError {
+                message: "nesting too deep",
+            });
+        }
+        let result = LISTS.with(handle, |list| {
+            self.out.push('[');
+            let len = list.items.len();
+            match &list.items {
+                ListItems::Values(items) => {
+                    for (index, item) in items.iter().enumerate() {
+                        self.separator(index == 0, depth);
+                        self.value(item, depth)?;
+                    }
+                }
+                ListItems::Int(items) => {
+                    for (index, item) in items.iter().enumerate() {
+                        self.separator(index == 0, depth);
+                        self.int(*item);
+                    }
+                }
+                ListItems::Float(items) => {
+                    for (index, item) in items.iter().enumerate() {
+                        self.separator(index == 0, depth);
+                        self.float(*item);
+                    }
+                }
+                ListItems::Bool(items) => {
+                    for (index, item) in items.iter().enumerate() {
+                        self.separator(index == 0, depth);
+                        self.bool(*item);
+                    }
+                }
+                ListItems::Str(items) => {
+                    for (index, item) in items.iter().enumerate() {
+                        self.separator(index == 0, depth);
+                        self.string(item);
+                    }
+                }
+            }
+            if len > 0 {
+                self.newline(depth - 1);
+            }
+            self.out.push(']');
+            Ok(())
+        });
+        // A stale handle has nothing to write.
+        result.unwrap_or_else(|| {
+            self.out.push_str("null");
+            Ok(())
+        })
+    }
+
+    fn map(&mut self, handle: u64, depth: usize) -> Result<(), EncodeError> {
+        if depth > MAX_DEPTH {
+            return Err(EncodeError {
+                message: "nesting too deep",
+            });
+        }
+        let result = MAPS.with(handle, |map| {
+            self.out.push('{');
+            let mut entries: Vec<(&[u8], &Value)> = map.items.iter().collect();
+            entries.sort_unstable_by_key(|(key, _)| *key);
+            for (index, (key, value)) in entries.into_iter().enumerate() {
+                self.separator(index == 0, depth);
+                self.string(&String::from_utf8_lossy(key));
+                self.out.push(':');
+                if self.pretty {
+                    self.out.push(' ');
+                }
+                self.value(value, depth)?;
+            }
+            if !map.items.is_empty() {
+                self.newline(depth - 1);
+            }
+            self.out.push('}');
+            Ok(())
+        });
+        result.unwrap_or_else(|| {
+            self.out.push_str("null");
+            Ok(())
+        })
+    }
+
+    fn string(&mut self, text: &str) {
+        self.out.reserve(text.len() + 2);
+        self.out.push('"');
+        let bytes = text.as_bytes();
+        let mut run_start = 0;
+        while let Some(offset) = find_string_special(&bytes[run_start..]) {
+            let at = run_start + offset;
+            self.out.push_str(&text[run_start..at]);
+            match bytes[at] {
+                b'"' => self.out.push_str("\\\""),
+                b'\\' => self.out.push_str("\\\\"),
+                b'\n' => self.out.push_str("\\n"),
+                b'\r' => self.out.push_str("\\r"),
+                b'\t' => self.out.push_str("\\t"),
+                byte => {
+                    let _ = write!(self.out, "\\u{byte:04x}");
+                }
+            }
+            run_start = at + 1;
+        }
+        self.out.push_str(&text[run_start..]);
+        self.out.push('"');
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::stdlib::builtins::{List, Map};
+    use crate::stdlib::key_map::KeyMap;
+
+    #[test]
+    fn test_encodes_typed_lists_and_maps() {
+        let ints = LISTS.insert(List {
+            items: ListItems::Int(vec![1, -2]),
+        });
+        let floats = LISTS.insert(List {
+            items: ListItems::Float(vec![1.0, 0.5, f64::NAN]),
+        });
+        let mut items = KeyMap::new();
+        items.insert_key(b"ints", Value::List(ints));
+        let map = MAPS.insert(Map { items });
+        let outer = LISTS.insert(List {
+            items: ListItems::Values(vec![
+                Value::Map(map),
+                Value::List(floats),
+                Value::String("tab\t \"q\" \u{1} é".into()),
+                Value::Unit,
+            ]),
+        });
+
+        assert_eq!(
+            encode(&Value::List(outer), false).unwrap(),
+            r#"[{"ints":[1,-2]},[1.0,0.5,null],"tab\t \"q\" \u0001 é",null]"#
+        );
+        assert_eq!(
+            encode(&Value::Map(map), true).unwrap(),
+            "{\n  \"ints\": [\n    1,\n    -2\n  ]\n}"
+        );
+        for handle in [ints, floats, outer] {
+            LISTS.remove(handle);
+        }
+        MAPS.remove(map);
+    }
+
+    #[test]
+    fn test_object_keys_are_sorted() {
+        let mut items = KeyMap::new();
+        for key in ["zeta", "alpha", "mid", "Alpha", "alpha2", ""] {
+            items.insert_key(key.as_bytes(), Value::Bool(true));
+        }
+        let map = MAPS.insert(Map { items });
+        assert_eq!(
+            encode(&Value::Map(map), false).unwrap(),
+            r#"{"":true,"Alpha":true,"alpha":true,"alpha2":true,"mid":true,"zeta":true}"#
+        );
+        MAPS.remove(map);
+    }
+
+    #[test]
+    fn test_self_containing_list_is_an_error() {
+        let list = LISTS.insert(List {
+            items: ListItems::Values(Vec::new()),
+        });
+        LISTS.with_mut(list, |items| items.items.push(Value::List(list)));
+        assert!(encode(&Value::List(list), false).is_err());
+        LISTS.remove(list);
+    }
+}
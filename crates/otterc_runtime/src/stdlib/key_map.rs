@@ -0,0 +1,207 @@
+//! Open-addressing map from byte-string keys, looked up by borrowed key
+//!
+//! Every entry stores its key's hash ([`hash_map_key`]), so probing
+//! compares hashes first and reads key bytes only on a hash match. Lookups
+//! take the key as `&[u8]` plus its hash, so a C string from compiled code
+//! is found without being copied. Callers holding a compile-time hash skip
+//! hashing too. A key is copied only when it is inserted for the first time.
+//!
+//! Linear probing over a power-of-two table. Removal leaves a tombstone.
+//! Once live entries and tombstones fill 7/8 of the table, it is rebuilt
+//! without tombstones, at a size that leaves it at most half full.
+
+use otterc_symbol::key_hash::hash_map_key;
+
+const MIN_CAPACITY: usize = 8;
+
+enum Slot<V> {
+    Empty,
+    Deleted,
+    Full { hash: u64, key: Box<[u8]>, value: V },
+}
+
+pub struct KeyMap<V> {
+    slots: Vec<Slot<V>>,
+    len: usize,
+    deleted: usize,
+}
+
+impl<V> Default for KeyMap<V> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl<V> KeyMap<V> {
+    pub const fn new() -> Self {
+        Self {
+            slots: Vec::new(),
+            len: 0,
+            deleted: 0,
+        }
+    }
+
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    /// Index of `key`'s slot, or `None` if it is absent
+    fn find(&self, hash: u64, key: &[u8]) -> Option<usize> {
+        if self.slots.is_empty() {
+            return None;
+        }
+        let mask = self.slots.len() - 1;
+        let mut index = hash as usize & mask;
+        loop {
+            match &self.slots[index] {
+                Slot::Empty => return None,
+                Slot::Full {
+                    hash: slot_hash,
+                    key: slot_key,
+                    ..
+                } if *slot_hash == hash && **slot_key == *key => return Some(index),
+                _ => index = (index + 1) & mask,
+            }
+        }
+    }
+
+    pub fn get(&self, hash: u64, key: &[u8]) -> Option<&V> {
+        match &self.slots[self.find(hash, key)?] {
+            Slot::Full { value, .. } => Some(value),
+            _ => None,
+        }
+    }
+
+    pub fn get_mut(&mut self, hash: u64, key: &[u8]) -> Option<&mut V> {
+        let index = self.find(hash, key)?;
+        match &mut self.slots[index] {
+            Slot::Full { value, .. } => Some(value),
+            _ => None,
+        }
+    }
+
+    /// Insert or replace, returning the previous value
+    pub fn insert(&mut self, hash: u64, key: &[u8], value: V) -> Option<V> {
+        if let Some(existing) = self.get_mut(hash, key) {
+            return Some(std::mem::replace(existing, value));
+        }
+        if (self.len + self.deleted + 1) * 8 > self.slots.len() * 7 {
+            self.rebuild();
+        }
+
+        let mask = self.slots.len() - 1;
+        let mut index = hash as usize & mask;
+        // `key` is absent, so the first free slot on its probe path is where
+        // it belongs; reusing a tombstone keeps chains short.
+        while let Slot::Full { .. } = self.slots[index] {
+            index = (index + 1) & mask;
+        }
+        if let Slot::Deleted = self.slots[index] {
+            self.deleted -= 1;
+        }
+        self.slots[index] = Slot::Full {
+            hash,
+            key: key.into(),
+            value,
+        };
+        self.len += 1;
+        None
+    }
+
+    pub fn remove(&mut self, hash: u64, key: &[u8]) -> Option<V> {
+        let index = self.find(hash, key)?;
+        match std::mem::replace(&mut self.slots[index], Slot::Deleted) {
+            Slot::Full { value, .. } => {
+                self.len -= 1;
+                self.deleted += 1;
+                Some(value)
+            }
+            _ => None,
+        }
+    }
+
+    /// Rehash into a table at most half full of live entries, dropping
+    /// tombstones
+    fn rebuild(&mut self) {
+        let capacity = ((self.len + 1) * 2).next_power_of_two().max(MIN_CAPACITY);
+        let old = std::mem::replace(
+            &mut self.slots,
+            std::iter::repeat_with(|| Slot::Empty)
+                .take(capacity)
+                .collect(),
+        );
+        self.deleted = 0;
+        let mask = capacity - 1;
+        for slot in old {
+            if let Slot::Full { hash, key, value } = slot {
+                let mut index = hash as usize & mask;
+                while let Slot::Full { .. } = self.slots[index] {
+                    index = (index + 1) & mask;
+                }
+                self.slots[index] = Slot::Full { hash, key, value };
+            }
+        }
+    }
+
+    /// Entries in table order
+    pub fn iter(&self) -> impl Iterator<Item = (&[u8], &V)> {
+        self.slots.iter().filter_map(|slot| match slot {
+            Slot::Full { key, value, .. } => Some((&**key, value)),
+            _ => None,
+        })
+    }
+
+    pub fn get_key(&self, key: &[u8]) -> Option<&V> {
+        self.get(hash_map_key(key), key)
+    }
+
+    pub fn insert_key(&mut self, key: &[u8], value: V) -> Option<V> {
+        self.insert(hash_map_key(key), key, value)
+    }
+
+    pub fn remove_key(&mut self, key: &[u8]) -> Option<V> {
+        self.remove(hash_map_key(key), key)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_matches_std_hash_map_under_churn() {
+        let mut map = KeyMap::new();
+        let mut reference = std::collections::HashMap::new();
+        for round in 0..20_000u32 {
+            let key = format!("key{}", round.wrapping_mul(2_654_435_761) % 997);
+            if round % 3 == 0 {
+                assert_eq!(map.remove_key(key.as_bytes()), reference.remove(&key));
+            } else {
+                assert_eq!(
+                    map.insert_key(key.as_bytes(), round),
+                    reference.insert(key, round)
+                );
+            }
+            assert_eq!(map.len(), reference.len());
+        }
+        for (key, value) in &reference {
+            assert_eq!(map.get_key(key.as_bytes()), Some(value));
+        }
+        assert_eq!(map.iter().count(), reference.len());
+        // Churn must not let tombstones grow the table without bound.
+        assert!(map.slots.len() <= 4096);
+    }
+
+    #[test]
+    fn test_prehashed_lookup_matches_key_lookup() {
+        let mut map = KeyMap::new();
+        map.insert_key(b"host", 1);
+        assert_eq!(map.get(hash_map_key(b"host"), b"host"), Some(&1));
+        assert_eq!(map.get(hash_map_key(b"port"), b"port"), None);
+        assert_eq!(map.get_key(b""), None);
+    }
+}
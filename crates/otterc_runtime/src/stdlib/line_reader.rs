@@ -0,0 +1,350 @@
+//! Streaming line reader over files and pipes
+//!
+//! Regular files are mapped read-only and each line is handed out as a
+//! slice of the mapping, with no copy. Pages behind the cursor are released
+//! as reading advances, so resident memory stays bounded on multi-gigabyte
+//! files. Anything that cannot be mapped (pipes, empty files, non-Unix
+//! targets) is read through one refillable buffer, and lines are sliced out
+//! of that buffer; it only grows to hold the longest line.
+//!
+//! Lines split on `\n`, and a trailing `\r` is dropped, as in
+//! [`std::io::BufRead::lines`]. A mapped file that another process truncates
+//! while it is being read raises `SIGBUS`, as with any mapping.
+
+use std::fs::File;
+use std::io::{self, Read};
+use std::path::Path;
+
+/// Initial size of the read buffer for unmapped input
+const READ_BUFFER: usize = 1 << 20;
+
+/// Consumed bytes of a mapping are released in steps of this size
+#[cfg(unix)]
+const RELEASE_STEP: usize = 64 << 20;
+
+pub struct LineReader {
+    source: Source,
+}
+
+enum Source {
+    #[cfg(unix)]
+    Mapped {
+        map: Mapping,
+        offset: usize,
+        released: usize,
+    },
+    Buffered {
+        reader: Box<dyn Read + Send + Sync>,
+        buf: Vec<u8>,
+        start: usize,
+        end: usize,
+        eof: bool,
+    },
+}
+
+impl LineReader {
+    pub fn open(path: impl AsRef<Path>) -> io::Result<Self> {
+        let file = File::open(path)?;
+        #[cfg(unix)]
+        {
+            let metadata = file.metadata()?;
+            if metadata.is_file()
+                && metadata.len() > 0
+                && let Some(map) = Mapping::new(&file, metadata.len())
+            {
+                return Ok(Self {
+                    source: Source::Mapped {
+                        map,
+                        offset: 0,
+                        released: 0,
+                    },
+                });
+            }
+        }
+        Ok(Self::from_reader(file))
+    }
+
+    pub fn from_reader(reader: impl Read + Send + Sync + 'static) -> Self {
+        Self::with_capacity(reader, READ_BUFFER)
+    }
+
+    fn with_capacity(reader: impl Read + Send + Sync + 'static, capacity: usize) -> Self {
+        Self {
+            source: Source::Buffered {
+                reader: Box::new(reader),
+                buf: vec![0; capacity.max(1)],
+                start: 0,
+                end: 0,
+                eof: false,
+            },
+        }
+    }
+
+    /// The next line without its terminator, or `None` at end of input
+    ///
+    /// The slice borrows the reader's mapping or buffer and is valid until
+    /// the next call.
+    pub fn next_line(&mut self) -> io::Result<Option<&[u8]>> {
+        let line = match &mut self.source {
+            #[cfg(unix)]
+            Source::Mapped {
+                map,
+                offset,
+                released,
+            } => {
+                // Nothing before `offset` is borrowed any more.
+                if *offset - *released >= RELEASE_STEP {
+                    *released = map.release_before(*offset);
+                }
+                let rest = &map.bytes()[*offset..];
+                if rest.is_empty() {
+                    return Ok(None);
+                }
+                let (line, consumed) = match find_newline(rest) {
+                    Some(newline) => (&rest[..newline], newline + 1),
+                    None => (rest, rest.len()),
+                };
+                *offset += consumed;
+                line
+            }
+            Source::Buffered {
+                reader,
+                buf,
+                start,
+                end,
+                eof,
+            } => {
+                let mut scanned = 0;
+                let newline = loop {
+                    if let Some(newline) = find_newline(&buf[*start + scanned..*end]) {
+                        break Some(*start + scanned + newline);
+                    }
+                    scanned = *end - *start;
+                    if *eof {
+                        break None;
+                    }
+                    // Make room for more input: drop what was consumed, and
+                    // grow only if the partial line fills the whole buffer.
+                    if *start > 0 {
+                        buf.copy_within(*start..*end, 0);
+                        *end -= *start;
+                        *start = 0;
+                    }
+                    if *end == buf.len() {
+                        buf.resize(buf.len() * 2, 0);
+                    }
+                    match reader.read(&mut buf[*end..]) {
+                        Ok(0) => *eof = true,
+                        Ok(read) => *end += read,
+                        Err(err) if err.kind() == io::ErrorKind::Interrupted => {}
+                        Err(err) => return Err(err),
+                    }
+                };
+                let line_start = *start;
+                match newline {
+                    Some(newline) => {
+                        *start = newline + 1;
+                        &buf[line_start..newline]
+                    }
+                    None if line_start == *end => return Ok(None),
+                    None => {
+                        *start = *end;
+                        &buf[line_start..*end]
+                    }
+                }
+            }
+        };
+        Ok(Some(line.strip_suffix(b"\r").unwrap_or(line)))
+    }
+}
+
+/// Index of the first `\n`, testing a word of bytes at a time
+fn find_newline(bytes: &[u8]) -> Option<usize> {
+    const ONES: u64 = u64::from_ne_bytes([0x01; 8]);
+    const HIGHS: u64 = u64::from_ne_bytes([0x80; 8]);
+    const NEWLINES: u64 = u64::from_ne_bytes([b'\n'; 8]);
+
+    let mut words = bytes.chunks_exact(8);
+    for (index, word) in (&mut words).enumerate() {
+        let mut buf = [0u8; 8];
+        buf.copy_from_slice(word);
+        // Bytes equal to `\n` become zero, and the classic zero-byte test
+        // flags them. Flags above a real zero can be spurious, so the lowest
+        // flag is always the first newline.
+        let diff = u64::from_le_bytes(buf) ^ NEWLINES;
+        let found = diff.wrapping_sub(ONES) & !diff & HIGHS;
+        if found != 0 {
+            return Some(index * 8 + found.trailing_zeros() as usize / 8);
+        }
+    }
+    let tail = words.remainder();
+    let tail_start = bytes.len() - tail.len();
+    tail.iter()
+        .position(|byte| *byte == b'\n')
+        .map(|offset| tail_start + offset)
+}
+
+/// Read-only private mapping of a whole file
+#[cfg(unix)]
+struct Mapping {
+    ptr: *mut libc::c_void,
+    len: usize,
+    page_size: usize,
+}
+
+// SAFETY: the mapping is read-only and owned by this value.
+#[cfg(unix)]
+unsafe impl Send for Mapping {}
+#[cfg(unix)]
+unsafe impl Sync for Mapping {}
+
+#[cfg(unix)]
+impl Mapping {
+    fn new(file: &File, len: u64) -> Option<Self> {
+        use std::os::unix::io::AsRawFd;
+
+        let len = usize::try_from(len).ok()?;
+        // SAFETY: maps a file we hold open; failure is reported as MAP_FAILED.
+        let ptr = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                len,
+                libc::PROT_READ,
+                libc::MAP_PRIVATE,
+                file.as_raw_fd(),
+                0,
+            )
+        };
+        if ptr == libc::MAP_FAILED {
+            return None;
+        }
+        // SAFETY: `ptr` and `len` describe the mapping just created. The
+        // advice is only a hint, so its result is ignored.
+        unsafe { libc::madvise(ptr, len, libc::MADV_SEQUENTIAL) };
+        let page_size =
+            usize::try_from(unsafe { libc::sysconf(libc::_SC_PAGESIZE) }).unwrap_or(4096);
+        Some(Self {
+            ptr,
+            len,
+            page_size,
+        })
+    }
+
+    fn bytes(&self) -> &[u8] {
+        // SAFETY: the mapping covers `len` readable bytes while `self` lives.
+        unsafe { std::slice::from_raw_parts(self.ptr.cast::<u8>(), self.len) }
+    }
+
+    /// Drop the resident pages wholly before `offset` and return how far
+    /// was released. The bytes stay mapped and read back from the file if
+    /// touched again.
+    fn release_before(&self, offset: usize) -> usize {
+        let end = offset - offset % self.page_size;
+        // SAFETY: `[ptr, ptr + end)` lies inside the mapping, and dropping
+        // pages of a private read-only file mapping loses no data.
+        unsafe { libc::madvise(self.ptr, end, libc::MADV_DONTNEED) };
+        end
+    }
+}
+
+#[cfg(unix)]
+impl Drop for Mapping {
+    fn drop(&mut self) {
+        // SAFETY: unmaps the mapping created in `new`, which nothing borrows
+        // once `self` is dropped.
+        unsafe { libc::munmap(self.ptr, self.len) };
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn collect(mut reader: LineReader) -> Vec<String> {
+        let mut lines = Vec::new();
+        while let Some(line) = reader.next_line().unwrap() {
+            lines.push(String::from_utf8(line.to_vec()).unwrap());
+        }
+        lines
+    }
+
+    #[test]
+    fn test_lines_match_bufread_lines() {
+        use std::io::BufRead;
+
+        let inputs: [&[u8]; 6] = [
+            b"",
+            b"\n",
+            b"one",
+            b"one\r\ntwo\n\nthree",
+            b"a\nbb\nccc\n",
+            b"long line that is wider than the buffer\nx\n",
+        ];
+        for input in inputs {
+            let expected: Vec<String> = input.lines().map(Result::unwrap).collect();
+            // A 4-byte buffer forces refills, compaction and growth mid-line.
+            let reader = LineReader::with_capacity(input, 4);
+            assert_eq!(collect(reader), expected, "input {input:?}");
+            assert_eq!(collect(LineReader::from_reader(input)), expected);
+        }
+    }
+
+    #[test]
+    fn test_find_newline_at_every_offset() {
+        for len in 0..24 {
+            // 0x0b sits next to `\n`, so a borrow in the word test would
+            // show up as a wrong match.
+            let filler = vec![0x0b; len];
+            assert_eq!(find_newline(&filler), None);
+            for at in 0..len {
+                let mut bytes = filler.clone();
+                bytes[at] = b'\n';
+                bytes[len - 1] = b'\n';
+                assert_eq!(find_newline(&bytes), Some(at));
+            }
+        }
+    }
+
+    #[test]
+    fn test_mapped_file_matches_buffered_read() {
+        let path = std::env::temp_dir().join(format!("otter_lines_{}.txt", std::process::id()));
+        let text: String = (0..10_000).map(|i| format!("line {i}\r\n")).collect();
+        std::fs::write(&path, format!("{text}tail")).unwrap();
+
+        let mapped = collect(LineReader::open(&path).unwrap());
+        let buffered = collect(LineReader::from_reader(File::open(&path).unwrap()));
+        std::fs::remove_file(&path).unwrap();
+
+        assert_eq!(mapped.len(), 10_001);
+        assert_eq!(mapped[9_999], "line 9999");
+        assert_eq!(mapped[10_000], "tail");
+        assert_eq!(mapped, buffered);
+    }
+
+    // Run with: cargo test -p otterc_runtime --release line_reader_benchmark -- --ignored --nocapture
+    #[test]
+    #[ignore]
+    fn line_reader_benchmark() {
+        const LINES: usize = 2_000_000;
+
+        let path =
+            std::env::temp_dir().join(format!("otter_lines_bench_{}.txt", std::process::id()));
+        let text: String = (0..LINES)
+            .map(|i| format!("2024-01-01T00:00:00Z INFO request {i} served\n"))
+            .collect();
+        std::fs::write(&path, text).unwrap();
+
+        crate::benchmark::Benchmark::new(format!("LineReader over {LINES} lines"))
+            .warmup(1)
+            .iterations(5)
+            .run_and_print(|| {
+                let mut reader = LineReader::open(&path).unwrap();
+                let mut count = 0;
+                while reader.next_line().unwrap().is_some() {
+                    count += 1;
+                }
+                assert_eq!(count, LINES);
+            });
+        std::fs::remove_file(&path).unwrap();
+    }
+}
@@ -0,0 +1,188 @@
+//! Bulk kernels over the contiguous buffers of typed lists
+//!
+//! Reductions keep `LANES` independent accumulators and walk the input in
+//! `chunks_exact(LANES)`, a shape LLVM turns into SIMD code on every target
+//! without per-architecture intrinsics. Float sums and dot products add in
+//! lane order rather than strictly left to right, so results can differ from
+//! a sequential loop in the last bits.
+
+const LANES: usize = 8;
+
+/// Wrapping sum, like repeated `+` on the language's ints.
+pub fn sum_i64(values: &[i64]) -> i64 {
+    let mut lanes = [0i64; LANES];
+    let chunks = values.chunks_exact(LANES);
+    let tail = chunks.remainder();
+    for chunk in chunks {
+        for (lane, value) in lanes.iter_mut().zip(chunk) {
+            *lane = lane.wrapping_add(*value);
+        }
+    }
+    lanes
+        .iter()
+        .chain(tail)
+        .fold(0, |sum, value| sum.wrapping_add(*value))
+}
+
+pub fn sum_f64(values: &[f64]) -> f64 {
+    let mut lanes = [0.0f64; LANES];
+    let chunks = values.chunks_exact(LANES);
+    let tail = chunks.remainder();
+    for chunk in chunks {
+        for (lane, value) in lanes.iter_mut().zip(chunk) {
+            *lane += *value;
+        }
+    }
+    lanes.iter().sum::<f64>() + tail.iter().sum::<f64>()
+}
+
+fn reduce_lanes<T: Copy>(values: &[T], pick: impl Fn(T, T) -> T) -> Option<T> {
+    let first = *values.first()?;
+    let mut lanes = [first; LANES];
+    let chunks = values.chunks_exact(LANES);
+    let tail = chunks.remainder();
+    for chunk in chunks {
+        for (lane, value) in lanes.iter_mut().zip(chunk) {
+            *lane = pick(*lane, *value);
+        }
+    }
+    Some(
+        lanes
+            .into_iter()
+            .chain(tail.iter().copied())
+            .fold(first, pick),
+    )
+}
+
+pub fn min_i64(values: &[i64]) -> Option<i64> {
+    reduce_lanes(values, i64::min)
+}
+
+pub fn max_i64(values: &[i64]) -> Option<i64> {
+    reduce_lanes(values, i64::max)
+}
+
+/// NaNs are skipped unless every element is NaN.
+pub fn min_f64(values: &[f64]) -> Option<f64> {
+    reduce_lanes(values, f64::min)
+}
+
+/// NaNs are skipped unless every element is NaN.
+pub fn max_f64(values: &[f64]) -> Option<f64> {
+    reduce_lanes(values, f64::max)
+}
+
+/// Dot product over the common prefix of `a` and `b`.
+pub fn dot_i64(a: &[i64], b: &[i64]) -> i64 {
+    let len = a.len().min(b.len());
+    let (a, b) = (&a[..len], &b[..len]);
+    let mut lanes = [0i64; LANES];
+    let a_chunks = a.chunks_exact(LANES);
+    let b_chunks = b.chunks_exact(LANES);
+    let tail = a_chunks.remainder().iter().zip(b_chunks.remainder());
+    for (a_chunk, b_chunk) in a_chunks.zip(b_chunks) {
+        for ((lane, x), y) in lanes.iter_mut().zip(a_chunk).zip(b_chunk) {
+            *lane = lane.wrapping_add(x.wrapping_mul(*y));
+        }
+    }
+    let sum = lanes.iter().fold(0i64, |sum, lane| sum.wrapping_add(*lane));
+    tail.fold(sum, |sum, (x, y)| sum.wrapping_add(x.wrapping_mul(*y)))
+}
+
+/// Dot product over the common prefix of `a` and `b`.
+pub fn dot_f64(a: &[f64], b: &[f64]) -> f64 {
+    let len = a.len().min(b.len());
+    let (a, b) = (&a[..len], &b[..len]);
+    let mut lanes = [0.0f64; LANES];
+    let a_chunks = a.chunks_exact(LANES);
+    let b_chunks = b.chunks_exact(LANES);
+    let tail = a_chunks.remainder().iter().zip(b_chunks.remainder());
+    for (a_chunk, b_chunk) in a_chunks.zip(b_chunks) {
+        for ((lane, x), y) in lanes.iter_mut().zip(a_chunk).zip(b_chunk) {
+            *lane += x * y;
+        }
+    }
+    lanes.iter().sum::<f64>() + tail.map(|(x, y)| x * y).sum::<f64>()
+}
+
+/// `value = value * mul + add` for every element, wrapping on overflow.
+pub fn scale_i64(values: &mut [i64], mul: i64, add: i64) {
+    for value in values {
+        *value = value.wrapping_mul(mul).wrapping_add(add);
+    }
+}
+
+/// `value = value * mul + add` for every element.
+pub fn scale_f64(values: &mut [f64], mul: f64, add: f64) {
+    for value in values {
+        *value = *value * mul + add;
+    }
+}
+
+pub fn sort_i64(values: &mut [i64]) {
+    values.sort_unstable();
+}
+
+/// Sorts by IEEE total order, so NaNs end up last.
+pub fn sort_f64(values: &mut [f64]) {
+    values.sort_unstable_by(f64::total_cmp);
+}
+
+/// `false` before `true`; a count and two fills instead of a comparison sort.
+pub fn sort_bool(values: &mut [bool]) {
+    let falses = values.iter().filter(|value| !**value).count();
+    let (low, high) = values.split_at_mut(falses);
+    low.fill(false);
+    high.fill(true);
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_reductions_match_sequential_loops() {
+        // Lengths around the lane width exercise both the chunks and the tail.
+        for len in [0, 1, 7, 8, 9, 31, 100] {
+            let ints: Vec<i64> = (0..len).map(|i| (i * 37 % 11) - 5).collect();
+            let floats: Vec<f64> = ints.iter().map(|i| *i as f64 * 0.5).collect();
+
+            assert_eq!(sum_i64(&ints), ints.iter().sum::<i64>());
+            assert_eq!(sum_f64(&floats), floats.iter().sum::<f64>());
+            assert_eq!(min_i64(&ints), ints.iter().copied().min());
+            assert_eq!(max_i64(&ints), ints.iter().copied().max());
+            assert_eq!(min_f64(&floats), floats.iter().copied().reduce(f64::min));
+            assert_eq!(max_f64(&floats), floats.iter().copied().reduce(f64::max));
+            assert_eq!(
+                dot_i64(&ints, &ints),
+                ints.iter().map(|i| i * i).sum::<i64>()
+            );
+            assert_eq!(
+                dot_f64(&floats, &floats),
+                floats.iter().map(|f| f * f).sum::<f64>()
+            );
+        }
+    }
+
+    #[test]
+    fn test_edge_cases() {
+        assert_eq!(sum_i64(&[i64::MAX, 1]), i64::MIN);
+        assert_eq!(dot_i64(&[1, 2, 3], &[4, 5]), 14);
+        assert_eq!(min_f64(&[f64::NAN, 2.0, 1.0]), Some(1.0));
+
+        let mut ints = vec![3, -1, 2];
+        scale_i64(&mut ints, 2, 1);
+        assert_eq!(ints, [7, -1, 5]);
+        sort_i64(&mut ints);
+        assert_eq!(ints, [-1, 5, 7]);
+
+        let mut floats = vec![2.0, f64::NAN, -1.0];
+        sort_f64(&mut floats);
+        assert_eq!(floats[..2], [-1.0, 2.0]);
+        assert!(floats[2].is_nan());
+
+        let mut bools = vec![true, false, true, false];
+        sort_bool(&mut bools);
+        assert_eq!(bools, [false, false, true, true]);
+    }
+}
@@ -3,9 +3,15 @@ pub mod enums;
 pub mod exceptions;
 pub mod fmt;
 pub mod gc;
+pub mod handle_table;
 pub mod http;
 pub mod io;
 pub mod json;
+pub mod json_decode;
+pub mod json_encode;
+pub mod key_map;
+pub mod line_reader;
+pub mod list_kernels;
 pub mod math;
 pub mod net;
 pub mod rand;
@@ -241,19 +241,21 @@ pub extern "C" fn otter_runtime_tasks() -> *mut c_char {
                     WorkerState::Idle => "idle",
                     WorkerState::Busy => "busy",
                     WorkerState::Parked => "parked",
+                    WorkerState::Retired => "retired",
                 };
                 format!(
-                    "{{\"id\":{},\"state\":\"{}\",\"queue_depth\":{},\"tasks_processed\":{}}}",
-                    w.id, state_str, w.queue_depth, w.tasks_processed
+                    "{{\"id\":{},\"state\":\"{}\",\"queue_depth\":{},\"tasks_processed\":{},\"steals\":{}}}",
+                    w.id, state_str, w.queue_depth, w.tasks_processed, w.steals
                 )
             })
             .collect();
 
         let json = format!(
-            "{{\"tasks\":{{\"spawned\":{},\"completed\":{},\"waiting\":{}}},\"channels\":{{\"registered\":{},\"waiting\":{},\"backlog\":{}}},\"workers\":{{\"total\":{},\"active\":{}}},\"worker_details\":[{}]}}",
+            "{{\"tasks\":{{\"spawned\":{},\"completed\":{},\"waiting\":{},\"queued\":{}}},\"channels\":{{\"registered\":{},\"waiting\":{},\"backlog\":{}}},\"workers\":{{\"total\":{},\"active\":{}}},\"worker_details\":[{}]}}",
             snapshot.tasks_spawned,
             snapshot.tasks_completed,
             snapshot.tasks_waiting,
+            snapshot.injector_depth,
             snapshot.channels_registered,
             snapshot.channel_waiters,
             snapshot.channel_backlog,
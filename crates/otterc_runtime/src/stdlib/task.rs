@@ -12,10 +12,12 @@ use once_cell::sync::Lazy;
 use parking_lot::Condvar;
 use parking_lot::Mutex;
 
+use crate::stdlib::builtins::{BOUNDED_CHANNEL_TABLE, LISTS, List, ListItems};
+use crate::stdlib::handle_table::HandleTable;
 #[cfg(feature = "task-runtime")]
 use crate::stdlib::runtime::task_metrics_clone;
 use crate::stdlib::runtime::{decrement_active_tasks, increment_active_tasks};
-use crate::task::{JoinHandle, TaskChannel, TaskRuntimeMetrics, runtime};
+use crate::task::{BoundedChannel, JoinHandle, TaskChannel, TaskRuntimeMetrics, runtime};
 use otterc_symbol::registry::{FfiFunction, FfiSignature, FfiType, SymbolRegistry};
 
 type HandleId = u64;
@@ -238,6 +240,165 @@ pub extern "C" fn otter_task_channel_float() -> u64 {
     id
 }
 
+/// Bounded channels live in a handle table, so sending on one never takes
+/// a lock shared with other channels. Their handles carry the table's tag
+/// and cannot collide with the ids of unbounded channels.
+enum BoundedWrapper {
+    Int(BoundedChannel<i64>),
+    Float(BoundedChannel<f64>),
+    String(BoundedChannel<String>),
+}
+
+impl BoundedWrapper {
+    fn is_empty(&self) -> bool {
+        match self {
+            BoundedWrapper::Int(channel) => channel.is_empty(),
+            BoundedWrapper::Float(channel) => channel.is_empty(),
+            BoundedWrapper::String(channel) => channel.is_empty(),
+        }
+    }
+
+    /// A send would not block: there is room, or it fails on a closed channel.
+    fn can_send(&self) -> bool {
+        match self {
+            BoundedWrapper::Int(channel) => !channel.is_full() || channel.is_closed(),
+            BoundedWrapper::Float(channel) => !channel.is_full() || channel.is_closed(),
+            BoundedWrapper::String(channel) => !channel.is_full() || channel.is_closed(),
+        }
+    }
+
+    fn close(&self) {
+        match self {
+            BoundedWrapper::Int(channel) => channel.close(),
+            BoundedWrapper::Float(channel) => channel.close(),
+            BoundedWrapper::String(channel) => channel.close(),
+        }
+    }
+
+    #[cfg(feature = "task-runtime")]
+    fn register_waker(&self, waker: &Waker, is_send: bool) {
+        match (self, is_send) {
+            (BoundedWrapper::Int(channel), false) => channel.register_waker(waker),
+            (BoundedWrapper::Int(channel), true) => channel.register_send_waker(waker),
+            (BoundedWrapper::Float(channel), false) => channel.register_waker(waker),
+            (BoundedWrapper::Float(channel), true) => channel.register_send_waker(waker),
+            (BoundedWrapper::String(channel), false) => channel.register_waker(waker),
+            (BoundedWrapper::String(channel), true) => channel.register_send_waker(waker),
+        }
+    }
+}
+
+static BOUNDED_CHANNELS: Lazy<HandleTable<BoundedWrapper>> =
+    Lazy::new(|| HandleTable::new(BOUNDED_CHANNEL_TABLE));
+
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_task_bounded_channel_int(capacity: i64) -> u64 {
+    let channel = BoundedChannel::with_metrics(capacity.max(0) as usize, obtain_metrics());
+    BOUNDED_CHANNELS.insert(BoundedWrapper::Int(channel))
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_task_bounded_channel_float(capacity: i64) -> u64 {
+    let channel = BoundedChannel::with_metrics(capacity.max(0) as usize, obtain_metrics());
+    BOUNDED_CHANNELS.insert(BoundedWrapper::Float(channel))
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_task_bounded_channel_string(capacity: i64) -> u64 {
+    let channel = BoundedChannel::with_metrics(capacity.max(0) as usize, obtain_metrics());
+    BOUNDED_CHANNELS.insert(BoundedWrapper::String(channel))
+}
+
+/// Either kind of channel, cloned out of its registry so that blocking on
+/// it holds no registry lock
+enum AnyChannel<T> {
+    Unbounded(TaskChannel<T>),
+    Bounded(BoundedChannel<T>),
+}
+
+trait ChannelValue: Sized {
+    fn unbounded(handle: HandleId) -> Option<TaskChannel<Self>>;
+    fn bounded(wrapper: &BoundedWrapper) -> Option<&BoundedChannel<Self>>;
+
+    fn lookup(handle: HandleId) -> Option<AnyChannel<Self>> {
+        if let Some(channel) = BOUNDED_CHANNELS
+            .with(handle, |wrapper| Self::bounded(wrapper).cloned())
+            .flatten()
+        {
+            return Some(AnyChannel::Bounded(channel));
+        }
+        Self::unbounded(handle).map(AnyChannel::Unbounded)
+    }
+}
+
+macro_rules! channel_value {
+    ($ty:ty, $registry:ident, $variant:ident) => {
+        impl ChannelValue for $ty {
+            fn unbounded(handle: HandleId) -> Option<TaskChannel<Self>> {
+                $registry
+                    .lock()
+                    .get(&handle)
+                    .map(|wrapper| wrapper.channel.clone())
+            }
+
+            fn bounded(wrapper: &BoundedWrapper) -> Option<&BoundedChannel<Self>> {
+                match wrapper {
+                    BoundedWrapper::$variant(channel) => Some(channel),
+                    _ => None,
+                }
+            }
+        }
+    };
+}
+
+channel_value!(i64, INT_CHANNELS, Int);
+channel_value!(f64, FLOAT_CHANNELS, Float);
+channel_value!(String, STRING_CHANNELS, String);
+
+/// 1 if `value` was sent, 0 for an unknown or closed channel
+fn send_value<T: ChannelValue>(handle: HandleId, value: T) -> i32 {
+    match T::lookup(handle) {
+        Some(AnyChannel::Unbounded(channel)) => {
+            channel.send(value);
+            1
+        }
+        Some(AnyChannel::Bounded(channel)) => i32::from(channel.send(value).is_ok()),
+        None => 0,
+    }
+}
+
+fn recv_value<T: ChannelValue>(handle: HandleId) -> Option<T> {
+    match T::lookup(handle)? {
+        AnyChannel::Unbounded(channel) => channel.recv(),
+        AnyChannel::Bounded(channel) => channel.recv(),
+    }
+}
+
+/// Send all of `values`, returning how many went out before any close
+fn send_values<T: ChannelValue>(handle: HandleId, values: Vec<T>) -> i64 {
+    let count = values.len() as i64;
+    match T::lookup(handle) {
+        Some(AnyChannel::Unbounded(channel)) => {
+            channel.send_batch(values);
+            count
+        }
+        Some(AnyChannel::Bounded(channel)) => match channel.send_batch(values) {
+            Ok(()) => count,
+            Err(unsent) => count - unsent.len() as i64,
+        },
+        None => 0,
+    }
+}
+
+fn recv_values<T: ChannelValue>(handle: HandleId, max: i64) -> Vec<T> {
+    let max = max.max(0) as usize;
+    match T::lookup(handle) {
+        Some(AnyChannel::Unbounded(channel)) => channel.recv_batch(max),
+        Some(AnyChannel::Bounded(channel)) => channel.recv_batch(max),
+        None => Vec::new(),
+    }
+}
+
 /// send a string `value` to the channel pointed to by `handle`
 ///
 /// # Safety
@@ -249,65 +410,93 @@ pub unsafe extern "C" fn otter_task_send_string(handle: u64, value: *const c_cha
         return 0;
     }
     let value = unsafe { CStr::from_ptr(value).to_str().unwrap_or("").to_string() };
-    if let Some(wrapper) = STRING_CHANNELS.lock().get(&handle) {
-        wrapper.channel.send(value);
-        1
-    } else {
-        0
-    }
+    send_value(handle, value)
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_task_send_int(handle: u64, value: i64) -> i32 {
-    if let Some(wrapper) = INT_CHANNELS.lock().get(&handle) {
-        wrapper.channel.send(value);
-        1
-    } else {
-        0
-    }
+    send_value(handle, value)
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_task_send_float(handle: u64, value: f64) -> i32 {
-    if let Some(wrapper) = FLOAT_CHANNELS.lock().get(&handle) {
-        wrapper.channel.send(value);
-        1
-    } else {
-        0
-    }
+    send_value(handle, value)
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_task_recv_string(handle: u64) -> *mut c_char {
-    if let Some(wrapper) = STRING_CHANNELS.lock().get(&handle)
-        && let Some(value) = wrapper.channel.recv()
-    {
-        return CString::new(value)
-            .ok()
-            .map(CString::into_raw)
-            .unwrap_or(std::ptr::null_mut());
-    }
-    std::ptr::null_mut()
+    recv_value::<String>(handle)
+        .and_then(|value| CString::new(value).ok())
+        .map_or(std::ptr::null_mut(), CString::into_raw)
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_task_recv_int(handle: u64) -> i64 {
-    if let Some(wrapper) = INT_CHANNELS.lock().get(&handle) {
-        return wrapper.channel.recv().unwrap_or(0);
-    }
-    0
+    recv_value(handle).unwrap_or(0)
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_task_recv_float(handle: u64) -> f64 {
-    if let Some(wrapper) = FLOAT_CHANNELS.lock().get(&handle) {
-        return wrapper.channel.recv().unwrap_or(0.0);
-    }
-    0.0
+    recv_value(handle).unwrap_or(0.0)
+}
+
+/// Send every element of the list `list`, blocking while a bounded channel
+/// is full; returns how many were sent
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_task_send_batch_int(handle: u64, list: u64) -> i64 {
+    let values = LISTS
+        .with(list, |list| list.items.ints().into_owned())
+        .unwrap_or_default();
+    send_values(handle, values)
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_task_send_batch_float(handle: u64, list: u64) -> i64 {
+    let values = LISTS
+        .with(list, |list| list.items.floats().into_owned())
+        .unwrap_or_default();
+    send_values(handle, values)
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_task_send_batch_string(handle: u64, list: u64) -> i64 {
+    let values = LISTS
+        .with(list, |list| list.items.strings().into_owned())
+        .unwrap_or_default();
+    send_values(handle, values)
+}
+
+/// Receive up to `max` values into a new list, blocking until there is at
+/// least one; the list is empty once the channel is closed and drained
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_task_recv_batch_int(handle: u64, max: i64) -> u64 {
+    LISTS.insert(List {
+        items: ListItems::Int(recv_values(handle, max)),
+    })
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_task_recv_batch_float(handle: u64, max: i64) -> u64 {
+    LISTS.insert(List {
+        items: ListItems::Float(recv_values(handle, max)),
+    })
+}
+
+#[unsafe(no_mangle)]
+pub extern "C" fn otter_task_recv_batch_string(handle: u64, max: i64) -> u64 {
+    LISTS.insert(List {
+        items: ListItems::Str(recv_values(handle, max)),
+    })
 }
 
 #[unsafe(no_mangle)]
 pub extern "C" fn otter_task_close_channel(handle: u64) {
+    if let Some(wrapper) = BOUNDED_CHANNELS.remove(handle) {
+        // Threads blocked on it hold their own clones and wake up here.
+        wrapper.close();
+        return;
+    }
+
     // Close channels before removing them to wake waiting tasks
     if let Some(wrapper) = STRING_CHANNELS.lock().get(&handle) {
         wrapper.channel.close();
@@ -329,6 +518,37 @@ pub extern "C" fn otter_task_close_channel(handle: u64) {
 // Select Implementation
 // ============================================================================
 
+/// A receive on `handle` would find a value waiting
+fn has_pending_value(handle: HandleId) -> bool {
+    if let Some(empty) = BOUNDED_CHANNELS.with(handle, BoundedWrapper::is_empty) {
+        return !empty;
+    }
+    STRING_CHANNELS
+        .lock()
+        .get(&handle)
+        .is_some_and(|wrapper| !wrapper.channel.is_empty())
+        || INT_CHANNELS
+            .lock()
+            .get(&handle)
+            .is_some_and(|wrapper| !wrapper.channel.is_empty())
+        || FLOAT_CHANNELS
+            .lock()
+            .get(&handle)
+            .is_some_and(|wrapper| !wrapper.channel.is_empty())
+}
+
+/// The case can proceed without blocking. Sends only block on a full
+/// bounded channel; unbounded channels always take them.
+fn case_ready(case: &SelectCase) -> bool {
+    if case.is_send {
+        BOUNDED_CHANNELS
+            .with(case.channel, BoundedWrapper::can_send)
+            .unwrap_or(true)
+    } else {
+        has_pending_value(case.channel)
+    }
+}
+
 #[repr(C)]
 pub struct SelectCase {
     channel: u64,
@@ -379,28 +599,8 @@ pub unsafe extern "C" fn otter_builtin_select(
     let cases_slice = unsafe { std::slice::from_raw_parts(cases, num_cases as usize) };
 
     // First pass: check for immediate readiness
-    for (idx, case) in cases_slice.iter().enumerate() {
-        if case.is_send {
-            // Send is always ready in unbounded channels
-            return idx as i64;
-        } else {
-            // Check if any channel has data
-            if STRING_CHANNELS
-                .lock()
-                .get(&case.channel)
-                .is_some_and(|wrapper| !wrapper.channel.is_empty())
-                || INT_CHANNELS
-                    .lock()
-                    .get(&case.channel)
-                    .is_some_and(|wrapper| !wrapper.channel.is_empty())
-                || FLOAT_CHANNELS
-                    .lock()
-                    .get(&case.channel)
-                    .is_some_and(|wrapper| !wrapper.channel.is_empty())
-            {
-                return idx as i64;
-            }
-        }
+    if let Some(idx) = cases_slice.iter().position(case_ready) {
+        return idx as i64;
     }
 
     if default_available {
@@ -414,38 +614,29 @@ pub unsafe extern "C" fn otter_builtin_select(
         let waker = create_condvar_waker(condvar_pair.clone());
 
         loop {
-            // Register waker on all receive channels
+            // Register waker on every channel a case waits for
             for case in cases_slice.iter() {
-                if !case.is_send {
-                    if let Some(wrapper) = STRING_CHANNELS.lock().get(&case.channel) {
-                        wrapper.channel.register_waker(&waker);
-                    } else if let Some(wrapper) = INT_CHANNELS.lock().get(&case.channel) {
-                        wrapper.channel.register_waker(&waker);
-                    } else if let Some(wrapper) = FLOAT_CHANNELS.lock().get(&case.channel) {
-                        wrapper.channel.register_waker(&waker);
-                    }
+                if BOUNDED_CHANNELS
+                    .with(case.channel, |wrapper| {
+                        wrapper.register_waker(&waker, case.is_send);
+                    })
+                    .is_some()
+                    || case.is_send
+                {
+                    continue;
+                }
+                if let Some(wrapper) = STRING_CHANNELS.lock().get(&case.channel) {
+                    wrapper.channel.register_waker(&waker);
+                } else if let Some(wrapper) = INT_CHANNELS.lock().get(&case.channel) {
+                    wrapper.channel.register_waker(&waker);
+                } else if let Some(wrapper) = FLOAT_CHANNELS.lock().get(&case.channel) {
+                    wrapper.channel.register_waker(&waker);
                 }
             }
 
             // Check again before sleeping to avoid race
-            for (idx, case) in cases_slice.iter().enumerate() {
-                if !case.is_send {
-                    if STRING_CHANNELS
-                        .lock()
-                        .get(&case.channel)
-                        .is_some_and(|wrapper| !wrapper.channel.is_empty())
-                        || INT_CHANNELS
-                            .lock()
-                            .get(&case.channel)
-                            .is_some_and(|wrapper| !wrapper.channel.is_empty())
-                        || FLOAT_CHANNELS
-                            .lock()
-                            .get(&case.channel)
-                            .is_some_and(|wrapper| !wrapper.channel.is_empty())
-                    {
-                        return idx as i64;
-                    }
-                }
+            if let Some(idx) = cases_slice.iter().position(case_ready) {
+                return idx as i64;
             }
 
             // Wait
@@ -621,6 +812,114 @@ fn register_std_task_symbols(registry: &SymbolRegistry) {
         symbol: "otter_task_recv_string".into(),
         signature: FfiSignature::new(vec![FfiType::Opaque], FfiType::Str),
     });
+
+    registry.register(FfiFunction {
+        name: "task.bounded_channel<int>".into(),
+        symbol: "otter_task_bounded_channel_int".into(),
+        signature: FfiSignature::new(vec![FfiType::I64], FfiType::Opaque),
+    });
+
+    registry.register(FfiFunction {
+        name: "task.bounded_channel<float>".into(),
+        symbol: "otter_task_bounded_channel_float".into(),
+        signature: FfiSignature::new(vec![FfiType::I64], FfiType::Opaque),
+    });
+
+    registry.register(FfiFunction {
+        name: "task.bounded_channel<string>".into(),
+        symbol: "otter_task_bounded_channel_string".into(),
+        signature: FfiSignature::new(vec![FfiType::I64], FfiType::Opaque),
+    });
+
+    registry.register(FfiFunction {
+        name: "task.send_batch<int>".into(),
+        symbol: "otter_task_send_batch_int".into(),
+        signature: FfiSignature::new(vec![FfiType::Opaque, FfiType::List], FfiType::I64),
+    });
+
+    registry.register(FfiFunction {
+        name: "task.send_batch<float>".into(),
+        symbol: "otter_task_send_batch_float".into(),
+        signature: FfiSignature::new(vec![FfiType::Opaque, FfiType::List], FfiType::I64),
+    });
+
+    registry.register(FfiFunction {
+        name: "task.send_batch<string>".into(),
+        symbol: "otter_task_send_batch_string".into(),
+        signature: FfiSignature::new(vec![FfiType::Opaque, FfiType::List], FfiType::I64),
+    });
+
+    registry.register(FfiFunction {
+        name: "task.recv_batch<int>".into(),
+        symbol: "otter_task_recv_batch_int".into(),
+        signature: FfiSignature::new(vec![FfiType::Opaque, FfiType::I64], FfiType::List),
+    });
+
+    registry.register(FfiFunction {
+        name: "task.recv_batch<float>".into(),
+        symbol: "otter_task_recv_batch_float".into(),
+        signature: FfiSignature::new(vec![FfiType::Opaque, FfiType::I64], FfiType::List),
+    });
+
+    registry.register(FfiFunction {
+        name: "task.recv_batch<string>".into(),
+        symbol: "otter_task_recv_batch_string".into(),
+        signature: FfiSignature::new(vec![FfiType::Opaque, FfiType::I64], FfiType::List),
+    });
+    // Underscore aliases for the bounded and batch functions
+    registry.register(FfiFunction {
+        name: "task.bounded_channel_int".into(),
+        symbol: "otter_task_bounded_channel_int".into(),
+        signature: FfiSignature::new(vec![FfiType::I64], FfiType::Opaque),
+    });
+
+    registry.register(FfiFunction {
+        name: "task.bounded_channel_float".into(),
+        symbol: "otter_task_bounded_channel_float".into(),
+        signature: FfiSignature::new(vec![FfiType::I64], FfiType::Opaque),
+    });
+
+    registry.register(FfiFunction {
+        name: "task.bounded_channel_string".into(),
+        symbol: "otter_task_bounded_channel_string".into(),
+        signature: FfiSignature::new(vec![FfiType::I64], FfiType::Opaque),
+    });
+
+    registry.register(FfiFunction {
+        name: "task.send_batch_int".into(),
+        symbol: "otter_task_send_batch_int".into(),
+        signature: FfiSignature::new(vec![FfiType::Opaque, FfiType::List], FfiType::I64),
+    });
+
+    registry.register(FfiFunction {
+        name: "task.send_batch_float".into(),
+        symbol: "otter_task_send_batch_float".into(),
+        signature: FfiSignature::new(vec![FfiType::Opaque, FfiType::List], FfiType::I64),
+    });
+
+    registry.register(FfiFunction {
+        name: "task.send_batch_string".into(),
+        symbol: "otter_task_send_batch_string".into(),
+        signature: FfiSignature::new(vec![FfiType::Opaque, FfiType::List], FfiType::I64),
+    });
+
+    registry.register(FfiFunction {
+        name: "task.recv_batch_int".into(),
+        symbol: "otter_task_recv_batch_int".into(),
+        signature: FfiSignature::new(vec![FfiType::Opaque, FfiType::I64], FfiType::List),
+    });
+
+    registry.register(FfiFunction {
+        name: "task.recv_batch_float".into(),
+        symbol: "otter_task_recv_batch_float".into(),
+        signature: FfiSignature::new(vec![FfiType::Opaque, FfiType::I64], FfiType::List),
+    });
+
+    registry.register(FfiFunction {
+        name: "task.recv_batch_string".into(),
+        symbol: "otter_task_recv_batch_string".into(),
+        signature: FfiSignature::new(vec![FfiType::Opaque, FfiType::I64], FfiType::List),
+    });
 }
 
 inventory::submit! {
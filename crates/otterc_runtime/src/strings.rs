@@ -91,8 +91,71 @@ pub unsafe extern "C" fn otter_str_concat(s1: *const c_char, s2: *const c_char)
     }
 }
 
+/// Concatenate `count` strings into a single allocation.
+///
+/// `lens[i]` may carry the byte length of `parts[i]` when the caller already
+/// knows it (compile-time literals); a negative entry, or a null `lens`,
+/// means the length is measured here. Used by codegen for f-strings and
+/// chains of `+` so the result is sized and written once.
+///
+/// # Safety
+///
+/// `parts` must point to `count` valid, NUL-terminated UTF-8 strings and
+/// `lens`, when non-null, to `count` lengths. Returned strings must be
+/// released with `otter_free_string`.
+#[unsafe(no_mangle)]
+pub unsafe extern "C" fn otter_str_concat_n(
+    parts: *const *const c_char,
+    lens: *const i64,
+    count: i64,
+) -> *mut c_char {
+    let Ok(count) = usize::try_from(count) else {
+        return std::ptr::null_mut();
+    };
+    if parts.is_null() && count > 0 {
+        return std::ptr::null_mut();
+    }
+
+    unsafe {
+        let mut slices: Vec<&[u8]> = Vec::with_capacity(count);
+        let mut total = 0;
+        for i in 0..count {
+            let part = *parts.add(i);
+            if part.is_null() {
+                return std::ptr::null_mut();
+            }
+            let known_len = if lens.is_null() { -1 } else { *lens.add(i) };
+            let bytes = match usize::try_from(known_len) {
+                Ok(len) => std::slice::from_raw_parts(part.cast::<u8>(), len),
+                Err(_) => CStr::from_ptr(part).to_bytes(),
+            };
+            if std::str::from_utf8(bytes).is_err() {
+                return std::ptr::null_mut();
+            }
+            total += bytes.len();
+            slices.push(bytes);
+        }
+
+        let mut result = Vec::with_capacity(total + 1);
+        for bytes in slices {
+            result.extend_from_slice(bytes);
+        }
+        let s = CString::new(result)
+            .map(CString::into_raw)
+            .unwrap_or_else(|_| std::ptr::null_mut());
+
+        if !s.is_null() {
+            get_gc().register_object(s as usize, total + 1, ObjectKind::CString);
+        }
+        s
+    }
+}
+
 /// Free a string allocated by Otter runtime
 ///
+/// The string is also dropped from the collector, which would otherwise
+/// free it a second time.
+///
 /// # Safety
 ///
 /// this function dereferences a raw pointer
@@ -101,6 +164,7 @@ pub unsafe extern "C" fn otter_free_string(ptr: *mut c_char) {
     if ptr.is_null() {
         return;
     }
+    get_gc().unregister_object(ptr as usize);
     unsafe {
         let _ = CString::from_raw(ptr);
     }
@@ -276,6 +340,22 @@ mod tests {
         }
     }
 
+    #[test]
+    fn test_concat_n_strings() {
+        let a = CString::new("id=").unwrap();
+        let b = CString::new("42").unwrap();
+        let c = CString::new(" 🦦").unwrap();
+        let parts = [a.as_ptr(), b.as_ptr(), c.as_ptr()];
+        let lens = [3, -1, -1];
+        let result = unsafe { otter_str_concat_n(parts.as_ptr(), lens.as_ptr(), 3) };
+        assert!(!result.is_null());
+        unsafe {
+            let s = CStr::from_ptr(result).to_str().unwrap();
+            assert_eq!(s, "id=42 🦦");
+            otter_free_string(result);
+        }
+    }
+
     #[test]
     fn test_validate_utf8() {
         let valid = CString::new("Hello 🦦").unwrap();
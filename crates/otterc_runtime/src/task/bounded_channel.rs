@@ -0,0 +1,732 @@
+//! Bounded lock-free MPMC channel
+//!
+//! A ring of slots, each with a sequence number (Vyukov's bounded queue).
+//! Producers claim positions by advancing `tail` with a CAS, and consumers
+//! do the same with `head`. A slot's sequence says whether the position
+//! that maps to it is free to write or holds a published value, so sends
+//! and receives on different slots never touch the same cache line beyond
+//! the two counters. Neither path takes a lock.
+//!
+//! The batch operations claim up to a whole run of positions with one CAS
+//! and then fill or drain the slots one by one. A claimed slot can still
+//! belong to a peer that is finishing its copy, so the batch waits briefly
+//! on that slot's sequence.
+//!
+//! Blocking is the slow path: a thread that finds the ring full (or empty)
+//! spins for a moment, then parks on a condvar. The other side only locks
+//! that condvar's mutex when someone is actually parked.
+
+use parking_lot::{Condvar, Mutex};
+use std::cell::UnsafeCell;
+use std::mem::MaybeUninit;
+use std::sync::Arc;
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering, fence};
+use std::task::Waker;
+
+use crossbeam_utils::{Backoff, CachePadded};
+
+use super::metrics::TaskRuntimeMetrics;
+
+/// Why [`BoundedChannel::try_send`] gave its value back
+#[derive(Debug, PartialEq, Eq)]
+pub enum TrySendError<T> {
+    Full(T),
+    Closed(T),
+}
+
+pub struct BoundedChannel<T> {
+    inner: Arc<BoundedInner<T>>,
+}
+
+struct Slot<T> {
+    /// `pos` when free for position `pos`; `pos + 1` once it holds that
+    /// position's value
+    sequence: AtomicUsize,
+    value: UnsafeCell<MaybeUninit<T>>,
+}
+
+struct BoundedInner<T> {
+    slots: Box<[Slot<T>]>,
+    mask: usize,
+    /// Next position to receive from
+    head: CachePadded<AtomicUsize>,
+    /// Next position to send to
+    tail: CachePadded<AtomicUsize>,
+    closed: AtomicBool,
+    /// Receivers waiting for a value
+    not_empty: Signal,
+    /// Senders waiting for a free slot
+    not_full: Signal,
+    metrics: Option<Arc<TaskRuntimeMetrics>>,
+}
+
+// SAFETY: a slot's value is only touched by the thread that claimed its
+// position, and the sequence number hands it over with acquire/release.
+unsafe impl<T: Send> Send for BoundedInner<T> {}
+unsafe impl<T: Send> Sync for BoundedInner<T> {}
+
+impl<T> BoundedChannel<T> {
+    /// A channel holding up to `capacity` values, rounded up to a power of
+    /// two (at least 2)
+    pub fn new(capacity: usize) -> Self {
+        Self::with_metrics(capacity, None)
+    }
+
+    pub fn with_metrics(capacity: usize, metrics: Option<Arc<TaskRuntimeMetrics>>) -> Self {
+        if let Some(metrics) = &metrics {
+            metrics.register_channel();
+        }
+        let capacity = capacity.max(2).next_power_of_two();
+        let slots = (0..capacity)
+            .map(|pos| Slot {
+                sequence: AtomicUsize::new(pos),
+                value: UnsafeCell::new(MaybeUninit::uninit()),
+            })
+            .collect();
+        Self {
+            inner: Arc::new(BoundedInner {
+                slots,
+                mask: capacity - 1,
+                head: CachePadded::new(AtomicUsize::new(0)),
+                tail: CachePadded::new(AtomicUsize::new(0)),
+                closed: AtomicBool::new(false),
+                not_empty: Signal::default(),
+                not_full: Signal::default(),
+                metrics,
+            }),
+        }
+    }
+
+    pub fn capacity(&self) -> usize {
+        self.inner.slots.len()
+    }
+
+    /// Values sent and not yet received; approximate while others are
+    /// sending or receiving
+    pub fn len(&self) -> usize {
+        let head = self.inner.head.load(Ordering::Acquire);
+        let tail = self.inner.tail.load(Ordering::Acquire);
+        tail.wrapping_sub(head).min(self.capacity())
+    }
+
+    pub fn is_empty(&self) -> bool {
+        !self.inner.has_value()
+    }
+
+    pub fn is_full(&self) -> bool {
+        !self.inner.has_room()
+    }
+
+    pub fn is_closed(&self) -> bool {
+        self.inner.closed.load(Ordering::Acquire)
+    }
+
+    /// Close the channel. Sends fail from now on; receivers drain what is
+    /// left and then see the end. Everyone parked is woken.
+    pub fn close(&self) {
+        if !self.inner.closed.swap(true, Ordering::AcqRel) {
+            self.inner.not_empty.notify();
+            self.inner.not_full.notify();
+        }
+    }
+
+    pub fn try_send(&self, value: T) -> Result<(), TrySendError<T>> {
+        if self.is_closed() {
+            return Err(TrySendError::Closed(value));
+        }
+        let inner = &*self.inner;
+        let backoff = Backoff::new();
+        let mut pos = inner.tail.load(Ordering::Relaxed);
+        loop {
+            let slot = inner.slot(pos);
+            let sequence = slot.sequence.load(Ordering::Acquire);
+            match sequence.wrapping_sub(pos) as isize {
+                0 => match inner.tail.compare_exchange_weak(
+                    pos,
+                    pos.wrapping_add(1),
+                    Ordering::Relaxed,
+                    Ordering::Relaxed,
+                ) {
+                    Ok(_) => {
+                        // SAFETY: the CAS made this thread the only writer of
+                        // `pos`, and its slot is free.
+                        unsafe { inner.write(pos, value) };
+                        inner.sent(1);
+                        return Ok(());
+                    }
+                    Err(current) => pos = current,
+                },
+                // The slot still holds the value from one lap ago.
+                lag if lag < 0 => return Err(TrySendError::Full(value)),
+                _ => {
+                    backoff.spin();
+                    pos = inner.tail.load(Ordering::Relaxed);
+                }
+            }
+        }
+    }
+
+    /// Send `value`, waiting while the channel is full. Gives the value
+    /// back if the channel is closed.
+    pub fn send(&self, value: T) -> Result<(), T> {
+        let mut value = value;
+        loop {
+            match self.try_send(value) {
+                Ok(()) => return Ok(()),
+                Err(TrySendError::Closed(value)) => return Err(value),
+                Err(TrySendError::Full(rejected)) => value = rejected,
+            }
+            let inner = &*self.inner;
+            inner
+                .not_full
+                .wait_until(|| inner.has_room() || inner.closed.load(Ordering::Acquire));
+        }
+    }
+
+    pub fn try_recv(&self) -> Option<T> {
+        let inner = &*self.inner;
+        let backoff = Backoff::new();
+        let mut pos = inner.head.load(Ordering::Relaxed);
+        loop {
+            let slot = inner.slot(pos);
+            let sequence = slot.sequence.load(Ordering::Acquire);
+            match sequence.wrapping_sub(pos.wrapping_add(1)) as isize {
+                0 => match inner.head.compare_exchange_weak(
+                    pos,
+                    pos.wrapping_add(1),
+                    Ordering::Relaxed,
+                    Ordering::Relaxed,
+                ) {
+                    Ok(_) => {
+                        // SAFETY: the CAS made this thread the only reader of
+                        // `pos`, and its value is published.
+                        let value = unsafe { inner.read(pos) };
+                        inner.received(1);
+                        return Some(value);
+                    }
+                    Err(current) => pos = current,
+                },
+                // Nothing has been published at `pos` yet.
+                lag if lag < 0 => return None,
+                _ => {
+                    backoff.spin();
+                    pos = inner.head.load(Ordering::Relaxed);
+                }
+            }
+        }
+    }
+
+    /// Receive a value, waiting while the channel is empty. `None` once the
+    /// channel is closed and drained.
+    pub fn recv(&self) -> Option<T> {
+        loop {
+            if let Some(value) = self.try_recv() {
+                return Some(value);
+            }
+            if self.is_closed() {
+                // A send may have landed between the two checks.
+                return self.try_recv();
+            }
+            let inner = &*self.inner;
+            inner
+                .not_empty
+                .wait_until(|| inner.has_value() || inner.closed.load(Ordering::Acquire));
+        }
+    }
+
+    /// Send every item, claiming as many slots per step as are free, and
+    /// waiting while the channel is full. On close, the items not yet sent
+    /// are given back.
+    pub fn send_batch(&self, items: Vec<T>) -> Result<(), Vec<T>> {
+        let mut items = items.into_iter();
+        let inner = &*self.inner;
+        while items.len() > 0 {
+            if self.is_closed() {
+                return Err(items.collect());
+            }
+            if inner.try_send_run(&mut items) == 0 {
+                inner
+                    .not_full
+                    .wait_until(|| inner.has_room() || inner.closed.load(Ordering::Acquire));
+            }
+        }
+        Ok(())
+    }
+
+    /// Move up to `max` values into `out` without waiting; returns how many
+    pub fn try_recv_batch(&self, max: usize, out: &mut Vec<T>) -> usize {
+        self.inner.try_recv_run(max, out)
+    }
+
+    /// Receive up to `max` values, waiting until there is at least one.
+    /// Empty once the channel is closed and drained.
+    pub fn recv_batch(&self, max: usize) -> Vec<T> {
+        let mut out = Vec::new();
+        if max == 0 {
+            return out;
+        }
+        let inner = &*self.inner;
+        loop {
+            if inner.try_recv_run(max, &mut out) > 0 {
+                return out;
+            }
+            if self.is_closed() {
+                inner.try_recv_run(max, &mut out);
+                return out;
+            }
+            inner
+                .not_empty
+                .wait_until(|| inner.has_value() || inner.closed.load(Ordering::Acquire));
+        }
+    }
+
+    /// Wake `waker` when a value arrives (or on close); used by `select`.
+    pub(crate) fn register_waker(&self, waker: &Waker) {
+        self.inner.not_empty.register(waker);
+    }
+
+    /// Wake `waker` when a slot frees up (or on close); used by `select`.
+    pub(crate) fn register_send_waker(&self, waker: &Waker) {
+        self.inner.not_full.register(waker);
+    }
+}
+
+impl<T> BoundedInner<T> {
+    fn slot(&self, pos: usize) -> &Slot<T> {
+        &self.slots[pos & self.mask]
+    }
+
+    /// The slot at `tail` is free.
+    fn has_room(&self) -> bool {
+        let tail = self.tail.load(Ordering::Acquire);
+        self.slot(tail).sequence.load(Ordering::Acquire) == tail
+    }
+
+    /// The slot at `head` holds a published value.
+    fn has_value(&self) -> bool {
+        let head = self.head.load(Ordering::Acquire);
+        self.slot(head).sequence.load(Ordering::Acquire) == head.wrapping_add(1)
+    }
+
+    /// # Safety
+    ///
+    /// The caller must have claimed `pos` by advancing `tail` past it.
+    unsafe fn write(&self, pos: usize, value: T) {
+        let slot = self.slot(pos);
+        // A peer that claimed this slot's previous position may still be
+        // copying out of it.
+        let backoff = Backoff::new();
+        while slot.sequence.load(Ordering::Acquire) != pos {
+            backoff.snooze();
+        }
+        unsafe { (*slot.value.get()).write(value) };
+        slot.sequence.store(pos.wrapping_add(1), Ordering::Release);
+    }
+
+    /// # Safety
+    ///
+    /// The caller must have claimed `pos` by advancing `head` past it.
+    unsafe fn read(&self, pos: usize) -> T {
+        let slot = self.slot(pos);
+        // The sender that claimed `pos` may still be copying into it.
+        let backoff = Backoff::new();
+        while slot.sequence.load(Ordering::Acquire) != pos.wrapping_add(1) {
+            backoff.snooze();
+        }
+        let value = unsafe { (*slot.value.get()).assume_init_read() };
+        slot.sequence
+            .store(pos.wrapping_add(self.slots.len()), Ordering::Release);
+        value
+    }
+
+    /// Claim as many positions as are free (up to what `items` has left)
+    /// with one CAS, and fill them. Returns how many were sent.
+    fn try_send_run(&self, items: &mut std::vec::IntoIter<T>) -> usize {
+        let mut tail = self.tail.load(Ordering::Relaxed);
+        let claimed = loop {
+            // Positions below `head` have been claimed by receivers, so
+            // their slots free up without waiting on anyone idle.
+            let head = self.head.load(Ordering::Acquire);
+            let free = self.slots.len().saturating_sub(tail.wrapping_sub(head));
+            let count = free.min(items.len());
+            if count == 0 {
+                return 0;
+            }
+            match self.tail.compare_exchange_weak(
+                tail,
+                tail.wrapping_add(count),
+                Ordering::Relaxed,
+                Ordering::Relaxed,
+            ) {
+                Ok(_) => break count,
+                Err(current) => tail = current,
+            }
+        };
+        for (offset, value) in items.take(claimed).enumerate() {
+            // SAFETY: the CAS claimed `tail..tail + claimed`.
+            unsafe { self.write(tail.wrapping_add(offset), value) };
+        }
+        self.sent(claimed);
+        claimed
+    }
+
+    /// Claim up to `max` positions that senders have claimed, with one CAS,
+    /// and drain them into `out`. Returns how many were received.
+    fn try_recv_run(&self, max: usize, out: &mut Vec<T>) -> usize {
+        let mut head = self.head.load(Ordering::Relaxed);
+        let claimed = loop {
+            let tail = self.tail.load(Ordering::Acquire);
+            let available = tail.wrapping_sub(head).min(self.slots.len());
+            let count = available.min(max);
+            if count == 0 {
+                return 0;
+            }
+            match self.head.compare_exchange_weak(
+                head,
+                head.wrapping_add(count),
+                Ordering::Relaxed,
+                Ordering::Relaxed,
+            ) {
+                Ok(_) => break count,
+                Err(current) => head = current,
+            }
+        };
+        out.reserve(claimed);
+        for offset in 0..claimed {
+            // SAFETY: the CAS claimed `head..head + claimed`.
+            out.push(unsafe { self.read(head.wrapping_add(offset)) });
+        }
+        self.received(claimed);
+        claimed
+    }
+
+    fn sent(&self, count: usize) {
+        if let Some(metrics) = &self.metrics {
+            metrics.record_channel_backlog(count as i64);
+        }
+        self.not_empty.notify();
+    }
+
+    fn received(&self, count: usize) {
+        if let Some(metrics) = &self.metrics {
+            metrics.record_channel_backlog(-(count as i64));
+        }
+        self.not_full.notify();
+    }
+}
+
+impl<T> Drop for BoundedInner<T> {
+    fn drop(&mut self) {
+        let head = *self.head.get_mut();
+        let tail = *self.tail.get_mut();
+        let mut pos = head;
+        while pos != tail {
+            let slot = &mut self.slots[pos & self.mask];
+            if *slot.sequence.get_mut() == pos.wrapping_add(1) {
+                // SAFETY: the value at `pos` was published and never read.
+                unsafe { slot.value.get_mut().assume_init_drop() };
+            }
+            pos = pos.wrapping_add(1);
+        }
+    }
+}
+
+impl<T> Clone for BoundedChannel<T> {
+    fn clone(&self) -> Self {
+        Self {
+            inner: Arc::clone(&self.inner),
+        }
+    }
+}
+
+impl<T> std::fmt::Debug for BoundedChannel<T> {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("BoundedChannel")
+            .field("capacity", &self.capacity())
+            .field("len", &self.len())
+            .field("closed", &self.is_closed())
+            .finish()
+    }
+}
+
+/// Parking for one side of the channel. `waiters` counts parked threads
+/// and registered wakers, so `notify` is one atomic load while nobody
+/// waits. `notify` wakes everyone and resets the count, and a thread that
+/// still cannot proceed counts itself again, so a burst of sends to a
+/// consumer that has not been scheduled yet wakes it once.
+#[derive(Default)]
+struct Signal {
+    waiters: AtomicUsize,
+    wakers: Mutex<Vec<Waker>>,
+    condvar: Condvar,
+}
+
+/// Spins before parking, so a peer that is about to make progress does not
+/// cost a sleep
+const SPINS_BEFORE_PARK: usize = 64;
+
+impl Signal {
+    /// Block until `ready` holds. The other side changes the state and then
+    /// calls `notify`.
+    fn wait_until(&self, ready: impl Fn() -> bool) {
+        for _ in 0..SPINS_BEFORE_PARK {
+            if ready() {
+                return;
+            }
+            std::hint::spin_loop();
+        }
+        let mut wakers = self.wakers.lock();
+        loop {
+            self.waiters.fetch_add(1, Ordering::SeqCst);
+            // Pairs with the fence in `notify`: either this check sees the
+            // new state, or the notifier sees the waiter and takes the
+            // lock, which it cannot do until the condvar has released it.
+            fence(Ordering::SeqCst);
+            if ready() {
+                // The lock is held, so no notifier has reset the count
+                // since it was raised.
+                self.waiters.fetch_sub(1, Ordering::SeqCst);
+                return;
+            }
+            self.condvar.wait(&mut wakers);
+        }
+    }
+
+    fn register(&self, waker: &Waker) {
+        let mut wakers = self.wakers.lock();
+        if wakers.iter().any(|existing| existing.will_wake(waker)) {
+            return;
+        }
+        wakers.push(waker.clone());
+        self.waiters.fetch_add(1, Ordering::SeqCst);
+    }
+
+    fn notify(&self) {
+        fence(Ordering::SeqCst);
+        if self.waiters.load(Ordering::SeqCst) == 0 {
+            return;
+        }
+        let wakers = {
+            let mut wakers = self.wakers.lock();
+            self.waiters.store(0, Ordering::SeqCst);
+            self.condvar.notify_all();
+            std::mem::take(&mut *wakers)
+        };
+        for waker in wakers {
+            waker.wake();
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::thread;
+
+    #[test]
+    fn try_send_stops_at_capacity() {
+        let channel = BoundedChannel::new(3);
+        assert_eq!(channel.capacity(), 4);
+        for value in 0..4 {
+            assert_eq!(channel.try_send(value), Ok(()));
+        }
+        assert_eq!(channel.try_send(4), Err(TrySendError::Full(4)));
+        assert!(channel.is_full());
+        assert_eq!(channel.try_recv(), Some(0));
+        assert_eq!(channel.try_send(4), Ok(()));
+        assert_eq!(channel.recv_batch(10), vec![1, 2, 3, 4]);
+        assert!(channel.is_empty());
+    }
+
+    #[test]
+    fn close_drains_then_ends_and_rejects_sends() {
+        let channel = BoundedChannel::new(4);
+        channel.send_batch(vec![1, 2]).unwrap();
+        channel.close();
+        assert_eq!(channel.send(3), Err(3));
+        assert_eq!(channel.send_batch(vec![4, 5]), Err(vec![4, 5]));
+        assert_eq!(channel.recv(), Some(1));
+        assert_eq!(channel.recv_batch(8), vec![2]);
+        assert_eq!(channel.recv(), None);
+        assert!(channel.recv_batch(8).is_empty());
+    }
+
+    #[test]
+    fn close_wakes_parked_senders_and_receivers() {
+        let full = BoundedChannel::new(2);
+        full.send_batch(vec![0, 0]).unwrap();
+        let empty = BoundedChannel::<i32>::new(2);
+        let (sender, receiver) = (full.clone(), empty.clone());
+        let blocked_send = thread::spawn(move || sender.send(1));
+        let blocked_recv = thread::spawn(move || receiver.recv());
+        thread::sleep(std::time::Duration::from_millis(20));
+        full.close();
+        empty.close();
+        assert_eq!(blocked_send.join().unwrap(), Err(1));
+        assert_eq!(blocked_recv.join().unwrap(), None);
+    }
+
+    #[test]
+    fn unread_values_are_dropped_with_the_channel() {
+        let value = Arc::new(());
+        let channel = BoundedChannel::new(4);
+        channel
+            .send_batch(vec![value.clone(), value.clone()])
+            .unwrap();
+        drop(channel.try_recv());
+        drop(channel);
+        assert_eq!(Arc::strong_count(&value), 1);
+    }
+
+    #[test]
+    fn every_value_arrives_once_under_contention() {
+        const PER_PRODUCER: u64 = 20_000;
+        const PRODUCERS: u64 = 4;
+
+        // A small ring keeps producers and consumers wrapping into each
+        // other's slots, mixing single and batch operations on both sides.
+        let channel = BoundedChannel::new(8);
+        let producers: Vec<_> = (0..PRODUCERS)
+            .map(|producer| {
+                let channel = channel.clone();
+                thread::spawn(move || {
+                    let values: Vec<u64> = (0..PER_PRODUCER)
+                        .map(|i| producer * PER_PRODUCER + i)
+                        .collect();
+                    if producer % 2 == 0 {
+                        for chunk in values.chunks(7) {
+                            channel.send_batch(chunk.to_vec()).unwrap();
+                        }
+                    } else {
+                        for value in values {
+                            channel.send(value).unwrap();
+                        }
+                    }
+                })
+            })
+            .collect();
+        let consumers: Vec<_> = (0..3)
+            .map(|consumer| {
+                let channel = channel.clone();
+                thread::spawn(move || {
+                    let mut seen = Vec::new();
+                    loop {
+                        if consumer == 0 {
+                            match channel.recv() {
+                                Some(value) => seen.push(value),
+                                None => return seen,
+                            }
+                        } else {
+                            let batch = channel.recv_batch(5);
+                            if batch.is_empty() {
+                                return seen;
+                            }
+                            seen.extend(batch);
+                        }
+                    }
+                })
+            })
+            .collect();
+
+        for producer in producers {
+            producer.join().unwrap();
+        }
+        channel.close();
+        let mut seen: Vec<u64> = consumers
+            .into_iter()
+            .flat_map(|consumer| consumer.join().unwrap())
+            .collect();
+        seen.sort_unstable();
+        assert_eq!(seen, (0..PRODUCERS * PER_PRODUCER).collect::<Vec<_>>());
+    }
+
+    // Run with: cargo test -p otterc_runtime --release channel_throughput_benchmark -- --ignored --nocapture
+    #[test]
+    #[ignore]
+    fn channel_throughput_benchmark() {
+        use crate::task::TaskChannel;
+
+        const MESSAGES: u64 = 1_000_000;
+        const BATCH: usize = 64;
+
+        /// Run `pairs` producers and `pairs` consumers that move `MESSAGES`
+        /// values in total.
+        fn run_pairs(
+            pairs: u64,
+            produce: impl Fn(u64) + Send + Sync + 'static,
+            consume: impl Fn() -> u64 + Send + Sync + 'static,
+        ) {
+            let produce = Arc::new(produce);
+            let consume = Arc::new(consume);
+            let producers: Vec<_> = (0..pairs)
+                .map(|_| {
+                    let produce = Arc::clone(&produce);
+                    thread::spawn(move || produce(MESSAGES / pairs))
+                })
+                .collect();
+            let consumers: Vec<_> = (0..pairs)
+                .map(|_| {
+                    let consume = Arc::clone(&consume);
+                    thread::spawn(move || consume())
+                })
+                .collect();
+            for producer in producers {
+                producer.join().unwrap();
+            }
+            let received: u64 = consumers.into_iter().map(|c| c.join().unwrap()).sum();
+            assert_eq!(received, MESSAGES / pairs * pairs);
+        }
+
+        for pairs in [1, 2, 4, 8] {
+            let per_consumer = MESSAGES / pairs;
+            crate::benchmark::Benchmark::new(format!("TaskChannel, {pairs} pairs"))
+                .warmup(1)
+                .iterations(3)
+                .run_and_print(|| {
+                    let channel = TaskChannel::new();
+                    let (tx, rx) = (channel.clone(), channel);
+                    run_pairs(
+                        pairs,
+                        move |count| (0..count).for_each(|value| tx.send(value)),
+                        move || (0..per_consumer).map(|_| rx.recv().unwrap()).count() as u64,
+                    );
+                });
+            crate::benchmark::Benchmark::new(format!("BoundedChannel, {pairs} pairs"))
+                .warmup(1)
+                .iterations(3)
+                .run_and_print(|| {
+                    let channel = BoundedChannel::new(1024);
+                    let (tx, rx) = (channel.clone(), channel);
+                    run_pairs(
+                        pairs,
+                        move |count| (0..count).for_each(|value| tx.send(value).unwrap()),
+                        move || (0..per_consumer).map(|_| rx.recv().unwrap()).count() as u64,
+                    );
+                });
+            crate::benchmark::Benchmark::new(format!("BoundedChannel batch, {pairs} pairs"))
+                .warmup(1)
+                .iterations(3)
+                .run_and_print(|| {
+                    let channel = BoundedChannel::new(1024);
+                    let (tx, rx) = (channel.clone(), channel);
+                    run_pairs(
+                        pairs,
+                        move |count| {
+                            let values: Vec<u64> = (0..count).collect();
+                            for chunk in values.chunks(BATCH) {
+                                tx.send_batch(chunk.to_vec()).unwrap();
+                            }
+                        },
+                        move || {
+                            let mut received = 0;
+                            while received < per_consumer {
+                                let want = (per_consumer - received).min(BATCH as u64);
+                                received += rx.recv_batch(want as usize).len() as u64;
+                            }
+                            received
+                        },
+                    );
+                });
+        }
+    }
+}
@@ -69,6 +69,61 @@ impl<T> TaskChannel<T> {
         self.inner.condvar.notify_one();
     }
 
+    /// Send several values under one lock, waking as many receivers.
+    pub fn send_batch(&self, values: Vec<T>) {
+        let count = values.len();
+        if count == 0 {
+            return;
+        }
+        self.inner.queue.lock().extend(values);
+
+        if let Some(metrics) = &self.inner.metrics {
+            metrics.record_channel_backlog(count as i64);
+        }
+
+        let wakers: Vec<Waker> = {
+            let mut wakers = self.inner.receiver_wakers.lock();
+            let keep = wakers.len().saturating_sub(count);
+            wakers.drain(keep..).collect()
+        };
+        if !wakers.is_empty()
+            && let Some(metrics) = &self.inner.metrics
+        {
+            metrics.record_channel_waiters(-(wakers.len() as i64));
+        }
+        for waker in wakers {
+            waker.wake();
+        }
+
+        self.inner.condvar.notify_all();
+    }
+
+    /// Receive up to `max` values under one lock, blocking until there is
+    /// at least one. Empty once the channel is closed and drained.
+    pub fn recv_batch(&self, max: usize) -> Vec<T> {
+        if max == 0 {
+            return Vec::new();
+        }
+        let mut queue = self.inner.queue.lock();
+
+        loop {
+            if !queue.is_empty() {
+                let count = max.min(queue.len());
+                let values: Vec<T> = queue.drain(..count).collect();
+                if let Some(metrics) = &self.inner.metrics {
+                    metrics.record_channel_backlog(-(count as i64));
+                }
+                return values;
+            }
+
+            if *self.inner.closed.lock() {
+                return Vec::new();
+            }
+
+            self.inner.condvar.wait(&mut queue);
+        }
+    }
+
     /// Receive a value, blocking if none is available.
     /// This is a legacy blocking API. For task-aware code, use `recv_async` instead.
     pub fn recv(&self) -> Option<T> {
@@ -317,6 +372,17 @@ mod tests {
         handle.join().unwrap();
     }
 
+    #[test]
+    fn batches_keep_fifo_order() {
+        let channel = TaskChannel::new();
+        channel.send_batch(vec![1, 2, 3]);
+        channel.send(4);
+        assert_eq!(channel.recv_batch(2), vec![1, 2]);
+        assert_eq!(channel.recv_batch(10), vec![3, 4]);
+        channel.close();
+        assert!(channel.recv_batch(10).is_empty());
+    }
+
     #[test]
     fn waker_registration_deduplicated_and_drained_on_close() {
         let channel = TaskChannel::<i32>::new();
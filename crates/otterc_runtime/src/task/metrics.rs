@@ -1,21 +1,83 @@
 use parking_lot::RwLock;
 use std::cmp::max;
 use std::sync::Arc;
-use std::sync::atomic::{AtomicI64, AtomicU64, Ordering};
+use std::sync::atomic::{AtomicI64, AtomicU8, AtomicU64, Ordering};
 
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
 pub enum WorkerState {
     Idle,
     Busy,
     Parked,
+    /// The worker's thread exited; the slot can be started again
+    Retired,
+}
+
+impl WorkerState {
+    fn from_u8(value: u8) -> Self {
+        match value {
+            0 => WorkerState::Idle,
+            1 => WorkerState::Busy,
+            2 => WorkerState::Parked,
+            _ => WorkerState::Retired,
+        }
+    }
 }
 
 #[derive(Debug, Clone)]
 pub struct WorkerInfo {
     pub id: usize,
     pub state: WorkerState,
+    /// Tasks in the worker's local queue when the snapshot was taken
     pub queue_depth: usize,
     pub tasks_processed: u64,
+    /// Tasks this worker took from other workers' queues
+    pub steals: u64,
+}
+
+/// Counters one worker updates without locking
+#[derive(Debug)]
+pub struct WorkerStats {
+    state: AtomicU8,
+    tasks_processed: AtomicU64,
+    steals: AtomicU64,
+}
+
+impl Default for WorkerStats {
+    fn default() -> Self {
+        Self {
+            state: AtomicU8::new(WorkerState::Retired as u8),
+            tasks_processed: AtomicU64::new(0),
+            steals: AtomicU64::new(0),
+        }
+    }
+}
+
+impl WorkerStats {
+    pub fn set_state(&self, state: WorkerState) {
+        self.state.store(state as u8, Ordering::Relaxed);
+    }
+
+    pub fn state(&self) -> WorkerState {
+        WorkerState::from_u8(self.state.load(Ordering::Relaxed))
+    }
+
+    pub fn record_task(&self) {
+        self.tasks_processed.fetch_add(1, Ordering::Relaxed);
+    }
+
+    pub fn record_steals(&self, count: u64) {
+        self.steals.fetch_add(count, Ordering::Relaxed);
+    }
+}
+
+/// Reads exact queue lengths from the scheduler when a snapshot is taken:
+/// fills in one local queue length per worker and returns the injector's.
+struct QueueProbe(Box<dyn Fn(&mut Vec<usize>) -> usize + Send + Sync>);
+
+impl std::fmt::Debug for QueueProbe {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.write_str("QueueProbe")
+    }
 }
 
 #[derive(Debug, Default)]
@@ -26,7 +88,8 @@ pub struct TaskRuntimeMetrics {
     channels: AtomicU64,
     channel_waiters: AtomicI64,
     channel_backlog: AtomicI64,
-    worker_infos: RwLock<Vec<WorkerInfo>>,
+    workers: RwLock<Vec<Arc<WorkerStats>>>,
+    queue_probe: RwLock<Option<QueueProbe>>,
     active_workers: AtomicU64,
     total_workers: AtomicU64,
 }
@@ -69,7 +132,7 @@ impl TaskRuntimeMetrics {
     }
 
     pub fn snapshot(&self) -> TaskMetricsSnapshot {
-        let worker_infos = self.worker_infos.read().clone();
+        let (injector_depth, worker_infos) = self.queue_depths();
         TaskMetricsSnapshot {
             tasks_spawned: self.spawned.load(Ordering::Relaxed),
             tasks_completed: self.completed.load(Ordering::Relaxed),
@@ -79,37 +142,30 @@ impl TaskRuntimeMetrics {
             channel_backlog: max(self.channel_backlog.load(Ordering::Relaxed), 0) as u64,
             active_workers: self.active_workers.load(Ordering::Relaxed),
             total_workers: self.total_workers.load(Ordering::Relaxed),
+            injector_depth: injector_depth as u64,
             worker_infos,
         }
     }
 
-    pub fn update_worker_info(&self, worker_id: usize, state: WorkerState, queue_depth: usize) {
-        let mut infos = self.worker_infos.write();
-        let current_len = infos.len();
-        if worker_id < current_len {
-            infos[worker_id].state = state;
-            infos[worker_id].queue_depth = queue_depth;
-        } else {
-            // Grow vector if needed
-            while infos.len() <= worker_id {
-                let new_id = infos.len();
-                infos.push(WorkerInfo {
-                    id: new_id,
-                    state: WorkerState::Idle,
-                    queue_depth: 0,
-                    tasks_processed: 0,
-                });
-            }
-            infos[worker_id].state = state;
-            infos[worker_id].queue_depth = queue_depth;
+    /// Stats handle for `worker_id`, created on first use
+    pub fn worker(&self, worker_id: usize) -> Arc<WorkerStats> {
+        if let Some(stats) = self.workers.read().get(worker_id) {
+            return Arc::clone(stats);
+        }
+        let mut workers = self.workers.write();
+        while workers.len() <= worker_id {
+            workers.push(Arc::default());
         }
+        Arc::clone(&workers[worker_id])
     }
 
-    pub fn record_worker_task(&self, worker_id: usize) {
-        let mut infos = self.worker_infos.write();
-        if worker_id < infos.len() {
-            infos[worker_id].tasks_processed += 1;
-        }
+    /// Install the scheduler's queue probe; snapshots without one report
+    /// empty queues.
+    pub fn set_queue_probe(
+        &self,
+        probe: impl Fn(&mut Vec<usize>) -> usize + Send + Sync + 'static,
+    ) {
+        *self.queue_probe.write() = Some(QueueProbe(Box::new(probe)));
     }
 
     pub fn set_total_workers(&self, count: usize) {
@@ -121,11 +177,36 @@ impl TaskRuntimeMetrics {
     }
 
     pub fn get_worker_infos(&self) -> Vec<WorkerInfo> {
-        self.worker_infos.read().clone()
+        self.queue_depths().1
     }
 
+    /// Tasks queued anywhere: the injector plus every local queue
     pub fn get_total_queue_depth(&self) -> usize {
-        self.worker_infos.read().iter().map(|w| w.queue_depth).sum()
+        let (injector_depth, infos) = self.queue_depths();
+        injector_depth + infos.iter().map(|w| w.queue_depth).sum::<usize>()
+    }
+
+    fn queue_depths(&self) -> (usize, Vec<WorkerInfo>) {
+        let mut local_depths = Vec::new();
+        let injector_depth = self
+            .queue_probe
+            .read()
+            .as_ref()
+            .map_or(0, |probe| (probe.0)(&mut local_depths));
+        let infos = self
+            .workers
+            .read()
+            .iter()
+            .enumerate()
+            .map(|(id, stats)| WorkerInfo {
+                id,
+                state: stats.state(),
+                queue_depth: local_depths.get(id).copied().unwrap_or(0),
+                tasks_processed: stats.tasks_processed.load(Ordering::Relaxed),
+                steals: stats.steals.load(Ordering::Relaxed),
+            })
+            .collect();
+        (injector_depth, infos)
     }
 }
 
@@ -139,5 +220,7 @@ pub struct TaskMetricsSnapshot {
     pub channel_backlog: u64,
     pub active_workers: u64,
     pub total_workers: u64,
+    /// Tasks spawned but not yet picked up by any worker
+    pub injector_depth: u64,
     pub worker_infos: Vec<WorkerInfo>,
 }
@@ -3,6 +3,7 @@
 //! Provides a lightweight task scheduler, join handles, and runtime metrics
 //! used by the standard library FFI bindings.
 
+mod bounded_channel;
 mod channel;
 mod metrics;
 mod scheduler;
@@ -10,11 +11,12 @@ mod task_impl;
 mod timer;
 mod tls;
 
+pub use bounded_channel::{BoundedChannel, TrySendError};
 pub use channel::{SelectResult, TaskChannel, TaskMailBox, select2, select2_async};
-pub use metrics::{TaskMetricsSnapshot, TaskRuntimeMetrics, WorkerInfo, WorkerState};
+pub use metrics::{TaskMetricsSnapshot, TaskRuntimeMetrics, WorkerInfo, WorkerState, WorkerStats};
 pub use scheduler::{SchedulerConfig, TaskScheduler};
 pub use task_impl::{CancellationToken, JoinFuture, JoinHandle, Task, TaskFn, TaskId, TaskState};
-pub use timer::TimerWheel;
+pub use timer::{TimerId, TimerWheel};
 pub use tls::{
     TaskLocalRegistry, TaskLocalStorage, cleanup_task_local_storage, get_task_local_storage,
 };
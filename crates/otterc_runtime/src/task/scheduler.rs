@@ -1,18 +1,43 @@
+//! Work-stealing task scheduler with an elastic worker pool.
+//!
+//! Spawned tasks go to a shared injector queue. Workers pull batches from
+//! it into their local deques and steal from each other when both run dry.
+//!
+//! The pool grows and shrinks with load. A worker that finds no work spins
+//! briefly and then parks. Spawning a task wakes one parked worker. The
+//! autoscaler thread starts a new worker, up to `max_workers`, when the
+//! injector stays backed up and nobody is parked. A worker that stays
+//! parked for `idle_timeout` retires, down to `min_workers`.
+//!
+//! Every worker slot has a fixed deque, so the stealer list never changes.
+//! A retiring worker hands its deque back to the slot for the next thread
+//! started there.
+
 use crossbeam_deque::{Injector, Steal, Stealer, Worker};
 use crossbeam_utils::Backoff;
+use parking_lot::{Condvar, Mutex};
 use std::sync::Arc;
-use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering, fence};
 use std::thread;
-use std::time::Duration;
+use std::time::{Duration, Instant};
 
-use super::metrics::{TaskRuntimeMetrics, WorkerState};
+use super::metrics::{TaskRuntimeMetrics, WorkerState, WorkerStats};
 use super::task_impl::{JoinHandle, Task, TaskFn};
-use super::timer::TimerWheel;
+use super::timer::{TimerWheel, bind_worker_shard};
 use super::tls::cleanup_task_local_storage;
 
+/// How often the autoscaler samples the injector
+const SCALE_INTERVAL: Duration = Duration::from_millis(10);
+/// Consecutive backed-up samples before the pool grows
+const SUSTAINED_BACKLOG_SAMPLES: u32 = 2;
+
 #[derive(Debug, Clone, Copy)]
 pub struct SchedulerConfig {
     pub max_workers: usize,
+    /// Workers kept alive while idle; the pool starts at this size
+    pub min_workers: usize,
+    /// How long a parked worker waits for work before it retires
+    pub idle_timeout: Duration,
 }
 
 impl Default for SchedulerConfig {
@@ -22,19 +47,35 @@ impl Default for SchedulerConfig {
             .unwrap_or(4);
         Self {
             max_workers: workers,
+            min_workers: 1,
+            idle_timeout: Duration::from_secs(5),
         }
     }
 }
 
+#[derive(Debug)]
+struct WorkerSlot {
+    /// The slot's deque while no thread runs in it
+    queue: Mutex<Option<Worker<Task>>>,
+    /// Set by `wake_one` when it takes this slot off the sleeper list
+    woken: Mutex<bool>,
+    condvar: Condvar,
+    stats: Arc<WorkerStats>,
+}
+
 #[derive(Debug)]
 struct SchedulerCore {
     injector: Injector<Task>,
-    _stealers: Arc<Vec<Stealer<Task>>>,
+    stealers: Vec<Stealer<Task>>,
+    slots: Vec<WorkerSlot>,
+    /// Parked workers, most recent last
+    sleepers: Mutex<Vec<usize>>,
+    parked: AtomicUsize,
     metrics: Arc<TaskRuntimeMetrics>,
     shutdown: AtomicBool,
     timer_wheel: Arc<TimerWheel>,
     worker_count: AtomicUsize,
-    _config: SchedulerConfig,
+    config: SchedulerConfig,
 }
 
 #[derive(Debug, Clone)]
@@ -44,32 +85,54 @@ pub struct TaskScheduler {
 
 impl TaskScheduler {
     pub fn new(config: SchedulerConfig) -> Self {
+        let max_workers = config.max_workers.max(1);
+        let config = SchedulerConfig {
+            max_workers,
+            min_workers: config.min_workers.clamp(1, max_workers),
+            ..config
+        };
         let metrics = TaskRuntimeMetrics::new();
-        let injector = Injector::new();
-        let timer_wheel = Arc::new(TimerWheel::new());
-        let mut workers = Vec::with_capacity(config.max_workers);
-        let mut stealer_store = Vec::with_capacity(config.max_workers);
+        let timer_wheel = Arc::new(TimerWheel::with_shards(max_workers));
+        let mut stealers = Vec::with_capacity(max_workers);
+        let mut slots = Vec::with_capacity(max_workers);
 
-        for _ in 0..config.max_workers {
+        for index in 0..max_workers {
             let worker = Worker::new_fifo();
-            stealer_store.push(worker.stealer());
-            workers.push(worker);
+            stealers.push(worker.stealer());
+            slots.push(WorkerSlot {
+                queue: Mutex::new(Some(worker)),
+                woken: Mutex::new(false),
+                condvar: Condvar::new(),
+                stats: metrics.worker(index),
+            });
         }
 
-        let stealers = Arc::new(stealer_store);
-
         let core = Arc::new(SchedulerCore {
-            injector,
-            _stealers: Arc::clone(&stealers),
+            injector: Injector::new(),
+            stealers,
+            slots,
+            sleepers: Mutex::new(Vec::with_capacity(max_workers)),
+            parked: AtomicUsize::new(0),
             metrics: Arc::clone(&metrics),
             shutdown: AtomicBool::new(false),
             timer_wheel: Arc::clone(&timer_wheel),
-            worker_count: AtomicUsize::new(config.max_workers),
-            _config: config,
+            worker_count: AtomicUsize::new(0),
+            config,
         });
 
-        metrics.set_total_workers(config.max_workers);
-        metrics.set_active_workers(config.max_workers);
+        // A weak reference, so the metrics do not keep the scheduler alive.
+        let probe_core = Arc::downgrade(&core);
+        metrics.set_queue_probe(move |local_depths| {
+            probe_core.upgrade().map_or(0, |core| {
+                local_depths.extend(core.stealers.iter().map(Stealer::len));
+                core.injector.len()
+            })
+        });
+
+        for _ in 0..config.min_workers {
+            start_worker(&core);
+        }
+        core.publish_worker_counts();
 
         // Spawn auto-scaling thread
         let autoscale_core = Arc::clone(&core);
@@ -85,15 +148,6 @@ impl TaskScheduler {
             .spawn(move || timer_processor_loop(timer_core))
             .expect("failed to spawn timer processor");
 
-        for (index, worker) in workers.into_iter().enumerate() {
-            let core = Arc::clone(&core);
-            let stealers = Arc::clone(&stealers);
-            thread::Builder::new()
-                .name(format!("otter-task-worker-{}", index))
-                .spawn(move || worker_loop(core, stealers, worker, index))
-                .expect("failed to spawn task worker");
-        }
-
         Self { core }
     }
 
@@ -114,188 +168,364 @@ impl TaskScheduler {
         let join = JoinHandle::new(task.id(), task.join_state(), cancellation_token);
         self.core.metrics.record_spawn();
         self.core.injector.push(task);
+        self.core.notify_work();
         join
     }
 
+    /// Threads currently in the pool, parked ones included
     pub fn get_worker_count(&self) -> usize {
         self.core.worker_count.load(Ordering::Relaxed)
     }
 
+    /// Tasks queued and not yet running: the injector plus every worker's
+    /// local queue
     pub fn get_queue_depth(&self) -> usize {
-        // Estimate queue depth from injector (this is approximate)
-        // crossbeam-deque doesn't expose exact size, so we estimate based on metrics
-        let snapshot = self.core.metrics.snapshot();
-        snapshot.tasks_waiting as usize
+        self.core.queue_depth()
     }
 }
 
-fn worker_loop(
-    core: Arc<SchedulerCore>,
-    stealers: Arc<Vec<Stealer<Task>>>,
-    local: Worker<Task>,
-    index: usize,
-) {
-    let stealers: Vec<_> = stealers
-        .iter()
-        .enumerate()
-        .filter_map(|(i, stealer)| {
-            if i != index {
-                Some(stealer.clone())
-            } else {
-                None
-            }
-        })
-        .collect();
+impl SchedulerCore {
+    fn queue_depth(&self) -> usize {
+        self.injector.len() + self.stealers.iter().map(Stealer::len).sum::<usize>()
+    }
+
+    /// Wake a parked worker, if any, after new work was queued
+    fn notify_work(&self) {
+        // Pairs with the fence in `park`: either the parking worker sees the
+        // queued task, or this load sees the worker on the sleeper list.
+        fence(Ordering::SeqCst);
+        if self.parked.load(Ordering::SeqCst) > 0 {
+            self.wake_one();
+        }
+    }
+
+    fn wake_one(&self) {
+        let Some(index) = self.sleepers.lock().pop() else {
+            return;
+        };
+        self.parked.fetch_sub(1, Ordering::SeqCst);
+        let slot = &self.slots[index];
+        *slot.woken.lock() = true;
+        slot.condvar.notify_one();
+    }
+
+    /// Take `index` off the sleeper list. False when `wake_one` already
+    /// did, and the worker is about to be woken.
+    fn cancel_sleep(&self, index: usize) -> bool {
+        let mut sleepers = self.sleepers.lock();
+        let Some(position) = sleepers.iter().position(|&sleeper| sleeper == index) else {
+            return false;
+        };
+        sleepers.remove(position);
+        self.parked.fetch_sub(1, Ordering::SeqCst);
+        true
+    }
+
+    fn publish_worker_counts(&self) {
+        let total = self.worker_count.load(Ordering::Relaxed);
+        let parked = self.parked.load(Ordering::Relaxed);
+        self.metrics.set_total_workers(total);
+        self.metrics
+            .set_active_workers(total.saturating_sub(parked));
+    }
+}
+
+/// Start a worker in a free slot. Returns false when all slots are in use.
+fn start_worker(core: &Arc<SchedulerCore>) -> bool {
+    for (index, slot) in core.slots.iter().enumerate() {
+        let Some(local) = slot.queue.lock().take() else {
+            continue;
+        };
+        core.worker_count.fetch_add(1, Ordering::SeqCst);
+        slot.stats.set_state(WorkerState::Busy);
+        let worker_core = Arc::clone(core);
+        thread::Builder::new()
+            .name(format!("otter-task-worker-{}", index))
+            .spawn(move || worker_loop(worker_core, local, index))
+            .expect("failed to spawn task worker");
+        return true;
+    }
+    false
+}
+
+fn worker_loop(core: Arc<SchedulerCore>, local: Worker<Task>, index: usize) {
+    bind_worker_shard(index);
+    let stats = Arc::clone(&core.slots[index].stats);
     let backoff = Backoff::new();
-    let mut consecutive_idle = 0;
 
     loop {
         if core.shutdown.load(Ordering::SeqCst) {
             break;
         }
 
-        let queue_depth = local.len();
-        core.metrics
-            .update_worker_info(index, WorkerState::Busy, queue_depth);
-
-        if let Some(task) = local.pop() {
+        if let Some(task) = find_task(&core, &local, index, &stats) {
             backoff.reset();
-            consecutive_idle = 0;
-            // Skip cancelled tasks
-            let task_id = task.id();
-            if task.is_cancelled() {
-                core.metrics.record_completion();
-                cleanup_task_local_storage(task_id);
-                continue;
-            }
-            task.run();
-            core.metrics.record_completion();
-            core.metrics.record_worker_task(index);
-            cleanup_task_local_storage(task_id);
+            stats.set_state(WorkerState::Busy);
+            run_task(&core, task, &stats);
             continue;
         }
 
-        match core.injector.steal_batch_and_pop(&local) {
-            Steal::Success(task) => {
-                backoff.reset();
-                consecutive_idle = 0;
-                // Skip cancelled tasks
-                let task_id = task.id();
-                if task.is_cancelled() {
-                    core.metrics.record_completion();
-                    cleanup_task_local_storage(task_id);
-                    continue;
-                }
-                task.run();
-                core.metrics.record_completion();
-                core.metrics.record_worker_task(index);
-                cleanup_task_local_storage(task_id);
-                continue;
-            }
-            Steal::Retry => {
-                backoff.spin();
-                continue;
-            }
-            Steal::Empty => {}
+        // Nothing to do: spin and yield for a while, then park.
+        if !backoff.is_completed() {
+            stats.set_state(WorkerState::Idle);
+            backoff.snooze();
+            continue;
         }
+        if !park(&core, index) {
+            break;
+        }
+        backoff.reset();
+    }
 
-        let mut stolen = None;
-        for stealer in &stealers {
-            match stealer.steal() {
-                Steal::Success(task) => {
-                    stolen = Some(task);
-                    break;
-                }
-                Steal::Retry => {
-                    stolen = None;
+    // Retiring; hand the deque back for the next worker in this slot.
+    while let Some(task) = local.pop() {
+        core.injector.push(task);
+    }
+    stats.set_state(WorkerState::Retired);
+    *core.slots[index].queue.lock() = Some(local);
+    core.publish_worker_counts();
+}
+
+fn find_task(
+    core: &SchedulerCore,
+    local: &Worker<Task>,
+    index: usize,
+    stats: &WorkerStats,
+) -> Option<Task> {
+    if let Some(task) = local.pop() {
+        return Some(task);
+    }
+
+    if let Some(task) = retry_steal(|| core.injector.steal_batch_and_pop(local)) {
+        // The batch left more work here than one worker should hold while
+        // others sleep; let a parked worker steal some of it.
+        if !local.is_empty() {
+            core.notify_work();
+        }
+        return Some(task);
+    }
+
+    // Start with the next slot, so idle workers spread over their peers.
+    let slots = core.stealers.len();
+    (1..slots)
+        .map(|offset| &core.stealers[(index + offset) % slots])
+        .find_map(|stealer| retry_steal(|| stealer.steal_batch_and_pop(local)))
+        .inspect(|_| stats.record_steals(1 + local.len() as u64))
+}
+
+/// Steal until the queue gives a definite answer
+fn retry_steal(mut steal: impl FnMut() -> Steal<Task>) -> Option<Task> {
+    std::iter::repeat_with(&mut steal)
+        .find(|attempt| !attempt.is_retry())
+        .and_then(Steal::success)
+}
+
+fn run_task(core: &SchedulerCore, task: Task, stats: &WorkerStats) {
+    let task_id = task.id();
+    // Skip cancelled tasks
+    if task.is_cancelled() {
+        core.metrics.record_completion();
+        cleanup_task_local_storage(task_id);
+        return;
+    }
+    task.run();
+    core.metrics.record_completion();
+    stats.record_task();
+    cleanup_task_local_storage(task_id);
+}
+
+/// Park until work arrives. Returns false when the worker should retire:
+/// it stayed idle for `idle_timeout` and the pool is above `min_workers`.
+fn park(core: &SchedulerCore, index: usize) -> bool {
+    let slot = &core.slots[index];
+    slot.stats.set_state(WorkerState::Parked);
+    loop {
+        core.sleepers.lock().push(index);
+        core.parked.fetch_add(1, Ordering::SeqCst);
+        // Pairs with the fence in `notify_work`.
+        fence(Ordering::SeqCst);
+        {
+            let deadline = Instant::now() + core.config.idle_timeout;
+            let mut woken = slot.woken.lock();
+            core.publish_worker_counts();
+            while !*woken && core.injector.is_empty() {
+                if slot.condvar.wait_until(&mut woken, deadline).timed_out() {
                     break;
                 }
-                Steal::Empty => continue,
+            }
+            if std::mem::take(&mut *woken) {
+                return true;
             }
         }
-
-        if let Some(task) = stolen {
-            backoff.reset();
-            consecutive_idle = 0;
-            // Skip cancelled tasks
-            let task_id = task.id();
-            if task.is_cancelled() {
-                core.metrics.record_completion();
-                cleanup_task_local_storage(task_id);
-                continue;
+        if !core.cancel_sleep(index) {
+            // `wake_one` took us off the list after the wait ended; consume
+            // its wakeup so the next park does not return at once.
+            let mut woken = slot.woken.lock();
+            while !std::mem::take(&mut *woken) {
+                slot.condvar.wait(&mut woken);
             }
-            task.run();
-            core.metrics.record_completion();
-            core.metrics.record_worker_task(index);
-            cleanup_task_local_storage(task_id);
-            continue;
+            return true;
         }
-
-        // Nothing to do
-        consecutive_idle += 1;
-        let queue_depth = local.len();
-        if consecutive_idle > 10 {
-            core.metrics
-                .update_worker_info(index, WorkerState::Idle, queue_depth);
-        } else {
-            core.metrics
-                .update_worker_info(index, WorkerState::Parked, queue_depth);
+        if !core.injector.is_empty() {
+            return true;
         }
-
-        // Check for timer wakeups and yield slightly.
-        if backoff.is_completed() {
-            // Process timers periodically
-            core.timer_wheel.process_expired();
-            thread::sleep(Duration::from_micros(100));
-        } else {
-            backoff.snooze();
+        let retired = core
+            .worker_count
+            .fetch_update(Ordering::SeqCst, Ordering::SeqCst, |count| {
+                (count > core.config.min_workers).then(|| count - 1)
+            })
+            .is_ok();
+        if retired {
+            return false;
         }
     }
 }
 
 fn autoscaler_loop(core: Arc<SchedulerCore>) {
+    let mut backlogged_samples = 0;
     loop {
         if core.shutdown.load(Ordering::SeqCst) {
             break;
         }
 
-        // Check metrics every 2 seconds
-        thread::sleep(Duration::from_secs(2));
+        thread::sleep(SCALE_INTERVAL);
 
-        let snapshot = core.metrics.snapshot();
-        let _current_workers = core.worker_count.load(Ordering::Relaxed);
-        let _queue_depth = snapshot.tasks_waiting;
-        let active_workers = snapshot
-            .worker_infos
-            .iter()
-            .filter(|w| w.state == WorkerState::Busy)
-            .count();
-
-        // Simple auto-scaling logic:
-        // - If queue depth > 2x workers and we haven't hit max, consider scaling up
-        // - If most workers are idle for extended period, consider scaling down
-        // Note: Actual worker addition/removal is complex with crossbeam-deque
-        // For now, we just track and report the metrics
+        // Tasks sitting in a busy worker's deque count too: that worker
+        // may be blocked, and only a peer can steal them.
+        let backlog = core.queue_depth();
+        if backlog == 0 {
+            backlogged_samples = 0;
+        } else if core.parked.load(Ordering::SeqCst) > 0 {
+            // Workers are available; make sure one is awake.
+            core.wake_one();
+        } else {
+            backlogged_samples += 1;
+            if backlogged_samples >= SUSTAINED_BACKLOG_SAMPLES {
+                // Every worker is busy and the queue is not draining: start
+                // up to one worker per queued task.
+                for _ in 0..backlog {
+                    if !start_worker(&core) {
+                        break;
+                    }
+                }
+                backlogged_samples = 0;
+            }
+        }
 
-        // Update active worker count
-        core.metrics.set_active_workers(active_workers);
+        core.publish_worker_counts();
     }
 }
-
 fn timer_processor_loop(core: Arc<SchedulerCore>) {
     loop {
         if core.shutdown.load(Ordering::SeqCst) {
             break;
         }
 
-        // Process expired timers
-        if let Some(next_timeout) = core.timer_wheel.process_expired() {
-            // Sleep until the next timer expires or a short timeout
-            let sleep_duration = next_timeout.min(Duration::from_millis(100));
-            thread::sleep(sleep_duration);
-        } else {
-            // No timers scheduled, sleep briefly
-            thread::sleep(Duration::from_millis(100));
+        // Fire due timers, then sleep until the next bucket is due or an
+        // earlier timer is scheduled
+        core.timer_wheel.process_expired();
+        core.timer_wheel.wait_for_next_bucket();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::Barrier;
+    use std::sync::mpsc;
+    use std::time::Instant;
+
+    fn wait_until(what: &str, condition: impl Fn() -> bool) {
+        let start = Instant::now();
+        while !condition() {
+            assert!(
+                start.elapsed() < Duration::from_secs(10),
+                "timed out waiting for {what}"
+            );
+            thread::sleep(Duration::from_millis(5));
+        }
+    }
+
+    #[test]
+    fn pool_grows_under_backlog_and_retires_when_idle() {
+        let scheduler = TaskScheduler::new(SchedulerConfig {
+            max_workers: 4,
+            min_workers: 1,
+            idle_timeout: Duration::from_millis(50),
+        });
+        assert_eq!(scheduler.get_worker_count(), 1);
+
+        // Each task waits for all the others, so they only finish once four
+        // workers run at the same time.
+        let barrier = Arc::new(Barrier::new(4));
+        let handles: Vec<_> = (0..4)
+            .map(|_| {
+                let barrier = Arc::clone(&barrier);
+                scheduler.spawn_fn(None, move || {
+                    barrier.wait();
+                })
+            })
+            .collect();
+        for handle in handles {
+            handle.join();
+        }
+        assert_eq!(scheduler.get_worker_count(), 4);
+
+        wait_until("idle workers to retire", || {
+            scheduler.get_worker_count() == 1
+        });
+        let snapshot = scheduler.metrics().snapshot();
+        let retired = snapshot
+            .worker_infos
+            .iter()
+            .filter(|info| info.state == WorkerState::Retired)
+            .count();
+        assert_eq!(retired, 3);
+        assert_eq!(
+            snapshot
+                .worker_infos
+                .iter()
+                .map(|info| info.tasks_processed)
+                .sum::<u64>(),
+            4
+        );
+
+        // A parked worker wakes up for new work.
+        let (sender, receiver) = mpsc::channel();
+        scheduler.spawn_fn(None, move || sender.send(7).unwrap());
+        assert_eq!(receiver.recv_timeout(Duration::from_secs(5)), Ok(7));
+    }
+
+    #[test]
+    fn queue_depth_is_exact() {
+        let scheduler = TaskScheduler::new(SchedulerConfig {
+            max_workers: 1,
+            min_workers: 1,
+            idle_timeout: Duration::from_secs(5),
+        });
+        let (release, blocked) = mpsc::channel::<()>();
+        let (started, running) = mpsc::channel();
+        scheduler.spawn_fn(None, move || {
+            started.send(()).unwrap();
+            blocked.recv().unwrap();
+        });
+        running.recv().unwrap();
+
+        let handles: Vec<_> = (0..10).map(|_| scheduler.spawn_fn(None, || {})).collect();
+        assert_eq!(scheduler.get_queue_depth(), 10);
+        let snapshot = scheduler.metrics().snapshot();
+        let local: u64 = snapshot
+            .worker_infos
+            .iter()
+            .map(|info| info.queue_depth as u64)
+            .sum();
+        assert_eq!(snapshot.injector_depth + local, 10);
+        assert_eq!(scheduler.metrics().get_total_queue_depth(), 10);
+
+        release.send(()).unwrap();
+        for handle in handles {
+            handle.join();
         }
+        assert_eq!(scheduler.get_queue_depth(), 0);
     }
 }
@@ -2,106 +2,397 @@
 //!
 //! Provides a timer wheel that integrates with the task scheduler to wake
 //! tasks after a specified delay without blocking OS threads.
-
-use std::cmp::Ordering;
-use std::collections::BinaryHeap;
-use std::sync::Mutex;
+//!
+//! Time is counted in one millisecond ticks from the wheel's creation.
+//! Each shard is a hierarchical hashed wheel: six levels of 64 slots, where
+//! a level-`n` slot spans `64^n` ticks. A timer goes into the lowest level
+//! whose current window contains its deadline, and moves down a level each
+//! time the wheel reaches its slot, so inserting and cancelling are O(1)
+//! and expiry only visits occupied slots. Timers in a slot form an
+//! intrusive list over the shard's node slab.
+//!
+//! There is one shard per scheduler worker. A worker registers timers on
+//! its own shard; other threads are spread round-robin. The timer thread
+//! advances every shard and then sleeps until the earliest occupied bucket
+//! is due, or until someone schedules an earlier timer.
+
+use crossbeam_utils::CachePadded;
+use parking_lot::{Condvar, Mutex};
+use std::cell::Cell;
+use std::sync::atomic::{AtomicU64, AtomicUsize, Ordering};
 use std::task::Waker;
 use std::time::{Duration, Instant};
 
-/// Timer entry that stores when a waker should be notified.
+/// Length of a tick
+const TICK_NANOS: u64 = 1_000_000;
+const SLOT_BITS: u32 = 6;
+const SLOTS: usize = 1 << SLOT_BITS;
+const LEVELS: usize = 6;
+/// Ticks covered by the whole wheel, a little over two years. A timer
+/// further out is placed at the far end and reinserted when it gets there.
+const MAX_SPAN: u64 = 1 << (SLOT_BITS as usize * LEVELS);
+const NIL: u32 = u32::MAX;
+
+/// Identifies a scheduled timer for [`TimerWheel::cancel`]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct TimerId {
+    shard: u32,
+    index: u32,
+    generation: u32,
+}
+
 #[derive(Debug)]
-struct TimerEntry {
-    deadline: Instant,
-    waker: Waker,
+struct Node {
+    /// Deadline tick; may lie past the slot when it was beyond `MAX_SPAN`
+    when: u64,
+    /// `None` while the node is on the free list
+    waker: Option<Waker>,
+    prev: u32,
+    next: u32,
+    /// Level and slot of the list holding the node
+    bucket: u16,
+    generation: u32,
 }
 
-impl PartialEq for TimerEntry {
-    fn eq(&self, other: &Self) -> bool {
-        self.deadline == other.deadline
-    }
+#[derive(Debug)]
+struct Level {
+    /// Bit `n` is set when slot `n` holds at least one timer
+    occupied: u64,
+    heads: [u32; SLOTS],
 }
 
-impl Eq for TimerEntry {}
+/// One hierarchical wheel. `elapsed` is the last tick it was advanced to;
+/// every timer in it is due later than that.
+#[derive(Debug)]
+struct Shard {
+    elapsed: u64,
+    levels: [Level; LEVELS],
+    nodes: Vec<Node>,
+    free: u32,
+    len: usize,
+}
 
-impl PartialOrd for TimerEntry {
-    fn partial_cmp(&self, other: &Self) -> Option<Ordering> {
-        Some(self.cmp(other))
+impl Shard {
+    fn new() -> Self {
+        Self {
+            elapsed: 0,
+            levels: std::array::from_fn(|_| Level {
+                occupied: 0,
+                heads: [NIL; SLOTS],
+            }),
+            nodes: Vec::new(),
+            free: NIL,
+            len: 0,
+        }
+    }
+
+    /// Add a timer due at tick `when`. A deadline the wheel has already
+    /// passed is moved to the next tick.
+    fn insert(&mut self, when: u64, waker: Waker) -> (u32, u32) {
+        let when = when.max(self.elapsed + 1);
+        let index = if self.free != NIL {
+            let index = self.free;
+            self.free = self.nodes[index as usize].next;
+            let node = &mut self.nodes[index as usize];
+            node.when = when;
+            node.waker = Some(waker);
+            index
+        } else {
+            self.nodes.push(Node {
+                when,
+                waker: Some(waker),
+                prev: NIL,
+                next: NIL,
+                bucket: 0,
+                generation: 0,
+            });
+            (self.nodes.len() - 1) as u32
+        };
+        self.link(index);
+        self.len += 1;
+        (index, self.nodes[index as usize].generation)
+    }
+
+    fn cancel(&mut self, index: u32, generation: u32) -> bool {
+        match self.nodes.get(index as usize) {
+            Some(node) if node.generation == generation && node.waker.is_some() => {
+                self.unlink(index);
+                self.release(index);
+                true
+            }
+            _ => false,
+        }
+    }
+
+    /// Put a node at the head of the slot its deadline maps to, relative to
+    /// `elapsed`
+    fn link(&mut self, index: u32) {
+        let when = self.nodes[index as usize]
+            .when
+            .min(self.elapsed + MAX_SPAN - 1);
+        // The highest bit where the deadline differs from now picks the
+        // level; the low six bits always belong to level 0.
+        let differing = (self.elapsed ^ when) | (SLOTS as u64 - 1);
+        let level = ((63 - differing.leading_zeros()) / SLOT_BITS).min(LEVELS as u32 - 1) as usize;
+        let slot = ((when >> (level as u32 * SLOT_BITS)) as usize) & (SLOTS - 1);
+        let head = self.levels[level].heads[slot];
+        let node = &mut self.nodes[index as usize];
+        node.bucket = (level * SLOTS + slot) as u16;
+        node.prev = NIL;
+        node.next = head;
+        if head != NIL {
+            self.nodes[head as usize].prev = index;
+        }
+        self.levels[level].heads[slot] = index;
+        self.levels[level].occupied |= 1 << slot;
+    }
+
+    fn unlink(&mut self, index: u32) {
+        let (prev, next, bucket) = {
+            let node = &self.nodes[index as usize];
+            (node.prev, node.next, node.bucket as usize)
+        };
+        let (level, slot) = (bucket / SLOTS, bucket % SLOTS);
+        if prev == NIL {
+            self.levels[level].heads[slot] = next;
+            if next == NIL {
+                self.levels[level].occupied &= !(1 << slot);
+            }
+        } else {
+            self.nodes[prev as usize].next = next;
+        }
+        if next != NIL {
+            self.nodes[next as usize].prev = prev;
+        }
     }
-}
 
-impl Ord for TimerEntry {
-    fn cmp(&self, other: &Self) -> Ordering {
-        other.deadline.cmp(&self.deadline)
+    fn release(&mut self, index: u32) -> Option<Waker> {
+        let node = &mut self.nodes[index as usize];
+        node.generation = node.generation.wrapping_add(1);
+        node.next = self.free;
+        self.free = index;
+        self.len -= 1;
+        node.waker.take()
     }
+
+    /// The earliest occupied slot as `(level, slot, first tick)`. Lower
+    /// levels cover earlier ticks, so the first occupied level wins.
+    fn next_bucket(&self) -> Option<(usize, usize, u64)> {
+        let level = self.levels.iter().position(|level| level.occupied != 0)?;
+        let shift = level as u32 * SLOT_BITS;
+        let current = ((self.elapsed >> shift) as usize) & (SLOTS - 1);
+        let occupied = self.levels[level].occupied.rotate_right(current as u32);
+        let slot = (current + occupied.trailing_zeros() as usize) & (SLOTS - 1);
+        let level_span = (SLOTS as u64) << shift;
+        let mut start = (self.elapsed & !(level_span - 1)) + ((slot as u64) << shift);
+        if start <= self.elapsed {
+            // Only a far-out timer on the top level lands behind the
+            // current slot; it belongs to the next turn of the wheel.
+            start += level_span;
+        }
+        Some((level, slot, start))
+    }
+
+    /// Advance to tick `now`, pushing the wakers of every timer due by then
+    fn advance(&mut self, now: u64, expired: &mut Vec<Waker>) {
+        while let Some((level, slot, start)) = self.next_bucket() {
+            if start > now {
+                break;
+            }
+            self.elapsed = self.elapsed.max(start);
+            let mut index = std::mem::replace(&mut self.levels[level].heads[slot], NIL);
+            self.levels[level].occupied &= !(1 << slot);
+            while index != NIL {
+                let next = self.nodes[index as usize].next;
+                if self.nodes[index as usize].when <= now {
+                    expired.extend(self.release(index));
+                } else {
+                    // Cascades to a lower level, or further along for a
+                    // timer past `MAX_SPAN`.
+                    self.link(index);
+                }
+                index = next;
+            }
+        }
+        self.elapsed = self.elapsed.max(now);
+    }
+
+    fn clear(&mut self) {
+        for level in &mut self.levels {
+            level.occupied = 0;
+            level.heads = [NIL; SLOTS];
+        }
+        for index in 0..self.nodes.len() as u32 {
+            if self.nodes[index as usize].waker.is_some() {
+                self.release(index);
+            }
+        }
+    }
+}
+
+thread_local! {
+    /// Shard the current thread registers timers on, set for scheduler
+    /// workers and assigned on first use elsewhere
+    static HOME_SHARD: Cell<usize> = const { Cell::new(usize::MAX) };
+}
+
+/// Route the current thread's timers to shard `index`
+pub(super) fn bind_worker_shard(index: usize) {
+    HOME_SHARD.with(|shard| shard.set(index));
 }
 
 /// Timer wheel for managing delayed wakeups.
 #[derive(Debug)]
 pub struct TimerWheel {
-    timers: Mutex<BinaryHeap<TimerEntry>>,
+    shards: Box<[CachePadded<Mutex<Shard>>]>,
+    start: Instant,
+    next_shard: AtomicUsize,
+    /// Earliest tick the timer thread must wake for, `u64::MAX` for none.
+    /// Lowered by every insert and rebuilt by `process_expired`.
+    next_wake: AtomicU64,
+    sleep: Mutex<()>,
+    wake: Condvar,
 }
 
 impl TimerWheel {
     pub fn new() -> Self {
+        let shards = std::thread::available_parallelism()
+            .map(|n| n.get())
+            .unwrap_or(4);
+        Self::with_shards(shards)
+    }
+
+    pub fn with_shards(shards: usize) -> Self {
         Self {
-            timers: Mutex::new(BinaryHeap::new()),
+            shards: (0..shards.max(1))
+                .map(|_| CachePadded::new(Mutex::new(Shard::new())))
+                .collect(),
+            start: Instant::now(),
+            next_shard: AtomicUsize::new(0),
+            next_wake: AtomicU64::new(u64::MAX),
+            sleep: Mutex::new(()),
+            wake: Condvar::new(),
         }
     }
 
     /// Schedule a waker to be notified after the specified duration.
-    pub fn schedule_wakeup(&self, delay: Duration, waker: Waker) {
-        let deadline = Instant::now() + delay;
-        let entry = TimerEntry { deadline, waker };
-        self.timers.lock().unwrap().push(entry);
+    pub fn schedule_wakeup(&self, delay: Duration, waker: Waker) -> TimerId {
+        self.schedule_at(Instant::now() + delay, waker)
     }
 
     /// Schedule a waker to be notified at a specific instant.
-    pub fn schedule_at(&self, deadline: Instant, waker: Waker) {
-        let entry = TimerEntry { deadline, waker };
-        self.timers.lock().unwrap().push(entry);
+    pub fn schedule_at(&self, deadline: Instant, waker: Waker) -> TimerId {
+        // Round up, so a timer never fires before its deadline.
+        let nanos = deadline.saturating_duration_since(self.start).as_nanos();
+        let when = nanos.div_ceil(TICK_NANOS as u128).min(u64::MAX as u128 / 2) as u64;
+        let shard = self.home_shard();
+        let (index, generation) = self.shards[shard].lock().insert(when, waker);
+        if when < self.next_wake.fetch_min(when, Ordering::SeqCst) {
+            // Taking the lock orders this notify after the timer thread's
+            // check, so it cannot miss the earlier deadline.
+            let _guard = self.sleep.lock();
+            self.wake.notify_one();
+        }
+        TimerId {
+            shard: shard as u32,
+            index,
+            generation,
+        }
+    }
+
+    /// Cancel a pending timer, dropping its waker. Returns false when it
+    /// already fired or was cancelled.
+    pub fn cancel(&self, id: TimerId) -> bool {
+        self.shards
+            .get(id.shard as usize)
+            .is_some_and(|shard| shard.lock().cancel(id.index, id.generation))
     }
 
     /// Process all expired timers, waking their associated wakers.
     /// Returns the duration until the next timer expires, or None if no timers are scheduled.
     pub fn process_expired(&self) -> Option<Duration> {
-        let mut timers = self.timers.lock().unwrap();
-        let now = Instant::now();
-        let mut next_deadline = None;
-
-        while let Some(entry) = timers.peek() {
-            if entry.deadline <= now {
-                let entry = timers.pop().unwrap();
-                entry.waker.wake();
-            } else {
-                next_deadline = Some(entry.deadline);
-                break;
+        let now = self.now_tick();
+        let mut expired = Vec::new();
+        // Reset before scanning: a timer added to a shard after its scan
+        // lowers `next_wake` itself.
+        self.next_wake.store(u64::MAX, Ordering::SeqCst);
+        let mut next = u64::MAX;
+        for shard in self.shards.iter() {
+            let mut shard = shard.lock();
+            shard.advance(now, &mut expired);
+            if let Some((_, _, start)) = shard.next_bucket() {
+                next = next.min(start);
             }
         }
-
-        next_deadline.map(|deadline| {
-            let delay = deadline.duration_since(now);
-            delay.max(Duration::from_millis(0))
-        })
+        self.next_wake.fetch_min(next, Ordering::SeqCst);
+        for waker in expired {
+            waker.wake();
+        }
+        (next != u64::MAX).then(|| self.until_tick(next))
     }
 
     /// Get the duration until the next timer expires, or None if no timers are scheduled.
     pub fn next_timeout(&self) -> Option<Duration> {
-        let timers = self.timers.lock().unwrap();
-        timers.peek().map(|entry| {
-            let delay = entry.deadline.duration_since(Instant::now());
-            delay.max(Duration::from_millis(0))
-        })
+        self.shards
+            .iter()
+            .filter_map(|shard| shard.lock().next_bucket().map(|(_, _, start)| start))
+            .min()
+            .map(|tick| self.until_tick(tick))
+    }
+
+    /// Block until the earliest pending bucket is due, or until a timer
+    /// earlier than that is scheduled. Used by the scheduler's timer thread
+    /// between calls to `process_expired`.
+    pub fn wait_for_next_bucket(&self) {
+        let mut guard = self.sleep.lock();
+        match self.next_wake.load(Ordering::SeqCst) {
+            u64::MAX => self.wake.wait(&mut guard),
+            tick => {
+                let deadline = self.instant_of(tick);
+                if deadline > Instant::now() {
+                    self.wake.wait_until(&mut guard, deadline);
+                }
+            }
+        }
     }
 
     /// Check if there are any pending timers.
     pub fn has_pending(&self) -> bool {
-        !self.timers.lock().unwrap().is_empty()
+        self.shards.iter().any(|shard| shard.lock().len > 0)
     }
 
     /// Clear all pending timers.
     pub fn clear(&self) {
-        self.timers.lock().unwrap().clear();
+        for shard in self.shards.iter() {
+            shard.lock().clear();
+        }
+    }
+
+    fn home_shard(&self) -> usize {
+        let index = HOME_SHARD.with(|shard| {
+            if shard.get() == usize::MAX {
+                shard.set(self.next_shard.fetch_add(1, Ordering::Relaxed));
+            }
+            shard.get()
+        });
+        index % self.shards.len()
+    }
+
+    fn now_tick(&self) -> u64 {
+        (self.start.elapsed().as_nanos() / TICK_NANOS as u128) as u64
+    }
+
+    fn instant_of(&self, tick: u64) -> Instant {
+        let offset = Duration::from_nanos(tick.saturating_mul(TICK_NANOS));
+        // Far enough out that the exact instant does not matter.
+        self.start
+            .checked_add(offset)
+            .unwrap_or_else(|| Instant::now() + Duration::from_secs(86_400))
+    }
+
+    fn until_tick(&self, tick: u64) -> Duration {
+        self.instant_of(tick)
+            .saturating_duration_since(Instant::now())
     }
 }
 
@@ -207,4 +498,210 @@ mod tests {
         assert!(timeout <= Duration::from_millis(100));
         assert!(timeout >= Duration::from_millis(50));
     }
+
+    /// Waker that records which timer fired, for driving a `Shard` by hand
+    struct Fired {
+        id: u64,
+        log: Arc<Mutex<Vec<u64>>>,
+    }
+
+    impl std::task::Wake for Fired {
+        fn wake(self: Arc<Self>) {
+            self.log.lock().push(self.id);
+        }
+    }
+
+    fn fired_waker(id: u64, log: &Arc<Mutex<Vec<u64>>>) -> Waker {
+        Waker::from(Arc::new(Fired {
+            id,
+            log: Arc::clone(log),
+        }))
+    }
+
+    #[test]
+    fn test_shard_fires_each_timer_on_its_tick() {
+        let log = Arc::new(Mutex::new(Vec::new()));
+        let mut shard = Shard::new();
+        // Deadlines on every level boundary, plus one past the whole wheel.
+        let deadlines = [
+            1,
+            63,
+            64,
+            65,
+            4095,
+            4096,
+            262_143,
+            262_144,
+            300_007,
+            MAX_SPAN + 7,
+        ];
+        for &when in deadlines.iter().rev() {
+            shard.insert(when, fired_waker(when, &log));
+        }
+
+        let mut expired = Vec::new();
+        for &when in &deadlines {
+            // Stop one tick short, then step onto the deadline.
+            shard.advance(when - 1, &mut expired);
+            assert!(expired.is_empty(), "timer {when} fired early");
+            shard.advance(when, &mut expired);
+            assert_eq!(expired.len(), 1, "timer {when} did not fire on time");
+            expired.drain(..).for_each(Waker::wake);
+        }
+        assert_eq!(*log.lock(), deadlines);
+        assert_eq!(shard.len, 0);
+        assert!(shard.next_bucket().is_none());
+    }
+
+    #[test]
+    fn test_shard_cancel_and_reuse() {
+        let log = Arc::new(Mutex::new(Vec::new()));
+        let mut shard = Shard::new();
+        let ids: Vec<_> = (0..200)
+            .map(|id| shard.insert(10 + id * 37, fired_waker(id, &log)))
+            .collect();
+        for (id, &(index, generation)) in ids.iter().enumerate() {
+            if id % 2 == 1 {
+                assert!(shard.cancel(index, generation));
+                assert!(!shard.cancel(index, generation));
+            }
+        }
+        // Freed nodes are reused with a new generation.
+        let (index, generation) = shard.insert(5, fired_waker(1000, &log));
+        assert!(!shard.cancel(ids[199].0, ids[199].1));
+        assert_eq!((index, generation), (ids[199].0, ids[199].1 + 1));
+
+        let mut expired = Vec::new();
+        shard.advance(10_000, &mut expired);
+        expired.into_iter().for_each(Waker::wake);
+        let mut fired = log.lock().clone();
+        fired.sort_unstable();
+        let expected: Vec<u64> = (0..200).step_by(2).chain([1000]).collect();
+        assert_eq!(fired, expected);
+        assert_eq!(shard.len, 0);
+    }
+
+    #[test]
+    fn test_cancelled_timer_does_not_fire() {
+        let wheel = TimerWheel::with_shards(2);
+        let flag = Arc::new(AtomicBool::new(false));
+        let id = wheel.schedule_wakeup(
+            Duration::from_millis(5),
+            create_test_waker(Arc::clone(&flag)),
+        );
+        assert!(wheel.has_pending());
+        assert!(wheel.cancel(id));
+        assert!(!wheel.has_pending());
+        std::thread::sleep(Duration::from_millis(10));
+        assert_eq!(wheel.process_expired(), None);
+        assert!(!flag.load(Ordering::SeqCst));
+    }
+
+    #[test]
+    fn test_wait_for_next_bucket_wakes_for_earlier_timer() {
+        let wheel = Arc::new(TimerWheel::with_shards(2));
+        let flag = Arc::new(AtomicBool::new(false));
+        let start = Instant::now();
+        let timer_thread = {
+            let wheel = Arc::clone(&wheel);
+            let flag = Arc::clone(&flag);
+            std::thread::spawn(move || {
+                loop {
+                    wheel.process_expired();
+                    if flag.load(Ordering::SeqCst) {
+                        break;
+                    }
+                    wheel.wait_for_next_bucket();
+                }
+            })
+        };
+        // The thread is parked with nothing pending; a far timer must not
+        // delay the near one scheduled after it.
+        std::thread::sleep(Duration::from_millis(20));
+        wheel.schedule_wakeup(
+            Duration::from_secs(60),
+            create_test_waker(Arc::new(AtomicBool::new(false))),
+        );
+        wheel.schedule_wakeup(
+            Duration::from_millis(30),
+            create_test_waker(Arc::clone(&flag)),
+        );
+        timer_thread.join().unwrap();
+        assert!(start.elapsed() < Duration::from_secs(5));
+        assert!(start.elapsed() >= Duration::from_millis(50));
+    }
+
+    // Run with: cargo test -p otterc_runtime --release timer_wheel_benchmark -- --ignored --nocapture
+    #[test]
+    #[ignore]
+    fn timer_wheel_benchmark() {
+        use std::collections::BinaryHeap;
+
+        const TIMERS: u64 = 100_000;
+        const THREADS: u64 = 4;
+
+        let noop = Waker::noop();
+        crate::benchmark::Benchmark::new(format!(
+            "BinaryHeap, {TIMERS} timeouts from {THREADS} threads"
+        ))
+        .warmup(1)
+        .iterations(5)
+        .run_and_print(|| {
+            // The previous design: one global heap, ordered by deadline.
+            let timers = Arc::new(std::sync::Mutex::new((BinaryHeap::new(), Vec::new())));
+            let threads: Vec<_> = (0..THREADS)
+                .map(|thread| {
+                    let timers = Arc::clone(&timers);
+                    std::thread::spawn(move || {
+                        for timer in 0..TIMERS / THREADS {
+                            let when = 1 + (timer * 7919 + thread) % 30_000;
+                            let (heap, wakers) = &mut *timers.lock().unwrap();
+                            heap.push(std::cmp::Reverse((when, wakers.len())));
+                            wakers.push(Some(noop.clone()));
+                        }
+                    })
+                })
+                .collect();
+            threads.into_iter().for_each(|t| t.join().unwrap());
+            let (heap, wakers) = &mut *timers.lock().unwrap();
+            for now in (0..=30_000).step_by(10) {
+                while heap.peek().is_some_and(|top| top.0.0 <= now) {
+                    let std::cmp::Reverse((_, index)) = heap.pop().unwrap();
+                    wakers[index].take().unwrap().wake();
+                }
+            }
+        });
+
+        crate::benchmark::Benchmark::new(format!(
+            "TimerWheel, {TIMERS} timeouts from {THREADS} threads"
+        ))
+        .warmup(1)
+        .iterations(5)
+        .run_and_print(|| {
+            let wheel = Arc::new(TimerWheel::with_shards(THREADS as usize));
+            let threads: Vec<_> = (0..THREADS)
+                .map(|thread| {
+                    let wheel = Arc::clone(&wheel);
+                    std::thread::spawn(move || {
+                        bind_worker_shard(thread as usize);
+                        for timer in 0..TIMERS / THREADS {
+                            let when = 1 + (timer * 7919 + thread) % 30_000;
+                            wheel.schedule_at(
+                                wheel.start + Duration::from_millis(when),
+                                noop.clone(),
+                            );
+                        }
+                    })
+                })
+                .collect();
+            threads.into_iter().for_each(|t| t.join().unwrap());
+            let mut expired = Vec::new();
+            for now in (0..=30_000).step_by(10) {
+                for shard in wheel.shards.iter() {
+                    shard.lock().advance(now, &mut expired);
+                }
+                expired.drain(..).for_each(Waker::wake);
+            }
+        });
+    }
 }
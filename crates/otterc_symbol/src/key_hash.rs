@@ -0,0 +1,54 @@
+//! Hash of runtime map keys
+//!
+//! The runtime's maps and the compiler share this function: the compiler
+//! hashes string-literal keys while generating code and passes the result to
+//! the `<prehashed>` map builtins, which then skip hashing at run time.
+//! Changing it changes the ABI between compiled programs and the runtime.
+//!
+//! The seed is fixed: a compiler and a runtime library from different builds
+//! must agree on every hash, and builds must stay reproducible. The hash is
+//! therefore no defence against keys chosen to collide.
+
+const SEED: u64 = 0x243f_6a88_85a3_08d3;
+const MULTIPLIER: u64 = 0xf135_7aea_2e62_a9c5;
+
+/// 64-bit hash of `key`, processed a little-endian word at a time
+pub fn hash_map_key(key: &[u8]) -> u64 {
+    let mut hash = SEED ^ (key.len() as u64).wrapping_mul(MULTIPLIER);
+    let mut words = key.chunks_exact(8);
+    for word in &mut words {
+        let mut bytes = [0u8; 8];
+        bytes.copy_from_slice(word);
+        hash = mix(hash, u64::from_le_bytes(bytes));
+    }
+    let tail = words.remainder();
+    if !tail.is_empty() {
+        let mut bytes = [0u8; 8];
+        bytes[..tail.len()].copy_from_slice(tail);
+        hash = mix(hash, u64::from_le_bytes(bytes));
+    }
+    // Final avalanche, so the low bits used for bucket selection depend on
+    // every input byte.
+    hash ^= hash >> 32;
+    hash = hash.wrapping_mul(MULTIPLIER);
+    hash ^ (hash >> 29)
+}
+
+fn mix(hash: u64, word: u64) -> u64 {
+    (hash ^ word).wrapping_mul(MULTIPLIER).rotate_left(26)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_hash_is_stable_and_length_sensitive() {
+        // Compiled programs embed these values; they must never change.
+        assert_eq!(hash_map_key(b""), 0x5f21_6a8e_6210_9763);
+        assert_eq!(hash_map_key(b"name"), 0x2aec_840e_82a2_5dd5);
+        assert_ne!(hash_map_key(b"a"), hash_map_key(b"a\0"));
+        assert_ne!(hash_map_key(b"name"), hash_map_key(b"eman"));
+        assert_ne!(hash_map_key(b"12345678"), hash_map_key(b"123456781"));
+    }
+}
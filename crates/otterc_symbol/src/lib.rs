@@ -1 +1,2 @@
+pub mod key_hash;
 pub mod registry;
@@ -83,6 +83,10 @@ pub struct OtterCli {
     /// Disable cache for this compilation.
     no_cache: bool,
 
+    #[arg(long, global = true)]
+    /// Reuse unchanged per-unit object code across builds; only backend emission is skipped (experimental).
+    object_cache: bool,
+
     #[arg(long, global = true, value_name = "list")]
     /// Enable experimental language features (comma-separated names or use OTTER_FEATURES env var).
     features: Option<String>,
@@ -409,8 +413,9 @@ pub fn compile_pipeline(
     source: &str,
     settings: &CompilationSettings,
 ) -> Result<CompilationStage> {
-    let mut cache_manager = CacheManager::new();
     let cache_options = settings.cache_build_options();
+    let mut cache_manager = CacheManager::with_options(&cache_options);
+    let compiler_version = compiler_build_id();
     let mut profiler = Profiler::new();
     let source_id = path.display().to_string();
     let source_dir = path.parent().unwrap_or(Path::new(".")).to_path_buf();
@@ -423,7 +428,7 @@ pub fn compile_pipeline(
 
     // Generate initial cache key for quick lookup check
     let initial_cache_key = profiler.record_phase("Fingerprint", || {
-        cache_manager.fingerprint(&inputs, &cache_options, VERSION)
+        cache_manager.fingerprint(&inputs, &cache_options, &compiler_version)
     });
 
     if settings.allow_cache()
@@ -534,8 +539,9 @@ pub fn compile_pipeline(
         .map(|p| p.display().to_string())
         .collect();
     let cache_key = profiler.record_phase("Fingerprint (with modules)", || {
-        cache_manager.fingerprint(&inputs, &cache_options, VERSION)
+        cache_manager.fingerprint(&inputs, &cache_options, &compiler_version)
     });
+    let input_digests = inputs.digests();
 
     // Check cache again with module dependencies included
     if settings.allow_cache()
@@ -551,8 +557,14 @@ pub fn compile_pipeline(
         });
     }
 
-    let codegen_options = settings.codegen_options();
-    let binary_path = if let Some(path) = cache_manager.binary_path(&cache_key) {
+    let mut codegen_options = settings.codegen_options();
+    // Per-unit object reuse is opt-in until it has seen wider use.
+    if settings.allow_cache() && settings.object_cache {
+        codegen_options.object_cache_dir = Some(cache_manager.objects_dir());
+    }
+    let binary_path = if settings.allow_cache()
+        && let Some(path) = cache_manager.binary_path(&cache_key)
+    {
         ensure_output_directory(&path)?;
         path
     } else {
@@ -588,12 +600,20 @@ pub fn compile_pipeline(
         artifact.binary.clone(),
         binary_size,
         build_duration_ms as u64,
-        PathBuf::from("./cache"), // cache_path
+        cache_manager.entry_path(&cache_key),
     )
-    .with_llvm_version(otterc_codegen::current_llvm_version());
-
-    if let Err(e) = cache_manager.store(&metadata) {
-        warn!("Failed to store cache entry: {}", e);
+    .with_llvm_version(cache_options.llvm_version.clone())
+    .with_inputs(input_digests);
+
+    if settings.allow_cache() {
+        if let Err(e) = cache_manager.store(&metadata) {
+            warn!("Failed to store cache entry: {}", e);
+        } else if let Err(e) = cache_manager.alias(&initial_cache_key, &cache_key) {
+            warn!("Failed to record cache key: {}", e);
+        }
+        if let Err(e) = cache_manager.evict(&cache_key) {
+            warn!("Failed to evict cache entries: {}", e);
+        }
     }
 
     info!(compiled = %artifact.binary.display(), size = binary_size);
@@ -651,6 +671,7 @@ pub struct CompilationSettings {
     debug: bool,
     target: Option<String>,
     no_cache: bool,
+    object_cache: bool,
     enable_cache: bool,
     cache_dir: PathBuf,
     max_cache_size: usize,
@@ -734,8 +755,11 @@ impl CompilationSettings {
             debug: cli.debug,
             target: cli.target.clone(),
             no_cache: cli.no_cache,
+            object_cache: cli.object_cache,
             enable_cache: !cli.no_cache,
-            cache_dir: PathBuf::from("./cache"),
+            cache_dir: otterc_cache::cache_root()
+                .map(|root| root.join("builds"))
+                .unwrap_or_else(|_| PathBuf::from("./cache")),
             max_cache_size: 1024 * 1024 * 1024, // 1GB default
             check_only: false,
             language_features,
@@ -791,6 +815,12 @@ impl CompilationSettings {
             release: self.release,
             lto: self.release,
             emit_ir: self.dump_ir,
+            target: self.target.clone(),
+            features: collect_enabled_feature_names(&self.language_features)
+                .into_iter()
+                .map(str::to_string)
+                .collect(),
+            llvm_version: otterc_codegen::current_llvm_version(),
         }
     }
 
@@ -815,6 +845,7 @@ impl CompilationSettings {
             pgo_profile_file: None,
             inline_threshold: None,
             target,
+            object_cache_dir: None,
         }
     }
 
@@ -890,6 +921,24 @@ fn resolve_output_path(path: &Path, output: Option<PathBuf>) -> PathBuf {
     })
 }
 
+/// The compiler version plus the size and modification time of the running
+/// executable, so a rebuilt compiler never reuses binaries cached by the
+/// previous build of the same version.
+fn compiler_build_id() -> String {
+    let build = std::env::current_exe()
+        .and_then(fs::metadata)
+        .map(|meta| {
+            let modified = meta
+                .modified()
+                .ok()
+                .and_then(|time| time.duration_since(std::time::UNIX_EPOCH).ok())
+                .map_or(0, |since| since.as_nanos());
+            format!("{}-{modified}", meta.len())
+        })
+        .unwrap_or_default();
+    format!("{VERSION}+{build}")
+}
+
 fn canonical_or(path: &Path) -> PathBuf {
     path.canonicalize().unwrap_or_else(|_| path.to_path_buf())
 }
@@ -1025,6 +1074,21 @@ fn print_timings(stage: &CompilationStage) {
         );
     }
     println!("  {:20} {:8.2}ms", "Total", total.as_secs_f64() * 1000.0);
+
+    // Codegen phases overlap (the runtime C compiles while LLVM emits), so
+    // they are listed on their own rather than counted towards the total.
+    if let CompilationResult::Compiled { artifact, .. } = &stage.result
+        && !artifact.phases.is_empty()
+    {
+        println!("\nCodegen phases:");
+        for phase in &artifact.phases {
+            println!(
+                "  {:20} {:8.2}ms",
+                phase.name,
+                phase.duration.as_secs_f64() * 1000.0
+            );
+        }
+    }
 }
 
 fn handle_fmt(paths: &[PathBuf]) -> Result<()> {
@@ -150,6 +150,20 @@ fn show_stats(file: Option<PathBuf>) -> Result<()> {
         println!("  Total Allocated: {} bytes", stats.total_allocated);
         println!("  Total Freed: {} bytes", stats.total_freed);
         println!("  Peak Memory: {} bytes", stats.peak_memory);
+        println!("  Active Allocations: {}", stats.active_allocations);
+
+        if !stats.top_allocators.is_empty() {
+            println!("\n{}", "Top Allocators:".cyan());
+            for (name, (bytes, count)) in &stats.top_allocators {
+                println!("  {name}: {bytes} bytes in {count} allocations");
+            }
+        }
+        if !stats.runtime_counters.is_empty() {
+            println!("\n{}", "Runtime Counters:".cyan());
+            for (name, value) in &stats.runtime_counters {
+                println!("  {name}: {value}");
+            }
+        }
     } else {
         println!(
             "{}",
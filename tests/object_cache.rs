@@ -0,0 +1,121 @@
+//! `otter build --object-cache` end to end: after an edit, only the codegen
+//! unit holding the edited function is emitted again, and the program still
+//! links and runs.
+
+use std::fs;
+use std::path::{Path, PathBuf};
+use std::process::Command;
+
+const PROGRAM: &str = "\
+fn square(x: int) -> int:
+    return x * x
+
+fn cube(x: int) -> int:
+    return x * x * x
+
+fn total(n: int) -> int:
+    let sum = 0
+    for i in 0..n:
+        sum = sum + square(i) + cube(i)
+    return sum
+
+fn main():
+    let n = 6
+    print(str(total(n) + n * 7))
+";
+
+struct Sandbox {
+    root: PathBuf,
+}
+
+impl Sandbox {
+    fn new() -> Self {
+        let root = std::env::temp_dir().join(format!("otter-object-cache-{}", std::process::id()));
+        let _ = fs::remove_dir_all(&root);
+        fs::create_dir_all(&root).unwrap();
+        Self { root }
+    }
+
+    fn source(&self) -> PathBuf {
+        self.root.join("program.ot")
+    }
+
+    fn binary(&self) -> PathBuf {
+        self.root.join("program")
+    }
+
+    /// The cache root resolves through `XDG_CACHE_HOME`, so each sandbox
+    /// gets its own object store.
+    fn objects_dir(&self) -> PathBuf {
+        self.root.join("xdg/otterlang/builds/objects")
+    }
+
+    fn build(&self) {
+        let output = Command::new(env!("CARGO_BIN_EXE_otter"))
+            .current_dir(&self.root)
+            .env("XDG_CACHE_HOME", self.root.join("xdg"))
+            .args(["--object-cache", "build"])
+            .arg(self.source())
+            .arg("-o")
+            .arg(self.binary())
+            .output()
+            .expect("failed to run otter");
+        assert!(
+            output.status.success(),
+            "build failed: {}",
+            String::from_utf8_lossy(&output.stderr)
+        );
+    }
+
+    fn run(&self) -> String {
+        let output = Command::new(self.binary()).output().unwrap();
+        assert!(output.status.success());
+        String::from_utf8(output.stdout).unwrap().trim().to_string()
+    }
+}
+
+impl Drop for Sandbox {
+    fn drop(&mut self) {
+        let _ = fs::remove_dir_all(&self.root);
+    }
+}
+
+fn cached_objects(dir: &Path) -> Vec<PathBuf> {
+    let mut objects: Vec<PathBuf> = fs::read_dir(dir)
+        .map(|entries| {
+            entries
+                .map(|entry| entry.unwrap().path())
+                .filter(|path| path.extension().is_some_and(|ext| ext == "o"))
+                .collect()
+        })
+        .unwrap_or_default();
+    objects.sort();
+    objects
+}
+
+#[test]
+fn edit_reemits_only_the_edited_unit() {
+    let sandbox = Sandbox::new();
+    fs::write(sandbox.source(), PROGRAM).unwrap();
+    sandbox.build();
+    // sum of i^2 + i^3 for i < 6 is 280, plus 6 * 7
+    assert_eq!(sandbox.run(), "322");
+    let first = cached_objects(&sandbox.objects_dir());
+    assert!(
+        first.len() > 1,
+        "expected several cached units, got {}",
+        first.len()
+    );
+
+    // Only `main` changes. Nothing inlines `main` and the edit adds no
+    // global, so its unit is the only one with new code.
+    fs::write(sandbox.source(), PROGRAM.replace("n * 7", "n * 8")).unwrap();
+    sandbox.build();
+    assert_eq!(sandbox.run(), "328");
+    let second = cached_objects(&sandbox.objects_dir());
+    let new: Vec<_> = second
+        .iter()
+        .filter(|object| !first.contains(object))
+        .collect();
+    assert_eq!(new.len(), 1, "re-emitted units: {new:?}");
+}